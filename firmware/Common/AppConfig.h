@@ -0,0 +1,566 @@
+/**
+ * \file           AppConfig.h
+ * \brief          Application build configuration header file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+#ifndef APPCONFIG_H_
+#define APPCONFIG_H_
+
+/*
+ * Every option below can be overridden from the compiler command line
+ * (Project Properties -> C/C++ Build -> Settings -> Preprocessor), e.g.
+ * -DAPP_IDLE_WFI=0. The values here are the release defaults.
+ */
+
+/*****************************************************************************/
+/* Scheduler Options                                                         */
+/*****************************************************************************/
+
+/**
+ * @brief Put the core to sleep (WFI) when the event queue is empty.
+ *
+ * @details 1 = sleep between events (default).
+ *          0 = spin on the event queue, i.e. the old busy-poll behaviour.
+ *              Only useful as a baseline for the scheduler statistics.
+ */
+#ifndef APP_IDLE_WFI
+#define APP_IDLE_WFI                         1
+#endif
+
+/**
+ * @brief Collect active vs. sleep residency statistics in the scheduler.
+ *
+ * @details Uses the DWT cycle counter to accumulate the cycles the core is
+ *          awake and reports them every APP_SCHEDULER_STATS_PERIOD seconds
+ *          through DEBUG_LOG(). Compiled out completely when 0.
+ */
+#ifndef APP_SCHEDULER_STATS
+#define APP_SCHEDULER_STATS                  0
+#endif
+
+/**
+ * @brief Scheduler statistics report period in seconds.
+ */
+#ifndef APP_SCHEDULER_STATS_PERIOD
+#define APP_SCHEDULER_STATS_PERIOD           60
+#endif
+
+/*****************************************************************************/
+/* Power Options                                                             */
+/*****************************************************************************/
+
+/**
+ * @brief Tickless idle.
+ *
+ * @details 0 = SysTick interrupts every 1 ms all the time (original behaviour).
+ *          1 = SysTick is suspended while the core sleeps and the MCU
+ *              enters STOP mode whenever no running peripheral needs the
+ *              PLL clocks.
+ */
+#ifndef APP_TICKLESS_IDLE
+#define APP_TICKLESS_IDLE                    1
+#endif
+
+/*****************************************************************************/
+/* Battery Options                                                           */
+/*****************************************************************************/
+
+/**
+ * @brief Battery voltage monitor.
+ *
+ * @details When 1, a short ADC burst measures the battery on PA4 (ADC1_IN4)
+ *          against VREFINT every APP_BATTERY_PERIOD seconds of a running
+ *          timer. A low battery is shown on the display and by the buzzer,
+ *          a critical battery stops the timer and puts the MCU in STANDBY.
+ *          Needs a divider from the battery to PA4 (APP_BATTERY_DIVIDER_NUM/
+ *          APP_BATTERY_DIVIDER_DEN), which the current board does not have,
+ *          so it is 0 (compiled out) by default: a floating PA4 would read
+ *          as a critical battery.
+ */
+#ifndef APP_BATTERY_MONITOR
+#define APP_BATTERY_MONITOR                  0
+#endif
+
+/**
+ * @brief Seconds between two battery measurements while the timer runs.
+ *
+ * @details One burst keeps the ADC on for about 1 ms, at 60 s this adds
+ *          well below 0.1 uA to the average current.
+ */
+#ifndef APP_BATTERY_PERIOD
+#define APP_BATTERY_PERIOD                   60
+#endif
+
+/**
+ * @brief Battery divider ratio, battery voltage = PA4 voltage * NUM / DEN.
+ *
+ * @details Default 2:1, e.g. 2 x 1 MOhm with 100 nF from PA4 to GND, which
+ *          keeps a full cell below VDDA and draws about 2 uA.
+ */
+#ifndef APP_BATTERY_DIVIDER_NUM
+#define APP_BATTERY_DIVIDER_NUM              2
+#endif
+#ifndef APP_BATTERY_DIVIDER_DEN
+#define APP_BATTERY_DIVIDER_DEN              1
+#endif
+
+/**
+ * @brief Battery voltage below which the low battery warning starts, in mV.
+ *
+ * @details Single Li-ion cell (TP4056 charger on the schematic), about 10 %
+ *          charge left under the light load of the timer.
+ */
+#ifndef APP_BATTERY_LOW_MV
+#define APP_BATTERY_LOW_MV                   3500
+#endif
+
+/**
+ * @brief Battery voltage below which the timer shuts down, in mV.
+ *
+ * @details Kept above the 3.3 V regulator dropout region and well above the
+ *          2.4 V cut-off of the DW01A protection.
+ */
+#ifndef APP_BATTERY_CRITICAL_MV
+#define APP_BATTERY_CRITICAL_MV              3350
+#endif
+
+/**
+ * @brief Hysteresis of the battery levels in mV.
+ *
+ * @details A level is only left again when the voltage is this much above
+ *          its threshold, so the recovery of a resting cell does not toggle
+ *          the warning.
+ */
+#ifndef APP_BATTERY_HYSTERESIS_MV
+#define APP_BATTERY_HYSTERESIS_MV            100
+#endif
+
+/*****************************************************************************/
+/* Timebase Options                                                          */
+/*****************************************************************************/
+
+#define APP_TIMEBASE_TIM3                    0 /**< Seconds from TIM3 (HSI/PLL) */
+#define APP_TIMEBASE_RTC                     1 /**< Seconds from the RTC wake-up timer (LSE) */
+
+/**
+ * @brief Source of the one second session tick.
+ *
+ * @details APP_TIMEBASE_TIM3 = the original TIM3 update interrupt, only as
+ *                              accurate as the HSI (+-1 % at 25 C).
+ *          APP_TIMEBASE_RTC  = RTC wake-up timer clocked by the 32.768 kHz
+ *                              LSE crystal (default). Keeps counting in STOP
+ *                              mode, so the MCU can stop between seconds.
+ */
+#ifndef APP_TIMEBASE
+#define APP_TIMEBASE                         APP_TIMEBASE_RTC
+#endif
+
+/**
+ * @brief LSE frequency error in ppm corrected by the RTC smooth calibration.
+ *
+ * @details Positive when the crystal runs fast, negative when it runs slow.
+ *          Measure once per board (e.g. 512 Hz RTC_CALIB output against a
+ *          frequency counter). Valid range is -488 ... +487 ppm.
+ */
+#ifndef APP_RTC_CALIBRATION_PPM
+#define APP_RTC_CALIBRATION_PPM              0
+#endif
+
+/**
+ * @brief Drift measurement of TIM3 against the RTC.
+ *
+ * @details When 1, TIM3 and the RTC wake-up timer run continuously from boot
+ *          and the TIM3 error in ppm is printed through DEBUG_LOG() every
+ *          APP_TIMEBASE_DRIFT_PERIOD seconds. STOP mode is not used because
+ *          TIM3 must keep counting. Compiled out completely when 0.
+ */
+#ifndef APP_TIMEBASE_DRIFT_MEASURE
+#define APP_TIMEBASE_DRIFT_MEASURE           0
+#endif
+
+/**
+ * @brief Drift measurement window in RTC seconds.
+ */
+#ifndef APP_TIMEBASE_DRIFT_PERIOD
+#define APP_TIMEBASE_DRIFT_PERIOD            60
+#endif
+
+/*****************************************************************************/
+/* Storage Options                                                           */
+/*****************************************************************************/
+
+/**
+ * @brief Session history log in flash sector 5.
+ *
+ * @details When 1, every started session that ends (time up, skip, restart,
+ *          stop, shutdown) is kept as a 16 byte record in the sector
+ *          reserved by STM32F401CCUX_FLASH.ld (see sessionlog.c). The
+ *          sector itself is reserved either way.
+ */
+#ifndef APP_SESSION_LOG
+#define APP_SESSION_LOG                      1
+#endif
+
+/**
+ * @brief Records staged in RAM before they are written to flash.
+ *
+ * @details The staged records are written when the timer is paused or
+ *          stopped, or when the staging buffer is full. Staged records are
+ *          lost on a power cut, at most this many sessions.
+ */
+#ifndef APP_SESSION_LOG_STAGING
+#define APP_SESSION_LOG_STAGING              8
+#endif
+
+/**
+ * @brief Session profiles in flash sector 4.
+ *
+ * @details When 1, the mode lengths come from named profiles (25/5/15,
+ *          50/10/30, 90/20/30 by default, see profilestore.c) chosen with a
+ *          long press of the function button while the timer is stopped.
+ *          The choice, and profiles written with Tools/profile_image.py,
+ *          are kept in the sector reserved by STM32F401CCUX_FLASH.ld.
+ *          When 0, the compiled POMODOROMODE_TIME ... NO_OF_CYCLES are used.
+ */
+#ifndef APP_PROFILE_STORE
+#define APP_PROFILE_STORE                    1
+#endif
+
+/*****************************************************************************/
+/* Display Options                                                           */
+/*****************************************************************************/
+
+/**
+ * @brief Drive the TM1637 bus from TIM1 + DMA2 instead of bit-banging.
+ *
+ * @details 1 = a whole frame is pre-encoded into a GPIOB->BSRR word table
+ *              and clocked out by DMA, the CPU is free during the transfer.
+ *          0 = the original blocking bit-bang driver.
+ */
+#ifndef TM1637_USE_DMA_BUS
+#define TM1637_USE_DMA_BUS                   1
+#endif
+
+/**
+ * @brief Length of one TM1637 bus slot (half clock period) in microseconds.
+ *
+ * @details One bit takes two slots, so 5 us gives a 100 kHz bus clock.
+ */
+#ifndef TM1637_BUS_SLOT_US
+#define TM1637_BUS_SLOT_US                   5
+#endif
+
+/**
+ * @brief Time in microseconds after a power-on or brownout reset before the
+ *        first TM1637 frame.
+ *
+ * @details The TM1637 clears itself with an internal power-on reset and has
+ *          no ready signal, so the first frame waits for its supply to
+ *          settle: 10 ms covers the rise through the decoupling with a wide
+ *          margin. Counted from reset, the boot up to the display
+ *          already takes part of it. After a pin, software or watchdog
+ *          reset and a wake-up from STANDBY the display kept its supply and
+ *          is written at once.
+ */
+#ifndef TM1637_POWER_UP_US
+#define TM1637_POWER_UP_US                   10000U
+#endif
+
+/*****************************************************************************/
+/* Fault Options                                                             */
+/*****************************************************************************/
+
+/**
+ * @brief Faults in a row after which the MCU stays in STANDBY.
+ *
+ * @details A fault (HardFault, MemManage, BusFault, UsageFault or
+ *          Error_Handler()) is recorded in RAM kept over the reset (see
+ *          faultcapture.c) and the MCU resets. When this many faults follow
+ *          each other without APP_FAULT_STABLE_SECONDS of running in
+ *          between, it goes to STANDBY instead of resetting again, so a
+ *          fault at every boot does not drain the battery. Wake-up with the
+ *          reset button or by switching the power off and on. STANDBY does
+ *          not keep the RAM, the wake-up starts with no record and no count.
+ */
+#ifndef APP_FAULT_RESET_LIMIT
+#define APP_FAULT_RESET_LIMIT                3
+#endif
+
+/**
+ * @brief Seconds of running after which the faults in a row count from zero.
+ */
+#ifndef APP_FAULT_STABLE_SECONDS
+#define APP_FAULT_STABLE_SECONDS             60
+#endif
+
+/*****************************************************************************/
+/* Watchdog Options                                                          */
+/*****************************************************************************/
+
+/**
+ * @brief IWDG supervisor (Platform/watchdog.c).
+ *
+ * @details When 1, the independent watchdog resets the MCU unless the
+ *          input, session, display and buzzer tasks all check in within
+ *          their deadlines. The IWDG keeps counting in STOP and STANDBY,
+ *          so the RTC wake-up timer stays on with the timer stopped and
+ *          wakes the MCU every APP_WATCHDOG_IDLE_WAKE seconds to feed it;
+ *          needs APP_TIMEBASE_RTC.
+ */
+#ifndef APP_WATCHDOG
+#define APP_WATCHDOG                         1
+#endif
+
+/**
+ * @brief Seconds between the watchdog wake-ups while the timer is stopped.
+ *
+ * @details Must stay below the shortest IWDG period, 22 s with the LSI at
+ *          its 47 kHz limit (checked in watchdog.c).
+ */
+#ifndef APP_WATCHDOG_IDLE_WAKE
+#define APP_WATCHDOG_IDLE_WAKE               16
+#endif
+
+/*****************************************************************************/
+/* Idle Options                                                              */
+/*****************************************************************************/
+
+/**
+ * @brief Seconds without a button press after which a stopped or paused
+ *        timer goes into deep idle, 0 = never.
+ *
+ * @details The display is switched off and the next button press only
+ *          wakes it. The time is counted on the RTC wake-ups of the stopped
+ *          timer, every APP_WATCHDOG_IDLE_WAKE seconds; needs
+ *          APP_TIMEBASE_RTC.
+ */
+#ifndef APP_IDLE_TIMEOUT
+#define APP_IDLE_TIMEOUT                     300
+#endif
+
+/**
+ * @brief Deep idle in STANDBY with a wake-up on PA0-WKUP.
+ *
+ * @details 1 = the session and the profile are saved into the RTC backup
+ *              registers and the MCU goes to STANDBY; a press of the
+ *              control button starts it again from reset in the saved
+ *              state. The WKUP pin wakes on a rising edge and forces a
+ *              pull-down, so the control button has to switch PA0 to VDD
+ *              (active high), which the current board does not do.
+ *          0 = the MCU stays in STOP with the display off, the state stays
+ *              in RAM and any button press wakes it.
+ */
+#ifndef APP_IDLE_STANDBY
+#define APP_IDLE_STANDBY                     0
+#endif
+
+/*****************************************************************************/
+/* Brownout Options                                                          */
+/*****************************************************************************/
+
+/**
+ * @brief Session resume after a brownout.
+ *
+ * @details 1 = the PVD interrupts when the supply falls below
+ *              APP_BROWNOUT_PVD_LEVEL; the session and the profile are saved
+ *              into the RTC backup registers and the next boot continues
+ *              the session at the saved second, running or paused. The
+ *              registers keep the snapshot as long as the supply stays
+ *              above the power-down reset (a sag), or with VBAT powered.
+ *          0 = a brownout reset starts with the timer stopped.
+ */
+#ifndef APP_BROWNOUT_RESUME
+#define APP_BROWNOUT_RESUME                  1
+#endif
+
+/**
+ * @brief PVD threshold that takes the snapshot.
+ *
+ * @details PWR_PVDLEVEL_0 ... 7, about 2.2 V ... 2.9 V falling (see the
+ *          electrical characteristics). It has to stay above the BOR level.
+ */
+#ifndef APP_BROWNOUT_PVD_LEVEL
+#define APP_BROWNOUT_PVD_LEVEL               PWR_PVDLEVEL_7
+#endif
+
+/**
+ * @brief Brownout reset level, programmed into the option bytes once.
+ *
+ * @details OB_BOR_LEVEL2 holds the MCU in reset below about 2.4 V, where
+ *          the 72 MHz clock with 2 flash wait states is still inside the
+ *          specification. OB_BOR_LEVEL3 (2.7 V) overlaps the highest PVD
+ *          level within the tolerances.
+ */
+#ifndef APP_BROWNOUT_BOR_LEVEL
+#define APP_BROWNOUT_BOR_LEVEL               OB_BOR_LEVEL2
+#endif
+
+/**
+ * @brief Time in microseconds between the PVD and the BOR level, the
+ *        budget of the snapshot.
+ *
+ * @details Worst case, the cell is pulled out: the decoupling capacitance
+ *          (about 10 uF) alone feeds the 20 mA of the board from 2.9 V down
+ *          to 2.4 V, C * dV / I = 250 us. A sagging cell gives seconds. The
+ *          boot after a brownout prints the measured snapshot time against
+ *          this budget.
+ */
+#ifndef APP_BROWNOUT_WINDOW_US
+#define APP_BROWNOUT_WINDOW_US               250U
+#endif
+
+/**
+ * @brief Time in milliseconds the MCU waits below the PVD level for the
+ *        supply to recover or the BOR to take over.
+ *
+ * @details A supply still low after it, a cell sagging above the BOR
+ *          level, ends in STANDBY, with APP_IDLE_STANDBY woken by the
+ *          control button, instead of the MCU spinning until the cell is
+ *          flat.
+ */
+#ifndef APP_BROWNOUT_HOLD_MS
+#define APP_BROWNOUT_HOLD_MS                 100U
+#endif
+
+/*****************************************************************************/
+/* Driver Options                                                            */
+/*****************************************************************************/
+
+/**
+ * @brief Register level drivers instead of the HAL for RCC, GPIO and the timers.
+ *
+ * @details 1 = HAL_Init(), SystemClock_Config() (also after STOP),
+ *              MX_GPIO_Init() and the TIM1/TIM3/TIM4 setup are replaced by
+ *              register writes (Platform/lowlevel.c), the TIM3 and button
+ *              interrupts clear their flag directly instead of going
+ *              through HAL_TIM_IRQHandler() / HAL_GPIO_EXTI_IRQHandler(),
+ *              and the HAL RCC, GPIO and TIM code is no longer linked
+ *              unless another option needs it.
+ *          0 = the CubeMX generated HAL code, the reference to compare
+ *              against with APP_PROFILER and Tools/map_footprint.py.
+ */
+#ifndef APP_LL_DRIVERS
+#define APP_LL_DRIVERS                       1
+#endif
+
+/*****************************************************************************/
+/* Boot Options                                                              */
+/*****************************************************************************/
+
+/**
+ * @brief Longest time in milliseconds from reset to the first frame on the
+ *        display.
+ *
+ * @details main() draws the first frame as soon as the clock, the GPIOs and
+ *          the display are up, and starts the timers, RTC, buzzer, battery
+ *          ADC and watchdog afterwards. Every boot prints its stages (see
+ *          bootstage.c) and flags a first frame later than this.
+ */
+#ifndef APP_BOOT_FRAME_BUDGET_MS
+#define APP_BOOT_FRAME_BUDGET_MS             50U
+#endif
+
+/*****************************************************************************/
+/* Debug Options                                                             */
+/*****************************************************************************/
+
+#define APP_DEBUG_OUTPUT_NONE                0 /**< debugPrintf() output is discarded */
+#define APP_DEBUG_OUTPUT_ITM                 1 /**< debugPrintf() output on ITM port 0 (SWO pin PB3) */
+#define APP_DEBUG_OUTPUT_UART                2 /**< debugPrintf() output on USART2 TX (PA2) by DMA */
+
+/**
+ * @brief Where debugPrintf() output goes.
+ *
+ * @details APP_DEBUG_OUTPUT_NONE = weak stdUtil_putChar() of StdUtil.h, nothing
+ *                                  is sent (default).
+ *          APP_DEBUG_OUTPUT_ITM  = ITM stimulus port 0, read with the SWV ITM
+ *                                  console of an ST-Link (see debugout.c).
+ *          APP_DEBUG_OUTPUT_UART = USART2 TX on PA2, 8N1 at
+ *                                  APP_DEBUG_UART_BAUD. Messages are copied
+ *                                  into a ring buffer and sent by DMA, a full
+ *                                  buffer drops the message instead of
+ *                                  waiting (see debugout.c).
+ */
+#ifndef APP_DEBUG_OUTPUT
+#define APP_DEBUG_OUTPUT                     APP_DEBUG_OUTPUT_NONE
+#endif
+
+/**
+ * @brief Baud rate of the USART2 debug output.
+ */
+#ifndef APP_DEBUG_UART_BAUD
+#define APP_DEBUG_UART_BAUD                  115200
+#endif
+
+/**
+ * @brief Size of the USART2 transmit ring buffer in bytes, a power of two.
+ *
+ * @details At 115200 baud 512 bytes drain in 45 ms, enough for the reports
+ *          of one second.
+ */
+#ifndef APP_DEBUG_UART_BUFFER
+#define APP_DEBUG_UART_BUFFER                512
+#endif
+
+/**
+ * @brief Tokenized DEBUG_LOG() output.
+ *
+ * @details 1 = DEBUG_LOG() sends a binary frame with the address of its format
+ *              string and the raw 32-bit arguments; the strings live in the
+ *              non-loaded .tokenlog section of the ELF and
+ *              Tools/tokenlog_decode.py turns the captured output back into
+ *              text (see tokenlog.h). No vsnprintf() on the target.
+ *          0 = DEBUG_LOG() is debugPrintf(), formatted on the target.
+ */
+#ifndef APP_DEBUG_TOKENIZED
+#define APP_DEBUG_TOKENIZED                  1
+#endif
+
+/**
+ * @brief Cycle profiler on the DWT cycle counter.
+ *
+ * @details When 1, the PROFILE_BEGIN()/PROFILE_END() probes (see profiler.h)
+ *          record min/avg/max core cycles of the display, scheduler and
+ *          button paths, and the report is printed through DEBUG_LOG()
+ *          every APP_PROFILER_PERIOD seconds while the timer runs.
+ *          Compiled out completely when 0.
+ */
+#ifndef APP_PROFILER
+#define APP_PROFILER                         0
+#endif
+
+/**
+ * @brief Profiler report period in seconds.
+ */
+#ifndef APP_PROFILER_PERIOD
+#define APP_PROFILER_PERIOD                  60
+#endif
+
+#endif /* APPCONFIG_H_ */
@@ -149,6 +149,39 @@ static inline int32_t stdUtil_map(int32_t x, int32_t in_min, int32_t in_max, int
 {
     return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
 }
+/*****************************************************************************/
+/* Checksum Functions                                                        */
+/*****************************************************************************/
+#define STDUTIL_CRC32_INIT                   0xFFFFFFFFu
+
+/**
+ * @brief Updates a CRC-32 (IEEE 802.3, reflected 0xEDB88320) over a buffer.
+ *
+ * @details Bitwise, no table. Start with STDUTIL_CRC32_INIT and invert the
+ *          final value for the standard CRC-32 (e.g. 0xCBF43926 for
+ *          "123456789").
+ *
+ * @param[in] crc     Running CRC.
+ * @param[in] data    Bytes to add.
+ * @param[in] length  Number of bytes.
+ *
+ * @return Updated running CRC.
+ */
+static inline uint32_t stdUtil_crc32(uint32_t crc, const void *data, uint32_t length)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+
+    while (length-- > 0U)
+    {
+        crc ^= *bytes++;
+        for (uint8_t bit = 0; bit < 8U; bit++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return crc;
+}
+
 /*****************************************************************************/
 /* Debug Print Utility                                                       */
 /*****************************************************************************/
@@ -171,23 +204,43 @@ __attribute__((weak)) void stdUtil_putChar(char c)
 }
 
 /**
- * @brief Lightweight printf using internal buffer and StdUtil_PutChar().
+ * @brief Weak implementation of a block write for debug printing.
+ *        Sends the characters one by one through stdUtil_putChar(); an
+ *        output that queues whole messages (e.g. DMA) overrides this.
+ *
+ * @param[in] data   Characters to output
+ * @param[in] length Number of characters
+ */
+__attribute__((weak)) void stdUtil_write(const char *data, uint32_t length)
+{
+    for (uint32_t i = 0; i < length; ++i)
+    {
+    	stdUtil_putChar(data[i]);
+    }
+}
+
+/**
+ * @brief Lightweight printf using internal buffer and stdUtil_write().
+ *
+ * @details The formatted message is passed on as one block, truncated to
+ *          DEBUG_PRINTF_BUFFER_SIZE - 1 characters.
  *
  * @param[in] format Format string
  * @param[in] ...    Variable arguments
  */
-inline void debugPrintf(const char *format, ...)
+static inline void debugPrintf(const char *format, ...)
 {
     char buffer[DEBUG_PRINTF_BUFFER_SIZE];
     va_list args;
+    int length;
 
     va_start(args, format);
-    vsnprintf(buffer, sizeof(buffer), format, args);
+    length = vsnprintf(buffer, sizeof(buffer), format, args);
     va_end(args);
 
-    for (char *p = buffer; *p != '\0'; ++p)
+    if (length > 0)
     {
-    	stdUtil_putChar(*p);
+        stdUtil_write(buffer, ((uint32_t)length < sizeof(buffer)) ? (uint32_t)length : (sizeof(buffer) - 1U));
     }
 }
 
@@ -33,6 +33,7 @@ extern "C" {
 /* USER CODE BEGIN Includes */
 #include "StdUtil.h"
 #include "Version.h"
+#include "AppConfig.h"
 #include "../../UserApp/pomodorotimer.h"
 /* USER CODE END Includes */
 
@@ -55,6 +56,7 @@ extern "C" {
 void Error_Handler(void);
 
 /* USER CODE BEGIN EFP */
+void SystemClock_Config(void);
 
 /* USER CODE END EFP */
 
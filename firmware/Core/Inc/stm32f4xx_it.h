@@ -47,16 +47,21 @@ extern "C" {
 
 /* Exported functions prototypes ---------------------------------------------*/
 void NMI_Handler(void);
-void HardFault_Handler(void);
-void MemManage_Handler(void);
-void BusFault_Handler(void);
-void UsageFault_Handler(void);
 void SVC_Handler(void);
 void DebugMon_Handler(void);
 void PendSV_Handler(void);
 void SysTick_Handler(void);
+void EXTI0_IRQHandler(void);
+void EXTI1_IRQHandler(void);
 void TIM3_IRQHandler(void);
 /* USER CODE BEGIN EFP */
+void DMA2_Stream5_IRQHandler(void);
+void RTC_WKUP_IRQHandler(void);
+void RTC_Alarm_IRQHandler(void);
+void TIM4_IRQHandler(void);
+void PVD_IRQHandler(void);
+void DMA2_Stream0_IRQHandler(void);
+void DMA1_Stream6_IRQHandler(void);
 
 /* USER CODE END EFP */
 
@@ -21,7 +21,22 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
-
+#include "rtcclock.h"
+#include "hwtimer.h"
+#include "buzzer.h"
+#include "profiler.h"
+#include "timebase.h"
+#include "batteryadc.h"
+#include "debugout.h"
+#include "tokenlog.h"
+#include "faultcapture.h"
+#include "watchdog.h"
+#include "power.h"
+#include "lowlevel.h"
+#include "bootstage.h"
+#if APP_IDLE_STANDBY
+#include "snapshot.h"
+#endif
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -51,7 +66,11 @@ void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
 static void MX_TIM3_Init(void);
 /* USER CODE BEGIN PFP */
-
+#if APP_LL_DRIVERS
+/* Kept for CubeMX, replaced by Platform/lowlevel.c */
+static void MX_GPIO_Init(void) __attribute__((unused));
+static void MX_TIM3_Init(void) __attribute__((unused));
+#endif
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -67,7 +86,20 @@ int main(void)
 {
 
   /* USER CODE BEGIN 1 */
+  /* Boot time, the cycle counter runs from SystemInit() on */
+  BootStage_Mark(BootStage_Main);
+
+  /* Fault record and counters kept in .noinit over the last reset */
+  FaultCapture_Init();
 
+  /* Session second counter, before the TIM3/RTC tick interrupt is enabled */
+  timeBase_Init();
+
+#if APP_LL_DRIVERS
+  /* HAL_Init() and SystemClock_Config() by register writes */
+  LowLevel_Init();
+  LowLevel_ClockConfig();
+#else
   /* USER CODE END 1 */
 
   /* MCU Configuration--------------------------------------------------------*/
@@ -83,21 +115,108 @@ int main(void)
   SystemClock_Config();
 
   /* USER CODE BEGIN SysInit */
+#endif
+  BootStage_Mark(BootStage_Clock);
 
+  /* Reset cause; a watchdog reset out of STANDBY goes straight back */
+  if(Watchdog_Init())
+  {
+#if APP_IDLE_STANDBY
+    if(snapshot_IsSaved())
+    {
+      Power_StandbyWakePin(); /* Deep idle, the control button wakes it */
+    }
+#endif
+    Power_Standby();
+  }
+
+#if APP_LL_DRIVERS
+  /* MX_GPIO_Init() and MX_TIM3_Init() by register writes */
+  LowLevel_GpioInit();
+  LowLevel_SecondTimerInit();
+#else
   /* USER CODE END SysInit */
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
   MX_TIM3_Init();
   /* USER CODE BEGIN 2 */
+#endif
+  BootStage_Mark(BootStage_Drivers);
+
+#if (APP_DEBUG_OUTPUT == APP_DEBUG_OUTPUT_UART)
+  /* debugPrintf() on USART2 TX (PA2) by DMA */
+  DebugOut_Init();
+#endif
+
+#if APP_BROWNOUT_RESUME
+  /* Snapshot of the session when the supply sags below the PVD level */
+  if(Power_BrownoutInit())
+  {
+    /* No PVD edge comes for it: wait for the supply or the BOR, else STANDBY */
+    DEBUG_LOG("brownout: supply below the PVD level at boot\r\n");
+    Power_BrownoutHold();
+  }
+#endif
+
+  /* Bring up the display bus, after a cold start once the TM1637 has powered up */
+  TM1637_Init();
+  ResetCause_e cause = Watchdog_GetResetCause();
+  if((cause == ResetCause_PowerOn) || (cause == ResetCause_Brownout))
+  {
+    BootStage_WaitUntil(TM1637_POWER_UP_US);
+  }
+  BootStage_Mark(BootStage_Display);
+
+  /* First frame: the stopped timer, or the session saved before STANDBY or a brownout */
+  userBootDisplay();
+  while(TM1637_Bus_IsBusy())
+  {
+  }
+  BootStage_Mark(BootStage_FirstFrame);
 
-  HAL_Delay(1000);
+  /* Nothing below is needed for the first frame */
+
+  /* Print the fault that caused the last reset, if any */
+  FaultCapture_Report();
+  Watchdog_Report();
+
+#if APP_PROFILER
+  /* Frame transmit time of the display bus (userInit() redraws), then the cycle counter for the probes */
+  uint32_t framecycles = TM1637_Benchmark(16U);
+  DEBUG_LOG("bench: tm1637 frame %lu cyc, %lu us (%s)\r\n",
+		  (unsigned long)framecycles, (unsigned long)(framecycles / (SystemCoreClock / 1000000U)),
+		  DEBUG_LOG_STRING(TM1637_USE_DMA_BUS ? "dma" : "bit-bang"));
+  Profiler_Init();
+#endif
+
+  /* One-shot timers for the button debounce and the buzzer */
+  HwTimer_Init();
+
+#if (APP_TIMEBASE == APP_TIMEBASE_RTC)
+  /* Start the LSE clocked RTC used as one second timebase */
+  RtcClock_Init();
+#endif
 
   /* Set LED for warning */
-  HAL_GPIO_WritePin(GPIOC, GPIO_PIN_13, GPIO_PIN_SET);
+  LED_OFF();
 
-  /* Set Buzzer OFF*/
-  HAL_GPIO_WritePin(GPIOB, GPIO_PIN_9, GPIO_PIN_SET);
+  /* Set Buzzer OFF, the pattern player runs on the one-shot timers */
+  Buzzer_Init();
+
+#if APP_BATTERY_MONITOR
+  /* Battery input on PA4, measured in short ADC bursts */
+  BatteryAdc_Init();
+#endif
+
+#if APP_WATCHDOG
+  /* Supervise the main loop tasks from here on */
+  Watchdog_Start();
+#endif
+
+  /* Reset to first frame and userMain(), against APP_BOOT_FRAME_BUDGET_MS */
+  BootStage_Mark(BootStage_Deferred);
+  (void)BootStage_Report();
 
   userMain();
   /* USER CODE END 2 */
@@ -110,7 +229,7 @@ int main(void)
 
     /* USER CODE BEGIN 3 */
 	  /* The given LED reaches if application functions crashed*/
-	  HAL_GPIO_TogglePin(GPIOC, GPIO_PIN_13);
+	  LED_TOGGLE();
 	  HAL_Delay(2000);
   }
   /* USER CODE END 3 */
@@ -228,7 +347,10 @@ static void MX_GPIO_Init(void)
   HAL_GPIO_WritePin(GPIOC, GPIO_PIN_13, GPIO_PIN_RESET);
 
   /*Configure GPIO pin Output Level */
-  HAL_GPIO_WritePin(GPIOB, GPIO_PIN_12|GPIO_PIN_13|GPIO_PIN_9, GPIO_PIN_RESET);
+  HAL_GPIO_WritePin(GPIOB, GPIO_PIN_12|GPIO_PIN_13, GPIO_PIN_RESET);
+
+  /*Configure GPIO pin Output Level */
+  HAL_GPIO_WritePin(GPIOB, GPIO_PIN_9, GPIO_PIN_SET);
 
   /*Configure GPIO pin : PC13 */
   GPIO_InitStruct.Pin = GPIO_PIN_13;
@@ -239,7 +361,7 @@ static void MX_GPIO_Init(void)
 
   /*Configure GPIO pins : PA0 PA1 */
   GPIO_InitStruct.Pin = GPIO_PIN_0|GPIO_PIN_1;
-  GPIO_InitStruct.Mode = GPIO_MODE_INPUT;
+  GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING_FALLING;
   GPIO_InitStruct.Pull = GPIO_PULLUP;
   HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
 
@@ -251,7 +373,16 @@ static void MX_GPIO_Init(void)
   HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
 
   /* USER CODE BEGIN MX_GPIO_Init_2 */
-
+  /* Button vectors are not enabled in init (.ioc), button_Init() enables them after HwTimer_Init() */
+  HAL_NVIC_SetPriority(EXTI0_IRQn, 0, 0);
+  HAL_NVIC_SetPriority(EXTI1_IRQn, 0, 0);
+#if APP_IDLE_STANDBY
+  /* Control button to VDD on PA0-WKUP, pulled down like the WKUP pin does */
+  GPIO_InitStruct.Pin = GPIO_PIN_0;
+  GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING_FALLING;
+  GPIO_InitStruct.Pull = GPIO_PULLDOWN;
+  HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+#endif
   /* USER CODE END MX_GPIO_Init_2 */
 }
 
@@ -267,11 +398,8 @@ void Error_Handler(void)
 {
   /* USER CODE BEGIN Error_Handler_Debug */
   /* User can add his own implementation to report the HAL error return state */
-  __disable_irq();
-  while (1)
-  {
-
-  }
+  /* Record the caller and reset, see faultcapture.h */
+  FaultCapture_Error((uint32_t)(uintptr_t)__builtin_return_address(0));
   /* USER CODE END Error_Handler_Debug */
 }
 
@@ -22,6 +22,14 @@
 #include "stm32f4xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "eventqueue.h"
+#include "rtcclock.h"
+#include "hwtimer.h"
+#include "timebase.h"
+#include "batteryadc.h"
+#include "debugout.h"
+#include "watchdog.h"
+#include "profiler.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -41,8 +49,6 @@
 
 /* Private variables ---------------------------------------------------------*/
 /* USER CODE BEGIN PV */
-extern volatile uintmax_t glbSecondCounter;
-extern volatile uintmax_t glbSysTicks;
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -79,66 +85,6 @@ void NMI_Handler(void)
   /* USER CODE END NonMaskableInt_IRQn 1 */
 }
 
-/**
-  * @brief This function handles Hard fault interrupt.
-  */
-void HardFault_Handler(void)
-{
-  /* USER CODE BEGIN HardFault_IRQn 0 */
-
-  /* USER CODE END HardFault_IRQn 0 */
-  while (1)
-  {
-    /* USER CODE BEGIN W1_HardFault_IRQn 0 */
-    /* USER CODE END W1_HardFault_IRQn 0 */
-  }
-}
-
-/**
-  * @brief This function handles Memory management fault.
-  */
-void MemManage_Handler(void)
-{
-  /* USER CODE BEGIN MemoryManagement_IRQn 0 */
-
-  /* USER CODE END MemoryManagement_IRQn 0 */
-  while (1)
-  {
-    /* USER CODE BEGIN W1_MemoryManagement_IRQn 0 */
-    /* USER CODE END W1_MemoryManagement_IRQn 0 */
-  }
-}
-
-/**
-  * @brief This function handles Pre-fetch fault, memory access fault.
-  */
-void BusFault_Handler(void)
-{
-  /* USER CODE BEGIN BusFault_IRQn 0 */
-
-  /* USER CODE END BusFault_IRQn 0 */
-  while (1)
-  {
-    /* USER CODE BEGIN W1_BusFault_IRQn 0 */
-    /* USER CODE END W1_BusFault_IRQn 0 */
-  }
-}
-
-/**
-  * @brief This function handles Undefined instruction or illegal state.
-  */
-void UsageFault_Handler(void)
-{
-  /* USER CODE BEGIN UsageFault_IRQn 0 */
-
-  /* USER CODE END UsageFault_IRQn 0 */
-  while (1)
-  {
-    /* USER CODE BEGIN W1_UsageFault_IRQn 0 */
-    /* USER CODE END W1_UsageFault_IRQn 0 */
-  }
-}
-
 /**
   * @brief This function handles System service call via SWI instruction.
   */
@@ -184,7 +130,7 @@ void PendSV_Handler(void)
 void SysTick_Handler(void)
 {
   /* USER CODE BEGIN SysTick_IRQn 0 */
-	glbSysTicks++;
+
   /* USER CODE END SysTick_IRQn 0 */
   HAL_IncTick();
   /* USER CODE BEGIN SysTick_IRQn 1 */
@@ -199,20 +145,148 @@ void SysTick_Handler(void)
 /* please refer to the startup file (startup_stm32f4xx.s).                    */
 /******************************************************************************/
 
+/**
+  * @brief This function handles EXTI line0 interrupt.
+  */
+void EXTI0_IRQHandler(void)
+{
+  /* USER CODE BEGIN EXTI0_IRQn 0 */
+#if APP_LL_DRIVERS
+  EXTI->PR = EXTI_PR_PR0; /* rc_w1, the line is the only source of this vector */
+  HAL_GPIO_EXTI_Callback(GPIO_PIN_0);
+#else
+  /* USER CODE END EXTI0_IRQn 0 */
+  HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_0);
+  /* USER CODE BEGIN EXTI0_IRQn 1 */
+#endif
+  /* USER CODE END EXTI0_IRQn 1 */
+}
+
+/**
+  * @brief This function handles EXTI line1 interrupt.
+  */
+void EXTI1_IRQHandler(void)
+{
+  /* USER CODE BEGIN EXTI1_IRQn 0 */
+#if APP_LL_DRIVERS
+  EXTI->PR = EXTI_PR_PR1;
+  HAL_GPIO_EXTI_Callback(GPIO_PIN_1);
+#else
+  /* USER CODE END EXTI1_IRQn 0 */
+  HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_1);
+  /* USER CODE BEGIN EXTI1_IRQn 1 */
+#endif
+  /* USER CODE END EXTI1_IRQn 1 */
+}
+
 /**
   * @brief This function handles TIM3 global interrupt.
   */
 void TIM3_IRQHandler(void)
 {
   /* USER CODE BEGIN TIM3_IRQn 0 */
-	glbSecondCounter++;
+  PROFILE_BEGIN(ProfileProbe_SecondTimerIsr);
+#if APP_LL_DRIVERS
+  TIM3->SR = ~TIM_SR_UIF; /* rc_w0, only the update interrupt is enabled; first, so the write lands before the return */
+#endif
+#if (APP_TIMEBASE == APP_TIMEBASE_TIM3)
+	timeBase_SecondTickFromISR();
+	(void)eventQueue_Post(AppEvent_SecondTick);
+#elif APP_TIMEBASE_DRIFT_MEASURE
+	RtcClock_DriftTimerOverflow();
+#endif
+#if (APP_LL_DRIVERS == 0)
   /* USER CODE END TIM3_IRQn 0 */
   HAL_TIM_IRQHandler(&htim3);
   /* USER CODE BEGIN TIM3_IRQn 1 */
-
+#endif
+  PROFILE_END(ProfileProbe_SecondTimerIsr);
   /* USER CODE END TIM3_IRQn 1 */
 }
 
 /* USER CODE BEGIN 1 */
+/**
+  * @brief This function handles TIM4 global interrupt (one-shot timers).
+  */
+void TIM4_IRQHandler(void)
+{
+  HwTimer_IRQHandler();
+}
+
+#if (APP_TIMEBASE == APP_TIMEBASE_RTC)
+/**
+  * @brief This function handles RTC wake-up interrupt through EXTI line 22.
+  */
+void RTC_WKUP_IRQHandler(void)
+{
+#if APP_WATCHDOG
+  Watchdog_ElapsedFromISR(RtcClock_GetWakePeriod());
+#endif
+  if(RtcClock_IRQHandler())
+  {
+	timeBase_SecondTickFromISR();
+	(void)eventQueue_Post(AppEvent_SecondTick);
+  }
+#if APP_IDLE_TIMEOUT
+  else
+  {
+	(void)eventQueue_Post(AppEvent_IdleWake);
+  }
+#endif
+}
+
+/**
+  * @brief This function handles RTC alarm interrupt through EXTI line 17 (pause blink).
+  */
+void RTC_Alarm_IRQHandler(void)
+{
+  if(RtcClock_AlarmIRQHandler())
+  {
+	(void)eventQueue_Post(AppEvent_DisplayBlink);
+  }
+}
+#endif
 
+#if APP_BROWNOUT_RESUME
+/**
+  * @brief This function handles PVD interrupt through EXTI line 16 (brownout snapshot).
+  */
+void PVD_IRQHandler(void)
+{
+  HAL_PWR_PVD_IRQHandler();
+}
+#endif
+
+#if APP_BATTERY_MONITOR
+/**
+  * @brief This function handles DMA2 stream0 global interrupt (ADC1, battery burst).
+  */
+void DMA2_Stream0_IRQHandler(void)
+{
+  if(BatteryAdc_IRQHandler())
+  {
+	(void)eventQueue_Post(AppEvent_BatterySample);
+  }
+}
+#endif
+
+#if (APP_DEBUG_OUTPUT == APP_DEBUG_OUTPUT_UART)
+/**
+  * @brief This function handles DMA1 stream6 global interrupt (USART2_TX, debug output).
+  */
+void DMA1_Stream6_IRQHandler(void)
+{
+  DebugOut_IRQHandler();
+}
+#endif
+
+#if TM1637_USE_DMA_BUS
+/**
+  * @brief This function handles DMA2 stream5 global interrupt (TIM1_UP, TM1637 bus).
+  */
+void DMA2_Stream5_IRQHandler(void)
+{
+  TM1637_Bus_IRQHandler();
+}
+#endif
 /* USER CODE END 1 */
@@ -42,14 +42,60 @@
 #define PLATFORM_PLATFORM_TRANSLATE_H_
 
 #include "main.h"
+#include "gpiopin.h"
+#if APP_LL_DRIVERS
+#include "lowlevel.h"
+#endif
+
+/*
+ * The macros wrapped in #ifndef reach the hardware directly; a host build
+ * (firmware/Simulation) may provide its own definition of any of them
+ * before this header.
+ */
+
+/**
+ * @brief GPIO port of the TM1637 CLK and DIO lines.
+ */
+#define TM1637_GPIO_PORT  GPIOB
+
+/**
+ * @brief GPIO pin of the TM1637 CLK line (PB12).
+ */
+#define TM1637_CLK_PIN    GPIO_PIN_12
+
+/**
+ * @brief GPIO pin of the TM1637 DIO line (PB13).
+ */
+#define TM1637_DIO_PIN    GPIO_PIN_13
+
+/**
+ * @brief GPIO port of the buzzer.
+ */
+#define BUZZER_GPIO_PORT  GPIOB
+
+/**
+ * @brief GPIO pin of the buzzer (PB9, active low).
+ */
+#define BUZZER_PIN        GPIO_PIN_9
+
+/**
+ * @brief GPIO port of the on-board LED.
+ */
+#define LED_GPIO_PORT     GPIOC
+
+/**
+ * @brief GPIO pin of the on-board LED (PC13, active low).
+ */
+#define LED_PIN           GPIO_PIN_13
 
 /**
  * @brief Sets the CLK (Clock) line high for TM1637 communication.
  *
  * @details This macro sets GPIO pin PB12 to high state to indicate a rising edge
  *          or high logic level on the clock line as required by the TM1637 protocol.
+ *          Single BSRR store, see gpiopin.h.
  */
-#define CLK_HIGH() HAL_GPIO_WritePin(GPIOB, GPIO_PIN_12, GPIO_PIN_SET)
+#define CLK_HIGH() GpioPin_Set(TM1637_GPIO_PORT, TM1637_CLK_PIN)
 
 /**
  * @brief Sets the CLK (Clock) line low for TM1637 communication.
@@ -57,7 +103,7 @@
  * @details This macro sets GPIO pin PB12 to low state to indicate a falling edge
  *          or low logic level on the clock line.
  */
-#define CLK_LOW()  HAL_GPIO_WritePin(GPIOB, GPIO_PIN_12, GPIO_PIN_RESET);
+#define CLK_LOW()  GpioPin_Reset(TM1637_GPIO_PORT, TM1637_CLK_PIN)
 
 /**
  * @brief Sets the DATA line high for TM1637 communication.
@@ -65,7 +111,7 @@
  * @details This macro sets GPIO pin PB13 to high state, representing a logic high
  *          signal on the data line for bit transmission.
  */
-#define DATA_HIGH() HAL_GPIO_WritePin(GPIOB, GPIO_PIN_13, GPIO_PIN_SET)
+#define DATA_HIGH() GpioPin_Set(TM1637_GPIO_PORT, TM1637_DIO_PIN)
 
 /**
  * @brief Sets the DATA line low for TM1637 communication.
@@ -73,22 +119,86 @@
  * @details This macro sets GPIO pin PB13 to low state, representing a logic low
  *          signal on the data line for bit transmission.
  */
-#define DATA_LOW()  HAL_GPIO_WritePin(GPIOB, GPIO_PIN_13, GPIO_PIN_RESET);
+#define DATA_LOW()  GpioPin_Reset(TM1637_GPIO_PORT, TM1637_DIO_PIN)
 
 /**
  * @brief Sets the Buzzer On for notification
  *
  * @details This macro sets GPIO pin PB9 to low state, representing a Buzzer on
  */
-#define BUZZER_ON() HAL_GPIO_WritePin(GPIOB, GPIO_PIN_9, GPIO_PIN_RESET)
+#define BUZZER_ON() GpioPin_Reset(BUZZER_GPIO_PORT, BUZZER_PIN)
 
 /**
  * @brief Sets the Buzzer Off for notification
  *
  * @details This macro sets GPIO pin PB9 to high state, representing a Buzzer off
  */
-#define BUZZER_OFF()  HAL_GPIO_WritePin(GPIOB, GPIO_PIN_9, GPIO_PIN_SET)
+#define BUZZER_OFF()  GpioPin_Set(BUZZER_GPIO_PORT, BUZZER_PIN)
+
+/**
+ * @brief Switches the on-board LED off
+ *
+ * @details This macro sets GPIO pin PC13 to high state, the LED is active low
+ */
+#define LED_OFF()  GpioPin_Set(LED_GPIO_PORT, LED_PIN)
+
+/**
+ * @brief Toggles the on-board LED
+ *
+ * @details This macro inverts GPIO pin PC13, used to blink the fault indication
+ */
+#define LED_TOGGLE()  GpioPin_Toggle(LED_GPIO_PORT, LED_PIN)
+
+#if (APP_TIMEBASE == APP_TIMEBASE_RTC)
+/**
+ * @brief Turn ON the 1 Second timer
+ *
+ * @details This macro starts the RTC wake-up timer seconds (see rtcclock.h)
+ */
+#define TIMER_ON() RtcClock_Start()
 
+/**
+ * @brief Turn OFF the 1 Second timer
+ *
+ * @details This macro stops the RTC wake-up timer seconds (see rtcclock.h)
+ */
+#define TIMER_OFF()  RtcClock_Stop()
+
+/**
+ * @brief Restart the phase of the 1 Second timer
+ *
+ * @details Drops the rest of the second kept by RtcClock_Stop(), so the
+ *          next second is a full one. TIMER_OFF()/TIMER_ON() alone keep the
+ *          phase to one SSR step (1/2048 s), as TIM3 does over a pause.
+ */
+#define TIMER_PHASE_RESET()  RtcClock_PhaseReset()
+#elif APP_LL_DRIVERS
+/**
+ * @brief Turn ON the 1 Second timer
+ *
+ * @details This macro starts TIM3 and its update interrupt by register writes
+ */
+#define TIMER_ON() LowLevel_SecondTimerStart()
+
+/**
+ * @brief Turn OFF the 1 Second timer
+ *
+ * @details This macro stops TIM3 and its update interrupt by register writes
+ */
+#define TIMER_OFF()  LowLevel_SecondTimerStop()
+
+/**
+ * @brief Restart the phase of the 1 Second timer
+ *
+ * @details As the HAL variant below, on TIM3 directly.
+ */
+#ifndef TIMER_PHASE_RESET
+#define TIMER_PHASE_RESET()  do { SET_BIT(TIM3->CR1, TIM_CR1_URS); \
+                                  TIM3->EGR = TIM_EGR_UG; \
+                                  CLEAR_BIT(TIM3->CR1, TIM_CR1_URS); \
+                                  TIM3->SR = ~TIM_SR_UIF; } while(0)
+#endif
+#else
 /**
  * @brief Turn ON the 1 Second timer
  *
@@ -103,6 +213,23 @@
  */
 #define TIMER_OFF()  HAL_TIM_Base_Stop_IT(&htim3)
 
+/**
+ * @brief Restart the phase of the 1 Second timer
+ *
+ * @details This macro reloads the TIM3 counter and prescaler with an update
+ *          generation (URS set so no update interrupt is requested) and
+ *          drops a pending update, so the next second is a full one. Call
+ *          with the timer stopped. TIMER_OFF()/TIMER_ON() alone keep the
+ *          phase, which is what a pause needs.
+ */
+#ifndef TIMER_PHASE_RESET
+#define TIMER_PHASE_RESET()  do { SET_BIT(htim3.Instance->CR1, TIM_CR1_URS); \
+                                  htim3.Instance->EGR = TIM_EGR_UG; \
+                                  CLEAR_BIT(htim3.Instance->CR1, TIM_CR1_URS); \
+                                  __HAL_TIM_CLEAR_FLAG(&htim3, TIM_FLAG_UPDATE); } while(0)
+#endif
+#endif
+
 /**
  * @brief Read control Button State
  *
@@ -110,7 +237,24 @@
  * GPIO_PIN_SET = true/1
  * GPIO_PIN_RESET = false/0
  */
+#if APP_LL_DRIVERS
+#define CONTROLBUTTON_READ() (GpioPin_Read(GPIOA, GPIO_PIN_0) ? GPIO_PIN_SET : GPIO_PIN_RESET)
+#else
 #define CONTROLBUTTON_READ() HAL_GPIO_ReadPin(GPIOA, GPIO_PIN_0)
+#endif
+
+/**
+ * @brief Control button level while pressed
+ *
+ * @details Active low against the pull-up of MX_GPIO_Init(). With
+ *          APP_IDLE_STANDBY the button switches PA0-WKUP to VDD against a
+ *          pull-down instead, the WKUP pin only wakes on a rising edge.
+ */
+#if APP_IDLE_STANDBY
+#define CONTROLBUTTON_PRESSED  GPIO_PIN_SET
+#else
+#define CONTROLBUTTON_PRESSED  GPIO_PIN_RESET
+#endif
 
 /**
  * @brief Read function Button State
@@ -119,7 +263,26 @@
  * GPIO_PIN_SET = true/1
  * GPIO_PIN_RESET = false/0
  */
+#if APP_LL_DRIVERS
+#define FUNCTIONBUTTON_READ()  (GpioPin_Read(GPIOA, GPIO_PIN_1) ? GPIO_PIN_SET : GPIO_PIN_RESET)
+#else
 #define FUNCTIONBUTTON_READ()  HAL_GPIO_ReadPin(GPIOA, GPIO_PIN_1)
+#endif
+
+/**
+ * @brief Enable the button interrupts
+ *
+ * @details This macro drops the EXTI0/EXTI1 edges latched since the GPIO
+ *          setup and enables both vectors, which the GPIO setup leaves
+ *          disabled. Called by button_Init() once the timer wheel is set up.
+ */
+#ifndef BUTTON_IRQ_ENABLE
+#define BUTTON_IRQ_ENABLE()  do { WRITE_REG(EXTI->PR, EXTI_PR_PR0 | EXTI_PR_PR1); \
+                                  NVIC_ClearPendingIRQ(EXTI0_IRQn); \
+                                  NVIC_ClearPendingIRQ(EXTI1_IRQn); \
+                                  NVIC_EnableIRQ(EXTI0_IRQn); \
+                                  NVIC_EnableIRQ(EXTI1_IRQn); } while(0)
+#endif
 
 /**
  * @brief Milliseconds delay function
@@ -128,4 +291,197 @@
  */
 #define APP_DELAY(milliseconds)  HAL_Delay(milliseconds)
 
+/**
+ * @brief Read the current interrupt mask state
+ *
+ * @details This macro returns PRIMASK so it can be restored by APP_IRQ_RESTORE()
+ */
+#define APP_IRQ_SAVE()  __get_PRIMASK()
+
+/**
+ * @brief Mask all maskable interrupts
+ *
+ * @details This macro sets PRIMASK. Pending interrupts still wake the core from WFI
+ */
+#define APP_IRQ_DISABLE()  __disable_irq()
+
+/**
+ * @brief Restore the interrupt mask state
+ *
+ * @details This macro restores PRIMASK saved by APP_IRQ_SAVE()
+ */
+#define APP_IRQ_RESTORE(state)  __set_PRIMASK(state)
+
+/**
+ * @brief Sleep until the next interrupt
+ *
+ * @details This macro executes WFI, the core stops until any interrupt is pending
+ */
+#define APP_WAIT_FOR_INTERRUPT()  __WFI()
+
+/**
+ * @brief Enable the DWT cycle counter
+ *
+ * @details This macro enables trace and starts DWT->CYCCNT. A running
+ *          count is kept, every user takes differences and the boot time
+ *          is counted from the start of main().
+ */
+#ifndef APP_CYCLE_COUNTER_INIT
+#define APP_CYCLE_COUNTER_INIT()  do { CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; \
+                                       DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk; } while(0)
+#endif
+
+/**
+ * @brief Read the DWT cycle counter
+ *
+ * @details This macro returns the free running 32-bit core cycle count.
+ */
+#ifndef APP_CYCLE_COUNTER
+#define APP_CYCLE_COUNTER()  (DWT->CYCCNT)
+#endif
+
+/**
+ * @brief Reset the MCU
+ *
+ * @details This macro requests a system reset through SCB->AIRCR.
+ */
+#ifndef APP_SYSTEM_RESET
+#define APP_SYSTEM_RESET()  NVIC_SystemReset()
+#endif
+
+/**
+ * @brief Enable the MemManage, BusFault and UsageFault exceptions
+ *
+ * @details Without this every fault escalates to HardFault.
+ */
+#ifndef APP_FAULT_ENABLE
+#define APP_FAULT_ENABLE()  SET_BIT(SCB->SHCSR, SCB_SHCSR_USGFAULTENA_Msk | \
+                                                SCB_SHCSR_BUSFAULTENA_Msk | \
+                                                SCB_SHCSR_MEMFAULTENA_Msk)
+#endif
+
+/**
+ * @brief Copy the fault status and address registers into a FaultRecord_t
+ */
+#ifndef APP_FAULT_STATUS_READ
+#define APP_FAULT_STATUS_READ(record)  do { (record)->cfsr = SCB->CFSR; \
+                                            (record)->hfsr = SCB->HFSR; \
+                                            (record)->mmfar = SCB->MMFAR; \
+                                            (record)->bfar = SCB->BFAR; } while(0)
+#endif
+
+/**
+ * @brief Check that a block of memory lies in SRAM
+ *
+ * @details This macro is true when [address, address + size) is in the 64K
+ *          of SRAM1, used before reading a stacked exception frame.
+ */
+#ifndef APP_RAM_CONTAINS
+#define APP_RAM_CONTAINS(address, size)  (((uintptr_t)(address) >= SRAM1_BASE) && \
+                                          (((uintptr_t)(address) + (size)) <= (SRAM1_BASE + 0x10000U)))
+#endif
+
+/**
+ * @brief Stop in STANDBY until reset or power cycle
+ *
+ * @details Used when the firmware keeps faulting, see power.h.
+ */
+#ifndef APP_FAULT_PARK
+#define APP_FAULT_PARK()  Power_Standby()
+#endif
+
+/**
+ * @brief Read the RCC reset flags
+ *
+ * @details This macro returns RCC->CSR, the RCC_CSR_*RSTF bits tell why
+ *          the MCU started.
+ */
+#ifndef APP_RESET_FLAGS
+#define APP_RESET_FLAGS()  (RCC->CSR)
+#endif
+
+/**
+ * @brief Clear the RCC reset flags
+ */
+#ifndef APP_RESET_FLAGS_CLEAR
+#define APP_RESET_FLAGS_CLEAR()  SET_BIT(RCC->CSR, RCC_CSR_RMVF)
+#endif
+
+/**
+ * @brief Check whether the MCU was in STANDBY before this start
+ *
+ * @details This macro reads PWR_CSR SBF, kept over every reset but a power
+ *          cycle. The PWR clock must be on (SystemClock_Config()).
+ */
+#ifndef APP_STANDBY_FLAG
+#define APP_STANDBY_FLAG()  (READ_BIT(PWR->CSR, PWR_CSR_SBF) != 0U)
+#endif
+
+/**
+ * @brief Clear the STANDBY flag
+ */
+#ifndef APP_STANDBY_FLAG_CLEAR
+#define APP_STANDBY_FLAG_CLEAR()  SET_BIT(PWR->CR, PWR_CR_CSBF)
+#endif
+
+/**
+ * @brief Start the independent watchdog
+ *
+ * @details This macro freezes the IWDG while a debugger halts the core,
+ *          unlocks PR/RLR (key 0x5555), waits for the LSI domain to take
+ *          them and starts the watchdog (key 0xCCCC, which also starts the
+ *          LSI). Once started only a reset stops it.
+ */
+#ifndef APP_WATCHDOG_START
+#define APP_WATCHDOG_START(prescaler, reload)  do { SET_BIT(DBGMCU->APB1FZ, DBGMCU_APB1_FZ_DBG_IWDG_STOP); \
+                                                    WRITE_REG(IWDG->KR, 0xCCCCU); \
+                                                    WRITE_REG(IWDG->KR, 0x5555U); \
+                                                    WRITE_REG(IWDG->PR, (prescaler)); \
+                                                    WRITE_REG(IWDG->RLR, (reload)); \
+                                                    while(READ_REG(IWDG->SR) != 0U) {} \
+                                                    WRITE_REG(IWDG->KR, 0xAAAAU); } while(0)
+#endif
+
+/**
+ * @brief Feed the independent watchdog
+ *
+ * @details This macro reloads the IWDG counter (key 0xAAAA), one store.
+ */
+#ifndef APP_WATCHDOG_FEED
+#define APP_WATCHDOG_FEED()  WRITE_REG(IWDG->KR, 0xAAAAU)
+#endif
+
+/**
+ * @brief Read an RTC backup register
+ *
+ * @details This macro reads RTC_BKPxR, index 0 ... 19. The 20 registers
+ *          keep their value over STANDBY and every reset, not over a power
+ *          cycle without VBAT.
+ */
+#ifndef APP_BACKUP_READ
+#define APP_BACKUP_READ(index)  READ_REG((&RTC->BKP0R)[(index)])
+#endif
+
+/**
+ * @brief Write an RTC backup register
+ *
+ * @details This macro sets PWR_CR DBP, the backup domain is write protected
+ *          after reset, and stores the word. The PWR clock must be on
+ *          (SystemClock_Config()).
+ */
+#ifndef APP_BACKUP_WRITE
+#define APP_BACKUP_WRITE(index, value)  do { SET_BIT(PWR->CR, PWR_CR_DBP); \
+                                             WRITE_REG((&RTC->BKP0R)[(index)], (value)); } while(0)
+#endif
+
+/**
+ * @brief Whether the supply is below the PVD level
+ *
+ * @details This macro reads PWR_CSR PVDO, only meaningful with the PVD
+ *          enabled (APP_BROWNOUT_RESUME).
+ */
+#ifndef APP_SUPPLY_LOW
+#define APP_SUPPLY_LOW()  (READ_BIT(PWR->CSR, PWR_CSR_PVDO) != 0U)
+#endif
+
 #endif /* PLATFORM_PLATFORM_TRANSLATE_H_ */
@@ -34,6 +34,7 @@
 /* Include Files                                                             */
 /*****************************************************************************/
 #include "TM1637.h"
+#include "profiler.h"
 /*****************************************************************************/
 /* Private Variables                                                         */
 /*****************************************************************************/
@@ -51,35 +52,81 @@ static const uint8_t tm1637digitpattern[] = {    0b00111111,    /* 0 */
 												 0b10000000,    /* . */
 											};
 
-static uint8_t tm1637currentdisplayvalue[MAX_NO_OF_CHARACTERS] = { };
+static uint8_t tm1637currentdisplayvalue[MAX_NO_OF_CHARACTERS] = { }; /** Segment patterns currently on the display **/
+
+static bool tm1637displayvalid = false; /** tm1637currentdisplayvalue matches the display **/
+
+static uint8_t tm1637displaycontrol = (DISPLAY_COMMAND|PULSE_WIDTH_SET_04_16|DISPLAY_ON); /** Requested brightness and on/off **/
+
+static uint8_t tm1637sentdisplaycontrol = 0; /** Last display command sent, 0 = none yet **/
+
+static volatile uint32_t tm1637busbytecount = 0; /** Bytes put on the TM1637 bus since boot **/
+
+static uint32_t tm1637updatecount = 0; /** TM1637_Update_Data_Dots() calls since boot **/
+
+static uint32_t tm1637cyclesperus = 16U; /** Core cycles per microsecond, set from SystemCoreClock by TM1637_Init() **/
 
 /*****************************************************************************/
 /* TM1637 Functions                                                          */
 /*****************************************************************************/
+/*****************************************************************************
+ * @brief Initializes the TM1637 bus.
+ *
+ * @details With TM1637_USE_DMA_BUS the TIM1/DMA bus engine is configured,
+ *          otherwise the CLK and DIO lines are parked high (bus idle) for the
+ *          bit-bang driver. The DWT cycle counter is started and delay_Us()
+ *          is calibrated from SystemCoreClock.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Call once after the GPIOs are initialized and before the first write.
+ *
+ * @see TM1637_Bus_Init()
+ *****************************************************************************/
+void TM1637_Init(void)
+{
+	APP_CYCLE_COUNTER_INIT();
+	tm1637cyclesperus = (SystemCoreClock + 999999U) / 1000000U; /** Round up, a delay must not be short **/
+
+#if TM1637_USE_DMA_BUS
+	TM1637_Bus_Init();
+#endif
+	CLK_HIGH();
+	DATA_HIGH();
+}
 /*****************************************************************************
  * @brief Generates a delay in microseconds.
  *
- * @details This function creates a rough delay using nested loops and NOP
- *          instructions. It is not highly accurate and depends on CPU speed.
+ * @details Busy-waits on the DWT cycle counter for time microseconds at the
+ *          SystemCoreClock rate taken by TM1637_Init(), so the delay no
+ *          longer depends on the compiler optimization level.
  *
- * @param[in] time  Number of microseconds to delay (approximate).
+ * @param[in] time  Number of microseconds to delay.
  *
  * @return None
  *
  * @retval None
  *
- * @note Best used for small delays like 1–10 microseconds. Not suitable
- *       for precise timing.
+ * @note Best used for small delays like 1–10 microseconds. Interrupts
+ *       taken during the wait only make it longer.
  *
- * @warning Delay accuracy is affected by compiler optimization and CPU speed.
+ * @warning TM1637_Init() must have run, it starts the cycle counter.
  *****************************************************************************/
 void delay_Us(int time)
 {
-	for(int i = 0; i < time; i++)
-		{
-			for(int j = 0; j < 3; j++)
-				__asm__("nop");
-		}
+	if(time <= 0)
+	{
+		return;
+	}
+	uint32_t start = APP_CYCLE_COUNTER();
+	uint32_t cycles = (uint32_t)time * tm1637cyclesperus;
+	while((uint32_t)(APP_CYCLE_COUNTER() - start) < cycles)
+	{
+	}
 }
 /*****************************************************************************
  * @brief Sends the start signal for TM1637 communication.
@@ -177,6 +224,8 @@ void TM1637_WaitForAck (void)
 void TM1637_WriteByte (uint8_t byte)
 {
 	int i;
+	PROFILE_BEGIN(ProfileProbe_TM1637Byte);
+	tm1637busbytecount++;
 	for (i = 0; i<8; i++)
 	{
 		CLK_LOW();
@@ -193,6 +242,7 @@ void TM1637_WriteByte (uint8_t byte)
 		CLK_HIGH();
 		delay_Us(3);
 	}
+	PROFILE_END(ProfileProbe_TM1637Byte);
 }
 /*****************************************************************************
  * @brief Sends a command to TM1637 to configure data writing.
@@ -230,7 +280,7 @@ void TM1637_WriteDataCommand(uint8_t datacommand)
  *
  * @retval None
  *
- * @note Expects `data` to have `MAX_NO_OF_CHARACTERS` elements.
+ * @note Expects `data` to have `NO_OF_DISPLAY_DIGITS` elements.
  *
  * @see TM1637_WriteByte(), TM1637_WaitForAck(), TM1637_Stop()
  *****************************************************************************/
@@ -239,7 +289,7 @@ void TM1637_WriteData(uint8_t address, uint8_t *data)
 	TM1637_Start();
 	TM1637_WriteByte(address);
 	TM1637_WaitForAck();
-	for (int i = 0; i < MAX_NO_OF_CHARACTERS; i++)
+	for (int i = 0; i < NO_OF_DISPLAY_DIGITS; i++)
 	{
 		TM1637_WriteByte(tm1637digitpattern[data[i]]);
 		TM1637_WaitForAck();
@@ -285,7 +335,7 @@ void TM1637_WriteDisplayCommand(uint8_t displaycommand)
  *
  * @note Combines all steps to write to TM1637 in one function.
  *
- * @warning Expects `data` to have `MAX_NO_OF_CHARACTERS` entries.
+ * @warning Expects `data` to have `NO_OF_DISPLAY_DIGITS` entries.
  *
  * @see TM1637_Start(), TM1637_WriteByte(), TM1637_Stop()
  *****************************************************************************/
@@ -299,7 +349,7 @@ void TM1637_Write(uint8_t datacommand,uint8_t address,uint8_t *data,uint8_t disp
 		TM1637_Start();
 		TM1637_WriteByte(address);
 		TM1637_WaitForAck();
-		for (int i = 0; i < MAX_NO_OF_CHARACTERS; i++)
+		for (int i = 0; i < NO_OF_DISPLAY_DIGITS; i++)
 		{
 			tm1637currentdisplayvalue[i] = tm1637digitpattern[data[i]];
 			TM1637_WriteByte(tm1637digitpattern[data[i]]);
@@ -311,6 +361,9 @@ void TM1637_Write(uint8_t datacommand,uint8_t address,uint8_t *data,uint8_t disp
 		TM1637_WriteByte(displaycommand);
 		TM1637_WaitForAck();
 		TM1637_Stop();
+
+		tm1637displayvalid = (address == DISPLAY_1_REGISTER_ADDRESS);
+		tm1637sentdisplaycontrol = displaycommand;
 }
 /*****************************************************************************
  * @brief Converts a time value in seconds into 4 display digits.
@@ -339,60 +392,247 @@ void TM1637_Convert_To_Digits(uint32_t values, uint8_t digits[4])
     digits[2] = seconds / 10;        /* Tens place of seconds*/
     digits[3] = seconds % 10;        /* Ones place of seconds*/
 }
+/*****************************************************************************
+ * @brief Sends a frame of transfers on the selected TM1637 bus backend.
+ *
+ * @param[in] transfers  Transfers to send.
+ * @param[in] count      Number of transfers.
+ *
+ * @return bool
+ *
+ * @retval true   Frame sent (bit-bang) or accepted by the DMA bus engine.
+ * @retval false  DMA bus engine could not take the frame.
+ *
+ * @see TM1637_Bus_Transmit()
+ *****************************************************************************/
+static bool tm1637SendTransfers(const TM1637_Transfer_t *transfers, uint8_t count)
+{
+#if TM1637_USE_DMA_BUS
+	if(TM1637_Bus_Transmit(transfers, count) == false)
+	{
+		return false;
+	}
+	for(uint8_t t = 0; t < count; t++)
+	{
+		tm1637busbytecount += transfers[t].length;
+	}
+#else
+	for(uint8_t t = 0; t < count; t++)
+	{
+		TM1637_Start();
+		for(uint8_t b = 0; b < transfers[t].length; b++)
+		{
+			TM1637_WriteByte(transfers[t].data[b]);
+			TM1637_WaitForAck();
+		}
+		TM1637_Stop();
+	}
+#endif
+	return true;
+}
 /*****************************************************************************
  * @brief Updates the TM1637 display with optional dots (colon).
  *
- * @details Sends digit patterns with or without the dot segment active
- *          depending on `status`. Handles full write cycle including commands.
+ * @details Builds the segment patterns of the NO_OF_DISPLAY_DIGITS digits and
+ *          compares them with the shadow of what is on the display. Only the
+ *          changed digits are sent, either one fixed-address write per digit
+ *          or one auto-increment run covering them, whichever is fewer bytes.
+ *          The display command is sent only when brightness or on/off
+ *          changed. The shadow is updated only once the frame is accepted.
  *
- * @param[in] displayvalue  Pointer to array of digit values to display.
- * @param[in] status        Boolean flag to enable (true) or disable (false) dots.
+ * @param[in] displayvalue  Pointer to array of NO_OF_DISPLAY_DIGITS digit values.
+ * @param[in] status        Boolean flag to enable (true) or disable (false) the colon.
  *
  * @return None
  *
  * @retval None
  *
  * @note Commonly used to blink the colon every second for visual feedback.
+ *       The colon is the dot segment of digit TM1637_COLON_DIGIT, so a tick
+ *       usually costs the seconds digit and the colon digit only.
  *
- * @see TM1637_Write(), TM1637_WriteDisplayCommand()
+ * @see TM1637_GetBusByteCount(), TM1637_SetDisplayControl()
  *****************************************************************************/
-void TM1637_Update_Data_Dots(uint8_t *displayvalue, uint8_t status);
-
 void TM1637_Update_Data_Dots(uint8_t *displayvalue, uint8_t status)
 {
-	TM1637_Start();
-	TM1637_WriteByte((DATA_COMMAND|WRITE_DATA_TO_DISPLAY|AUTOMATIC_ADDRESS_ADD|NORMAL_MODE));
-	TM1637_WaitForAck();
-	TM1637_Stop();
+	PROFILE_BEGIN(ProfileProbe_TM1637Update);
+	tm1637updatecount++;
+	uint8_t segments[NO_OF_DISPLAY_DIGITS];
+	uint8_t changed = 0;
+	uint8_t first = NO_OF_DISPLAY_DIGITS;
+	uint8_t last = 0;
+	uint8_t dirty = 0;
 
-	if(status)
+	for (uint8_t i = 0; i < NO_OF_DISPLAY_DIGITS; i++)
 	{
-		TM1637_Start();
-		TM1637_WriteByte(DISPLAY_1_REGISTER_ADDRESS);
-		TM1637_WaitForAck();
-		for (int i = 0; i < MAX_NO_OF_CHARACTERS; i++)
+		segments[i] = tm1637digitpattern[displayvalue[i]];
+		if(status && (i == TM1637_COLON_DIGIT))
 		{
-			TM1637_WriteByte((tm1637digitpattern[displayvalue[i]] | tm1637digitpattern[11]));
-			TM1637_WaitForAck();
+			segments[i] |= tm1637digitpattern[11];
+		}
+		if((tm1637displayvalid == false) || (segments[i] != tm1637currentdisplayvalue[i]))
+		{
+			changed |= (uint8_t)(1U << i);
+			if(first == NO_OF_DISPLAY_DIGITS)
+			{
+				first = i;
+			}
+			last = i;
+			dirty++;
 		}
-		TM1637_Stop();
 	}
-	else
+
+	uint8_t datacommand;
+	uint8_t bytes[2 * NO_OF_DISPLAY_DIGITS];
+	TM1637_Transfer_t transfers[2 + NO_OF_DISPLAY_DIGITS];
+	uint8_t count = 0;
+
+	if(changed != 0U)
 	{
-		TM1637_Start();
-		TM1637_WriteByte(DISPLAY_1_REGISTER_ADDRESS);
-		TM1637_WaitForAck();
-		for (int i = 0; i < MAX_NO_OF_CHARACTERS; i++)
+		uint8_t run = (uint8_t)(last - first + 1U);
+		if((2U * dirty) <= (run + 1U))
 		{
-			TM1637_WriteByte(tm1637digitpattern[displayvalue[i]]);
-			TM1637_WaitForAck();
+			/* Fixed address: address + data per changed digit */
+			datacommand = (DATA_COMMAND|WRITE_DATA_TO_DISPLAY|FIX_ADDRESS|NORMAL_MODE);
+			transfers[count].data = &datacommand;
+			transfers[count++].length = 1;
+			uint8_t k = 0;
+			for (uint8_t i = first; i <= last; i++)
+			{
+				if(changed & (1U << i))
+				{
+					bytes[k] = (uint8_t)(DISPLAY_1_REGISTER_ADDRESS + i);
+					bytes[k + 1U] = segments[i];
+					transfers[count].data = &bytes[k];
+					transfers[count++].length = 2;
+					k += 2U;
+				}
+			}
+		}
+		else
+		{
+			/* Auto increment: one address and the run of digits from first to last */
+			datacommand = (DATA_COMMAND|WRITE_DATA_TO_DISPLAY|AUTOMATIC_ADDRESS_ADD|NORMAL_MODE);
+			transfers[count].data = &datacommand;
+			transfers[count++].length = 1;
+			bytes[0] = (uint8_t)(DISPLAY_1_REGISTER_ADDRESS + first);
+			memcpy(&bytes[1], &segments[first], run);
+			transfers[count].data = bytes;
+			transfers[count++].length = (uint8_t)(run + 1U);
 		}
-		TM1637_Stop();
 	}
 
-	TM1637_Start();
-	TM1637_WriteByte((DISPLAY_COMMAND|PULSE_WIDTH_SET_04_16|DISPLAY_ON));
-	TM1637_WaitForAck();
-	TM1637_Stop();
+	uint8_t displaycontrol = tm1637displaycontrol;
+	if((tm1637displayvalid == false) || (displaycontrol != tm1637sentdisplaycontrol))
+	{
+		transfers[count].data = &displaycontrol;
+		transfers[count++].length = 1;
+	}
+
+	if(count == 0U)
+	{
+		PROFILE_END(ProfileProbe_TM1637Update);
+		return; /** Nothing changed, nothing on the bus **/
+	}
+
+	PROFILE_BEGIN(ProfileProbe_TM1637Frame);
+	bool sent = tm1637SendTransfers(transfers, count);
+	PROFILE_END(ProfileProbe_TM1637Frame);
+
+	if(sent)
+	{
+		memcpy(tm1637currentdisplayvalue, segments, NO_OF_DISPLAY_DIGITS);
+		tm1637sentdisplaycontrol = displaycontrol;
+		tm1637displayvalid = true;
+	}
+	PROFILE_END(ProfileProbe_TM1637Update);
+}
+/*****************************************************************************
+ * @brief Sets the display control (brightness and on/off).
+ *
+ * @details The new value is sent with the next TM1637_Update_Data_Dots() and
+ *          only if it differs from what was sent last.
+ *
+ * @param[in] displaycommand  DISPLAY_COMMAND | PULSE_WIDTH_SET_xx_16 | DISPLAY_ON/OFF.
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+void TM1637_SetDisplayControl(uint8_t displaycommand)
+{
+	tm1637displaycontrol = displaycommand;
+}
+/*****************************************************************************
+ * @brief Returns the number of bytes sent on the TM1637 bus.
+ *
+ * @details Counts command, address and data bytes of every transfer on both
+ *          bus backends. Compare two readings over a known time to get the
+ *          bus traffic per second.
+ *
+ * @param None
+ *
+ * @return uint32_t Bytes sent since boot.
+ *****************************************************************************/
+uint32_t TM1637_GetBusByteCount(void)
+{
+	return tm1637busbytecount;
+}
+/*****************************************************************************
+ * @brief Returns the number of display updates requested.
+ *
+ * @details Every TM1637_Update_Data_Dots() call, whether it sent anything
+ *          or not. Against TM1637_GetBusByteCount() it gives the bytes per
+ *          update; a full frame (data command, address, the digits and the
+ *          display command) is TM1637_FULL_FRAME_BYTES.
+ *
+ * @param None
+ *
+ * @return uint32_t Updates since boot.
+ *****************************************************************************/
+uint32_t TM1637_GetUpdateCount(void)
+{
+	return tm1637updatecount;
+}
+/*****************************************************************************
+ * @brief Measures the time to put a full frame on the display.
+ *
+ * @details Forces all four digits plus the display command to be sent
+ *          (7 bytes in 3 transfers) and measures from the call until the
+ *          bus is idle again, on whichever backend is built. The display
+ *          shows 88:88 afterwards and is fully redrawn by the next update.
+ *
+ * @param[in] frames  Number of frames to average over.
+ *
+ * @return uint32_t Core cycles per frame.
+ *
+ * @note Build with TM1637_USE_DMA_BUS = 0 to time the bit-bang driver,
+ *       compare the result against a build of the previous release.
+ *
+ * @see TM1637_Update_Data_Dots()
+ *****************************************************************************/
+uint32_t TM1637_Benchmark(uint32_t frames)
+{
+	uint8_t digits[NO_OF_DISPLAY_DIGITS] = { 8, 8, 8, 8 };
+	uint32_t total = 0;
+
+	if(frames == 0U)
+	{
+		return 0;
+	}
+
+	for(uint32_t f = 0; f < frames; f++)
+	{
+		tm1637displayvalid = false;
+		uint32_t start = APP_CYCLE_COUNTER();
+		TM1637_Update_Data_Dots(digits, true);
+		while(TM1637_Bus_IsBusy())
+		{
+		}
+		total += APP_CYCLE_COUNTER() - start;
+	}
+
+	tm1637displayvalid = false;
+	return total / frames;
 }
 /*************************************END*************************************/
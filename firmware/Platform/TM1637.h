@@ -42,6 +42,7 @@ extern "C"
 /* Include Files                                                             */
 /*****************************************************************************/
 #include "Platform_Translate.h"
+#include "TM1637_Bus.h"
 
 /*****************************************************************************/
 /* TM1637 Macros                                                             */
@@ -54,6 +55,29 @@ extern "C"
  */
 #define MAX_NO_OF_CHARACTERS                 6
 
+/**
+ * @brief Number of digits fitted on the display module.
+ *
+ * @note The TM1637 drives up to 6 digits, the module used here has 4.
+ */
+#define NO_OF_DISPLAY_DIGITS                 4
+
+/**
+ * @brief Bytes of a full frame: data command, address, the digits and the
+ *        display command.
+ */
+#define TM1637_FULL_FRAME_BYTES              (3 + NO_OF_DISPLAY_DIGITS)
+
+/**
+ * @brief Digit whose dot segment drives the MM:SS colon on the module.
+ */
+#define TM1637_COLON_DIGIT                   1
+
+/**
+ * @brief Digit value that shows a dash ('-') instead of a number.
+ */
+#define TM1637_DIGIT_DASH                    10
+
 /**
  * @brief Number of digits used for numeric display (e.g., time MM:SS).
  *
@@ -186,11 +210,16 @@ extern "C"
 /*****************************************************************************/
 
 /**
- * @brief Generates an approximate delay in microseconds.
+ * @brief Initializes the TM1637 bus (DMA engine or bit-bang lines).
+ */
+void TM1637_Init(void);
+
+/**
+ * @brief Busy-waits for a number of microseconds on the DWT cycle counter.
  *
- * @param[in] time Number of microseconds (approximate).
+ * @param[in] time Number of microseconds.
  */
-void Delay_us(int time);
+void delay_Us(int time);
 
 /**
  * @brief Sends the start signal for TM1637 communication.
@@ -257,11 +286,43 @@ void TM1637_Convert_To_Digits(uint32_t values, uint8_t digits[4]);
 /**
  * @brief Updates display with values and enables/disables the dot/colon.
  *
+ * @details Only digits that differ from the last frame are sent.
+ *
  * @param[in] displayvalue Pointer to 4-byte digit array.
  * @param[in] status       true = show colon; false = hide colon.
  */
 void TM1637_Update_Data_Dots(uint8_t *displayvalue, uint8_t status);
 
+/**
+ * @brief Sets brightness and on/off, sent with the next update if changed.
+ *
+ * @param[in] displaycommand DISPLAY_COMMAND | PULSE_WIDTH_SET_xx_16 | DISPLAY_ON/OFF.
+ */
+void TM1637_SetDisplayControl(uint8_t displaycommand);
+
+/**
+ * @brief Number of bytes sent on the TM1637 bus since boot.
+ *
+ * @return Byte count.
+ */
+uint32_t TM1637_GetBusByteCount(void);
+
+/**
+ * @brief Number of TM1637_Update_Data_Dots() calls since boot.
+ *
+ * @return Update count.
+ */
+uint32_t TM1637_GetUpdateCount(void);
+
+/**
+ * @brief Core cycles to send one full frame (all digits and the display command).
+ *
+ * @param[in] frames Number of frames to average over.
+ *
+ * @return Cycles per frame.
+ */
+uint32_t TM1637_Benchmark(uint32_t frames);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,399 @@
+/**
+ * \file           TM1637_Bus.c
+ * \brief          TM1637 hardware timed bus engine source file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "TM1637_Bus.h"
+/*****************************************************************************/
+/* Private Defines                                                           */
+/*****************************************************************************/
+/**
+ * @brief One BSRR word driving both TM1637 lines to the given levels.
+ *
+ * @details The low half-word sets pins, the high half-word resets them, so
+ *          each slot fully defines CLK and DIO regardless of the previous one.
+ */
+#define TM1637_BUS_WORD(clk, dio)            ((uint32_t)(((clk) ? TM1637_CLK_PIN : ((uint32_t)TM1637_CLK_PIN << 16U)) | \
+                                                         ((dio) ? TM1637_DIO_PIN : ((uint32_t)TM1637_DIO_PIN << 16U))))
+
+/*****************************************************************************/
+/* Private Types                                                             */
+/*****************************************************************************/
+/**
+ * @brief Frame waiting for the bus, bytes of all transfers stored back to back.
+ */
+typedef struct
+{
+	uint8_t bytes[TM1637_BUS_MAX_BYTES];         /**< Transfer bytes */
+	uint8_t lengths[TM1637_BUS_MAX_TRANSFERS];   /**< Length of each transfer */
+	uint8_t count;                               /**< Number of transfers */
+	uint8_t used;                                /**< Number of bytes used */
+}TM1637_BusFrame_t;
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+#if TM1637_USE_DMA_BUS
+static uint32_t tm1637bustable[TM1637_BUS_TABLE_SIZE]; /** Waveform being clocked out by DMA **/
+
+static TM1637_BusFrame_t tm1637buspending; /** Frame queued behind the active one **/
+
+static volatile bool tm1637busactive = false; /** DMA transfer in progress **/
+
+static TM1637_BusCallback_t tm1637buscallback = NULL; /** Called when the bus goes idle **/
+
+static TIM_HandleTypeDef htim1; /** TIM1 paces the DMA, one update event per slot **/
+
+static DMA_HandleTypeDef hdma_tim1_up; /** DMA2 Stream5 Channel6 = TIM1_UP **/
+#endif
+
+/*****************************************************************************/
+/* TM1637 Bus Functions                                                      */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Encodes TM1637 transfers into a GPIO BSRR waveform table.
+ *
+ * @details Each table word is written to GPIOB->BSRR at one slot. Per transfer:
+ *          - start: CLK=1 DIO=1, then DIO=0 while CLK is high
+ *          - per bit (LSB first): CLK=0 with DIO=bit, then CLK=1
+ *          - ACK: CLK=0 DIO=0, CLK=1, CLK=0 (DIO is driven low so it never
+ *            fights the TM1637 pulling it low)
+ *          - stop: CLK=0 DIO=0, CLK=1, then DIO=1 while CLK is high
+ *
+ * @param[in]  transfers  Transfers to encode.
+ * @param[in]  count      Number of transfers.
+ * @param[out] table      Destination BSRR word table.
+ * @param[in]  tablesize  Capacity of table in words.
+ *
+ * @return uint16_t
+ *
+ * @retval 0      The table is too small, nothing written.
+ * @retval other  Number of words written.
+ *
+ * @note Pure function, no hardware access, so it can be checked on a host.
+ *****************************************************************************/
+uint16_t TM1637_Bus_Encode(const TM1637_Transfer_t *transfers, uint8_t count, uint32_t *table, uint16_t tablesize)
+{
+	uint32_t required = 0;
+	for(uint8_t t = 0; t < count; t++)
+	{
+		required += TM1637_BUS_START_WORDS + TM1637_BUS_STOP_WORDS + ((uint32_t)transfers[t].length * TM1637_BUS_BYTE_WORDS);
+	}
+	if((required == 0U) || (required > tablesize))
+	{
+		return 0;
+	}
+
+	uint16_t word = 0;
+	for(uint8_t t = 0; t < count; t++)
+	{
+		table[word++] = TM1637_BUS_WORD(1, 1);
+		table[word++] = TM1637_BUS_WORD(1, 0);
+
+		for(uint8_t b = 0; b < transfers[t].length; b++)
+		{
+			uint8_t byte = transfers[t].data[b];
+			for(uint8_t i = 0; i < 8U; i++)
+			{
+				table[word++] = TM1637_BUS_WORD(0, byte & 0x01U);
+				table[word++] = TM1637_BUS_WORD(1, byte & 0x01U);
+				byte = byte >> 1;
+			}
+			table[word++] = TM1637_BUS_WORD(0, 0);
+			table[word++] = TM1637_BUS_WORD(1, 0);
+			table[word++] = TM1637_BUS_WORD(0, 0);
+		}
+
+		table[word++] = TM1637_BUS_WORD(0, 0);
+		table[word++] = TM1637_BUS_WORD(1, 0);
+		table[word++] = TM1637_BUS_WORD(1, 1);
+	}
+	return word;
+}
+
+#if TM1637_USE_DMA_BUS
+/*****************************************************************************
+ * @brief Starts clocking out the first words of the waveform table.
+ *
+ * @param[in] words  Number of table words to send.
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+static void tm1637BusStart(uint16_t words)
+{
+	__HAL_TIM_SET_COUNTER(&htim1, 0);
+	__HAL_TIM_CLEAR_FLAG(&htim1, TIM_FLAG_UPDATE);
+	if(HAL_DMA_Start_IT(&hdma_tim1_up, (uint32_t)tm1637bustable, (uint32_t)&TM1637_GPIO_PORT->BSRR, words) != HAL_OK)
+	{
+		Error_Handler();
+	}
+	__HAL_TIM_ENABLE_DMA(&htim1, TIM_DMA_UPDATE);
+	__HAL_TIM_ENABLE(&htim1);
+}
+/*****************************************************************************
+ * @brief DMA transfer complete/error callback.
+ *
+ * @details Stops TIM1 and either starts the pending frame or marks the bus
+ *          idle and runs the completion callback.
+ *
+ * @param[in] hdma  DMA handle (unused).
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Runs in the DMA2 Stream5 interrupt.
+ *****************************************************************************/
+static void tm1637BusTransferDone(DMA_HandleTypeDef *hdma)
+{
+	(void)hdma;
+	__HAL_TIM_DISABLE(&htim1);
+	__HAL_TIM_DISABLE_DMA(&htim1, TIM_DMA_UPDATE);
+
+	if(tm1637buspending.count != 0U)
+	{
+		TM1637_Transfer_t transfers[TM1637_BUS_MAX_TRANSFERS];
+		const uint8_t *bytes = tm1637buspending.bytes;
+		for(uint8_t t = 0; t < tm1637buspending.count; t++)
+		{
+			transfers[t].data = bytes;
+			transfers[t].length = tm1637buspending.lengths[t];
+			bytes += tm1637buspending.lengths[t];
+		}
+		uint16_t words = TM1637_Bus_Encode(transfers, tm1637buspending.count, tm1637bustable, TM1637_BUS_TABLE_SIZE);
+		tm1637buspending.count = 0;
+		tm1637buspending.used = 0;
+		if(words != 0U)
+		{
+			tm1637BusStart(words);
+			return;
+		}
+	}
+
+	tm1637busactive = false;
+	if(tm1637buscallback != NULL)
+	{
+		tm1637buscallback();
+	}
+}
+/*****************************************************************************
+ * @brief Configures TIM1 and DMA2 Stream5 for the bus engine.
+ *
+ * @details TIM1 runs from the APB2 timer clock with one update event every
+ *          TM1637_BUS_SLOT_US; each update requests one DMA word transfer
+ *          from the waveform table to GPIOB->BSRR. DMA2 is used because only
+ *          its peripheral port reaches the AHB1 GPIO registers.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Call after SystemClock_Config() and MX_GPIO_Init().
+ *****************************************************************************/
+void TM1637_Bus_Init(void)
+{
+#if APP_LL_DRIVERS
+	uint32_t timerclock = LowLevel_TimerClock(TIM1);
+#else
+	uint32_t timerclock = HAL_RCC_GetPCLK2Freq();
+	if((RCC->CFGR & RCC_CFGR_PPRE2) != RCC_CFGR_PPRE2_DIV1)
+	{
+		timerclock *= 2U; /** APB2 timers run at twice PCLK2 when APB2 is divided **/
+	}
+#endif
+
+	__HAL_RCC_TIM1_CLK_ENABLE();
+	__HAL_RCC_DMA2_CLK_ENABLE();
+
+	htim1.Instance = TIM1;
+#if APP_LL_DRIVERS
+	LowLevel_TimerInit(TIM1, 0U, ((timerclock / 1000000U) * TM1637_BUS_SLOT_US) - 1U);
+#else
+	htim1.Init.Prescaler = 0;
+	htim1.Init.CounterMode = TIM_COUNTERMODE_UP;
+	htim1.Init.Period = ((timerclock / 1000000U) * TM1637_BUS_SLOT_US) - 1U;
+	htim1.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+	htim1.Init.RepetitionCounter = 0;
+	htim1.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+	if (HAL_TIM_Base_Init(&htim1) != HAL_OK)
+	{
+		Error_Handler();
+	}
+#endif
+
+	hdma_tim1_up.Instance = DMA2_Stream5;
+	hdma_tim1_up.Init.Channel = DMA_CHANNEL_6;
+	hdma_tim1_up.Init.Direction = DMA_MEMORY_TO_PERIPH;
+	hdma_tim1_up.Init.PeriphInc = DMA_PINC_DISABLE;
+	hdma_tim1_up.Init.MemInc = DMA_MINC_ENABLE;
+	hdma_tim1_up.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+	hdma_tim1_up.Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+	hdma_tim1_up.Init.Mode = DMA_NORMAL;
+	hdma_tim1_up.Init.Priority = DMA_PRIORITY_HIGH;
+	hdma_tim1_up.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+	if (HAL_DMA_Init(&hdma_tim1_up) != HAL_OK)
+	{
+		Error_Handler();
+	}
+	hdma_tim1_up.XferCpltCallback = tm1637BusTransferDone;
+	hdma_tim1_up.XferErrorCallback = tm1637BusTransferDone;
+
+	tm1637buspending.count = 0;
+	tm1637buspending.used = 0;
+	tm1637busactive = false;
+
+	HAL_NVIC_SetPriority(DMA2_Stream5_IRQn, 1, 0);
+	HAL_NVIC_EnableIRQ(DMA2_Stream5_IRQn);
+}
+/*****************************************************************************
+ * @brief Queues a frame for non-blocking transmission.
+ *
+ * @details If the bus is idle the frame is encoded and the DMA started right
+ *          away. Otherwise the bytes are copied behind the pending frame and
+ *          sent from the completion interrupt; the caller's buffers may be
+ *          reused as soon as this returns.
+ *
+ * @param[in] transfers  Transfers to send.
+ * @param[in] count      Number of transfers.
+ *
+ * @return bool
+ *
+ * @retval true   Frame accepted.
+ * @retval false  Frame does not fit in the table or behind the pending frame.
+ *
+ * @see TM1637_Bus_Encode(), TM1637_Bus_SetCompleteCallback()
+ *****************************************************************************/
+bool TM1637_Bus_Transmit(const TM1637_Transfer_t *transfers, uint8_t count)
+{
+	bool status = true;
+	bool startnow = false;
+
+	uint32_t irqstate = APP_IRQ_SAVE();
+	APP_IRQ_DISABLE();
+	if(tm1637busactive == false)
+	{
+		tm1637busactive = true; /** Claim the table, the DMA interrupt leaves it alone now **/
+		startnow = true;
+	}
+	else
+	{
+		uint8_t used = tm1637buspending.used;
+		uint8_t pendingcount = tm1637buspending.count;
+		for(uint8_t t = 0; (t < count) && status; t++)
+		{
+			if((pendingcount >= TM1637_BUS_MAX_TRANSFERS) || ((used + transfers[t].length) > TM1637_BUS_MAX_BYTES))
+			{
+				status = false;
+			}
+			else
+			{
+				memcpy(&tm1637buspending.bytes[used], transfers[t].data, transfers[t].length);
+				tm1637buspending.lengths[pendingcount++] = transfers[t].length;
+				used += transfers[t].length;
+			}
+		}
+		if(status)
+		{
+			tm1637buspending.used = used;
+			tm1637buspending.count = pendingcount;
+		}
+	}
+	APP_IRQ_RESTORE(irqstate);
+
+	if(startnow)
+	{
+		uint16_t words = TM1637_Bus_Encode(transfers, count, tm1637bustable, TM1637_BUS_TABLE_SIZE);
+		if(words == 0U)
+		{
+			tm1637busactive = false;
+			status = false;
+		}
+		else
+		{
+			tm1637BusStart(words);
+		}
+	}
+	return status;
+}
+/*****************************************************************************
+ * @brief Registers the bus idle callback.
+ *
+ * @param[in] callback  Function called from the DMA interrupt, or NULL.
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+void TM1637_Bus_SetCompleteCallback(TM1637_BusCallback_t callback)
+{
+	tm1637buscallback = callback;
+}
+/*****************************************************************************
+ * @brief DMA2 Stream5 interrupt entry.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Called from DMA2_Stream5_IRQHandler().
+ *****************************************************************************/
+void TM1637_Bus_IRQHandler(void)
+{
+	HAL_DMA_IRQHandler(&hdma_tim1_up);
+}
+#endif /* TM1637_USE_DMA_BUS */
+/*****************************************************************************
+ * @brief Checks whether the bus is busy.
+ *
+ * @param None
+ *
+ * @return bool
+ *
+ * @retval true   A frame is being sent or pending.
+ * @retval false  Bus idle, CLK and DIO high (always with the bit-bang driver).
+ *****************************************************************************/
+bool TM1637_Bus_IsBusy(void)
+{
+#if TM1637_USE_DMA_BUS
+	return tm1637busactive;
+#else
+	return false;
+#endif
+}
+/*************************************END*************************************/
@@ -0,0 +1,155 @@
+/**
+ * \file           TM1637_Bus.h
+ * \brief          TM1637 hardware timed bus engine header file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+#ifndef TM1637_BUS_H_
+#define TM1637_BUS_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "Platform_Translate.h"
+
+/*****************************************************************************/
+/* TM1637 Bus Macros                                                         */
+/*****************************************************************************/
+
+/**
+ * @brief Maximum number of start/stop transfers in one frame.
+ */
+#define TM1637_BUS_MAX_TRANSFERS             8U
+
+/**
+ * @brief Maximum number of bytes in one frame over all transfers.
+ */
+#define TM1637_BUS_MAX_BYTES                 16U
+
+/**
+ * @brief BSRR words needed for the start condition of a transfer.
+ */
+#define TM1637_BUS_START_WORDS               2U
+
+/**
+ * @brief BSRR words needed for one byte including the ACK clock.
+ */
+#define TM1637_BUS_BYTE_WORDS                19U
+
+/**
+ * @brief BSRR words needed for the stop condition of a transfer.
+ */
+#define TM1637_BUS_STOP_WORDS                3U
+
+/**
+ * @brief Size of the BSRR waveform table in words.
+ *
+ * @note Large enough for TM1637_BUS_MAX_TRANSFERS transfers carrying
+ *       TM1637_BUS_MAX_BYTES bytes in total.
+ */
+#define TM1637_BUS_TABLE_SIZE                ((TM1637_BUS_MAX_TRANSFERS * (TM1637_BUS_START_WORDS + TM1637_BUS_STOP_WORDS)) + \
+                                              (TM1637_BUS_MAX_BYTES * TM1637_BUS_BYTE_WORDS))
+
+/*****************************************************************************/
+/* TM1637 Bus Types                                                          */
+/*****************************************************************************/
+
+/**
+ * @brief One TM1637 transfer: start condition, bytes (each ACKed), stop condition.
+ */
+typedef struct
+{
+	const uint8_t *data;    /**< Bytes to send, LSB first on the wire */
+	uint8_t length;         /**< Number of bytes */
+}TM1637_Transfer_t;
+
+/**
+ * @brief Called from the DMA interrupt when the bus becomes idle.
+ */
+typedef void (*TM1637_BusCallback_t)(void);
+
+/*****************************************************************************/
+/* TM1637 Bus Function Declarations                                          */
+/*****************************************************************************/
+
+/**
+ * @brief Encodes transfers into a GPIO BSRR waveform table.
+ *
+ * @param[in]  transfers  Transfers to encode.
+ * @param[in]  count      Number of transfers.
+ * @param[out] table      BSRR word table, one word per bus slot.
+ * @param[in]  tablesize  Capacity of table in words.
+ *
+ * @return Number of words written, 0 if the table is too small.
+ */
+uint16_t TM1637_Bus_Encode(const TM1637_Transfer_t *transfers, uint8_t count, uint32_t *table, uint16_t tablesize);
+
+/**
+ * @brief Configures TIM1 and DMA2 Stream5 for the bus engine.
+ */
+void TM1637_Bus_Init(void);
+
+/**
+ * @brief Queues a frame of transfers for non-blocking transmission.
+ *
+ * @param[in] transfers  Transfers to send.
+ * @param[in] count      Number of transfers.
+ *
+ * @return true if accepted, false if it does not fit behind the pending frame.
+ */
+bool TM1637_Bus_Transmit(const TM1637_Transfer_t *transfers, uint8_t count);
+
+/**
+ * @brief Checks whether a frame is being clocked out or pending.
+ *
+ * @return true while the bus is busy.
+ */
+bool TM1637_Bus_IsBusy(void);
+
+/**
+ * @brief Registers the callback run when the bus becomes idle.
+ *
+ * @param[in] callback  Function to call, NULL to disable.
+ */
+void TM1637_Bus_SetCompleteCallback(TM1637_BusCallback_t callback);
+
+/**
+ * @brief DMA2 Stream5 interrupt entry of the bus engine.
+ */
+void TM1637_Bus_IRQHandler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TM1637_BUS_H_ */
@@ -0,0 +1,244 @@
+/**
+ * \file           batteryadc.c
+ * \brief          Battery voltage ADC burst driver source file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "batteryadc.h"
+/*****************************************************************************/
+/* Private Defines                                                           */
+/*****************************************************************************/
+#define BATTERYADC_VREFINT_CAL_ADDR   ((const uint16_t *)0x1FFF7A2AU)   /** VREFINT at 30 C, VDDA = 3.3 V **/
+#define BATTERYADC_CHANNEL_VREFINT    17U                               /** ADC1_IN17 **/
+#define BATTERYADC_CHANNEL_BATTERY    4U                                /** ADC1_IN4 = PA4 **/
+#define BATTERYADC_SMP_480            7U                                /** 480 cycle sample time, VREFINT needs 10 us **/
+#define BATTERYADC_EXTSEL_TIM2_TRGO   (ADC_CR2_EXTSEL_1 | ADC_CR2_EXTSEL_2)   /** EXTSEL = 0110 **/
+#define BATTERYADC_TIMER_TICK_HZ      1000000U                          /** TIM2 counts microseconds **/
+#define BATTERYADC_DMA_FLAGS          (DMA_LIFCR_CTCIF0 | DMA_LIFCR_CHTIF0 | DMA_LIFCR_CTEIF0 | \
+                                       DMA_LIFCR_CDMEIF0 | DMA_LIFCR_CFEIF0)   /** All stream 0 flags **/
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static BatteryAdcSample_t batteryadcburst[BATTERYADC_BURST_LENGTH]; /** DMA target, one pair per trigger **/
+
+static volatile bool batteryadcbusy = false; /** Burst running **/
+
+/*****************************************************************************/
+/* Private Functions                                                         */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Ends a burst and removes the clocks of ADC1 and TIM2.
+ *
+ * @details The ADC is switched off together with the VREFINT buffer, so
+ *          nothing of the measurement draws current between two bursts.
+ *****************************************************************************/
+static void batteryAdcOff(void)
+{
+	TIM2->CR1 &= ~TIM_CR1_CEN;
+	TIM2->CNT = 0;
+	DMA2_Stream0->CR &= ~DMA_SxCR_EN;
+	ADC1->CR2 = 0;
+	ADC1->SR = 0;
+	ADC1_COMMON->CCR &= ~ADC_CCR_TSVREFE;
+
+	__HAL_RCC_TIM2_CLK_DISABLE();
+	__HAL_RCC_ADC1_CLK_DISABLE();
+	batteryadcbusy = false;
+}
+
+/*****************************************************************************/
+/* Battery ADC Functions                                                     */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Prepares the battery input, the trigger timer and the DMA stream.
+ *
+ * @details PA4 becomes an analog input. TIM2 is set up to overflow at
+ *          BATTERYADC_TRIGGER_HZ with the update event as TRGO, the
+ *          prescaler is loaded here once so the first trigger of every
+ *          burst comes a full period after the start, which is also the
+ *          VREFINT start-up time. DMA2 stream 0 channel 0 moves ADC1_DR
+ *          into the burst buffer.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Call once after SystemClock_Config(); TIM2 and ADC1 keep their
+ *       register contents while their clocks are off.
+ *
+ * @see BatteryAdc_Start()
+ *****************************************************************************/
+void BatteryAdc_Init(void)
+{
+	GPIO_InitTypeDef GPIO_InitStruct = {0};
+	uint32_t timerclock = HAL_RCC_GetPCLK1Freq();
+	if((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1)
+	{
+		timerclock *= 2U; /** APB1 timers run at twice PCLK1 when APB1 is divided **/
+	}
+
+	__HAL_RCC_GPIOA_CLK_ENABLE();
+	GPIO_InitStruct.Pin = GPIO_PIN_4;
+	GPIO_InitStruct.Mode = GPIO_MODE_ANALOG;
+	GPIO_InitStruct.Pull = GPIO_NOPULL;
+	HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+	__HAL_RCC_TIM2_CLK_ENABLE();
+	TIM2->CR1 = 0;
+	TIM2->PSC = (timerclock / BATTERYADC_TIMER_TICK_HZ) - 1U;
+	TIM2->ARR = (BATTERYADC_TIMER_TICK_HZ / BATTERYADC_TRIGGER_HZ) - 1U;
+	TIM2->CR2 = TIM_CR2_MMS_1; /** TRGO on update **/
+	TIM2->EGR = TIM_EGR_UG;    /** Load PSC now, the ADC is off **/
+	TIM2->SR = 0;
+	TIM2->CNT = 0;
+
+	__HAL_RCC_DMA2_CLK_ENABLE();
+	DMA2_Stream0->CR = 0;
+	DMA2->LIFCR = BATTERYADC_DMA_FLAGS;
+	DMA2_Stream0->PAR = (uint32_t)&ADC1->DR;
+	DMA2_Stream0->M0AR = (uint32_t)batteryadcburst;
+	DMA2_Stream0->FCR = 0; /** Direct mode **/
+
+	__HAL_RCC_TIM2_CLK_DISABLE();
+	batteryadcbusy = false;
+
+	HAL_NVIC_SetPriority(DMA2_Stream0_IRQn, 1, 0);
+	HAL_NVIC_EnableIRQ(DMA2_Stream0_IRQn);
+}
+/*****************************************************************************
+ * @brief Starts one burst.
+ *
+ * @details ADC1 scans VREFINT then PA4 on each TIM2 trigger, both with the
+ *          longest sample time so the high impedance divider and its
+ *          capacitor are sampled correctly. The DMA stops after
+ *          BATTERYADC_BURST_LENGTH pairs and its transfer complete interrupt
+ *          ends the burst. ADC clock is PCLK2 / 4 = 18 MHz.
+ *
+ * @param None
+ *
+ * @return bool
+ *
+ * @retval true   Burst started.
+ * @retval false  The previous burst is still running.
+ *
+ * @note About 1 ms of ADC and core sleep current per burst. The MCU must
+ *       not enter STOP until BatteryAdc_IsBusy() is false.
+ *****************************************************************************/
+bool BatteryAdc_Start(void)
+{
+	if(batteryadcbusy)
+	{
+		return false;
+	}
+	batteryadcbusy = true;
+
+	__HAL_RCC_ADC1_CLK_ENABLE();
+	__HAL_RCC_TIM2_CLK_ENABLE();
+
+	ADC1_COMMON->CCR = ADC_CCR_ADCPRE_0 | ADC_CCR_TSVREFE;
+	ADC1->SR = 0;
+	ADC1->CR1 = ADC_CR1_SCAN;
+	ADC1->SMPR1 = BATTERYADC_SMP_480 << ADC_SMPR1_SMP17_Pos;
+	ADC1->SMPR2 = BATTERYADC_SMP_480 << ADC_SMPR2_SMP4_Pos;
+	ADC1->SQR1 = (2U - 1U) << ADC_SQR1_L_Pos;
+	ADC1->SQR3 = (BATTERYADC_CHANNEL_VREFINT << ADC_SQR3_SQ1_Pos) |
+	             (BATTERYADC_CHANNEL_BATTERY << ADC_SQR3_SQ2_Pos);
+	ADC1->CR2 = ADC_CR2_EXTEN_0 | BATTERYADC_EXTSEL_TIM2_TRGO | ADC_CR2_DMA | ADC_CR2_ADON;
+
+	DMA2->LIFCR = BATTERYADC_DMA_FLAGS;
+	DMA2_Stream0->NDTR = BATTERYADC_BURST_LENGTH * 2U;
+	DMA2_Stream0->CR = DMA_SxCR_MSIZE_0 | DMA_SxCR_PSIZE_0 | DMA_SxCR_MINC |
+	                   DMA_SxCR_TCIE | DMA_SxCR_TEIE | DMA_SxCR_EN; /** Channel 0, peripheral to memory **/
+
+	TIM2->CNT = 0;
+	TIM2->CR1 = TIM_CR1_CEN;
+	return true;
+}
+/*****************************************************************************
+ * @brief Tells whether a burst is running.
+ *
+ * @return bool
+ *
+ * @retval true   Converting, the PLL clocks are needed.
+ * @retval false  Idle.
+ *****************************************************************************/
+bool BatteryAdc_IsBusy(void)
+{
+	return batteryadcbusy;
+}
+/*****************************************************************************
+ * @brief Returns the samples of the last completed burst.
+ *
+ * @return const BatteryAdcSample_t * BATTERYADC_BURST_LENGTH pairs.
+ *
+ * @note Only valid between the completion of a burst and the next
+ *       BatteryAdc_Start().
+ *****************************************************************************/
+const BatteryAdcSample_t *BatteryAdc_GetBurst(void)
+{
+	return batteryadcburst;
+}
+/*****************************************************************************
+ * @brief Returns the factory VREFINT calibration value.
+ *
+ * @return uint16_t ADC reading of VREFINT at VDDA = 3.3 V.
+ *****************************************************************************/
+uint16_t BatteryAdc_GetVrefintCal(void)
+{
+	return *BATTERYADC_VREFINT_CAL_ADDR;
+}
+/*****************************************************************************
+ * @brief Ends the burst on the DMA interrupt.
+ *
+ * @return bool
+ *
+ * @retval true   All pairs were transferred.
+ * @retval false  Transfer error, the burst is dropped.
+ *
+ * @note Called from DMA2_Stream0_IRQHandler().
+ *****************************************************************************/
+bool BatteryAdc_IRQHandler(void)
+{
+	uint32_t flags = DMA2->LISR;
+	DMA2->LIFCR = BATTERYADC_DMA_FLAGS;
+
+	if(batteryadcbusy == false)
+	{
+		return false;
+	}
+	batteryAdcOff();
+	return ((flags & DMA_LISR_TEIF0) == 0U) && ((flags & DMA_LISR_TCIF0) != 0U);
+}
+/*************************************END*************************************/
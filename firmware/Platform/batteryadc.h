@@ -0,0 +1,125 @@
+/**
+ * \file           batteryadc.h
+ * \brief          Battery voltage ADC burst driver header file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+#ifndef BATTERYADC_H_
+#define BATTERYADC_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "Platform_Translate.h"
+
+/*****************************************************************************/
+/* Battery ADC Macros                                                        */
+/*****************************************************************************/
+
+/**
+ * @brief Number of VREFINT/battery sample pairs in one burst.
+ */
+#define BATTERYADC_BURST_LENGTH              8U
+
+/**
+ * @brief Rate of the TIM2 trigger during a burst.
+ *
+ * @details One pair takes 2 x (480 + 12) ADC clocks = 55 us at 18 MHz, so a
+ *          burst is over after BATTERYADC_BURST_LENGTH x 100 us.
+ */
+#define BATTERYADC_TRIGGER_HZ                10000U
+
+/*****************************************************************************/
+/* Battery ADC Types                                                         */
+/*****************************************************************************/
+
+/**
+ * @brief One scan of the regular sequence, in DMA order.
+ */
+typedef struct
+{
+	uint16_t vrefint;   /**< ADC1_IN17, internal reference */
+	uint16_t battery;   /**< ADC1_IN4 (PA4), battery through the divider */
+}BatteryAdcSample_t;
+
+/*****************************************************************************/
+/* Battery ADC Function Declarations                                         */
+/*****************************************************************************/
+
+/**
+ * @brief Sets PA4 to analog and prepares TIM2 and DMA2 stream 0.
+ *
+ * @note ADC1 and TIM2 are only clocked during a burst.
+ */
+void BatteryAdc_Init(void);
+
+/**
+ * @brief Starts one burst of BATTERYADC_BURST_LENGTH sample pairs.
+ *
+ * @return true if started, false if a burst is still running.
+ */
+bool BatteryAdc_Start(void);
+
+/**
+ * @brief Tells whether a burst is running.
+ *
+ * @return true while converting; ADC1, TIM2 and the DMA stop in STOP mode.
+ */
+bool BatteryAdc_IsBusy(void);
+
+/**
+ * @brief Samples of the last completed burst.
+ *
+ * @return BATTERYADC_BURST_LENGTH pairs, overwritten by the next burst.
+ */
+const BatteryAdcSample_t *BatteryAdc_GetBurst(void);
+
+/**
+ * @brief Factory VREFINT reading at VDDA = 3.3 V.
+ *
+ * @return VREFINT_CAL from system memory.
+ */
+uint16_t BatteryAdc_GetVrefintCal(void);
+
+/**
+ * @brief DMA2 stream 0 interrupt handler, call from DMA2_Stream0_IRQHandler().
+ *
+ * @return true when a burst completed, false on a transfer error.
+ */
+bool BatteryAdc_IRQHandler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BATTERYADC_H_ */
@@ -0,0 +1,202 @@
+/**
+ * \file           bootstage.c
+ * \brief          Reset to first frame timestamps of the boot stages
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "bootstage.h"
+#include "tokenlog.h"
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static const char *const bootstagenames[BootStage_Count] =
+{
+	[BootStage_Main]       = "main",
+	[BootStage_Clock]      = "clock",
+	[BootStage_Drivers]    = "drivers",
+	[BootStage_Display]    = "display",
+	[BootStage_FirstFrame] = "frame",
+	[BootStage_Deferred]   = "deferred",
+};
+
+static uint32_t bootstagecycles[BootStage_Count]; /** Cycle counter at each mark, 0 at reset (SystemInit()) **/
+
+static uint32_t bootstageclock[BootStage_Count]; /** SystemCoreClock at each mark **/
+
+static uint32_t bootstagemarked = 0; /** Bit per marked BootStage_e **/
+
+/*****************************************************************************/
+/* Private Functions                                                         */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Converts a cycle count since reset into microseconds.
+ *
+ * @details Walks the marks before the given stage: every span between two
+ *          marks is converted at the clock seen at its first mark, the
+ *          span from reset to the first mark at the HSI. Each span may
+ *          wrap the 32-bit counter once, at 72 MHz that is 59 s.
+ *
+ * @param[in] cycles  Cycle counter value.
+ * @param[in] before  Marks from this stage on are not used.
+ *
+ * @return uint32_t Microseconds since reset.
+ *****************************************************************************/
+static uint32_t bootStageMicroseconds(uint32_t cycles, BootStage_e before)
+{
+	uint32_t microseconds = 0;
+	uint32_t base = 0;
+	uint32_t clock = HSI_VALUE;
+
+	for(uint32_t stage = 0; stage < (uint32_t)before; stage++)
+	{
+		if((bootstagemarked & (1UL << stage)) != 0U)
+		{
+			microseconds += (bootstagecycles[stage] - base) / (clock / 1000000U);
+			base = bootstagecycles[stage];
+			clock = bootstageclock[stage];
+		}
+	}
+	return microseconds + ((cycles - base) / (clock / 1000000U));
+}
+
+/*****************************************************************************/
+/* Boot Stage Functions                                                      */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Timestamps a boot stage.
+ *
+ * @details Keeps the cycle counter and SystemCoreClock. SystemInit() starts
+ *          the counter at 0 before the C runtime is set up, so the first
+ *          mark in main() already holds the startup code and the copy of
+ *          .data. Marking a stage again moves it and drops the marks of
+ *          the stages after it.
+ *
+ * @param[in] stage  Stage reached.
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+void BootStage_Mark(BootStage_e stage)
+{
+	if(stage >= BootStage_Count)
+	{
+		return;
+	}
+	bootstagecycles[stage] = APP_CYCLE_COUNTER();
+	bootstageclock[stage] = SystemCoreClock;
+	bootstagemarked = (bootstagemarked & ((1UL << stage) - 1U)) | (1UL << stage);
+}
+/*****************************************************************************
+ * @brief Microseconds from reset to a marked stage.
+ *
+ * @param[in] stage  Stage.
+ *
+ * @return uint32_t Microseconds, 0 if the stage was not marked.
+ *****************************************************************************/
+uint32_t BootStage_GetMicroseconds(BootStage_e stage)
+{
+	if((stage >= BootStage_Count) || ((bootstagemarked & (1UL << stage)) == 0U))
+	{
+		return 0;
+	}
+	return bootStageMicroseconds(bootstagecycles[stage], stage);
+}
+/*****************************************************************************
+ * @brief Microseconds from reset to now.
+ *
+ * @param None
+ *
+ * @return uint32_t Microseconds.
+ *
+ * @note Converted at the clock of the last mark, mark a change of the
+ *       clock before calling.
+ *****************************************************************************/
+uint32_t BootStage_GetElapsed(void)
+{
+	return bootStageMicroseconds(APP_CYCLE_COUNTER(), BootStage_Count);
+}
+/*****************************************************************************
+ * @brief Busy-waits until the given time after reset has passed.
+ *
+ * @details Returns at once when the boot is already past it, so a wait
+ *          for a device to power up only takes what is left of it.
+ *
+ * @param[in] microseconds  Time after reset.
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+void BootStage_WaitUntil(uint32_t microseconds)
+{
+	while(BootStage_GetElapsed() < microseconds)
+	{
+	}
+}
+/*****************************************************************************
+ * @brief Prints the marked stages through DEBUG_LOG().
+ *
+ * @details One line per marked stage with the time since reset and since
+ *          the previous mark, then the first frame against
+ *          APP_BOOT_FRAME_BUDGET_MS.
+ *
+ * @param None
+ *
+ * @return bool
+ *
+ * @retval true   First frame marked within the budget.
+ * @retval false  First frame late or not marked.
+ *****************************************************************************/
+bool BootStage_Report(void)
+{
+	uint32_t previous = 0;
+
+	for(uint32_t stage = 0; stage < (uint32_t)BootStage_Count; stage++)
+	{
+		if((bootstagemarked & (1UL << stage)) != 0U)
+		{
+			uint32_t microseconds = BootStage_GetMicroseconds((BootStage_e)stage);
+			DEBUG_LOG("boot: %s at %lu us, +%lu us\r\n", DEBUG_LOG_STRING(bootstagenames[stage]),
+					(unsigned long)microseconds, (unsigned long)(microseconds - previous));
+			previous = microseconds;
+		}
+	}
+
+	uint32_t frame = BootStage_GetMicroseconds(BootStage_FirstFrame);
+	bool within = (frame != 0U) && (frame <= (APP_BOOT_FRAME_BUDGET_MS * 1000U));
+	DEBUG_LOG("boot: first frame %lu us after reset (%s drivers), budget %lu ms%s\r\n", (unsigned long)frame,
+			DEBUG_LOG_STRING(APP_LL_DRIVERS ? "ll" : "hal"), (unsigned long)APP_BOOT_FRAME_BUDGET_MS,
+			DEBUG_LOG_STRING(within ? "" : ", OVER"));
+	return within;
+}
+/*************************************END*************************************/
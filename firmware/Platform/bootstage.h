@@ -0,0 +1,106 @@
+/**
+ * \file           bootstage.h
+ * \brief          Reset to first frame timestamps of the boot stages
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+#ifndef BOOTSTAGE_H_
+#define BOOTSTAGE_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "Platform_Translate.h"
+
+/*****************************************************************************/
+/* Boot Stage Enums                                                          */
+/*****************************************************************************/
+
+/**
+ * @brief Points of the boot from reset to userMain(), in boot order.
+ */
+typedef enum
+{
+	BootStage_Main,                   /**< main() entered, C runtime set up on the HSI */
+	BootStage_Clock,                  /**< PLL clock and SysTick running */
+	BootStage_Drivers,                /**< Reset cause read, GPIO and TIM3 set up */
+	BootStage_Display,                /**< TM1637 powered up, its bus ready */
+	BootStage_FirstFrame,             /**< First frame on the display */
+	BootStage_Deferred,               /**< Timers, RTC, LED, buzzer, ADC and watchdog started */
+	BootStage_Count,                  /**< Number of stages */
+}BootStage_e;
+
+/*****************************************************************************/
+/* Boot Stage Function Declarations                                          */
+/*****************************************************************************/
+
+/**
+ * @brief Timestamps a boot stage, at the current SystemCoreClock.
+ *
+ * @param[in] stage  Stage reached.
+ *
+ * @note Mark right after every change of the core clock, the time up to
+ *       the next mark is converted at the clock seen here.
+ */
+void BootStage_Mark(BootStage_e stage);
+
+/**
+ * @brief Microseconds from reset to a marked stage, 0 if it was not marked.
+ *
+ * @param[in] stage  Stage.
+ */
+uint32_t BootStage_GetMicroseconds(BootStage_e stage);
+
+/**
+ * @brief Microseconds from reset to now.
+ */
+uint32_t BootStage_GetElapsed(void);
+
+/**
+ * @brief Busy-waits until the given time after reset has passed.
+ *
+ * @param[in] microseconds  Time after reset.
+ */
+void BootStage_WaitUntil(uint32_t microseconds);
+
+/**
+ * @brief Prints the marked stages through DEBUG_LOG().
+ *
+ * @return true if the first frame was marked within APP_BOOT_FRAME_BUDGET_MS.
+ */
+bool BootStage_Report(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BOOTSTAGE_H_ */
@@ -37,11 +37,185 @@
 /*****************************************************************************/
 /* Private Variables                                                         */
 /*****************************************************************************/
+static HwTimer_t buzzertimer; /** One-shot timing the pattern steps **/
+
+static const BuzzerPattern_t *buzzerqueue[BUZZER_QUEUE_SIZE]; /** Patterns waiting to be played **/
+
+static uint8_t buzzerqueuehead = 0; /** Next free slot **/
+
+static uint8_t buzzerqueuetail = 0; /** Oldest queued pattern **/
+
+static const BuzzerPattern_t * volatile buzzercurrent = NULL; /** Pattern playing, NULL when silent **/
+
+static uint8_t buzzerstep = 0; /** Index of the step playing **/
+
+static uint8_t buzzerrepeat = 0; /** Repetitions left including the one playing **/
+
+/*****************************************************************************/
+/* Private Functions                                                         */
+/*****************************************************************************/
+static void buzzerStepExpired(HwTimer_t *timer);
+
+/*****************************************************************************
+ * @brief Starts the next queued pattern or goes silent.
+ *
+ * @note Called with interrupts masked or from the TIM4 interrupt.
+ *****************************************************************************/
+static void buzzerStartNext(void)
+{
+	while(buzzerqueuetail != buzzerqueuehead)
+	{
+		const BuzzerPattern_t *pattern = buzzerqueue[buzzerqueuetail];
+		buzzerqueuetail = (buzzerqueuetail + 1U) & (BUZZER_QUEUE_SIZE - 1U);
+
+		if((pattern->steps != NULL) && (pattern->steps[0] != 0U) && (pattern->repeat != 0U))
+		{
+			buzzercurrent = pattern;
+			buzzerstep = 0;
+			buzzerrepeat = pattern->repeat;
+			BUZZER_ON();
+			HwTimer_Start(&buzzertimer, pattern->steps[0], buzzerStepExpired);
+			return;
+		}
+	}
+
+	buzzercurrent = NULL;
+	BUZZER_OFF();
+}
+/*****************************************************************************
+ * @brief Advances the playing pattern by one step.
+ *
+ * @details Even steps switch the buzzer on, odd steps off. At the 0
+ *          terminator the pattern repeats or the next queued one starts.
+ *
+ * @note One-shot callback, runs in the TIM4 interrupt.
+ *****************************************************************************/
+static void buzzerStepExpired(HwTimer_t *timer)
+{
+	(void)timer;
+
+	if(buzzercurrent == NULL)
+	{
+		return;
+	}
+
+	buzzerstep++;
+	if(buzzercurrent->steps[buzzerstep] == 0U)
+	{
+		buzzerrepeat--;
+		if(buzzerrepeat == 0U)
+		{
+			buzzerStartNext();
+			return;
+		}
+		buzzerstep = 0;
+	}
+
+	if((buzzerstep & 1U) == 0U)
+	{
+		BUZZER_ON();
+	}
+	else
+	{
+		BUZZER_OFF();
+	}
+	HwTimer_Start(&buzzertimer, buzzercurrent->steps[buzzerstep], buzzerStepExpired);
+}
 
 /*****************************************************************************/
 /* Buzzer Functions                                                          */
 /*****************************************************************************/
+/*****************************************************************************
+ * @brief Initializes the buzzer pattern player.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @see Buzzer_Play()
+ *****************************************************************************/
+void Buzzer_Init(void)
+{
+	Buzzer_Stop();
+}
+/*****************************************************************************
+ * @brief Queues a beep pattern.
+ *
+ * @details The pattern is timed by a TIM4 one-shot, the call returns at once.
+ *          Patterns queued back to back play without a gap, so a long beep
+ *          and a cue can be chained.
+ *
+ * @param[in] pattern  Pattern to play, must stay valid until played.
+ *
+ * @return bool
+ *
+ * @retval true   Queued (or started).
+ * @retval false  Queue full, pattern dropped.
+ *
+ * @note Main loop only.
+ *
+ * @see Buzzer_Stop()
+ *****************************************************************************/
+bool Buzzer_Play(const BuzzerPattern_t *pattern)
+{
+	bool queued = false;
 
-/*************************************END*************************************/
+	if(pattern == NULL)
+	{
+		return false;
+	}
 
+	uint32_t irqstate = APP_IRQ_SAVE();
+	APP_IRQ_DISABLE();
+	uint8_t next = (buzzerqueuehead + 1U) & (BUZZER_QUEUE_SIZE - 1U);
+	if(next != buzzerqueuetail)
+	{
+		buzzerqueue[buzzerqueuehead] = pattern;
+		buzzerqueuehead = next;
+		queued = true;
+		if(buzzercurrent == NULL)
+		{
+			buzzerStartNext();
+		}
+	}
+	APP_IRQ_RESTORE(irqstate);
 
+	return queued;
+}
+/*****************************************************************************
+ * @brief Silences the buzzer and drops all queued patterns.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+void Buzzer_Stop(void)
+{
+	uint32_t irqstate = APP_IRQ_SAVE();
+	APP_IRQ_DISABLE();
+	HwTimer_Stop(&buzzertimer);
+	buzzerqueuehead = 0;
+	buzzerqueuetail = 0;
+	buzzercurrent = NULL;
+	BUZZER_OFF();
+	APP_IRQ_RESTORE(irqstate);
+}
+/*****************************************************************************
+ * @brief Tells whether a pattern is playing.
+ *
+ * @param None
+ *
+ * @return bool
+ *
+ * @retval true   Playing.
+ * @retval false  Silent.
+ *****************************************************************************/
+bool Buzzer_IsBusy(void)
+{
+	return (buzzercurrent != NULL);
+}
+/*************************************END*************************************/
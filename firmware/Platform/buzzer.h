@@ -41,18 +41,72 @@ extern "C"
 /* Include Files                                                             */
 /*****************************************************************************/
 #include "Platform_Translate.h"
+#include "hwtimer.h"
 
 /*****************************************************************************/
 /* Buzzer Macros                                                             */
 /*****************************************************************************/
 
+/**
+ * @brief Number of slots in the pattern queue.
+ *
+ * @note Must be a power of two. One slot is always kept free to tell a full
+ *       queue from an empty one.
+ */
+#define BUZZER_QUEUE_SIZE                    8U
+
+/*****************************************************************************/
+/* Buzzer Types                                                              */
+/*****************************************************************************/
+
+/**
+ * @brief Beep pattern.
+ *
+ * @details `steps` alternates on and off durations in milliseconds, starting
+ *          with on and terminated by 0, e.g. { 50, 50, 0 } is one short beep
+ *          followed by 50 ms of silence. The steps are played `repeat`
+ *          times; use an even number of steps when repeating.
+ */
+typedef struct
+{
+	const uint16_t *steps;   /**< On/off durations in ms, 0 terminated */
+	uint8_t repeat;          /**< Number of times the steps are played */
+}BuzzerPattern_t;
+
 /*****************************************************************************/
 /* Buzzer Function Declarations                                              */
 /*****************************************************************************/
 
+/**
+ * @brief Turns the buzzer off and empties the pattern queue.
+ *
+ * @note HwTimer_Init() must have been called.
+ */
+void Buzzer_Init(void);
+
+/**
+ * @brief Queues a pattern, it starts at once if nothing is playing.
+ *
+ * @param[in] pattern  Pattern to play, must stay valid until played.
+ *
+ * @return true if queued, false if the queue was full.
+ */
+bool Buzzer_Play(const BuzzerPattern_t *pattern);
+
+/**
+ * @brief Silences the buzzer and drops all queued patterns.
+ */
+void Buzzer_Stop(void);
+
+/**
+ * @brief Tells whether a pattern is playing.
+ *
+ * @return true while playing.
+ */
+bool Buzzer_IsBusy(void);
+
 #ifdef __cplusplus
 }
 #endif
 
-
 #endif /* BUZZER_H_ */
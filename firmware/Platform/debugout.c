@@ -0,0 +1,330 @@
+/**
+ * \file           debugout.c
+ * \brief          debugPrintf() output backend source file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "AppConfig.h"
+#if (APP_DEBUG_OUTPUT == APP_DEBUG_OUTPUT_UART)
+#include "stm32f4xx_hal.h"   /** UART/DMA handles; not main.h, StdUtil.h carries the weak default **/
+#include "debugout.h"
+#else
+#include "stm32f4xx.h"   /** ITM_SendChar(); not main.h, StdUtil.h carries the weak default **/
+#endif
+
+#if (APP_DEBUG_OUTPUT == APP_DEBUG_OUTPUT_ITM)
+/*****************************************************************************/
+/* Debug Output Functions                                                    */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Sends one debugPrintf() character to ITM stimulus port 0 (SWO).
+ *
+ * @details Overrides the weak stdUtil_putChar() of StdUtil.h. The character
+ *          is dropped when no debugger has enabled the ITM and port 0, so a
+ *          board without a probe attached does not block here.
+ *
+ * @param[in] c  Character to send.
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Enable SWV in the debug configuration with the core clock set to
+ *       the SystemCoreClock value and watch port 0 in the SWV ITM console.
+ *
+ * @see ITM_SendChar()
+ *****************************************************************************/
+void stdUtil_putChar(char c)
+{
+	(void)ITM_SendChar((uint32_t)(uint8_t)c);
+}
+#elif (APP_DEBUG_OUTPUT == APP_DEBUG_OUTPUT_UART)
+/*****************************************************************************/
+/* Private Defines                                                           */
+/*****************************************************************************/
+#define DEBUGOUT_RING_MASK       (APP_DEBUG_UART_BUFFER - 1U)   /** Index mask of the ring **/
+#define DEBUGOUT_IRQ_PRIORITY    15U                            /** Lowest, below every producer **/
+#define DEBUGOUT_DMA_CHANNEL     (4U << DMA_SxCR_CHSEL_Pos)     /** DMA1 stream 6 channel 4 = USART2_TX **/
+#define DEBUGOUT_DMA_FLAGS       (DMA_HIFCR_CTCIF6 | DMA_HIFCR_CHTIF6 | DMA_HIFCR_CTEIF6 | \
+                                  DMA_HIFCR_CDMEIF6 | DMA_HIFCR_CFEIF6)   /** All stream 6 flags **/
+
+#if (APP_DEBUG_UART_BUFFER & (APP_DEBUG_UART_BUFFER - 1)) || (APP_DEBUG_UART_BUFFER < 64)
+#error "APP_DEBUG_UART_BUFFER must be a power of two, at least 64"
+#endif
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static char debugoutring[APP_DEBUG_UART_BUFFER]; /** Transmit ring, the DMA reads it in place **/
+
+static volatile uint32_t debugoutreserved = 0; /** End of the reserved bytes, free running, written by producers **/
+
+static volatile uint32_t debugoutcommitted = 0; /** End of the completely copied bytes, free running **/
+
+static volatile uint32_t debugoutwriters = 0; /** Producers between reservation and commit, nested **/
+
+static volatile uint32_t debugouttail = 0; /** First byte not yet sent, free running, written by the interrupt **/
+
+static volatile uint32_t debugoutinflight = 0; /** Bytes of the running DMA transfer, 0 = idle **/
+
+static volatile DebugOutStats_t debugoutstats; /** Counters **/
+
+/*****************************************************************************/
+/* Debug Output Functions                                                    */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Sets up PA2, USART2 and DMA1 stream 6 for the debug output.
+ *
+ * @details PA2 becomes USART2_TX (AF7), 8N1 at APP_DEBUG_UART_BAUD with TX
+ *          only. DMA1 stream 6 channel 4 copies ring bytes into USART2_DR,
+ *          memory to peripheral, one contiguous span per transfer. Its
+ *          interrupt has the lowest priority, so a producer of any priority
+ *          can pend it.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Call after SystemClock_Config(); the baud rate divider is taken
+ *       from the PCLK1 frequency at that time.
+ *
+ * @see DebugOut_Write()
+ *****************************************************************************/
+void DebugOut_Init(void)
+{
+	GPIO_InitTypeDef GPIO_InitStruct = {0};
+	uint32_t pclk = HAL_RCC_GetPCLK1Freq();
+
+	__HAL_RCC_GPIOA_CLK_ENABLE();
+	GPIO_InitStruct.Pin = GPIO_PIN_2;
+	GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+	GPIO_InitStruct.Pull = GPIO_PULLUP;
+	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+	GPIO_InitStruct.Alternate = GPIO_AF7_USART2;
+	HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+	__HAL_RCC_USART2_CLK_ENABLE();
+	USART2->CR1 = 0;
+	USART2->CR2 = 0;
+	USART2->CR3 = USART_CR3_DMAT;
+	USART2->BRR = (pclk + (APP_DEBUG_UART_BAUD / 2U)) / APP_DEBUG_UART_BAUD; /** 16x oversampling, 4 bit fraction **/
+	USART2->CR1 = USART_CR1_UE | USART_CR1_TE;
+
+	__HAL_RCC_DMA1_CLK_ENABLE();
+	DMA1_Stream6->CR = 0;
+	DMA1->HIFCR = DEBUGOUT_DMA_FLAGS;
+	DMA1_Stream6->PAR = (uint32_t)&USART2->DR;
+	DMA1_Stream6->FCR = 0; /** Direct mode **/
+
+	debugoutreserved = 0;
+	debugoutcommitted = 0;
+	debugoutwriters = 0;
+	debugouttail = 0;
+	debugoutinflight = 0;
+	debugoutstats.sent = 0;
+	debugoutstats.dropped = 0;
+	debugoutstats.peak = 0;
+
+	HAL_NVIC_SetPriority(DMA1_Stream6_IRQn, DEBUGOUT_IRQ_PRIORITY, 0);
+	HAL_NVIC_EnableIRQ(DMA1_Stream6_IRQn);
+}
+/*****************************************************************************
+ * @brief Queues a message for transmission.
+ *
+ * @details The space is reserved with interrupts masked for a handful of
+ *          instructions, as in eventQueue_Post(); the copy runs with
+ *          interrupts enabled. A producer interrupting another one finishes
+ *          first, so the bytes are released to the DMA when the outermost
+ *          producer commits and nothing half copied is ever sent. The DMA
+ *          interrupt is then pended to start a transfer, the caller never
+ *          waits for the line.
+ *
+ * @param[in] data    Bytes to send.
+ * @param[in] length  Number of bytes.
+ *
+ * @return bool
+ *
+ * @retval true   Queued.
+ * @retval false  Not enough free space, the message is dropped and counted.
+ *****************************************************************************/
+bool DebugOut_Write(const char *data, uint32_t length)
+{
+	uint32_t start;
+	uint32_t used;
+	uint32_t irqstate;
+
+	if(length == 0U)
+	{
+		return true;
+	}
+
+	irqstate = __get_PRIMASK(); /** APP_IRQ_SAVE(), Platform_Translate.h pulls in StdUtil.h **/
+	__disable_irq();
+	start = debugoutreserved;
+	used = start - debugouttail;
+	if((APP_DEBUG_UART_BUFFER - used) < length)
+	{
+		debugoutstats.dropped += length;
+		__set_PRIMASK(irqstate);
+		return false;
+	}
+	debugoutreserved = start + length;
+	debugoutwriters++;
+	if((used + length) > debugoutstats.peak)
+	{
+		debugoutstats.peak = used + length;
+	}
+	__set_PRIMASK(irqstate);
+
+	for(uint32_t i = 0; i < length; i++)
+	{
+		debugoutring[(start + i) & DEBUGOUT_RING_MASK] = data[i];
+	}
+
+	irqstate = __get_PRIMASK();
+	__disable_irq();
+	if(--debugoutwriters == 0U)
+	{
+		debugoutcommitted = debugoutreserved;
+	}
+	__set_PRIMASK(irqstate);
+
+	NVIC_SetPendingIRQ(DMA1_Stream6_IRQn);
+	return true;
+}
+/*****************************************************************************
+ * @brief Tells whether bytes are still queued or on the line.
+ *
+ * @return bool
+ *
+ * @retval true   Transmitting, the PLL clocks are needed.
+ * @retval false  Ring empty and the last stop bit sent.
+ *****************************************************************************/
+bool DebugOut_IsBusy(void)
+{
+	return (debugoutinflight != 0U) || (debugoutcommitted != debugouttail) ||
+			((USART2->SR & USART_SR_TC) == 0U);
+}
+/*****************************************************************************
+ * @brief Returns the counters since DebugOut_Init().
+ *
+ * @param[out] stats  Counters.
+ *
+ * @return None
+ *****************************************************************************/
+void DebugOut_GetStats(DebugOutStats_t *stats)
+{
+	stats->sent = debugoutstats.sent;
+	stats->dropped = debugoutstats.dropped;
+	stats->peak = debugoutstats.peak;
+}
+/*****************************************************************************
+ * @brief Retires the finished transfer and starts the next span.
+ *
+ * @details Runs on the transfer complete interrupt and whenever a producer
+ *          pends it. The span ends at the committed bytes or at the end of
+ *          the ring, whichever comes first; the wrapped part follows with
+ *          the next transfer.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @note Called from DMA1_Stream6_IRQHandler(), the only consumer.
+ *****************************************************************************/
+void DebugOut_IRQHandler(void)
+{
+	uint32_t tail = debugouttail;
+	uint32_t pending;
+	uint32_t span;
+
+	if(debugoutinflight != 0U)
+	{
+		if((DMA1_Stream6->CR & DMA_SxCR_EN) != 0U)
+		{
+			return; /** Pended by a producer during a transfer **/
+		}
+		tail += debugoutinflight;
+		debugouttail = tail;
+		debugoutinflight = 0;
+	}
+	DMA1->HIFCR = DEBUGOUT_DMA_FLAGS;
+
+	pending = debugoutcommitted - tail;
+	if(pending == 0U)
+	{
+		return;
+	}
+	span = APP_DEBUG_UART_BUFFER - (tail & DEBUGOUT_RING_MASK);
+	span = (pending < span) ? pending : span;
+
+	debugoutinflight = span;
+	debugoutstats.sent += span;
+	DMA1_Stream6->M0AR = (uint32_t)&debugoutring[tail & DEBUGOUT_RING_MASK];
+	DMA1_Stream6->NDTR = span;
+	USART2->SR = ~USART_SR_TC; /** TC is cleared by writing 0 **/
+	DMA1_Stream6->CR = DEBUGOUT_DMA_CHANNEL | DMA_SxCR_DIR_0 | DMA_SxCR_MINC |
+	                   DMA_SxCR_TCIE | DMA_SxCR_TEIE | DMA_SxCR_EN; /** Bytes, memory to peripheral **/
+}
+/*****************************************************************************
+ * @brief Queues one debugPrintf() block on USART2.
+ *
+ * @details Overrides the weak stdUtil_write() of StdUtil.h, so a whole
+ *          message takes one reservation.
+ *
+ * @param[in] data    Characters to send.
+ * @param[in] length  Number of characters.
+ *
+ * @return None
+ *
+ * @see DebugOut_Write()
+ *****************************************************************************/
+void stdUtil_write(const char *data, uint32_t length)
+{
+	(void)DebugOut_Write(data, length);
+}
+/*****************************************************************************
+ * @brief Queues one character on USART2.
+ *
+ * @details Overrides the weak stdUtil_putChar() of StdUtil.h.
+ *
+ * @param[in] c  Character to send.
+ *
+ * @return None
+ *****************************************************************************/
+void stdUtil_putChar(char c)
+{
+	(void)DebugOut_Write(&c, 1U);
+}
+#endif
+/*************************************END*************************************/
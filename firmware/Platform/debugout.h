@@ -0,0 +1,105 @@
+/**
+ * \file           debugout.h
+ * \brief          debugPrintf() output backend header file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+#ifndef DEBUGOUT_H_
+#define DEBUGOUT_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include <stdbool.h>
+#include <stdint.h>
+#include "AppConfig.h"   /** Not main.h, the backend defines the weak StdUtil.h functions **/
+
+#if (APP_DEBUG_OUTPUT == APP_DEBUG_OUTPUT_UART)
+/*****************************************************************************/
+/* Debug Output Structures                                                   */
+/*****************************************************************************/
+
+/**
+ * @brief Counters of the USART2 output.
+ */
+typedef struct
+{
+	uint32_t sent;                    /**< Bytes handed to the DMA */
+	uint32_t dropped;                 /**< Bytes of messages dropped, ring full */
+	uint32_t peak;                    /**< Highest ring fill in bytes */
+}DebugOutStats_t;
+
+/*****************************************************************************/
+/* Debug Output Function Declarations                                        */
+/*****************************************************************************/
+
+/**
+ * @brief Sets up PA2, USART2 and DMA1 stream 6 for the debug output.
+ */
+void DebugOut_Init(void);
+
+/**
+ * @brief Queues a message for transmission, from any context.
+ *
+ * @param[in] data    Bytes to send.
+ * @param[in] length  Number of bytes.
+ *
+ * @return false if the ring is full; the whole message is dropped and counted.
+ */
+bool DebugOut_Write(const char *data, uint32_t length);
+
+/**
+ * @brief Tells whether bytes are still queued or on the line.
+ *
+ * @return true while USART2 or the DMA are needed, STOP mode would halt them.
+ */
+bool DebugOut_IsBusy(void);
+
+/**
+ * @brief Counters since DebugOut_Init().
+ *
+ * @param[out] stats  Counters.
+ */
+void DebugOut_GetStats(DebugOutStats_t *stats);
+
+/**
+ * @brief DMA1 stream 6 interrupt handler, call from DMA1_Stream6_IRQHandler().
+ */
+void DebugOut_IRQHandler(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DEBUGOUT_H_ */
@@ -0,0 +1,474 @@
+/**
+ * \file           faultcapture.c
+ * \brief          Fault capture kept over reset source file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include <stddef.h>
+#include <string.h>
+#include "faultcapture.h"
+#include "power.h"   /** APP_FAULT_PARK() **/
+#include "tokenlog.h"
+
+/*****************************************************************************/
+/* Private Macros                                                            */
+/*****************************************************************************/
+
+/**
+ * @brief 1 to define the Cortex-M fault handlers here (not generated by
+ *        CubeMX, see pomodor-timer.ioc). A host build sets 0.
+ */
+#ifndef FAULTCAPTURE_HANDLERS
+#define FAULTCAPTURE_HANDLERS                1
+#endif
+
+/**
+ * @brief Magic of the counters kept over the reset ("FCNT").
+ */
+#define FAULTCAPTURE_STATE_MAGIC             0x544E4346U
+
+/*****************************************************************************/
+/* Private Types                                                             */
+/*****************************************************************************/
+
+/**
+ * @brief Everything kept in .noinit RAM.
+ *
+ * @details The startup code neither copies nor clears .noinit, so a reset
+ *          keeps it and a power-up leaves random bytes. The counters carry
+ *          a check word, the record its magic and CRC.
+ */
+typedef struct
+{
+	uint32_t magic;                   /**< FAULTCAPTURE_STATE_MAGIC */
+	uint32_t count;                   /**< Faults since power-up */
+	uint32_t inarow;                  /**< Faults with less than APP_FAULT_STABLE_SECONDS of running between them */
+	uint32_t check;                   /**< ~(magic ^ count ^ inarow) */
+	uint32_t uptime;                  /**< Seconds since boot */
+	uint8_t mode;                     /**< Last FaultCapture_SetMode() */
+	uint8_t next;                     /**< Next history entry */
+	uint8_t events;                   /**< Valid history entries */
+	uint8_t history[FAULTCAPTURE_HISTORY]; /**< Ring of the last events */
+	FaultRecord_t record;             /**< Last fault */
+}FaultCapture_t;
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static FaultCapture_t faultcapture __attribute__((section(".noinit"))); /** Kept over the reset **/
+
+/*****************************************************************************/
+/* Private Functions                                                         */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Check word of the counters.
+ *
+ * @param None
+ *
+ * @return uint32_t Check word.
+ *****************************************************************************/
+static inline uint32_t faultCaptureCheck(void)
+{
+	return ~(faultcapture.magic ^ faultcapture.count ^ faultcapture.inarow);
+}
+/*****************************************************************************
+ * @brief CRC of a record, every byte after magic.
+ *
+ * @param[in] record  Record.
+ *
+ * @return uint32_t CRC-32.
+ *****************************************************************************/
+static uint32_t faultCaptureCrc(const FaultRecord_t *record)
+{
+	return ~stdUtil_crc32(STDUTIL_CRC32_INIT, &record->cause,
+			(uint32_t)(offsetof(FaultRecord_t, crc) - offsetof(FaultRecord_t, cause)));
+}
+/*****************************************************************************
+ * @brief Whether the record holds a fault.
+ *
+ * @param None
+ *
+ * @return bool true for a new or reported record with a good CRC.
+ *****************************************************************************/
+static bool faultCaptureIsValid(void)
+{
+	const FaultRecord_t *record = &faultcapture.record;
+
+	if((record->magic != FAULTCAPTURE_MAGIC_NEW) && (record->magic != FAULTCAPTURE_MAGIC_REPORTED))
+	{
+		return false;
+	}
+	return (record->crc == faultCaptureCrc(record));
+}
+/*****************************************************************************
+ * @brief Fills the record, counts the fault and resets.
+ *
+ * @details Runs in the fault handler on whatever stack is left, so it only
+ *          copies words and takes no locks. After APP_FAULT_RESET_LIMIT
+ *          faults in a row the MCU is parked in STANDBY instead of
+ *          rebooting for ever. STANDBY does not keep SRAM: the record and
+ *          the counters are lost and the wake-up starts as a power-up.
+ *
+ * @param[in] cause      Fault cause.
+ * @param[in] frame      Stacked registers, NULL if there are none.
+ * @param[in] excReturn  EXC_RETURN, 0 if there is none.
+ * @param[in] pc         Program counter to keep when frame is NULL.
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+static void __attribute__((noreturn)) faultCaptureRecord(FaultCause_e cause, const uint32_t *frame, uint32_t excReturn, uint32_t pc)
+{
+	FaultRecord_t *record = &faultcapture.record;
+
+	APP_IRQ_DISABLE();
+
+	memset(record, 0, sizeof(*record));
+	record->cause = (uint8_t)cause;
+	record->mode = faultcapture.mode;
+	if((frame != NULL) && ((((uintptr_t)frame) & 3U) == 0U) &&
+	   APP_RAM_CONTAINS(frame, FaultFrame_Count * sizeof(uint32_t)))
+	{
+		memcpy(record->frame, frame, sizeof(record->frame));
+		record->frameValid = 1U;
+	}
+	else
+	{
+		record->frame[FaultFrame_Pc] = pc;
+	}
+	record->sp = (uint32_t)(uintptr_t)frame;
+	record->excReturn = excReturn;
+	APP_FAULT_STATUS_READ(record);
+	record->uptime = faultcapture.uptime;
+
+	/** History oldest first **/
+	uint32_t events = (faultcapture.events <= FAULTCAPTURE_HISTORY) ? faultcapture.events : FAULTCAPTURE_HISTORY;
+	for(uint32_t index = 0; index < events; index++)
+	{
+		record->history[index] = faultcapture.history[(faultcapture.next + FAULTCAPTURE_HISTORY - events + index) % FAULTCAPTURE_HISTORY];
+	}
+	record->events = (uint8_t)events;
+
+	faultcapture.count++;
+	faultcapture.inarow++;
+	record->count = faultcapture.count;
+	record->crc = faultCaptureCrc(record);
+	record->magic = FAULTCAPTURE_MAGIC_NEW;
+
+	faultcapture.check = faultCaptureCheck();
+
+	if(faultcapture.inarow >= APP_FAULT_RESET_LIMIT)
+	{
+		APP_FAULT_PARK();
+	}
+	APP_SYSTEM_RESET();
+
+	while(1)
+	{
+	}
+}
+
+/*****************************************************************************/
+/* Fault Capture Functions                                                   */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Checks the RAM kept over the reset, starts the counters after a power-up.
+ *
+ * @details Enables the MemManage, BusFault and UsageFault exceptions so a
+ *          fault reports its own cause instead of a forced HardFault.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+void FaultCapture_Init(void)
+{
+	if((faultcapture.magic != FAULTCAPTURE_STATE_MAGIC) || (faultcapture.check != faultCaptureCheck()))
+	{
+		FaultCapture_Clear();
+	}
+	else if(!faultCaptureIsValid())
+	{
+		faultcapture.record.magic = 0U;
+	}
+	faultcapture.uptime = 0U;
+	faultcapture.mode = 0U;
+	faultcapture.next = 0U;
+	faultcapture.events = 0U;
+
+	APP_FAULT_ENABLE();
+}
+/*****************************************************************************
+ * @brief Whether a fault record is waiting to be reported.
+ *
+ * @param None
+ *
+ * @return bool true if FaultCapture_Report() has something to print.
+ *****************************************************************************/
+bool FaultCapture_IsPending(void)
+{
+	return faultCaptureIsValid() && (faultcapture.record.magic == FAULTCAPTURE_MAGIC_NEW);
+}
+/*****************************************************************************
+ * @brief Copies the last fault record, reported or not.
+ *
+ * @param[out] record  Record.
+ *
+ * @return bool false if there is none.
+ *****************************************************************************/
+bool FaultCapture_GetRecord(FaultRecord_t *record)
+{
+	if(!faultCaptureIsValid())
+	{
+		return false;
+	}
+	*record = faultcapture.record;
+	return true;
+}
+/*****************************************************************************
+ * @brief Prints a waiting record through DEBUG_LOG() and marks it reported.
+ *
+ * @details The record stays in RAM for FaultCapture_GetRecord() until the
+ *          next fault, STANDBY or power-up. Only the magic changes, it is not part
+ *          of the CRC.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+void FaultCapture_Report(void)
+{
+	const FaultRecord_t *record = &faultcapture.record;
+
+	if(!FaultCapture_IsPending())
+	{
+		return;
+	}
+
+	DEBUG_LOG("fault: cause %lu count %lu uptime %lu s mode %02lx frame %lu events %lu\r\n",
+			(unsigned long)record->cause, (unsigned long)record->count, (unsigned long)record->uptime,
+			(unsigned long)record->mode, (unsigned long)record->frameValid, (unsigned long)record->events);
+	DEBUG_LOG("fault: pc %08lx lr %08lx psr %08lx sp %08lx exc %08lx\r\n",
+			(unsigned long)record->frame[FaultFrame_Pc], (unsigned long)record->frame[FaultFrame_Lr],
+			(unsigned long)record->frame[FaultFrame_Psr], (unsigned long)record->sp,
+			(unsigned long)record->excReturn);
+	DEBUG_LOG("fault: r0 %08lx r1 %08lx r2 %08lx r3 %08lx r12 %08lx\r\n",
+			(unsigned long)record->frame[FaultFrame_R0], (unsigned long)record->frame[FaultFrame_R1],
+			(unsigned long)record->frame[FaultFrame_R2], (unsigned long)record->frame[FaultFrame_R3],
+			(unsigned long)record->frame[FaultFrame_R12]);
+	DEBUG_LOG("fault: cfsr %08lx hfsr %08lx mmfar %08lx bfar %08lx\r\n",
+			(unsigned long)record->cfsr, (unsigned long)record->hfsr,
+			(unsigned long)record->mmfar, (unsigned long)record->bfar);
+	DEBUG_LOG("fault: history %02lx %02lx %02lx %02lx %02lx %02lx %02lx %02lx\r\n",
+			(unsigned long)record->history[0], (unsigned long)record->history[1],
+			(unsigned long)record->history[2], (unsigned long)record->history[3],
+			(unsigned long)record->history[4], (unsigned long)record->history[5],
+			(unsigned long)record->history[6], (unsigned long)record->history[7]);
+
+	faultcapture.record.magic = FAULTCAPTURE_MAGIC_REPORTED;
+}
+/*****************************************************************************
+ * @brief Faults since power-up.
+ *
+ * @param None
+ *
+ * @return uint32_t Count, kept over the resets.
+ *****************************************************************************/
+uint32_t FaultCapture_GetCount(void)
+{
+	return faultcapture.count;
+}
+/*****************************************************************************
+ * @brief Forgets the record and the counters, as after a power-up.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+void FaultCapture_Clear(void)
+{
+	memset(&faultcapture, 0, sizeof(faultcapture));
+	faultcapture.magic = FAULTCAPTURE_STATE_MAGIC;
+	faultcapture.check = faultCaptureCheck();
+}
+/*****************************************************************************
+ * @brief Adds an application event to the history.
+ *
+ * @details One store into a ring of FAULTCAPTURE_HISTORY entries, cheap
+ *          enough for every dispatched event.
+ *
+ * @param[in] event  Event code, e.g. AppEvent_e.
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+void FaultCapture_Event(uint8_t event)
+{
+	faultcapture.history[faultcapture.next] = event;
+	faultcapture.next = (uint8_t)((faultcapture.next + 1U) % FAULTCAPTURE_HISTORY);
+	if(faultcapture.events < FAULTCAPTURE_HISTORY)
+	{
+		faultcapture.events++;
+	}
+}
+/*****************************************************************************
+ * @brief Sets the application mode saved with a fault.
+ *
+ * @param[in] mode  Mode code.
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+void FaultCapture_SetMode(uint8_t mode)
+{
+	faultcapture.mode = mode;
+}
+/*****************************************************************************
+ * @brief Counts one second of running.
+ *
+ * @details After APP_FAULT_STABLE_SECONDS the firmware counts as running
+ *          again and the faults in a row start from zero.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+void FaultCapture_SecondTick(void)
+{
+	if(faultcapture.uptime < UINT32_MAX)
+	{
+		faultcapture.uptime++;
+	}
+	if((faultcapture.uptime >= APP_FAULT_STABLE_SECONDS) && (faultcapture.inarow != 0U))
+	{
+		faultcapture.inarow = 0U;
+		faultcapture.check = faultCaptureCheck();
+	}
+}
+/*****************************************************************************
+ * @brief Records a fault exception and resets.
+ *
+ * @param[in] frame      Stacked registers (MSP or PSP at the exception).
+ * @param[in] excReturn  EXC_RETURN value of the handler's LR.
+ * @param[in] cause      Which handler.
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+void FaultCapture_Handler(const uint32_t *frame, uint32_t excReturn, FaultCause_e cause)
+{
+	faultCaptureRecord(cause, frame, excReturn, 0U);
+}
+/*****************************************************************************
+ * @brief Records an Error_Handler() call and resets.
+ *
+ * @details There is no exception frame, the record keeps the caller in
+ *          frame[FaultFrame_Pc] with frameValid 0.
+ *
+ * @param[in] caller  Return address into the caller of Error_Handler().
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+void FaultCapture_Error(uint32_t caller)
+{
+	faultCaptureRecord(FaultCause_Error, NULL, 0U, caller);
+}
+
+#if FAULTCAPTURE_HANDLERS
+/*****************************************************************************/
+/* Fault Handlers                                                            */
+/*****************************************************************************/
+
+/**
+ * @brief Handler body: r0 = stacked frame (MSP or PSP from EXC_RETURN bit 2),
+ *        r1 = EXC_RETURN, r2 = cause, then FaultCapture_Handler().
+ *
+ * @details Naked so no prologue moves the stack before it is read.
+ */
+#define FAULTCAPTURE_ENTRY(cause)  __asm volatile( \
+		"tst lr, #4\n" \
+		"ite eq\n" \
+		"mrseq r0, msp\n" \
+		"mrsne r0, psp\n" \
+		"mov r1, lr\n" \
+		"movs r2, #" #cause "\n" \
+		"b FaultCapture_Handler\n")
+
+_Static_assert((FaultCause_HardFault == 1) && (FaultCause_MemManage == 2) &&
+               (FaultCause_BusFault == 3) && (FaultCause_UsageFault == 4), "FAULTCAPTURE_ENTRY() causes");
+
+/**
+ * @brief This function handles Hard fault interrupt.
+ */
+__attribute__((naked)) void HardFault_Handler(void)
+{
+	FAULTCAPTURE_ENTRY(1);
+}
+
+/**
+ * @brief This function handles Memory management fault.
+ */
+__attribute__((naked)) void MemManage_Handler(void)
+{
+	FAULTCAPTURE_ENTRY(2);
+}
+
+/**
+ * @brief This function handles Pre-fetch fault, memory access fault.
+ */
+__attribute__((naked)) void BusFault_Handler(void)
+{
+	FAULTCAPTURE_ENTRY(3);
+}
+
+/**
+ * @brief This function handles Undefined instruction or illegal state.
+ */
+__attribute__((naked)) void UsageFault_Handler(void)
+{
+	FAULTCAPTURE_ENTRY(4);
+}
+#endif /* FAULTCAPTURE_HANDLERS */
+/*************************************END*************************************/
@@ -0,0 +1,207 @@
+/**
+ * \file           faultcapture.h
+ * \brief          Fault capture kept over reset header file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+#ifndef FAULTCAPTURE_H_
+#define FAULTCAPTURE_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "Platform_Translate.h"
+
+/*****************************************************************************/
+/* Fault Capture Macros                                                      */
+/*****************************************************************************/
+
+/**
+ * @brief Application events kept for the record, the latest ones.
+ */
+#define FAULTCAPTURE_HISTORY                 8U
+
+/**
+ * @brief Record magic: a fault not reported yet ("FALT").
+ */
+#define FAULTCAPTURE_MAGIC_NEW               0x544C4146U
+
+/**
+ * @brief Record magic: a fault already reported ("FALR").
+ */
+#define FAULTCAPTURE_MAGIC_REPORTED          0x524C4146U
+
+/*****************************************************************************/
+/* Fault Capture Enums                                                       */
+/*****************************************************************************/
+
+/**
+ * @brief What stopped the firmware.
+ */
+typedef enum
+{
+	FaultCause_None,                  /**< No fault */
+	FaultCause_HardFault,             /**< HardFault exception */
+	FaultCause_MemManage,             /**< MemManage exception */
+	FaultCause_BusFault,              /**< BusFault exception */
+	FaultCause_UsageFault,            /**< UsageFault exception */
+	FaultCause_Error,                 /**< Error_Handler(), e.g. a HAL init failed */
+	FaultCause_Count,                 /**< Number of causes */
+}FaultCause_e;
+
+/**
+ * @brief Registers the core stacks on exception entry, in stack order.
+ */
+typedef enum
+{
+	FaultFrame_R0,                    /**< r0 */
+	FaultFrame_R1,                    /**< r1 */
+	FaultFrame_R2,                    /**< r2 */
+	FaultFrame_R3,                    /**< r3 */
+	FaultFrame_R12,                   /**< r12 */
+	FaultFrame_Lr,                    /**< Link register of the faulting code */
+	FaultFrame_Pc,                    /**< Faulting instruction (Error_Handler() caller for FaultCause_Error) */
+	FaultFrame_Psr,                   /**< xPSR, IPSR bits give the active exception */
+	FaultFrame_Count,                 /**< Number of stacked registers */
+}FaultFrame_e;
+
+/*****************************************************************************/
+/* Fault Capture Structures                                                  */
+/*****************************************************************************/
+
+/**
+ * @brief One fault, as kept in RAM over the reset.
+ *
+ * @details 84 bytes, little endian words, CRC-32 (IEEE) over the bytes from
+ *          cause up to crc.
+ */
+typedef struct
+{
+	uint32_t magic;                   /**< FAULTCAPTURE_MAGIC_NEW or FAULTCAPTURE_MAGIC_REPORTED */
+	uint8_t cause;                    /**< FaultCause_e */
+	uint8_t mode;                     /**< Application mode, see FaultCapture_SetMode() */
+	uint8_t frameValid;               /**< 1 if frame holds the stacked registers */
+	uint8_t events;                   /**< Valid entries of history */
+	uint32_t frame[FaultFrame_Count]; /**< Stacked registers */
+	uint32_t sp;                      /**< Stack pointer of the faulting code (frame address) */
+	uint32_t excReturn;               /**< EXC_RETURN: which stack, thread or handler mode */
+	uint32_t cfsr;                    /**< SCB->CFSR, MemManage/BusFault/UsageFault status */
+	uint32_t hfsr;                    /**< SCB->HFSR, HardFault status */
+	uint32_t mmfar;                   /**< SCB->MMFAR, MemManage fault address */
+	uint32_t bfar;                    /**< SCB->BFAR, BusFault address */
+	uint32_t uptime;                  /**< Seconds since boot */
+	uint32_t count;                   /**< Faults since power-up, this one included */
+	uint8_t history[FAULTCAPTURE_HISTORY]; /**< Last application events, oldest first */
+	uint32_t crc;                     /**< CRC-32 of the record after magic */
+}FaultRecord_t;
+
+/*****************************************************************************/
+/* Fault Capture Function Declarations                                       */
+/*****************************************************************************/
+
+/**
+ * @brief Checks the RAM kept over the reset, starts the counters after a power-up.
+ *
+ * @note Call first thing in main(), before anything that can fault.
+ */
+void FaultCapture_Init(void);
+
+/**
+ * @brief Whether a fault record is waiting to be reported.
+ */
+bool FaultCapture_IsPending(void);
+
+/**
+ * @brief Copies the last fault record.
+ *
+ * @param[out] record  Record.
+ *
+ * @return false if there is none.
+ */
+bool FaultCapture_GetRecord(FaultRecord_t *record);
+
+/**
+ * @brief Prints a waiting record through DEBUG_LOG() and marks it reported.
+ */
+void FaultCapture_Report(void);
+
+/**
+ * @brief Faults since power-up.
+ */
+uint32_t FaultCapture_GetCount(void);
+
+/**
+ * @brief Forgets the record and the counters, as after a power-up.
+ */
+void FaultCapture_Clear(void);
+
+/**
+ * @brief Adds an application event to the history.
+ *
+ * @param[in] event  Event code, e.g. AppEvent_e.
+ */
+void FaultCapture_Event(uint8_t event);
+
+/**
+ * @brief Sets the application mode saved with a fault.
+ *
+ * @param[in] mode  Mode code.
+ */
+void FaultCapture_SetMode(uint8_t mode);
+
+/**
+ * @brief Counts one second of running, see APP_FAULT_STABLE_SECONDS.
+ */
+void FaultCapture_SecondTick(void);
+
+/**
+ * @brief Records a fault exception and resets, called by the fault handlers.
+ *
+ * @param[in] frame      Stacked registers (MSP or PSP at the exception).
+ * @param[in] excReturn  EXC_RETURN value of the handler's LR.
+ * @param[in] cause      Which handler.
+ */
+void FaultCapture_Handler(const uint32_t *frame, uint32_t excReturn, FaultCause_e cause) __attribute__((noreturn));
+
+/**
+ * @brief Records an Error_Handler() call and resets.
+ *
+ * @param[in] caller  Return address into the caller of Error_Handler().
+ */
+void FaultCapture_Error(uint32_t caller) __attribute__((noreturn));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FAULTCAPTURE_H_ */
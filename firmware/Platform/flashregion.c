@@ -0,0 +1,188 @@
+/**
+ * \file           flashregion.c
+ * \brief          Internal flash data regions source file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "flashregion.h"
+/*****************************************************************************/
+/* Private Defines                                                           */
+/*****************************************************************************/
+#define FLASHREGION_ERROR_FLAGS    (FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR | \
+                                    FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR)  /** Sticky status flags **/
+
+/*****************************************************************************/
+/* Private Types                                                             */
+/*****************************************************************************/
+/**
+ * @brief Placement of one region.
+ */
+typedef struct
+{
+	uint32_t *start;      /**< First word, from the linker script */
+	uint32_t *end;        /**< One past the last word */
+	uint32_t sector;      /**< FLASH_SECTOR_x erased for the region */
+}FlashRegionInfo_t;
+
+/*****************************************************************************/
+/* External Variables                                                        */
+/*****************************************************************************/
+extern uint32_t _ssessionlog[]; /** Session log sector start, STM32F401CCUX_FLASH.ld **/
+extern uint32_t _esessionlog[]; /** Session log sector end **/
+extern uint32_t _sprofiles[];   /** Profile sector start **/
+extern uint32_t _eprofiles[];   /** Profile sector end **/
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static const FlashRegionInfo_t flashregions[FlashRegion_Count] =
+{
+	[FlashRegion_SessionLog] = { _ssessionlog, _esessionlog, FLASH_SECTOR_5 },
+	[FlashRegion_Profiles]   = { _sprofiles,   _eprofiles,   FLASH_SECTOR_4 },
+}; /** Regions, each exactly one sector **/
+
+/*****************************************************************************/
+/* Flash Region Functions                                                    */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Returns the first word of a region.
+ *
+ * @param[in] region  Region.
+ *
+ * @return const volatile uint32_t * Start address.
+ *****************************************************************************/
+const volatile uint32_t *FlashRegion_GetBase(FlashRegion_e region)
+{
+	return flashregions[region].start;
+}
+/*****************************************************************************
+ * @brief Returns the size of a region.
+ *
+ * @param[in] region  Region.
+ *
+ * @return uint32_t Size in bytes.
+ *****************************************************************************/
+uint32_t FlashRegion_GetSize(FlashRegion_e region)
+{
+	return (uint32_t)((uintptr_t)flashregions[region].end - (uintptr_t)flashregions[region].start);
+}
+/*****************************************************************************
+ * @brief Erases the sector of a region.
+ *
+ * @param[in] region  Region.
+ *
+ * @return bool
+ *
+ * @retval true   Sector erased.
+ * @retval false  Erase error or timeout, or the supply is below the PVD
+ *                level.
+ *
+ * @note VDD is 3.3 V, so the erase runs with 32-bit parallelism
+ *       (FLASH_VOLTAGE_RANGE_3). The HAL flushes the flash caches. With
+ *       APP_BROWNOUT_RESUME no erase is started below the PVD level, the
+ *       range needs 2.7 V; the core stalls during an erase, which also
+ *       holds back the PVD snapshot.
+ *
+ * @see HAL_FLASHEx_Erase()
+ *****************************************************************************/
+bool FlashRegion_Erase(FlashRegion_e region)
+{
+	FLASH_EraseInitTypeDef erase = { 0 };
+	uint32_t failedsector = 0;
+	HAL_StatusTypeDef status;
+
+	erase.TypeErase = FLASH_TYPEERASE_SECTORS;
+	erase.Sector = flashregions[region].sector;
+	erase.NbSectors = 1;
+	erase.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+
+#if APP_BROWNOUT_RESUME
+	if(APP_SUPPLY_LOW())
+	{
+		return false;
+	}
+#endif
+	HAL_FLASH_Unlock();
+	__HAL_FLASH_CLEAR_FLAG(FLASHREGION_ERROR_FLAGS);
+	status = HAL_FLASHEx_Erase(&erase, &failedsector);
+	HAL_FLASH_Lock();
+
+	return (status == HAL_OK) && (failedsector == 0xFFFFFFFFU);
+}
+/*****************************************************************************
+ * @brief Programs words into erased flash of a region.
+ *
+ * @details One word at a time in address order, so a power failure leaves
+ *          a prefix of the words programmed. The data cache is flushed
+ *          afterwards, it may still hold the erased words.
+ *
+ * @param[in] region  Region.
+ * @param[in] offset  Byte offset in the region, word aligned.
+ * @param[in] words   Words to program.
+ * @param[in] count   Number of words.
+ *
+ * @return bool
+ *
+ * @retval true   All words programmed.
+ * @retval false  Out of the region, misaligned, programming error or the
+ *                supply below the PVD level (APP_BROWNOUT_RESUME).
+ *
+ * @see HAL_FLASH_Program()
+ *****************************************************************************/
+bool FlashRegion_Program(FlashRegion_e region, uint32_t offset, const uint32_t *words, uint32_t count)
+{
+	HAL_StatusTypeDef status = HAL_OK;
+	uint32_t address = (uint32_t)(uintptr_t)flashregions[region].start + offset;
+
+	if(((offset & 3U) != 0U) || ((offset + (count * 4U)) > FlashRegion_GetSize(region)))
+	{
+		return false;
+	}
+#if APP_BROWNOUT_RESUME
+	if(APP_SUPPLY_LOW())
+	{
+		return false;
+	}
+#endif
+
+	HAL_FLASH_Unlock();
+	__HAL_FLASH_CLEAR_FLAG(FLASHREGION_ERROR_FLAGS);
+	for(uint32_t i = 0; (i < count) && (status == HAL_OK); i++)
+	{
+		status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, address + (i * 4U), words[i]);
+	}
+	HAL_FLASH_Lock();
+	FLASH_FlushCaches();
+
+	return (status == HAL_OK);
+}
+/*************************************END*************************************/
@@ -0,0 +1,112 @@
+/**
+ * \file           flashregion.h
+ * \brief          Internal flash data regions header file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+#ifndef FLASHREGION_H_
+#define FLASHREGION_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "Platform_Translate.h"
+
+/*****************************************************************************/
+/* Flash Region Enums                                                        */
+/*****************************************************************************/
+
+/**
+ * @brief Flash sectors reserved for data in STM32F401CCUX_FLASH.ld.
+ */
+typedef enum
+{
+	FlashRegion_SessionLog,   /**< Sector 5, 128 KB, session history log */
+	FlashRegion_Profiles,     /**< Sector 4, 64 KB, session profiles */
+	FlashRegion_Count,        /**< Number of regions */
+}FlashRegion_e;
+
+/*****************************************************************************/
+/* Flash Region Function Declarations                                        */
+/*****************************************************************************/
+
+/**
+ * @brief First word of a region, read directly from the memory map.
+ *
+ * @param[in] region  Region.
+ *
+ * @return Start address of the region.
+ */
+const volatile uint32_t *FlashRegion_GetBase(FlashRegion_e region);
+
+/**
+ * @brief Size of a region.
+ *
+ * @param[in] region  Region.
+ *
+ * @return Size in bytes.
+ */
+uint32_t FlashRegion_GetSize(FlashRegion_e region);
+
+/**
+ * @brief Erases a whole region to 0xFF.
+ *
+ * @param[in] region  Region.
+ *
+ * @return true if erased.
+ *
+ * @warning A 128 KB sector takes 1 to 2 s, the core stalls on every flash
+ *          fetch (interrupts included) meanwhile.
+ */
+bool FlashRegion_Erase(FlashRegion_e region);
+
+/**
+ * @brief Programs words into erased flash.
+ *
+ * @param[in] region  Region.
+ * @param[in] offset  Byte offset in the region, word aligned.
+ * @param[in] words   Words to program, in address order.
+ * @param[in] count   Number of words.
+ *
+ * @return true if all words were programmed.
+ *
+ * @note Bits can only be cleared. Zeroing an already programmed word is
+ *       allowed, e.g. to invalidate it.
+ */
+bool FlashRegion_Program(FlashRegion_e region, uint32_t offset, const uint32_t *words, uint32_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FLASHREGION_H_ */
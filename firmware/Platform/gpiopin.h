@@ -0,0 +1,132 @@
+/**
+ * \file           gpiopin.h
+ * \brief          Compile-time resolved GPIO pin access header file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+#ifndef GPIOPIN_H_
+#define GPIOPIN_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "main.h"
+
+/*****************************************************************************/
+/* GPIO Pin Macros                                                           */
+/*****************************************************************************/
+
+/**
+ * @brief Writes a GPIOx->BSRR word.
+ *
+ * @details Low half sets pins, high half resets them, in one store. A host
+ *          build may define it before this header to observe the pins.
+ */
+#ifndef GPIOPIN_BSRR_WRITE
+#define GPIOPIN_BSRR_WRITE(port, value)      ((port)->BSRR = (value))
+#endif
+
+/*****************************************************************************/
+/* GPIO Pin Functions                                                        */
+/*****************************************************************************/
+
+/**
+ * @brief Drives pins high.
+ *
+ * @details With a constant port and pin this is a single store to BSRR, no
+ *          call, no assert and no read-modify-write, so it is safe against
+ *          interrupts touching other pins of the same port.
+ *
+ * @param[in] port  GPIO port.
+ * @param[in] pin   Pin mask (GPIO_PIN_x).
+ */
+static inline __attribute__((always_inline)) void GpioPin_Set(GPIO_TypeDef *port, uint16_t pin)
+{
+	GPIOPIN_BSRR_WRITE(port, (uint32_t)pin);
+}
+
+/**
+ * @brief Drives pins low.
+ *
+ * @param[in] port  GPIO port.
+ * @param[in] pin   Pin mask (GPIO_PIN_x).
+ */
+static inline __attribute__((always_inline)) void GpioPin_Reset(GPIO_TypeDef *port, uint16_t pin)
+{
+	GPIOPIN_BSRR_WRITE(port, (uint32_t)pin << 16U);
+}
+
+/**
+ * @brief Drives pins to a level.
+ *
+ * @param[in] port   GPIO port.
+ * @param[in] pin    Pin mask (GPIO_PIN_x).
+ * @param[in] level  true = high, false = low.
+ */
+static inline __attribute__((always_inline)) void GpioPin_Write(GPIO_TypeDef *port, uint16_t pin, bool level)
+{
+	GPIOPIN_BSRR_WRITE(port, level ? (uint32_t)pin : ((uint32_t)pin << 16U));
+}
+
+/**
+ * @brief Inverts output pins.
+ *
+ * @details Reads ODR once and writes the inverted levels through BSRR.
+ *
+ * @param[in] port  GPIO port.
+ * @param[in] pin   Pin mask (GPIO_PIN_x).
+ */
+static inline __attribute__((always_inline)) void GpioPin_Toggle(GPIO_TypeDef *port, uint16_t pin)
+{
+	uint32_t odr = port->ODR;
+	GPIOPIN_BSRR_WRITE(port, ((odr & pin) << 16U) | (~odr & pin));
+}
+
+/**
+ * @brief Reads the input level of a pin.
+ *
+ * @param[in] port  GPIO port.
+ * @param[in] pin   Pin mask (GPIO_PIN_x).
+ *
+ * @return true if any pin of the mask is high.
+ */
+static inline __attribute__((always_inline)) bool GpioPin_Read(GPIO_TypeDef *port, uint16_t pin)
+{
+	return ((port->IDR & pin) != 0U);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GPIOPIN_H_ */
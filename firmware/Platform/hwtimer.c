@@ -0,0 +1,357 @@
+/**
+ * \file           hwtimer.c
+ * \brief          TIM4 software timer service source file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "hwtimer.h"
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+#if (APP_LL_DRIVERS == 0)
+static TIM_HandleTypeDef htim4; /** TIM4 free running, CC1 set to the next wheel event **/
+#endif
+
+static TimerWheel_t hwtimerwheel; /** All software timers **/
+
+static uint32_t hwtimerbase = 0; /** Wheel tick at hwtimerlast **/
+
+static uint16_t hwtimerlast = 0; /** TIM4->CNT when hwtimerbase was taken **/
+
+static bool hwtimeradvancing = false; /** In TimerWheel_Advance(), the compare is set after it **/
+
+/*****************************************************************************/
+/* Private Functions                                                         */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Extends the 16-bit counter to the 32-bit wheel time.
+ *
+ * @details Valid as long as it runs at least once per counter wrap, which
+ *          the compare limit HWTIMER_MAX_COMPARE_TICKS ensures while timers
+ *          are queued; an empty wheel takes any time as its own.
+ *
+ * @param None
+ *
+ * @return uint32_t Current wheel tick.
+ *****************************************************************************/
+static uint32_t hwTimerSync(void)
+{
+	uint16_t count = (uint16_t)TIM4->CNT;
+
+	hwtimerbase += (uint16_t)(count - hwtimerlast);
+	hwtimerlast = count;
+	return hwtimerbase;
+}
+/*****************************************************************************
+ * @brief Advances the wheel, the expired callbacks run.
+ *
+ * @details Callbacks that start or stop timers leave the compare to the
+ *          caller of this function.
+ *
+ * @param[in] now  Current wheel tick.
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+static void hwTimerAdvance(uint32_t now)
+{
+	hwtimeradvancing = true;
+	TimerWheel_Advance(&hwtimerwheel, now);
+	hwtimeradvancing = false;
+}
+/*****************************************************************************
+ * @brief Sets CC1 to the next wheel event, or switches it off.
+ *
+ * @details An event already passed, also while the compare was written, is
+ *          advanced here directly instead of waiting a counter wrap.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Called with the TIM4 interrupt masked or from it.
+ *****************************************************************************/
+static void hwTimerProgram(void)
+{
+	uint32_t at;
+
+	while(TimerWheel_NextEvent(&hwtimerwheel, &at))
+	{
+		uint32_t now = hwTimerSync();
+		uint32_t ahead = at - now;
+		if((int32_t)ahead <= 0)
+		{
+			hwTimerAdvance(now);
+			continue;
+		}
+		if(ahead > HWTIMER_MAX_COMPARE_TICKS)
+		{
+			ahead = HWTIMER_MAX_COMPARE_TICKS;
+		}
+		TIM4->CCR1 = (uint16_t)(hwtimerlast + ahead);
+		TIM4->SR = ~TIM_SR_CC1IF; /** rc_w0, clear a stale match **/
+		TIM4->DIER |= TIM_DIER_CC1IE;
+		if((uint16_t)((uint16_t)TIM4->CNT - hwtimerlast) < ahead)
+		{
+			return;
+		}
+	}
+	TIM4->DIER &= ~TIM_DIER_CC1IE;
+	TIM4->SR = ~TIM_SR_CC1IF;
+}
+/*****************************************************************************
+ * @brief Starts a timer on the wheel and moves the compare.
+ *
+ * @param[in] timer     Timer.
+ * @param[in] ticks     Ticks to the first expiry.
+ * @param[in] period    Ticks between expiries, 0 = one-shot.
+ * @param[in] callback  Expiry callback.
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+static void hwTimerStart(HwTimer_t *timer, uint32_t ticks, uint32_t period, HwTimerCallback_t callback)
+{
+	uint32_t irqstate = APP_IRQ_SAVE();
+	APP_IRQ_DISABLE();
+	TimerWheel_Start(&hwtimerwheel, timer, hwTimerSync(), ticks, period, callback);
+	if(hwtimeradvancing == false)
+	{
+		hwTimerProgram();
+	}
+	APP_IRQ_RESTORE(irqstate);
+}
+
+/*****************************************************************************/
+/* HW Timer Functions                                                        */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Starts TIM4 as free running tick counter.
+ *
+ * @details The prescaler is derived from the APB1 timer clock, the counter
+ *          wraps at 0xFFFF. Compare channel 1 is used in frozen output
+ *          mode, i.e. only its match flag and interrupt, for the next event
+ *          of the timer wheel.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Call once after SystemClock_Config(). The counter keeps the
+ *       same rate after STOP because SystemClock_Config() restores the PLL.
+ *
+ * @see HwTimer_Start()
+ *****************************************************************************/
+void HwTimer_Init(void)
+{
+#if APP_LL_DRIVERS
+	__HAL_RCC_TIM4_CLK_ENABLE();
+	LowLevel_TimerInit(TIM4, (LowLevel_TimerClock(TIM4) / HWTIMER_TICK_HZ) - 1U, 0xFFFFU);
+#else
+	uint32_t timerclock = HAL_RCC_GetPCLK1Freq();
+	if((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1)
+	{
+		timerclock *= 2U; /** APB1 timers run at twice PCLK1 when APB1 is divided **/
+	}
+
+	__HAL_RCC_TIM4_CLK_ENABLE();
+
+	htim4.Instance = TIM4;
+	htim4.Init.Prescaler = (timerclock / HWTIMER_TICK_HZ) - 1U;
+	htim4.Init.CounterMode = TIM_COUNTERMODE_UP;
+	htim4.Init.Period = 0xFFFF;
+	htim4.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+	htim4.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+	if (HAL_TIM_Base_Init(&htim4) != HAL_OK)
+	{
+		Error_Handler();
+	}
+#endif
+
+	TIM4->DIER = 0;
+	TIM4->SR = 0;
+	hwtimerlast = (uint16_t)TIM4->CNT;
+	hwtimerbase = 0;
+	TimerWheel_Init(&hwtimerwheel, hwtimerbase);
+
+	HAL_NVIC_SetPriority(TIM4_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(TIM4_IRQn);
+
+#if APP_LL_DRIVERS
+	TIM4->CR1 |= TIM_CR1_CEN;
+#else
+	if (HAL_TIM_Base_Start(&htim4) != HAL_OK)
+	{
+		Error_Handler();
+	}
+#endif
+}
+/*****************************************************************************
+ * @brief Starts a one-shot timer.
+ *
+ * @details Restarting a pending timer simply moves its expiry.
+ *
+ * @param[in] timer         Timer.
+ * @param[in] milliseconds  Delay, clamped to 1 ... HWTIMER_MAX_DELAY_MS.
+ * @param[in] callback      Called from the TIM4 interrupt on expiry.
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Safe to call from thread and interrupt context.
+ *****************************************************************************/
+void HwTimer_Start(HwTimer_t *timer, uint32_t milliseconds, HwTimerCallback_t callback)
+{
+	if(milliseconds > HWTIMER_MAX_DELAY_MS)
+	{
+		milliseconds = HWTIMER_MAX_DELAY_MS;
+	}
+	hwTimerStart(timer, HWTIMER_MS_TO_TICKS(milliseconds), 0U, callback);
+}
+/*****************************************************************************
+ * @brief Starts a periodic timer.
+ *
+ * @details The expiries stay on the grid of the start, a late interrupt
+ *          does not shift the later ones.
+ *
+ * @param[in] timer         Timer.
+ * @param[in] milliseconds  Period, clamped to 1 ... HWTIMER_MAX_DELAY_MS.
+ * @param[in] callback      Called from the TIM4 interrupt on every expiry.
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Safe to call from thread and interrupt context.
+ *****************************************************************************/
+void HwTimer_StartPeriodic(HwTimer_t *timer, uint32_t milliseconds, HwTimerCallback_t callback)
+{
+	if(milliseconds > HWTIMER_MAX_DELAY_MS)
+	{
+		milliseconds = HWTIMER_MAX_DELAY_MS;
+	}
+	uint32_t ticks = HWTIMER_MS_TO_TICKS(milliseconds);
+	if(ticks == 0U)
+	{
+		ticks = 1U;
+	}
+	hwTimerStart(timer, ticks, ticks, callback);
+}
+/*****************************************************************************
+ * @brief Stops a timer.
+ *
+ * @param[in] timer  Timer, stopped already is fine.
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Safe to call from thread and interrupt context.
+ *****************************************************************************/
+void HwTimer_Stop(HwTimer_t *timer)
+{
+	uint32_t irqstate = APP_IRQ_SAVE();
+	APP_IRQ_DISABLE();
+	if(TimerWheel_IsRunning(timer))
+	{
+		TimerWheel_Stop(&hwtimerwheel, timer);
+		if(hwtimeradvancing == false)
+		{
+			hwTimerProgram();
+		}
+	}
+	APP_IRQ_RESTORE(irqstate);
+}
+/*****************************************************************************
+ * @brief Tells whether a timer is started.
+ *
+ * @param[in] timer  Timer.
+ *
+ * @return bool true until its last expiry or its stop.
+ *****************************************************************************/
+bool HwTimer_IsRunning(const HwTimer_t *timer)
+{
+	return TimerWheel_IsRunning(timer);
+}
+/*****************************************************************************
+ * @brief Tells whether any timer is started.
+ *
+ * @param None
+ *
+ * @return bool
+ *
+ * @retval true   At least one timer pending, TIM4 must keep running.
+ * @retval false  No timer pending.
+ *****************************************************************************/
+bool HwTimer_IsActive(void)
+{
+	return (TimerWheel_GetCount(&hwtimerwheel) != 0U);
+}
+/*****************************************************************************
+ * @brief Returns the free running tick count.
+ *
+ * @param None
+ *
+ * @return uint16_t Ticks of 1 / HWTIMER_TICK_HZ, differences are modulo 2^16.
+ *****************************************************************************/
+uint16_t HwTimer_Now(void)
+{
+	return (uint16_t)TIM4->CNT;
+}
+/*****************************************************************************
+ * @brief Handles the TIM4 compare interrupt.
+ *
+ * @details Advances the wheel to the current tick, which runs the callbacks
+ *          of the expired timers, and sets the compare to the next event.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Called from TIM4_IRQHandler().
+ *****************************************************************************/
+void HwTimer_IRQHandler(void)
+{
+	TIM4->SR = ~TIM_SR_CC1IF;
+	hwTimerAdvance(hwTimerSync());
+	hwTimerProgram();
+}
+/*************************************END*************************************/
@@ -0,0 +1,155 @@
+/**
+ * \file           hwtimer.h
+ * \brief          TIM4 software timer service header file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+#ifndef HWTIMER_H_
+#define HWTIMER_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "Platform_Translate.h"
+#include "timerwheel.h"
+
+/*****************************************************************************/
+/* HW Timer Macros                                                           */
+/*****************************************************************************/
+
+/**
+ * @brief Tick rate of the free running TIM4 counter and of the timer wheel.
+ *
+ * @details 2 kHz gives 0.5 ms resolution; the 16-bit counter wraps every
+ *          32 s, the wheel counts on in 32 bits.
+ */
+#define HWTIMER_TICK_HZ                      2000U
+
+/**
+ * @brief Longest delay in milliseconds, about 2.3 hours.
+ */
+#define HWTIMER_MAX_DELAY_MS                 ((TIMERWHEEL_MAX_TICKS / HWTIMER_TICK_HZ) * 1000U)
+
+/**
+ * @brief Converts milliseconds to timer ticks.
+ */
+#define HWTIMER_MS_TO_TICKS(milliseconds)    ((uint32_t)(milliseconds) * (HWTIMER_TICK_HZ / 1000U))
+
+/**
+ * @brief Furthest the compare channel is set ahead, in ticks.
+ *
+ * @details Keeps the 16-bit counter from wrapping between two interrupts
+ *          while timers are queued, so the wheel time can be extended from
+ *          it.
+ */
+#define HWTIMER_MAX_COMPARE_TICKS            0x7FFFU
+
+/*****************************************************************************/
+/* HW Timer Types                                                            */
+/*****************************************************************************/
+
+/**
+ * @brief One software timer, statically allocated by its user; a zeroed
+ *        timer is stopped.
+ */
+typedef TimerWheelTimer_t HwTimer_t;
+
+/**
+ * @brief Called in TIM4 interrupt context when a timer expires.
+ */
+typedef TimerWheelCallback_t HwTimerCallback_t;
+
+/*****************************************************************************/
+/* HW Timer Function Declarations                                            */
+/*****************************************************************************/
+
+/**
+ * @brief Starts TIM4 as free running HWTIMER_TICK_HZ counter, empty wheel.
+ */
+void HwTimer_Init(void);
+
+/**
+ * @brief Starts (or restarts) a one-shot timer.
+ *
+ * @param[in] timer         Timer.
+ * @param[in] milliseconds  Delay, 1 ... HWTIMER_MAX_DELAY_MS.
+ * @param[in] callback      Called from the TIM4 interrupt on expiry.
+ */
+void HwTimer_Start(HwTimer_t *timer, uint32_t milliseconds, HwTimerCallback_t callback);
+
+/**
+ * @brief Starts (or restarts) a periodic timer, first expiry one period
+ *        from now.
+ *
+ * @param[in] timer         Timer.
+ * @param[in] milliseconds  Period, 1 ... HWTIMER_MAX_DELAY_MS.
+ * @param[in] callback      Called from the TIM4 interrupt on every expiry.
+ */
+void HwTimer_StartPeriodic(HwTimer_t *timer, uint32_t milliseconds, HwTimerCallback_t callback);
+
+/**
+ * @brief Stops a timer, no callback follows.
+ *
+ * @param[in] timer  Timer.
+ */
+void HwTimer_Stop(HwTimer_t *timer);
+
+/**
+ * @brief Tells whether a timer is started.
+ */
+bool HwTimer_IsRunning(const HwTimer_t *timer);
+
+/**
+ * @brief Tells whether any timer is started.
+ *
+ * @return true while a timer is pending; TIM4 does not run in STOP mode.
+ */
+bool HwTimer_IsActive(void);
+
+/**
+ * @brief Current counter value in ticks, wraps every 65536 ticks.
+ *
+ * @return Free running tick count.
+ */
+uint16_t HwTimer_Now(void);
+
+/**
+ * @brief TIM4 interrupt handler, call from TIM4_IRQHandler().
+ */
+void HwTimer_IRQHandler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HWTIMER_H_ */
@@ -0,0 +1,337 @@
+/**
+ * \file           lowlevel.c
+ * \brief          Register level drivers for the clock tree, GPIO and the timers source file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "lowlevel.h"
+#include "gpiopin.h"
+
+/*****************************************************************************/
+/* Private Defines                                                           */
+/*****************************************************************************/
+#define LOWLEVEL_SPIN_LIMIT        200000U  /** Flag polls before giving up, > 10 ms at 16 MHz **/
+
+#define LOWLEVEL_PLL_M             8U       /** 16 MHz HSI / 8 = 2 MHz VCO input **/
+#define LOWLEVEL_PLL_N             72U      /** 144 MHz VCO **/
+#define LOWLEVEL_PLL_Q             4U       /** 36 MHz, no USB **/
+
+#define LOWLEVEL_TIM3_PRESCALER    7199U    /** 72 MHz / 7200 = 10 kHz, as MX_TIM3_Init() **/
+#define LOWLEVEL_TIM3_PERIOD       10000U   /** As MX_TIM3_Init() **/
+
+#define LOWLEVEL_MODE_INPUT        0U       /** MODER input **/
+#define LOWLEVEL_MODE_OUTPUT       1U       /** MODER general purpose output **/
+#define LOWLEVEL_PULL_NONE         0U       /** PUPDR no pull **/
+#define LOWLEVEL_PULL_UP           1U       /** PUPDR pull-up **/
+#define LOWLEVEL_PULL_DOWN         2U       /** PUPDR pull-down **/
+
+/*****************************************************************************/
+/* Private Functions                                                         */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Waits until a register flag reaches the wanted state.
+ *
+ * @details Counts polls instead of milliseconds, SysTick is not running
+ *          yet when the clock tree is set up.
+ *
+ * @param[in] reg   Register to poll.
+ * @param[in] mask  Flag mask.
+ * @param[in] set   true to wait for the flag to be set, false for cleared.
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Calls Error_Handler() on a timeout, like the HAL callers do.
+ *****************************************************************************/
+static void lowLevelWaitFlag(volatile uint32_t *reg, uint32_t mask, bool set)
+{
+	for(uint32_t spin = 0; ((*reg & mask) != 0U) != set; spin++)
+	{
+		if(spin >= LOWLEVEL_SPIN_LIMIT)
+		{
+			Error_Handler();
+			return;
+		}
+	}
+}
+/*****************************************************************************
+ * @brief Sets mode and pull of one pin; push-pull, low speed.
+ *
+ * @param[in] port  GPIO port with its clock enabled.
+ * @param[in] pin   Pin number 0 ... 15.
+ * @param[in] mode  LOWLEVEL_MODE_INPUT or LOWLEVEL_MODE_OUTPUT.
+ * @param[in] pull  LOWLEVEL_PULL_NONE, _UP or _DOWN.
+ *****************************************************************************/
+static void lowLevelPinMode(GPIO_TypeDef *port, uint32_t pin, uint32_t mode, uint32_t pull)
+{
+	uint32_t shift = pin * 2U;
+
+	port->OTYPER &= ~(1UL << pin);
+	port->OSPEEDR &= ~(3UL << shift);
+	MODIFY_REG(port->PUPDR, 3UL << shift, pull << shift);
+	MODIFY_REG(port->MODER, 3UL << shift, mode << shift);
+}
+
+/*****************************************************************************/
+/* Low Level Functions                                                       */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Flash accelerator, NVIC grouping and the SYSCFG/PWR clocks.
+ *
+ * @details The register part of HAL_Init() and HAL_MspInit(): prefetch,
+ *          instruction and data cache as configured in stm32f4xx_hal_conf.h,
+ *          all priority bits as preemption priority.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Call first in main(), in place of HAL_Init().
+ *****************************************************************************/
+void LowLevel_Init(void)
+{
+#if (INSTRUCTION_CACHE_ENABLE != 0U)
+	FLASH->ACR |= FLASH_ACR_ICEN;
+#endif
+#if (DATA_CACHE_ENABLE != 0U)
+	FLASH->ACR |= FLASH_ACR_DCEN;
+#endif
+#if (PREFETCH_ENABLE != 0U)
+	FLASH->ACR |= FLASH_ACR_PRFTEN;
+#endif
+	NVIC_SetPriorityGrouping(NVIC_PRIORITYGROUP_4);
+
+	RCC->APB2ENR |= RCC_APB2ENR_SYSCFGEN;
+	RCC->APB1ENR |= RCC_APB1ENR_PWREN;
+	(void)RCC->APB1ENR; /** Clock enable delay before the first access **/
+}
+/*****************************************************************************
+ * @brief Runs the core at 72 MHz from the HSI through the PLL.
+ *
+ * @details Same tree as SystemClock_Config(): voltage scale 2,
+ *          HSI / 8 * 72 / 2 = 72 MHz, APB1 36 MHz, APB2 72 MHz, 2 flash
+ *          wait states. The bus dividers and the wait states are set
+ *          before the switch, the core still runs at 16 MHz then. Ends by
+ *          starting the 1 ms SysTick like HAL_InitTick().
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Called at boot and on every wake-up from STOP, where the core
+ *       comes back on the HSI with the PLL off.
+ *
+ * @see SystemClock_Config()
+ *****************************************************************************/
+void LowLevel_ClockConfig(void)
+{
+	RCC->APB1ENR |= RCC_APB1ENR_PWREN;
+	(void)RCC->APB1ENR;
+	MODIFY_REG(PWR->CR, PWR_CR_VOS, PWR_REGULATOR_VOLTAGE_SCALE2);
+
+	RCC->CR |= RCC_CR_HSION;
+	lowLevelWaitFlag(&RCC->CR, RCC_CR_HSIRDY, true);
+
+	if((RCC->CFGR & RCC_CFGR_SWS) == RCC_CFGR_SWS_PLL)
+	{
+		MODIFY_REG(RCC->CFGR, RCC_CFGR_SW, RCC_CFGR_SW_HSI); /** The PLL can only be changed while unused **/
+		lowLevelWaitFlag(&RCC->CFGR, RCC_CFGR_SWS, false);
+	}
+	RCC->CR &= ~RCC_CR_PLLON;
+	lowLevelWaitFlag(&RCC->CR, RCC_CR_PLLRDY, false);
+
+	RCC->PLLCFGR = RCC_PLLCFGR_PLLSRC_HSI |
+			(LOWLEVEL_PLL_M << RCC_PLLCFGR_PLLM_Pos) |
+			(LOWLEVEL_PLL_N << RCC_PLLCFGR_PLLN_Pos) |
+			(((RCC_PLLP_DIV2 >> 1U) - 1U) << RCC_PLLCFGR_PLLP_Pos) |
+			(LOWLEVEL_PLL_Q << RCC_PLLCFGR_PLLQ_Pos);
+	RCC->CR |= RCC_CR_PLLON;
+	lowLevelWaitFlag(&RCC->CR, RCC_CR_PLLRDY, true);
+
+	MODIFY_REG(FLASH->ACR, FLASH_ACR_LATENCY, FLASH_LATENCY_2);
+	if((FLASH->ACR & FLASH_ACR_LATENCY) != FLASH_LATENCY_2)
+	{
+		Error_Handler();
+	}
+	MODIFY_REG(RCC->CFGR, RCC_CFGR_HPRE | RCC_CFGR_PPRE1 | RCC_CFGR_PPRE2,
+			RCC_CFGR_HPRE_DIV1 | RCC_CFGR_PPRE1_DIV2 | RCC_CFGR_PPRE2_DIV1);
+	MODIFY_REG(RCC->CFGR, RCC_CFGR_SW, RCC_CFGR_SW_PLL);
+	lowLevelWaitFlag(&RCC->CFGR, RCC_CFGR_SWS_1, true);
+
+	SystemCoreClockUpdate();
+	(void)SysTick_Config(SystemCoreClock / (1000U / (uint32_t)uwTickFreq));
+	NVIC_SetPriority(SysTick_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), TICK_INT_PRIORITY, 0U));
+}
+/*****************************************************************************
+ * @brief Sets up the pins of MX_GPIO_Init().
+ *
+ * @details Outputs push-pull, low speed: LED PC13 and TM1637 CLK/DIO
+ *          PB12/PB13 low, the active low buzzer PB9 high so it stays silent
+ *          until Buzzer_Init(). Buttons PA0/PA1 as inputs with pull-up on
+ *          both edges of EXTI0/EXTI1; with APP_IDLE_STANDBY PA0 is pulled
+ *          down, the button switches it to VDD like the WKUP pin.
+ *          The output levels are set through BSRR before the pins become
+ *          outputs, so they never drive the reset level of ODR. The
+ *          EXTI0/EXTI1 vectors are left disabled until button_Init()
+ *          enables them, an edge before the timer wheel is set up must not
+ *          start a debounce one-shot.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @see MX_GPIO_Init()
+ *****************************************************************************/
+void LowLevel_GpioInit(void)
+{
+	RCC->AHB1ENR |= RCC_AHB1ENR_GPIOAEN | RCC_AHB1ENR_GPIOBEN | RCC_AHB1ENR_GPIOCEN;
+	(void)RCC->AHB1ENR;
+
+	GpioPin_Reset(GPIOC, GPIO_PIN_13);
+	GpioPin_Reset(GPIOB, GPIO_PIN_12 | GPIO_PIN_13);
+	GpioPin_Set(GPIOB, GPIO_PIN_9);
+	lowLevelPinMode(GPIOC, 13U, LOWLEVEL_MODE_OUTPUT, LOWLEVEL_PULL_NONE);
+	lowLevelPinMode(GPIOB, 12U, LOWLEVEL_MODE_OUTPUT, LOWLEVEL_PULL_NONE);
+	lowLevelPinMode(GPIOB, 13U, LOWLEVEL_MODE_OUTPUT, LOWLEVEL_PULL_NONE);
+	lowLevelPinMode(GPIOB, 9U, LOWLEVEL_MODE_OUTPUT, LOWLEVEL_PULL_NONE);
+
+#if APP_IDLE_STANDBY
+	lowLevelPinMode(GPIOA, 0U, LOWLEVEL_MODE_INPUT, LOWLEVEL_PULL_DOWN);
+#else
+	lowLevelPinMode(GPIOA, 0U, LOWLEVEL_MODE_INPUT, LOWLEVEL_PULL_UP);
+#endif
+	lowLevelPinMode(GPIOA, 1U, LOWLEVEL_MODE_INPUT, LOWLEVEL_PULL_UP);
+
+	SYSCFG->EXTICR[0] &= ~(SYSCFG_EXTICR1_EXTI0 | SYSCFG_EXTICR1_EXTI1); /** Port A **/
+	EXTI->EMR &= ~(EXTI_EMR_MR0 | EXTI_EMR_MR1);
+	EXTI->RTSR |= EXTI_RTSR_TR0 | EXTI_RTSR_TR1;
+	EXTI->FTSR |= EXTI_FTSR_TR0 | EXTI_FTSR_TR1;
+	EXTI->IMR |= EXTI_IMR_MR0 | EXTI_IMR_MR1;
+
+	NVIC_SetPriority(EXTI0_IRQn, 0U);
+	NVIC_SetPriority(EXTI1_IRQn, 0U);
+}
+/*****************************************************************************
+ * @brief Sets up TIM3 for one update interrupt per second.
+ *
+ * @details The prescaler and period of MX_TIM3_Init(), internal clock,
+ *          no trigger output; the clock and the interrupt of
+ *          HAL_TIM_Base_MspInit(). The timer is left stopped.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @see LowLevel_SecondTimerStart()
+ *****************************************************************************/
+void LowLevel_SecondTimerInit(void)
+{
+	RCC->APB1ENR |= RCC_APB1ENR_TIM3EN;
+	(void)RCC->APB1ENR;
+
+	LowLevel_TimerInit(TIM3, LOWLEVEL_TIM3_PRESCALER, LOWLEVEL_TIM3_PERIOD);
+	TIM3->SMCR = 0;
+	TIM3->CR2 = 0;
+
+	NVIC_SetPriority(TIM3_IRQn, 0U);
+	NVIC_EnableIRQ(TIM3_IRQn);
+}
+/*****************************************************************************
+ * @brief Sets up a timer as plain up-counter.
+ *
+ * @details What HAL_TIM_Base_Init() does without the handle: CR1 with
+ *          no clock division and no ARR preload, PSC and ARR, repetition
+ *          counter 0, then an update event to load the prescaler, whose
+ *          flag is cleared.
+ *
+ * @param[in] timer      Timer with its clock enabled.
+ * @param[in] prescaler  PSC value.
+ * @param[in] period     ARR value.
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+void LowLevel_TimerInit(TIM_TypeDef *timer, uint32_t prescaler, uint32_t period)
+{
+	timer->CR1 = 0;
+	timer->ARR = period;
+	timer->PSC = prescaler;
+	if(IS_TIM_REPETITION_COUNTER_INSTANCE(timer))
+	{
+		timer->RCR = 0;
+	}
+	timer->EGR = TIM_EGR_UG;
+	timer->SR = ~TIM_SR_UIF;
+}
+/*****************************************************************************
+ * @brief Input clock of a timer.
+ *
+ * @details TIM1 and TIM9-11 are on APB2, the others on APB1. A timer runs
+ *          at twice its PCLK when the bus is divided.
+ *
+ * @param[in] timer  Timer.
+ *
+ * @return uint32_t Clock in Hz.
+ *
+ * @retval Timer clock.
+ *****************************************************************************/
+uint32_t LowLevel_TimerClock(TIM_TypeDef *timer)
+{
+	uint32_t cfgr = RCC->CFGR;
+	uint32_t hclk = SystemCoreClock;
+	uint32_t ppre;
+
+	if((timer == TIM1) || (timer == TIM9) || (timer == TIM10) || (timer == TIM11))
+	{
+		ppre = (cfgr & RCC_CFGR_PPRE2) >> RCC_CFGR_PPRE2_Pos;
+	}
+	else
+	{
+		ppre = (cfgr & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos;
+	}
+	if((ppre & 0x4U) == 0U)
+	{
+		return hclk; /** APB not divided **/
+	}
+	return (hclk >> ((ppre & 0x3U) + 1U)) * 2U;
+}
+/*************************************END*************************************/
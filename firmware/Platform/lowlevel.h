@@ -0,0 +1,124 @@
+/**
+ * \file           lowlevel.h
+ * \brief          Register level drivers for the clock tree, GPIO and the timers header file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+#ifndef LOWLEVEL_H_
+#define LOWLEVEL_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "main.h"
+
+/*****************************************************************************/
+/* Low Level Function Declarations                                           */
+/*****************************************************************************/
+
+/**
+ * @brief Flash accelerator, NVIC grouping and the SYSCFG/PWR clocks, as HAL_Init().
+ *
+ * @note SysTick is started by LowLevel_ClockConfig(), nothing before it
+ *       needs HAL_GetTick().
+ */
+void LowLevel_Init(void);
+
+/**
+ * @brief HSI / PLL to 72 MHz and the 1 ms SysTick, as SystemClock_Config().
+ *
+ * @note Also restores the PLL after STOP mode.
+ */
+void LowLevel_ClockConfig(void);
+
+/**
+ * @brief LED, buzzer, TM1637 and button pins with their EXTI lines, as MX_GPIO_Init().
+ */
+void LowLevel_GpioInit(void);
+
+/**
+ * @brief TIM3 one second update interrupt, as MX_TIM3_Init(); not started.
+ */
+void LowLevel_SecondTimerInit(void);
+
+/**
+ * @brief Sets up a timer as plain up-counter, stopped, update flag cleared.
+ *
+ * @param[in] timer      Timer with its clock enabled.
+ * @param[in] prescaler  PSC value, the counter runs at clock / (prescaler + 1).
+ * @param[in] period     ARR value.
+ */
+void LowLevel_TimerInit(TIM_TypeDef *timer, uint32_t prescaler, uint32_t period);
+
+/**
+ * @brief Input clock of a timer in Hz.
+ *
+ * @param[in] timer  Timer on APB1 or APB2.
+ *
+ * @return PCLK of its bus, doubled when the bus is divided.
+ */
+uint32_t LowLevel_TimerClock(TIM_TypeDef *timer);
+
+/*****************************************************************************/
+/* Low Level Inline Functions                                                */
+/*****************************************************************************/
+
+/**
+ * @brief Starts TIM3 with its update interrupt, as HAL_TIM_Base_Start_IT().
+ *
+ * @return HAL_OK
+ */
+static inline HAL_StatusTypeDef LowLevel_SecondTimerStart(void)
+{
+	TIM3->DIER |= TIM_DIER_UIE;
+	TIM3->CR1 |= TIM_CR1_CEN;
+	return HAL_OK;
+}
+
+/**
+ * @brief Stops TIM3 and its update interrupt, as HAL_TIM_Base_Stop_IT().
+ *
+ * @return HAL_OK
+ */
+static inline HAL_StatusTypeDef LowLevel_SecondTimerStop(void)
+{
+	TIM3->DIER &= ~TIM_DIER_UIE;
+	TIM3->CR1 &= ~TIM_CR1_CEN;
+	return HAL_OK;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOWLEVEL_H_ */
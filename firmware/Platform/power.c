@@ -0,0 +1,294 @@
+/**
+ * \file           power.c
+ * \brief          Power management source file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "power.h"
+#include "profiler.h"
+#if (APP_TIMEBASE == APP_TIMEBASE_RTC)
+#include "rtcclock.h"
+#endif
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static uint32_t powerstopcount = 0; /** Number of STOP mode entries **/
+
+/*****************************************************************************/
+/* Power Functions                                                           */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Sleeps until the next interrupt.
+ *
+ * @details With APP_TICKLESS_IDLE the SysTick interrupt is suspended for the
+ *          time the core sleeps, so the only wake ups are the real events
+ *          (second tick, button edge or one-shot, DMA done).
+ *          PowerIdle_Stop additionally stops the PLL and HSI; on wake up the
+ *          MCU runs from HSI and SystemClock_Config() restores the PLL before
+ *          anything else executes.
+ *
+ * @param[in] mode  PowerIdle_Sleep or PowerIdle_Stop.
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Must be called with PRIMASK set after checking that no event is
+ *       pending; a pending interrupt still ends WFI and runs once the
+ *       caller restores PRIMASK.
+ *
+ * @warning TIM1/TIM3/TIM4/DMA do not run in STOP mode. The caller must only ask
+ *          for PowerIdle_Stop when none of them is needed.
+ *
+ * @see HAL_SuspendTick(), HAL_PWR_EnterSTOPMode(), SystemClock_Config(),
+ *      LowLevel_ClockConfig()
+ *****************************************************************************/
+void Power_Idle(PowerIdle_e mode)
+{
+#if APP_TICKLESS_IDLE
+	HAL_SuspendTick();
+
+	if(mode == PowerIdle_Stop)
+	{
+		powerstopcount++;
+		HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+		PROFILE_BEGIN(ProfileProbe_StopWakeClock);
+#if APP_LL_DRIVERS
+		LowLevel_ClockConfig(); /** Back from STOP on HSI, restart the PLL **/
+#else
+		SystemClock_Config(); /** Back from STOP on HSI, restart the PLL **/
+#endif
+		PROFILE_END(ProfileProbe_StopWakeClock);
+	}
+	else
+	{
+		APP_WAIT_FOR_INTERRUPT();
+	}
+
+	HAL_ResumeTick();
+#else
+	(void)mode;
+	APP_WAIT_FOR_INTERRUPT();
+#endif
+}
+/*****************************************************************************
+ * @brief Switches the wake-up timer off and enters STANDBY.
+ *
+ * @param[in] wakepin  Wake up on a rising edge of PA0-WKUP.
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Does not return. WFI is retried should a pending interrupt end it.
+ *****************************************************************************/
+static void powerEnterStandby(bool wakepin)
+{
+	HAL_SuspendTick();
+#if (APP_TIMEBASE == APP_TIMEBASE_RTC)
+	RtcClock_Shutdown();
+#endif
+	HAL_PWR_DisableWakeUpPin(PWR_WAKEUP_PIN1);
+	__HAL_PWR_CLEAR_FLAG(PWR_FLAG_WU);
+	if(wakepin)
+	{
+		HAL_PWR_EnableWakeUpPin(PWR_WAKEUP_PIN1); /** A pin already high wakes at once **/
+	}
+
+	while(1)
+	{
+		HAL_PWR_EnterSTANDBYMode();
+	}
+}
+/*****************************************************************************
+ * @brief Enters STANDBY mode.
+ *
+ * @details Used for the controlled shutdown on a critical battery: the 1.2 V
+ *          domain is switched off and the MCU draws a few uA. The wake-up pin
+ *          is not used, PA0 is the control button with an internal pull-up
+ *          and WKUP would force it to pull-down. The RTC wake-up timer is
+ *          shut off here, it runs as the watchdog keep-alive even with the
+ *          timer stopped. A started IWDG keeps counting in STANDBY, its
+ *          reset is sent back here by Watchdog_Init().
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Does not return. WFI is retried should a pending interrupt end it.
+ *
+ * @see HAL_PWR_EnterSTANDBYMode()
+ *****************************************************************************/
+void Power_Standby(void)
+{
+	powerEnterStandby(false);
+}
+/*****************************************************************************
+ * @brief Enters STANDBY mode until the control button is pressed.
+ *
+ * @details Deep idle with APP_IDLE_STANDBY: a rising edge on PA0-WKUP, or
+ *          NRST, starts the MCU again from reset. Needs the control button
+ *          switching PA0 to VDD, see AppConfig.h; the WKUP pin forces a
+ *          pull-down.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Does not return.
+ *
+ * @see Power_Standby()
+ *****************************************************************************/
+void Power_StandbyWakePin(void)
+{
+	powerEnterStandby(true);
+}
+#if APP_BROWNOUT_RESUME
+/*****************************************************************************
+ * @brief Sets the brownout reset level and starts the PVD interrupt.
+ *
+ * @details The BOR level lives in the option bytes; it is only programmed
+ *          when it differs from APP_BROWNOUT_BOR_LEVEL, normally at the
+ *          first boot of a new board. The option bytes are locked again
+ *          whatever happens; a failed unlock, program or launch, or a level
+ *          that did not take, goes to Error_Handler(), so the fault capture
+ *          records it instead of the board running with the wrong BOR
+ *          level. The PVD raises EXTI line 16 when the
+ *          supply falls below APP_BROWNOUT_PVD_LEVEL, also in STOP, at the
+ *          highest priority; HAL_PWR_PVDCallback() takes the snapshot,
+ *          timed on the DWT cycle counter started here.
+ *
+ * @param None
+ *
+ * @return bool
+ *
+ * @retval true   The supply is already below the PVD level, no interrupt
+ *                will come for it.
+ * @retval false  Supply above the PVD level.
+ *
+ * @note Call once the PWR clock is on (SystemClock_Config()).
+ *
+ * @see Power_BrownoutHold(), HAL_PWR_PVD_IRQHandler()
+ *****************************************************************************/
+bool Power_BrownoutInit(void)
+{
+	FLASH_OBProgramInitTypeDef options;
+
+	HAL_FLASHEx_OBGetConfig(&options);
+	if(options.BORLevel != APP_BROWNOUT_BOR_LEVEL)
+	{
+		options.OptionType = OPTIONBYTE_BOR;
+		options.BORLevel = APP_BROWNOUT_BOR_LEVEL;
+		HAL_StatusTypeDef status = HAL_FLASH_OB_Unlock();
+		if(status == HAL_OK)
+		{
+			status = HAL_FLASHEx_OBProgram(&options);
+		}
+		if(status == HAL_OK)
+		{
+			status = HAL_FLASH_OB_Launch();
+		}
+		(void)HAL_FLASH_OB_Lock(); /** Only sets OPTLOCK, cannot fail **/
+
+		HAL_FLASHEx_OBGetConfig(&options);
+		if((status != HAL_OK) || (options.BORLevel != APP_BROWNOUT_BOR_LEVEL))
+		{
+			Error_Handler();
+		}
+	}
+
+	PWR_PVDTypeDef pvd =
+	{
+		.PVDLevel = APP_BROWNOUT_PVD_LEVEL,
+		.Mode = PWR_PVD_MODE_IT_RISING, /** PVDO rises when the supply falls **/
+	};
+	APP_CYCLE_COUNTER_INIT(); /** Time of the snapshot **/
+	HAL_PWR_ConfigPVD(&pvd);
+	HAL_PWR_EnablePVD();
+	HAL_NVIC_SetPriority(PVD_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(PVD_IRQn);
+
+	return APP_SUPPLY_LOW();
+}
+/*****************************************************************************
+ * @brief Waits for the brownout reset, resets once the supply is back, or
+ *        enters STANDBY.
+ *
+ * @details Called from the PVD interrupt after the snapshot, or at boot
+ *          with the supply already low: either the supply keeps falling
+ *          and the BOR holds the MCU in reset, or it recovers above the
+ *          PVD level (with its hysteresis) and the MCU is reset here, so
+ *          both ways the next boot resumes from the snapshot. The wait is
+ *          timed on the cycle counter, the SysTick does not advance in the
+ *          PVD interrupt; a supply still low after APP_BROWNOUT_HOLD_MS
+ *          goes to STANDBY, which keeps the snapshot in the backup
+ *          registers, woken with APP_IDLE_STANDBY by the control button.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Does not return.
+ *****************************************************************************/
+void Power_BrownoutHold(void)
+{
+	uint32_t start = APP_CYCLE_COUNTER();
+	uint32_t hold = (SystemCoreClock / 1000U) * APP_BROWNOUT_HOLD_MS;
+
+	while(APP_SUPPLY_LOW())
+	{
+		if((APP_CYCLE_COUNTER() - start) > hold)
+		{
+			powerEnterStandby(APP_IDLE_STANDBY != 0);
+		}
+	}
+	APP_SYSTEM_RESET();
+}
+#endif
+/*****************************************************************************
+ * @brief Returns the number of STOP mode entries.
+ *
+ * @param None
+ *
+ * @return uint32_t STOP entries since boot.
+ *****************************************************************************/
+uint32_t Power_GetStopCount(void)
+{
+	return powerstopcount;
+}
+/*************************************END*************************************/
@@ -0,0 +1,112 @@
+/**
+ * \file           power.h
+ * \brief          Power management header file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+#ifndef POWER_H_
+#define POWER_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "Platform_Translate.h"
+
+/*****************************************************************************/
+/* Power Enums                                                               */
+/*****************************************************************************/
+
+/**
+ * @brief Low power state used while the application waits for an event.
+ */
+typedef enum
+{
+	PowerIdle_Sleep,     /**< WFI, all clocks and peripherals keep running */
+	PowerIdle_Stop,      /**< STOP mode, PLL/HSI off, wake on EXTI (buttons, RTC) */
+}PowerIdle_e;
+
+/*****************************************************************************/
+/* Power Function Declarations                                               */
+/*****************************************************************************/
+
+/**
+ * @brief Sleeps until the next interrupt in the requested low power state.
+ *
+ * @param[in] mode  PowerIdle_Sleep or PowerIdle_Stop.
+ *
+ * @note Call with interrupts masked (PRIMASK set); returns with them masked.
+ */
+void Power_Idle(PowerIdle_e mode);
+
+/**
+ * @brief Enters STANDBY mode, does not return.
+ *
+ * @note Everything but the backup domain is lost; only NRST (or a power
+ *       cycle) starts the MCU again.
+ */
+void Power_Standby(void);
+
+/**
+ * @brief Enters STANDBY mode, a rising edge on PA0-WKUP wakes it; does not return.
+ *
+ * @note The wake-up starts the MCU from reset, like NRST.
+ */
+void Power_StandbyWakePin(void);
+
+#if APP_BROWNOUT_RESUME
+/**
+ * @brief Programs the BOR level if needed and enables the PVD interrupt.
+ *
+ * @return true if the supply is already below the PVD level.
+ */
+bool Power_BrownoutInit(void);
+
+/**
+ * @brief Waits until the BOR, resets when the supply recovers, or enters
+ *        STANDBY after APP_BROWNOUT_HOLD_MS; does not return.
+ */
+void Power_BrownoutHold(void);
+#endif
+
+/**
+ * @brief Number of times STOP mode was entered since boot.
+ *
+ * @return STOP entry count.
+ */
+uint32_t Power_GetStopCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* POWER_H_ */
@@ -0,0 +1,226 @@
+/**
+ * \file           profiler.c
+ * \brief          DWT cycle counter profiler source file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "profiler.h"
+#include "tokenlog.h"
+
+#if APP_PROFILER
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static const char *const profilernames[ProfileProbe_Count] =
+{
+	[ProfileProbe_Dispatch]      = "dispatch",
+	[ProfileProbe_UpdateDisplay] = "updatedisplay",
+	[ProfileProbe_TM1637Update]  = "tm1637update",
+	[ProfileProbe_TM1637Frame]   = "tm1637frame",
+	[ProfileProbe_TM1637Byte]    = "tm1637byte",
+	[ProfileProbe_ButtonEdge]    = "buttonedge",
+	[ProfileProbe_ButtonExpired] = "buttonexpired",
+	[ProfileProbe_SecondTimerIsr] = "tim3isr",
+	[ProfileProbe_StopWakeClock] = "stopwakeclock",
+}; /** Probe names printed by Profiler_Report() **/
+
+static ProfileStats_t profilerstats[ProfileProbe_Count]; /** Statistics of each probe **/
+
+static uint32_t profileroverhead = 0; /** Cycles of an empty PROFILE_BEGIN()/PROFILE_END() pair **/
+
+/*****************************************************************************/
+/* Private Functions                                                         */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Clears the statistics of every probe.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+static void profilerClear(void)
+{
+	for(uint32_t probe = 0; probe < ProfileProbe_Count; probe++)
+	{
+		profilerstats[probe].count = 0;
+		profilerstats[probe].min = UINT32_MAX;
+		profilerstats[probe].max = 0;
+		profilerstats[probe].total = 0;
+	}
+}
+
+/*****************************************************************************/
+/* Profiler Functions                                                        */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Starts the DWT cycle counter and clears all probes.
+ *
+ * @details The overhead of the two CYCCNT reads is measured a few times and
+ *          the smallest value is subtracted from every sample, so an empty
+ *          probe reads 0 cycles.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Call once after SystemClock_Config().
+ *****************************************************************************/
+void Profiler_Init(void)
+{
+	APP_CYCLE_COUNTER_INIT();
+
+	profileroverhead = UINT32_MAX;
+	for(uint32_t i = 0; i < 8U; i++)
+	{
+		uint32_t start = APP_CYCLE_COUNTER();
+		uint32_t cycles = APP_CYCLE_COUNTER() - start;
+		if(cycles < profileroverhead)
+		{
+			profileroverhead = cycles;
+		}
+	}
+
+	profilerClear();
+}
+/*****************************************************************************
+ * @brief Adds one sample to a probe.
+ *
+ * @param[in] probe   Probe the sample belongs to.
+ * @param[in] cycles  Measured cycles including the probe overhead.
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Runs with interrupts masked for a few cycles, probes in interrupt
+ *       handlers may record while a thread probe is being recorded.
+ *****************************************************************************/
+void Profiler_Record(ProfileProbe_e probe, uint32_t cycles)
+{
+	if(probe >= ProfileProbe_Count)
+	{
+		return;
+	}
+	cycles = (cycles > profileroverhead) ? (cycles - profileroverhead) : 0U;
+
+	uint32_t irqstate = APP_IRQ_SAVE();
+	APP_IRQ_DISABLE();
+	ProfileStats_t *stats = &profilerstats[probe];
+	stats->count++;
+	stats->total += cycles;
+	if(cycles < stats->min)
+	{
+		stats->min = cycles;
+	}
+	if(cycles > stats->max)
+	{
+		stats->max = cycles;
+	}
+	APP_IRQ_RESTORE(irqstate);
+}
+/*****************************************************************************
+ * @brief Copies the statistics of a probe.
+ *
+ * @param[in]  probe  Probe to read.
+ * @param[out] stats  Copy of the statistics, min is 0 when count is 0.
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+void Profiler_Get(ProfileProbe_e probe, ProfileStats_t *stats)
+{
+	if((probe >= ProfileProbe_Count) || (stats == NULL))
+	{
+		return;
+	}
+
+	uint32_t irqstate = APP_IRQ_SAVE();
+	APP_IRQ_DISABLE();
+	*stats = profilerstats[probe];
+	APP_IRQ_RESTORE(irqstate);
+
+	if(stats->count == 0U)
+	{
+		stats->min = 0;
+	}
+}
+/*****************************************************************************
+ * @brief Prints every probe through DEBUG_LOG() and clears them.
+ *
+ * @details One line per probe that has samples: count, min/avg/max cycles
+ *          per call and the cycles per second it cost over the period.
+ *          The output goes wherever APP_DEBUG_OUTPUT sends debugPrintf(),
+ *          tokenized with APP_DEBUG_TOKENIZED.
+ *
+ * @param[in] seconds  Length of the measured period in seconds.
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @see Profiler_Get()
+ *****************************************************************************/
+void Profiler_Report(uint32_t seconds)
+{
+	if(seconds == 0U)
+	{
+		seconds = 1U;
+	}
+
+	DEBUG_LOG("prof: %lu s @ %lu Hz, overhead %lu cyc\r\n",
+			(unsigned long)seconds, (unsigned long)SystemCoreClock, (unsigned long)profileroverhead);
+
+	for(uint32_t probe = 0; probe < ProfileProbe_Count; probe++)
+	{
+		ProfileStats_t stats;
+		Profiler_Get((ProfileProbe_e)probe, &stats);
+		if(stats.count == 0U)
+		{
+			continue;
+		}
+		DEBUG_LOG("prof: %-14s n %6lu min %6lu avg %6lu max %6lu cyc/s %8lu\r\n",
+				DEBUG_LOG_STRING(profilernames[probe]), (unsigned long)stats.count,
+				(unsigned long)stats.min, (unsigned long)(stats.total / stats.count),
+				(unsigned long)stats.max, (unsigned long)(stats.total / seconds));
+	}
+
+	uint32_t irqstate = APP_IRQ_SAVE();
+	APP_IRQ_DISABLE();
+	profilerClear();
+	APP_IRQ_RESTORE(irqstate);
+}
+#endif /* APP_PROFILER */
+/*************************************END*************************************/
@@ -0,0 +1,141 @@
+/**
+ * \file           profiler.h
+ * \brief          DWT cycle counter profiler header file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "Platform_Translate.h"
+
+/*****************************************************************************/
+/* Profiler Enums                                                            */
+/*****************************************************************************/
+
+/**
+ * @brief Named probe points.
+ *
+ * @details Add a probe here and its name in profilernames[] (profiler.c).
+ */
+typedef enum
+{
+	ProfileProbe_Dispatch,        /**< dispatchEvent(), one event */
+	ProfileProbe_UpdateDisplay,   /**< updateDisplay() */
+	ProfileProbe_TM1637Update,    /**< TM1637_Update_Data_Dots() */
+	ProfileProbe_TM1637Frame,     /**< One frame handed to the TM1637 bus */
+	ProfileProbe_TM1637Byte,      /**< TM1637_WriteByte(), 16 GPIO writes of the bit-bang driver */
+	ProfileProbe_ButtonEdge,      /**< button_Edge(), EXTI */
+	ProfileProbe_ButtonExpired,   /**< Button debounce / long press one-shot, TIM4 */
+	ProfileProbe_SecondTimerIsr,  /**< TIM3_IRQHandler() body, HAL or APP_LL_DRIVERS */
+	ProfileProbe_StopWakeClock,   /**< PLL restart after STOP, HAL or APP_LL_DRIVERS */
+	ProfileProbe_Count,           /**< Number of probes */
+}ProfileProbe_e;
+
+/*****************************************************************************/
+/* Profiler Types                                                            */
+/*****************************************************************************/
+
+/**
+ * @brief Statistics of one probe.
+ */
+typedef struct
+{
+	uint32_t count;          /**< Number of samples */
+	uint32_t min;            /**< Shortest sample in core cycles */
+	uint32_t max;            /**< Longest sample in core cycles */
+	uint64_t total;          /**< Sum of all samples in core cycles */
+}ProfileStats_t;
+
+/*****************************************************************************/
+/* Profiler Macros                                                           */
+/*****************************************************************************/
+#if APP_PROFILER
+/**
+ * @brief Opens a probe, must be closed by PROFILE_END() in the same scope.
+ *
+ * @details Reads DWT->CYCCNT into a local named after the probe.
+ */
+#define PROFILE_BEGIN(probe)   uint32_t profilestart_##probe = APP_CYCLE_COUNTER()
+
+/**
+ * @brief Closes a probe and records the cycles since PROFILE_BEGIN().
+ */
+#define PROFILE_END(probe)     Profiler_Record((probe), APP_CYCLE_COUNTER() - profilestart_##probe)
+#else
+#define PROFILE_BEGIN(probe)
+#define PROFILE_END(probe)     ((void)0)
+#endif
+
+/*****************************************************************************/
+/* Profiler Function Declarations                                            */
+/*****************************************************************************/
+
+/**
+ * @brief Starts the DWT cycle counter, clears all probes and measures the probe overhead.
+ */
+void Profiler_Init(void);
+
+/**
+ * @brief Adds one sample to a probe.
+ *
+ * @param[in] probe   Probe the sample belongs to.
+ * @param[in] cycles  Measured cycles, the probe overhead is subtracted.
+ *
+ * @note Safe to call from thread and interrupt context.
+ */
+void Profiler_Record(ProfileProbe_e probe, uint32_t cycles);
+
+/**
+ * @brief Copies the statistics of a probe.
+ *
+ * @param[in]  probe  Probe to read.
+ * @param[out] stats  Copy of the statistics.
+ */
+void Profiler_Get(ProfileProbe_e probe, ProfileStats_t *stats);
+
+/**
+ * @brief Prints every probe through DEBUG_LOG() and clears them.
+ *
+ * @param[in] seconds  Length of the measured period, for the cycles per second column.
+ */
+void Profiler_Report(uint32_t seconds);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PROFILER_H_ */
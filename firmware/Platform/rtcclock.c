@@ -0,0 +1,785 @@
+/**
+ * \file           rtcclock.c
+ * \brief          RTC wake-up timer timebase source file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "rtcclock.h"
+/*****************************************************************************/
+/* Private Defines                                                           */
+/*****************************************************************************/
+#define RTCCLOCK_WPR_KEY1          0xCAU    /** Write protection unlock key 1 **/
+#define RTCCLOCK_WPR_KEY2          0x53U    /** Write protection unlock key 2 **/
+#define RTCCLOCK_WPR_LOCK          0xFFU    /** Any other value locks again **/
+#define RTCCLOCK_TIMEOUT_MS        10U      /** INITF/WUTWF/RECALPF/RSF/SHPF take a few RTCCLK cycles **/
+
+/** PREDIV_A + 1 = 16: one SSR step is one RTC/16 wake-up clock cycle (~0.5 ms) **/
+#define RTCCLOCK_PRER_LSE          ((15U << RTC_PRER_PREDIV_A_Pos) | 2047U)   /** 32768 / 16 / 2048 = 1 Hz **/
+#define RTCCLOCK_PRER_LSI          ((15U << RTC_PRER_PREDIV_A_Pos) | 1999U)   /** 32000 / 16 / 2000 = 1 Hz **/
+
+/** Alarm A on SS[9:0] = 0 only: every 1024 SSR steps, 0.5 s on the LSE, 0.512/0.488 s on the LSI **/
+#define RTCCLOCK_BLINK_ALRMAR      (RTC_ALRMAR_MSK4 | RTC_ALRMAR_MSK3 | RTC_ALRMAR_MSK2 | RTC_ALRMAR_MSK1)
+#define RTCCLOCK_BLINK_ALRMASSR    (10U << RTC_ALRMASSR_MASKSS_Pos)
+
+#define RTCCLOCK_CALIB_PPM_MIN     (-488)   /** CALP with CALM = 0 **/
+#define RTCCLOCK_CALIB_PPM_MAX     (487)    /** CALM = 511 **/
+
+#define RTCCLOCK_DRIFT_TIMER       TIM3     /** Reference timer of the drift measurement **/
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static RtcClockSource_e rtcclocksource = RtcClockSource_Lse; /** Oscillator selected by RtcClock_Init() **/
+static uint32_t rtcclockprer = RTCCLOCK_PRER_LSE; /** Prescaler value for the selected oscillator **/
+static volatile bool rtcclockrunning = false; /** Wake-ups count as session seconds **/
+static volatile uint32_t rtcclockwakeperiod = 1U; /** Seconds between wake-ups **/
+static uint32_t rtcclockremaining = 0U; /** SSR steps left of the paused second, 0 = a full second **/
+static volatile bool rtcclockpartial = false; /** The next wake-up ends the partial first second **/
+
+#if APP_TIMEBASE_DRIFT_MEASURE
+static volatile uint32_t rtcdriftoverflows = 0; /** TIM3 update events since boot **/
+static volatile bool rtcdriftrestart = true; /** Start a new window on the next wake-up **/
+static uint64_t rtcdriftstart = 0; /** TIM3 tick position at the start of the window **/
+static volatile uint64_t rtcdriftticks = 0; /** TIM3 ticks elapsed in the window **/
+static volatile uint32_t rtcdriftseconds = 0; /** RTC seconds elapsed in the window **/
+#endif
+
+/*****************************************************************************/
+/* Private Functions                                                         */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Waits until a register flag reaches the wanted state.
+ *
+ * @param[in] reg      Register to poll.
+ * @param[in] mask     Flag mask.
+ * @param[in] set      true to wait for the flag to be set, false for cleared.
+ * @param[in] timeout  Timeout in milliseconds.
+ *
+ * @return bool
+ *
+ * @retval true   Flag reached the wanted state.
+ * @retval false  Timeout.
+ *
+ * @note Uses HAL_GetTick(), the SysTick must be running.
+ *****************************************************************************/
+static bool rtcClockWaitFlag(volatile uint32_t *reg, uint32_t mask, bool set, uint32_t timeout)
+{
+	uint32_t start = HAL_GetTick();
+	while(((*reg & mask) != 0U) != set)
+	{
+		if((HAL_GetTick() - start) > timeout)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+/*****************************************************************************
+ * @brief rtcClockWaitFlag() timed by the DWT cycle counter, for the wake-up
+ *        interrupt where the SysTick cannot advance.
+ *
+ * @param[in] reg      Register to poll.
+ * @param[in] mask     Flag mask.
+ * @param[in] set      true to wait for the flag to be set, false for cleared.
+ *
+ * @return bool
+ *
+ * @retval true   Flag reached the wanted state.
+ * @retval false  RTCCLOCK_TIMEOUT_MS of core cycles passed.
+ *
+ * @note Counts SystemCoreClock cycles; on the HSI after a STOP wake-up the
+ *       timeout is only longer.
+ *****************************************************************************/
+static bool rtcClockWaitFlagIsr(volatile uint32_t *reg, uint32_t mask, bool set)
+{
+	uint32_t start = APP_CYCLE_COUNTER();
+	uint32_t timeout = (SystemCoreClock / 1000U) * RTCCLOCK_TIMEOUT_MS;
+	while(((*reg & mask) != 0U) != set)
+	{
+		if((APP_CYCLE_COUNTER() - start) > timeout)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+/*****************************************************************************
+ * @brief Reloads the RTC prescalers through initialisation mode.
+ *
+ * @details Entering initialisation mode stops and reloads the prescaler
+ *          chain, so the next 1 Hz (ck_spre) edge comes a full second after
+ *          initialisation mode is left.
+ *
+ * @param None
+ *
+ * @return bool
+ *
+ * @retval true   Prescalers reloaded.
+ * @retval false  INITF did not set.
+ *
+ * @note The write protection must be unlocked by the caller.
+ *****************************************************************************/
+static bool rtcClockRestartPrescaler(void)
+{
+	RTC->ISR = 0xFFFFFFFFU; /** Sets INIT, the rc_w0 flags are left untouched **/
+	if(rtcClockWaitFlag(&RTC->ISR, RTC_ISR_INITF, true, RTCCLOCK_TIMEOUT_MS) == false)
+	{
+		RTC->ISR &= ~RTC_ISR_INIT;
+		return false;
+	}
+	RTC->PRER = rtcclockprer & RTC_PRER_PREDIV_S; /** Two separate writes as required by the RM **/
+	RTC->PRER = rtcclockprer;
+	RTC->ISR &= ~RTC_ISR_INIT;
+	return true;
+}
+/*****************************************************************************
+ * @brief Clears the wake-up flag and its EXTI line 22 pending bit.
+ *****************************************************************************/
+static void rtcClockClearWakeup(void)
+{
+	RTC->ISR = ~(RTC_ISR_WUTF | RTC_ISR_INIT) | (RTC->ISR & RTC_ISR_INIT);
+	EXTI->PR = EXTI_PR_PR22;
+}
+/*****************************************************************************
+ * @brief Clears the alarm A flag and its EXTI line 17 pending bit.
+ *****************************************************************************/
+static void rtcClockClearAlarm(void)
+{
+	RTC->ISR = ~(RTC_ISR_ALRAF | RTC_ISR_INIT) | (RTC->ISR & RTC_ISR_INIT);
+	EXTI->PR = EXTI_PR_PR17;
+}
+/*****************************************************************************
+ * @brief Clocks the wake-up timer from ck_spre again, one wake-up a second.
+ *
+ * @param None
+ *
+ * @return bool
+ *
+ * @retval true   Reprogrammed and enabled.
+ * @retval false  WUTWF did not set, the wake-up timer is left disabled.
+ *
+ * @note The write protection must be unlocked by the caller. Also called
+ *       from the wake-up interrupt, so WUTWF is waited for on the cycle
+ *       counter.
+ *****************************************************************************/
+static bool rtcClockSecondWakeup(void)
+{
+	RTC->CR &= ~RTC_CR_WUTE;
+	if(rtcClockWaitFlagIsr(&RTC->ISR, RTC_ISR_WUTWF, true) == false)
+	{
+		return false;
+	}
+	RTC->WUTR = 0U;
+	RTC->CR = (RTC->CR & ~RTC_CR_WUCKSEL) | RTC_CR_WUCKSEL_2;
+	rtcClockClearWakeup();
+	RTC->CR |= RTC_CR_WUTIE | RTC_CR_WUTE;
+	return true;
+}
+/*****************************************************************************
+ * @brief Returns the SSR steps left until the next session second.
+ *
+ * @details SSR counts down to the next ck_spre edge. After the shift of
+ *          RtcClock_Start() it is above PREDIV_S until the partial first
+ *          second ends, the session second then comes PREDIV_S steps before
+ *          the ck_spre edge. The step in progress counts as a whole one.
+ *
+ * @param None
+ *
+ * @return uint32_t 1 ... PREDIV_S + 1, 0 if the shadow registers did not
+ *         synchronise.
+ *
+ * @note The write protection must be unlocked by the caller, RSF is cleared
+ *       first so a shift still in progress is not read.
+ *****************************************************************************/
+static uint32_t rtcClockRemaining(void)
+{
+	uint32_t predivs = rtcclockprer & RTC_PRER_PREDIV_S;
+
+	RTC->ISR = ~(RTC_ISR_RSF | RTC_ISR_INIT);
+	if(rtcClockWaitFlag(&RTC->ISR, RTC_ISR_RSF, true, RTCCLOCK_TIMEOUT_MS) == false)
+	{
+		return 0U;
+	}
+	uint32_t ssr = RTC->SSR & RTC_SSR_SS;
+	(void)RTC->DR; /** Reading SSR locks the calendar shadows until DR is read **/
+
+	return (ssr > predivs) ? (ssr - predivs) : (ssr + 1U);
+}
+
+#if APP_TIMEBASE_DRIFT_MEASURE
+/*****************************************************************************
+ * @brief Returns the free running TIM3 position in timer ticks.
+ *
+ * @details Combines the update count with TIM3->CNT. An update that is
+ *          pending but not serviced yet (counter already wrapped) is added
+ *          here, the RTC and TIM3 interrupts share one priority.
+ *****************************************************************************/
+static uint64_t rtcClockDriftTicks(void)
+{
+	uint32_t overflows = rtcdriftoverflows;
+	uint32_t count = RTCCLOCK_DRIFT_TIMER->CNT;
+	uint32_t period = RTCCLOCK_DRIFT_TIMER->ARR + 1U;
+
+	if(((RTCCLOCK_DRIFT_TIMER->SR & TIM_SR_UIF) != 0U) && (count < (period / 2U)))
+	{
+		overflows++;
+	}
+	return ((uint64_t)overflows * period) + count;
+}
+/*****************************************************************************
+ * @brief Takes one drift sample on an RTC second edge.
+ *****************************************************************************/
+static void rtcClockDriftSample(void)
+{
+	uint64_t now = rtcClockDriftTicks();
+
+	if(rtcdriftrestart)
+	{
+		rtcdriftstart = now;
+		rtcdriftticks = 0;
+		rtcdriftseconds = 0;
+		rtcdriftrestart = false;
+	}
+	else
+	{
+		rtcdriftticks = now - rtcdriftstart;
+		rtcdriftseconds++;
+	}
+}
+#endif
+
+/*****************************************************************************/
+/* RTC Clock Functions                                                       */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Starts the RTC as one second timebase.
+ *
+ * @details The backup domain is only reset when the RTC is not enabled or
+ *          runs from an LSE that stopped, so a warm reset or a STANDBY
+ *          wake-up keeps it and the backup registers (session snapshots).
+ *          If the LSE does not start within LSE_STARTUP_TIMEOUT the LSI is
+ *          used instead; the timer keeps working, but only with RC accuracy.
+ *          An RTC already running from the LSI is kept as well, the LSI
+ *          (reset with the MCU) is only switched on again, so the LSE wait
+ *          is not repeated on every boot.
+ *          The wake-up timer is clocked from ck_spre (1 Hz) with WUTR = 0,
+ *          so it fires once per calibrated RTC second on EXTI line 22, which
+ *          also wakes the MCU from STOP mode.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Call once after SystemClock_Config() with the SysTick running.
+ *
+ * @warning A failed initialisation mode entry calls Error_Handler().
+ *
+ * @see RtcClock_Start(), RtcClock_SetCalibration()
+ *****************************************************************************/
+void RtcClock_Init(void)
+{
+	__HAL_RCC_PWR_CLK_ENABLE();
+	PWR->CR |= PWR_CR_DBP; /** Backup domain write access **/
+
+	uint32_t rtcsel = RCC->BDCR & RCC_BDCR_RTCSEL;
+	bool enabled = (RCC->BDCR & RCC_BDCR_RTCEN) != 0U;
+
+	if(enabled && (rtcsel == RCC_BDCR_RTCSEL_1))
+	{
+		RCC->CSR |= RCC_CSR_LSION;
+		if(rtcClockWaitFlag(&RCC->CSR, RCC_CSR_LSIRDY, true, RTCCLOCK_TIMEOUT_MS) == false)
+		{
+			Error_Handler();
+		}
+		rtcclocksource = RtcClockSource_Lsi;
+		rtcclockprer = RTCCLOCK_PRER_LSI;
+	}
+	else if((enabled == false) || (rtcsel != RCC_BDCR_RTCSEL_0) ||
+	        ((RCC->BDCR & RCC_BDCR_LSERDY) == 0U))
+	{
+		RCC->BDCR |= RCC_BDCR_BDRST; /** RTCSEL can only be changed after a backup domain reset **/
+		RCC->BDCR &= ~RCC_BDCR_BDRST;
+
+		RCC->BDCR |= RCC_BDCR_LSEON;
+		if(rtcClockWaitFlag(&RCC->BDCR, RCC_BDCR_LSERDY, true, LSE_STARTUP_TIMEOUT))
+		{
+			RCC->BDCR |= RCC_BDCR_RTCSEL_0 | RCC_BDCR_RTCEN;
+		}
+		else
+		{
+			RCC->BDCR &= ~RCC_BDCR_LSEON;
+			RCC->CSR |= RCC_CSR_LSION;
+			if(rtcClockWaitFlag(&RCC->CSR, RCC_CSR_LSIRDY, true, RTCCLOCK_TIMEOUT_MS) == false)
+			{
+				Error_Handler();
+			}
+			RCC->BDCR |= RCC_BDCR_RTCSEL_1 | RCC_BDCR_RTCEN;
+			rtcclocksource = RtcClockSource_Lsi;
+			rtcclockprer = RTCCLOCK_PRER_LSI;
+		}
+	}
+
+	RTC->WPR = RTCCLOCK_WPR_KEY1;
+	RTC->WPR = RTCCLOCK_WPR_KEY2;
+
+	if(rtcClockRestartPrescaler() == false)
+	{
+		Error_Handler();
+	}
+
+	RTC->CR &= ~(RTC_CR_WUTE | RTC_CR_WUTIE | RTC_CR_ALRAE | RTC_CR_ALRAIE); /** A reset while paused left the blink on **/
+	rtcClockClearAlarm();
+	if(rtcClockWaitFlag(&RTC->ISR, RTC_ISR_WUTWF, true, RTCCLOCK_TIMEOUT_MS) == false)
+	{
+		Error_Handler();
+	}
+	RTC->WUTR = 0U; /** Period = WUTR + 1 = one ck_spre cycle **/
+	RTC->CR = (RTC->CR & ~RTC_CR_WUCKSEL) | RTC_CR_WUCKSEL_2;
+	rtcClockClearWakeup();
+#if APP_TIMEBASE_DRIFT_MEASURE
+	RTC->CR |= RTC_CR_WUTIE | RTC_CR_WUTE; /** Measure from boot, sessions only gate the counting **/
+#elif (APP_WATCHDOG || APP_IDLE_TIMEOUT)
+	RTC->WUTR = APP_WATCHDOG_IDLE_WAKE - 1U; /** Keep-alive of the stopped timer, see RtcClock_Stop() **/
+	rtcclockwakeperiod = APP_WATCHDOG_IDLE_WAKE;
+	RTC->CR |= RTC_CR_WUTIE | RTC_CR_WUTE;
+#endif
+
+	RTC->WPR = RTCCLOCK_WPR_LOCK;
+
+	if(RtcClock_SetCalibration(APP_RTC_CALIBRATION_PPM) == false)
+	{
+		Error_Handler();
+	}
+
+	EXTI->IMR |= EXTI_IMR_MR22 | EXTI_IMR_MR17;
+	EXTI->RTSR |= EXTI_RTSR_TR22 | EXTI_RTSR_TR17;
+	HAL_NVIC_SetPriority(RTC_WKUP_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(RTC_WKUP_IRQn);
+	HAL_NVIC_SetPriority(RTC_Alarm_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(RTC_Alarm_IRQn);
+
+#if APP_TIMEBASE_DRIFT_MEASURE
+	RTCCLOCK_DRIFT_TIMER->DIER |= TIM_DIER_UIE; /** Free running reference, not started by the session **/
+	RTCCLOCK_DRIFT_TIMER->CR1 |= TIM_CR1_CEN;
+#endif
+}
+/*****************************************************************************
+ * @brief Starts counting session seconds.
+ *
+ * @details Restarts the prescalers so the first tick comes one full second
+ *          after the start, like a freshly started TIM3, then enables the
+ *          wake-up interrupt. After a pause (RtcClock_Stop() without
+ *          RtcClock_PhaseReset()) only the rest of the paused second is
+ *          counted: a shift delays the prescaler by that many SSR steps and
+ *          the wake-up timer runs once from RTC/16 (one SSR step per cycle)
+ *          until then. RtcClock_IRQHandler() goes back to ck_spre, whose
+ *          edges now come a whole second after the partial one.
+ *
+ * @param None
+ *
+ * @return HAL_StatusTypeDef
+ *
+ * @retval HAL_OK       Counting.
+ * @retval HAL_TIMEOUT  The RTC did not respond.
+ *
+ * @see RtcClock_Stop()
+ *****************************************************************************/
+HAL_StatusTypeDef RtcClock_Start(void)
+{
+	HAL_StatusTypeDef status = HAL_OK;
+
+	RTC->WPR = RTCCLOCK_WPR_KEY1;
+	RTC->WPR = RTCCLOCK_WPR_KEY2;
+
+	RTC->CR &= ~RTC_CR_WUTE;
+	if((rtcClockWaitFlag(&RTC->ISR, RTC_ISR_WUTWF, true, RTCCLOCK_TIMEOUT_MS) == false) ||
+	   (rtcClockRestartPrescaler() == false))
+	{
+		status = HAL_TIMEOUT;
+	}
+	else
+	{
+		uint32_t remaining = rtcclockremaining;
+		if((remaining != 0U) && (remaining <= (rtcclockprer & RTC_PRER_PREDIV_S)))
+		{
+			if(rtcClockWaitFlag(&RTC->ISR, RTC_ISR_SHPF, false, RTCCLOCK_TIMEOUT_MS))
+			{
+				RTC->SHIFTR = remaining; /** SUBFS delays ck_spre, SSR > PREDIV_S until then **/
+			}
+			else
+			{
+				status = HAL_TIMEOUT;
+			}
+			RTC->WUTR = remaining - 1U;
+			RTC->CR &= ~RTC_CR_WUCKSEL; /** RTC/16 **/
+			rtcclockpartial = true;
+		}
+		else
+		{
+			RTC->WUTR = 0U; /** 1 Hz, the stopped timer may have left the keep-alive period **/
+			RTC->CR = (RTC->CR & ~RTC_CR_WUCKSEL) | RTC_CR_WUCKSEL_2;
+			rtcclockpartial = false;
+		}
+		rtcclockwakeperiod = 1U;
+		rtcClockClearWakeup();
+#if APP_TIMEBASE_DRIFT_MEASURE
+		rtcdriftrestart = true; /** The phase jumped, start a new window **/
+#endif
+		rtcclockrunning = true;
+		RTC->CR |= RTC_CR_WUTIE | RTC_CR_WUTE;
+	}
+
+	RTC->WPR = RTCCLOCK_WPR_LOCK;
+	return status;
+}
+/*****************************************************************************
+ * @brief Stops counting session seconds.
+ *
+ * @details The SSR steps left of the current second are kept for the next
+ *          RtcClock_Start(), so a pause does not lose the started second.
+ *          The wake-up timer is disabled so an idle device is not woken
+ *          every second, unless the drift measurement needs it. With
+ *          APP_WATCHDOG it keeps running with the APP_WATCHDOG_IDLE_WAKE
+ *          period instead, the IWDG has to be fed while the MCU is in STOP;
+ *          APP_IDLE_TIMEOUT counts the idle time on the same wake-ups.
+ *
+ * @param None
+ *
+ * @return HAL_StatusTypeDef
+ *
+ * @retval HAL_OK       Stopped.
+ * @retval HAL_TIMEOUT  The keep-alive period could not be set.
+ *****************************************************************************/
+HAL_StatusTypeDef RtcClock_Stop(void)
+{
+	HAL_StatusTypeDef status = HAL_OK;
+
+	RTC->WPR = RTCCLOCK_WPR_KEY1;
+	RTC->WPR = RTCCLOCK_WPR_KEY2;
+	if(rtcclockrunning)
+	{
+		rtcclockremaining = rtcClockRemaining();
+	}
+	rtcclockrunning = false;
+#if APP_TIMEBASE_DRIFT_MEASURE
+	if(rtcclockpartial && (rtcClockSecondWakeup() == false))
+	{
+		status = HAL_TIMEOUT;
+	}
+#elif (APP_WATCHDOG || APP_IDLE_TIMEOUT)
+	RTC->CR &= ~RTC_CR_WUTE;
+	if(rtcClockWaitFlag(&RTC->ISR, RTC_ISR_WUTWF, true, RTCCLOCK_TIMEOUT_MS))
+	{
+		RTC->WUTR = APP_WATCHDOG_IDLE_WAKE - 1U;
+		RTC->CR = (RTC->CR & ~RTC_CR_WUCKSEL) | RTC_CR_WUCKSEL_2;
+		rtcclockwakeperiod = APP_WATCHDOG_IDLE_WAKE;
+		rtcClockClearWakeup();
+	}
+	else
+	{
+		status = HAL_TIMEOUT;
+	}
+	RTC->CR |= RTC_CR_WUTIE | RTC_CR_WUTE; /** Old period on a timeout, still a wake-up **/
+#else
+	RTC->CR &= ~(RTC_CR_WUTE | RTC_CR_WUTIE);
+#endif
+	rtcclockpartial = false;
+	RTC->WPR = RTCCLOCK_WPR_LOCK;
+	return status;
+}
+/*****************************************************************************
+ * @brief Drops the second kept by RtcClock_Stop().
+ *
+ * @details The next RtcClock_Start() counts a full first second, as for a
+ *          new session. Call with the timer stopped.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+void RtcClock_PhaseReset(void)
+{
+	rtcclockremaining = 0U;
+}
+/*****************************************************************************
+ * @brief Stops the wake-up timer and the blink alarm for STANDBY.
+ *
+ * @details Whatever keeps it running (drift measurement, watchdog
+ *          keep-alive, a paused timer), a wake-up would restart the
+ *          switched off timer.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+void RtcClock_Shutdown(void)
+{
+	rtcclockrunning = false;
+	rtcclockpartial = false;
+	__HAL_RCC_PWR_CLK_ENABLE();
+	PWR->CR |= PWR_CR_DBP;
+	RTC->WPR = RTCCLOCK_WPR_KEY1;
+	RTC->WPR = RTCCLOCK_WPR_KEY2;
+	RTC->CR &= ~(RTC_CR_WUTE | RTC_CR_WUTIE | RTC_CR_ALRAE | RTC_CR_ALRAIE);
+	RTC->WPR = RTCCLOCK_WPR_LOCK;
+	rtcClockClearWakeup();
+	rtcClockClearAlarm();
+}
+/*****************************************************************************
+ * @brief Starts or stops the half second alarm of the pause blink.
+ *
+ * @details Alarm A compares only the low 10 bits of SSR, all calendar
+ *          fields are masked, so it matches every 1024 SSR steps whatever
+ *          the time. It runs from the RTC like the seconds and wakes the
+ *          MCU from STOP on EXTI line 17, where the TIM4 software timers
+ *          are halted; the paused timer can stay in STOP between blinks.
+ *
+ * @param[in] enable  true while the timer is paused.
+ *
+ * @return HAL_StatusTypeDef
+ *
+ * @retval HAL_OK       Alarm started or stopped.
+ * @retval HAL_TIMEOUT  ALRAWF did not set, the alarm is left stopped.
+ *****************************************************************************/
+HAL_StatusTypeDef RtcClock_SetBlink(bool enable)
+{
+	HAL_StatusTypeDef status = HAL_OK;
+
+	RTC->WPR = RTCCLOCK_WPR_KEY1;
+	RTC->WPR = RTCCLOCK_WPR_KEY2;
+	RTC->CR &= ~(RTC_CR_ALRAE | RTC_CR_ALRAIE);
+	if(enable)
+	{
+		if(rtcClockWaitFlag(&RTC->ISR, RTC_ISR_ALRAWF, true, RTCCLOCK_TIMEOUT_MS))
+		{
+			RTC->ALRMAR = RTCCLOCK_BLINK_ALRMAR;
+			RTC->ALRMASSR = RTCCLOCK_BLINK_ALRMASSR;
+			rtcClockClearAlarm();
+			RTC->CR |= RTC_CR_ALRAIE | RTC_CR_ALRAE;
+		}
+		else
+		{
+			status = HAL_TIMEOUT;
+		}
+	}
+	RTC->WPR = RTCCLOCK_WPR_LOCK;
+	if(enable == false)
+	{
+		rtcClockClearAlarm();
+	}
+	return status;
+}
+/*****************************************************************************
+ * @brief Seconds between two wake-ups.
+ *
+ * @param None
+ *
+ * @return uint32_t 1 while counting, APP_WATCHDOG_IDLE_WAKE for the
+ *         keep-alive of the stopped timer.
+ *****************************************************************************/
+uint32_t RtcClock_GetWakePeriod(void)
+{
+	return rtcclockwakeperiod;
+}
+/*****************************************************************************
+ * @brief Programs the RTC smooth calibration.
+ *
+ * @details Over each 32 s cycle the RTC masks CALM RTCCLK pulses and, with
+ *          CALP, adds 512 pulses. One CALM step is 1 / 2^20 = 0.954 ppm:
+ *          a fast crystal (ppm > 0) is slowed with CALM = ppm * 1.048576,
+ *          a slow one uses CALP (+488.3 ppm) and masks the surplus.
+ *
+ * @param[in] ppm  LSE error in ppm, positive when the crystal runs fast.
+ *
+ * @return bool
+ *
+ * @retval true   Calibration applied.
+ * @retval false  ppm outside -488 ... +487, or the RTC did not respond.
+ *****************************************************************************/
+bool RtcClock_SetCalibration(int32_t ppm)
+{
+	uint32_t calr;
+
+	if((ppm < RTCCLOCK_CALIB_PPM_MIN) || (ppm > RTCCLOCK_CALIB_PPM_MAX))
+	{
+		return false;
+	}
+
+	if(ppm >= 0)
+	{
+		calr = (((uint32_t)ppm * 1048576U) + 500000U) / 1000000U;
+	}
+	else
+	{
+		calr = RTC_CALR_CALP | (512U - ((((uint32_t)(-ppm) * 1048576U) + 500000U) / 1000000U));
+	}
+
+	bool ok = false;
+	RTC->WPR = RTCCLOCK_WPR_KEY1;
+	RTC->WPR = RTCCLOCK_WPR_KEY2;
+	if(rtcClockWaitFlag(&RTC->ISR, RTC_ISR_RECALPF, false, RTCCLOCK_TIMEOUT_MS))
+	{
+		RTC->CALR = calr;
+		ok = true;
+	}
+	RTC->WPR = RTCCLOCK_WPR_LOCK;
+	return ok;
+}
+/*****************************************************************************
+ * @brief Returns the oscillator the RTC runs from.
+ *
+ * @param None
+ *
+ * @return RtcClockSource_e
+ *****************************************************************************/
+RtcClockSource_e RtcClock_GetSource(void)
+{
+	return rtcclocksource;
+}
+/*****************************************************************************
+ * @brief Handles the RTC wake-up interrupt.
+ *
+ * @param None
+ *
+ * @return bool
+ *
+ * @retval true   A session second elapsed.
+ * @retval false  Spurious, stopped, or drift-only wake-up.
+ *
+ * @note Called from RTC_WKUP_IRQHandler(). The wake-up that ends a partial
+ *       first second switches the timer back to ck_spre, which waits a few
+ *       RTCCLK cycles for WUTWF on the cycle counter (the SysTick does not
+ *       advance at this priority); a dead RTC ends in Error_Handler() after
+ *       RTCCLOCK_TIMEOUT_MS.
+ *****************************************************************************/
+bool RtcClock_IRQHandler(void)
+{
+	bool second = false;
+
+	if((RTC->ISR & RTC_ISR_WUTF) != 0U)
+	{
+#if APP_TIMEBASE_DRIFT_MEASURE
+		rtcClockDriftSample();
+#endif
+		second = rtcclockrunning;
+		if(rtcclockpartial)
+		{
+			rtcclockpartial = false;
+			RTC->WPR = RTCCLOCK_WPR_KEY1;
+			RTC->WPR = RTCCLOCK_WPR_KEY2;
+			bool ok = rtcClockSecondWakeup();
+			RTC->WPR = RTCCLOCK_WPR_LOCK;
+			if(ok == false)
+			{
+				Error_Handler();
+			}
+		}
+	}
+	rtcClockClearWakeup();
+	return second;
+}
+
+/*****************************************************************************
+ * @brief Handles the RTC alarm interrupt.
+ *
+ * @param None
+ *
+ * @return bool
+ *
+ * @retval true   The blink alarm matched.
+ * @retval false  Spurious.
+ *
+ * @note Called from RTC_Alarm_IRQHandler().
+ *****************************************************************************/
+bool RtcClock_AlarmIRQHandler(void)
+{
+	bool blink = ((RTC->ISR & RTC_ISR_ALRAF) != 0U) && ((RTC->CR & RTC_CR_ALRAE) != 0U);
+
+	rtcClockClearAlarm();
+	return blink;
+}
+
+#if APP_TIMEBASE_DRIFT_MEASURE
+/*****************************************************************************
+ * @brief Counts one update of the free running TIM3.
+ *
+ * @note Called from TIM3_IRQHandler(), at the priority of the RTC interrupt
+ *       that reads the count.
+ *****************************************************************************/
+void RtcClock_DriftTimerOverflow(void)
+{
+	rtcdriftoverflows++;
+}
+/*****************************************************************************
+ * @brief Returns the TIM3 drift of a completed measurement window.
+ *
+ * @details error = (TIM3 ticks - seconds * (ARR + 1)) / (seconds * (ARR + 1)).
+ *          The nominal length of a TIM3 second is taken from ARR + 1, so
+ *          the result is the error of the TIM3 based second counter,
+ *          including any ARR setting that is not an exact 1 Hz.
+ *
+ * @param[out] drift  Drift of the window in 0.1 ppm and its length.
+ *
+ * @return bool
+ *
+ * @retval true   A window completed, the next one starts at the next second.
+ * @retval false  Still measuring.
+ *****************************************************************************/
+bool RtcClock_GetDrift(RtcClockDrift_t *drift)
+{
+	uint32_t irqstate = APP_IRQ_SAVE();
+	APP_IRQ_DISABLE();
+	uint32_t seconds = rtcdriftseconds;
+	uint64_t ticks = rtcdriftticks;
+	bool complete = (rtcdriftrestart == false) && (seconds >= APP_TIMEBASE_DRIFT_PERIOD);
+	if(complete)
+	{
+		rtcdriftrestart = true;
+	}
+	APP_IRQ_RESTORE(irqstate);
+
+	if(complete)
+	{
+		int64_t expected = (int64_t)seconds * (RTCCLOCK_DRIFT_TIMER->ARR + 1U);
+		drift->ppmx10 = (int32_t)((((int64_t)ticks - expected) * 10000000LL) / expected);
+		drift->seconds = seconds;
+	}
+	return complete;
+}
+#endif
+/*************************************END*************************************/
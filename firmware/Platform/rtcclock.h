@@ -0,0 +1,175 @@
+/**
+ * \file           rtcclock.h
+ * \brief          RTC wake-up timer timebase header file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+#ifndef RTCCLOCK_H_
+#define RTCCLOCK_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "Platform_Translate.h"
+
+#if APP_TIMEBASE_DRIFT_MEASURE && (APP_TIMEBASE != APP_TIMEBASE_RTC)
+#error "APP_TIMEBASE_DRIFT_MEASURE needs APP_TIMEBASE_RTC, TIM3 must run free as the reference"
+#endif
+
+/*****************************************************************************/
+/* RTC Clock Enums                                                           */
+/*****************************************************************************/
+
+/**
+ * @brief Oscillator clocking the RTC.
+ */
+typedef enum
+{
+	RtcClockSource_Lse,     /**< 32.768 kHz crystal, the normal case */
+	RtcClockSource_Lsi,     /**< ~32 kHz RC fallback when the LSE did not start */
+}RtcClockSource_e;
+
+/*****************************************************************************/
+/* RTC Clock Types                                                           */
+/*****************************************************************************/
+
+/**
+ * @brief Result of one drift measurement window.
+ */
+typedef struct
+{
+	int32_t ppmx10;          /**< TIM3 error against the RTC in 0.1 ppm, positive = TIM3 fast */
+	uint32_t seconds;        /**< Length of the window in RTC seconds */
+}RtcClockDrift_t;
+
+/*****************************************************************************/
+/* RTC Clock Function Declarations                                           */
+/*****************************************************************************/
+
+/**
+ * @brief Starts the LSE (LSI as fallback), the RTC and its 1 Hz wake-up timer.
+ *
+ * @note Calls Error_Handler() if the RTC does not enter initialisation mode.
+ */
+void RtcClock_Init(void);
+
+/**
+ * @brief Starts posting one second ticks, the first one after the rest of
+ *        the second paused by RtcClock_Stop(), or a full second later.
+ *
+ * @return HAL_OK, same contract as HAL_TIM_Base_Start_IT().
+ */
+HAL_StatusTypeDef RtcClock_Start(void);
+
+/**
+ * @brief Stops posting one second ticks, keeping the rest of the current second.
+ *
+ * @return HAL_OK, HAL_TIMEOUT if the watchdog keep-alive could not be set.
+ */
+HAL_StatusTypeDef RtcClock_Stop(void);
+
+/**
+ * @brief Makes the next RtcClock_Start() count a full first second.
+ */
+void RtcClock_PhaseReset(void);
+
+/**
+ * @brief Stops the wake-up timer whatever uses it, before STANDBY.
+ */
+void RtcClock_Shutdown(void);
+
+/**
+ * @brief Starts or stops the half second RTC alarm that blinks the paused display.
+ *
+ * @param[in] enable  true while the timer is paused.
+ *
+ * @return HAL_OK, HAL_TIMEOUT if the alarm could not be set.
+ */
+HAL_StatusTypeDef RtcClock_SetBlink(bool enable);
+
+/**
+ * @brief Seconds between two wake-ups, see APP_WATCHDOG_IDLE_WAKE.
+ */
+uint32_t RtcClock_GetWakePeriod(void);
+
+/**
+ * @brief Programs the RTC smooth calibration.
+ *
+ * @param[in] ppm  LSE error in ppm, positive when the crystal runs fast.
+ *
+ * @return true if applied, false if outside -488 ... +487 ppm.
+ */
+bool RtcClock_SetCalibration(int32_t ppm);
+
+/**
+ * @brief Oscillator the RTC runs from.
+ *
+ * @return RtcClockSource_Lse or RtcClockSource_Lsi.
+ */
+RtcClockSource_e RtcClock_GetSource(void);
+
+/**
+ * @brief RTC wake-up interrupt handler, call from RTC_WKUP_IRQHandler().
+ *
+ * @return true if a session second elapsed and the tick must be counted.
+ */
+bool RtcClock_IRQHandler(void);
+
+/**
+ * @brief RTC alarm interrupt handler, call from RTC_Alarm_IRQHandler().
+ *
+ * @return true if the blink alarm matched.
+ */
+bool RtcClock_AlarmIRQHandler(void);
+
+#if APP_TIMEBASE_DRIFT_MEASURE
+/**
+ * @brief Counts a TIM3 update for the drift measurement, call from TIM3_IRQHandler().
+ */
+void RtcClock_DriftTimerOverflow(void);
+
+/**
+ * @brief Returns the drift of a completed window and starts the next one.
+ *
+ * @param[out] drift  Result of the window.
+ *
+ * @return true once APP_TIMEBASE_DRIFT_PERIOD seconds were measured.
+ */
+bool RtcClock_GetDrift(RtcClockDrift_t *drift);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RTCCLOCK_H_ */
@@ -0,0 +1,399 @@
+/**
+ * \file           timerwheel.c
+ * \brief          Hierarchical software timer wheel
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+/*
+ * Four levels of 64 slots. A timer due in less than 64 ticks sits in level
+ * 0, in the slot of its expiry tick; one due in less than 64^2 ticks in
+ * level 1, in the slot of its expiry tick / 64, and so on. When the wheel
+ * time reaches the start of an occupied slot of a coarser level, the slot
+ * is handed down: each of its timers is queued again, now into a finer
+ * level. A timer is handed down at most three times, so start, stop and
+ * expiry are O(1).
+ *
+ * An occupancy bit per slot gives the next slot to visit with one count of
+ * trailing zeros per level; TimerWheel_Advance() jumps straight to it, and
+ * TimerWheel_NextEvent() tells the hardware compare when to wake up.
+ */
+
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "timerwheel.h"
+
+/*****************************************************************************/
+/* Private Defines                                                           */
+/*****************************************************************************/
+#define TIMERWHEEL_SLOT_MASK        (TIMERWHEEL_SLOTS - 1UL)                   /** Slot index bits **/
+#define TIMERWHEEL_SHIFT(level)     ((level) * TIMERWHEEL_LEVEL_BITS)           /** Tick bits below a slot of the level **/
+
+/*****************************************************************************/
+/* Private Functions                                                         */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Links a started timer into the slot of its expiry.
+ *
+ * @details The level comes from the ticks left, the slot from the expiry
+ *          tick itself, so a slot keeps its meaning while the time moves.
+ *
+ * @param[in] wheel  Wheel.
+ * @param[in] timer  Timer with expires set, not queued.
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+static void timerWheelQueue(TimerWheel_t *wheel, TimerWheelTimer_t *timer)
+{
+	uint32_t left = timer->expires - wheel->now;
+	uint32_t level = 0;
+
+	while((level < (TIMERWHEEL_LEVELS - 1U)) && ((left >> TIMERWHEEL_SHIFT(level + 1U)) != 0U))
+	{
+		level++;
+	}
+	uint32_t index = (timer->expires >> TIMERWHEEL_SHIFT(level)) & TIMERWHEEL_SLOT_MASK;
+	TimerWheelTimer_t **head = &wheel->slots[level][index];
+
+	timer->level = (uint8_t)level;
+	timer->index = (uint8_t)index;
+	timer->next = *head;
+	if(timer->next != NULL)
+	{
+		timer->next->pprev = &timer->next;
+	}
+	timer->pprev = head;
+	*head = timer;
+	wheel->occupied[level] |= (1ULL << index);
+	wheel->count++;
+}
+/*****************************************************************************
+ * @brief Unlinks a queued timer.
+ *
+ * @details The timer may sit in a slot or in a list taken out of one by
+ *          TimerWheel_Advance(); the occupancy bit is only cleared for an
+ *          empty slot.
+ *
+ * @param[in] wheel  Wheel.
+ * @param[in] timer  Queued timer.
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+static void timerWheelUnlink(TimerWheel_t *wheel, TimerWheelTimer_t *timer)
+{
+	*timer->pprev = timer->next;
+	if(timer->next != NULL)
+	{
+		timer->next->pprev = timer->pprev;
+	}
+	timer->next = NULL;
+	timer->pprev = NULL;
+	if(wheel->slots[timer->level][timer->index] == NULL)
+	{
+		wheel->occupied[timer->level] &= ~(1ULL << timer->index);
+	}
+	wheel->count--;
+}
+/*****************************************************************************
+ * @brief Takes all timers out of a slot into a list of the caller.
+ *
+ * @param[in]  wheel  Wheel.
+ * @param[in]  level  Level.
+ * @param[in]  index  Slot.
+ * @param[out] list   Head of the list.
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+static void timerWheelTake(TimerWheel_t *wheel, uint32_t level, uint32_t index, TimerWheelTimer_t **list)
+{
+	*list = wheel->slots[level][index];
+	if(*list != NULL)
+	{
+		(*list)->pprev = list;
+	}
+	wheel->slots[level][index] = NULL;
+	wheel->occupied[level] &= ~(1ULL << index);
+}
+/*****************************************************************************
+ * @brief Ticks from the wheel time to the next occupied slot.
+ *
+ * @details The slot at the current index of a level is a full turn away:
+ *          level 0 expires its slot when it gets there, the coarser levels
+ *          only hold timers of the next turn in it.
+ *
+ * @param[in] wheel  Wheel with at least one timer.
+ *
+ * @return uint32_t Ticks, at least 1.
+ *****************************************************************************/
+static uint32_t timerWheelNextDistance(const TimerWheel_t *wheel)
+{
+	uint32_t distance = UINT32_MAX;
+
+	for(uint32_t level = 0; level < TIMERWHEEL_LEVELS; level++)
+	{
+		uint64_t occupied = wheel->occupied[level];
+		if(occupied == 0U)
+		{
+			continue;
+		}
+		uint32_t block = wheel->now >> TIMERWHEEL_SHIFT(level);
+		uint32_t shift = (block + 1U) & TIMERWHEEL_SLOT_MASK;
+		uint64_t rotated = (shift == 0U) ? occupied : ((occupied >> shift) | (occupied << (TIMERWHEEL_SLOTS - shift)));
+		uint32_t slots = (uint32_t)__builtin_ctzll(rotated) + 1U;
+		uint32_t ticks = ((block + slots) << TIMERWHEEL_SHIFT(level)) - wheel->now;
+		if(ticks < distance)
+		{
+			distance = ticks;
+		}
+	}
+	return distance;
+}
+
+/*****************************************************************************/
+/* Timer Wheel Functions                                                     */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Empties the wheel and sets its time.
+ *
+ * @param[in] wheel  Wheel.
+ * @param[in] now    Current tick.
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Timers still marked as queued must not be used with the wheel
+ *       again before they are started.
+ *****************************************************************************/
+void TimerWheel_Init(TimerWheel_t *wheel, uint32_t now)
+{
+	for(uint32_t level = 0; level < TIMERWHEEL_LEVELS; level++)
+	{
+		for(uint32_t index = 0; index < TIMERWHEEL_SLOTS; index++)
+		{
+			wheel->slots[level][index] = NULL;
+		}
+		wheel->occupied[level] = 0U;
+	}
+	wheel->now = now;
+	wheel->count = 0U;
+}
+/*****************************************************************************
+ * @brief Starts (or restarts) a timer.
+ *
+ * @details The expiry counts from now, which may be ahead of the wheel time
+ *          between two advances. An empty wheel simply moves its time to
+ *          now.
+ *
+ * @param[in] wheel     Wheel.
+ * @param[in] timer     Timer.
+ * @param[in] now       Current tick.
+ * @param[in] delay     Ticks to the first expiry, clamped to
+ *                      1 ... TIMERWHEEL_MAX_TICKS.
+ * @param[in] period    Ticks between later expiries, 0 = one-shot; clamped
+ *                      to TIMERWHEEL_MAX_TICKS.
+ * @param[in] callback  Called from TimerWheel_Advance() on expiry.
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Not reentrant, the caller keeps the wheel from being used by an
+ *       interrupt meanwhile.
+ *****************************************************************************/
+void TimerWheel_Start(TimerWheel_t *wheel, TimerWheelTimer_t *timer, uint32_t now, uint32_t delay,
+		uint32_t period, TimerWheelCallback_t callback)
+{
+	if(timer->pprev != NULL)
+	{
+		timerWheelUnlink(wheel, timer);
+	}
+	if(wheel->count == 0U)
+	{
+		wheel->now = now;
+	}
+	else if((int32_t)(now - wheel->now) < 0)
+	{
+		now = wheel->now;
+	}
+	if(delay == 0U)
+	{
+		delay = 1U;
+	}
+	uint32_t ahead = now - wheel->now;
+	if(delay > (TIMERWHEEL_MAX_TICKS - ahead))
+	{
+		delay = TIMERWHEEL_MAX_TICKS - ahead;
+	}
+
+	timer->expires = now + delay;
+	timer->period = (period > TIMERWHEEL_MAX_TICKS) ? TIMERWHEEL_MAX_TICKS : period;
+	timer->callback = callback;
+	timerWheelQueue(wheel, timer);
+}
+/*****************************************************************************
+ * @brief Stops a timer.
+ *
+ * @param[in] wheel  Wheel.
+ * @param[in] timer  Timer, stopped already is fine.
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note May be called from a callback, also for a timer due in the same
+ *       tick.
+ *****************************************************************************/
+void TimerWheel_Stop(TimerWheel_t *wheel, TimerWheelTimer_t *timer)
+{
+	if(timer->pprev != NULL)
+	{
+		timerWheelUnlink(wheel, timer);
+	}
+}
+/*****************************************************************************
+ * @brief Whether a timer is queued.
+ *
+ * @param[in] timer  Timer.
+ *
+ * @return bool true from the start until the last expiry or the stop.
+ *****************************************************************************/
+bool TimerWheel_IsRunning(const TimerWheelTimer_t *timer)
+{
+	return (timer->pprev != NULL);
+}
+/*****************************************************************************
+ * @brief Moves the wheel time to now and calls every timer due.
+ *
+ * @details Jumps from one occupied slot to the next. At the start of a
+ *          slot of a coarser level the slot is handed down, coarsest
+ *          first, then the level 0 slot of the tick expires. A periodic
+ *          timer is queued again at its last expiry plus its period before
+ *          its callback runs, so it does not drift and the callback may
+ *          stop it.
+ *
+ * @param[in] wheel  Wheel.
+ * @param[in] now    Current tick.
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Callbacks run with the wheel time at their expiry and may start
+ *       and stop any timer.
+ *****************************************************************************/
+void TimerWheel_Advance(TimerWheel_t *wheel, uint32_t now)
+{
+	TimerWheelTimer_t *list;
+
+	while(wheel->count != 0U)
+	{
+		uint32_t step = timerWheelNextDistance(wheel);
+		if((int32_t)(now - wheel->now) < (int32_t)step)
+		{
+			break;
+		}
+		wheel->now += step;
+
+		for(uint32_t level = TIMERWHEEL_LEVELS - 1U; level > 0U; level--)
+		{
+			uint32_t shift = TIMERWHEEL_SHIFT(level);
+			if((wheel->now & ((1UL << shift) - 1UL)) != 0U)
+			{
+				continue;
+			}
+			timerWheelTake(wheel, level, (wheel->now >> shift) & TIMERWHEEL_SLOT_MASK, &list);
+			while(list != NULL)
+			{
+				TimerWheelTimer_t *timer = list;
+				timerWheelUnlink(wheel, timer);
+				timerWheelQueue(wheel, timer);
+			}
+		}
+
+		timerWheelTake(wheel, 0U, wheel->now & TIMERWHEEL_SLOT_MASK, &list);
+		while(list != NULL)
+		{
+			TimerWheelTimer_t *timer = list;
+			timerWheelUnlink(wheel, timer);
+			if(timer->period != 0U)
+			{
+				timer->expires += timer->period;
+				timerWheelQueue(wheel, timer);
+			}
+			if(timer->callback != NULL)
+			{
+				timer->callback(timer);
+			}
+		}
+	}
+	if((int32_t)(now - wheel->now) > 0)
+	{
+		wheel->now = now;
+	}
+}
+/*****************************************************************************
+ * @brief Tick at which the wheel next needs TimerWheel_Advance().
+ *
+ * @param[in]  wheel  Wheel.
+ * @param[out] at     Tick of the next occupied slot: the expiry of a level 0
+ *                    timer, or the start of a coarser slot to hand down.
+ *
+ * @return bool
+ *
+ * @retval true   at is set.
+ * @retval false  No timer queued.
+ *****************************************************************************/
+bool TimerWheel_NextEvent(const TimerWheel_t *wheel, uint32_t *at)
+{
+	if(wheel->count == 0U)
+	{
+		return false;
+	}
+	*at = wheel->now + timerWheelNextDistance(wheel);
+	return true;
+}
+/*****************************************************************************
+ * @brief Number of timers queued.
+ *
+ * @param[in] wheel  Wheel.
+ *
+ * @return uint32_t Timers started and not yet expired or stopped.
+ *****************************************************************************/
+uint32_t TimerWheel_GetCount(const TimerWheel_t *wheel)
+{
+	return wheel->count;
+}
+/*************************************END*************************************/
@@ -0,0 +1,168 @@
+/**
+ * \file           timerwheel.h
+ * \brief          Hierarchical software timer wheel header file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+#ifndef TIMERWHEEL_H_
+#define TIMERWHEEL_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*****************************************************************************/
+/* Timer Wheel Macros                                                        */
+/*****************************************************************************/
+
+/**
+ * @brief Index bits of one wheel level, 64 slots.
+ */
+#define TIMERWHEEL_LEVEL_BITS                6U
+
+/**
+ * @brief Slots of one wheel level.
+ */
+#define TIMERWHEEL_SLOTS                     (1UL << TIMERWHEEL_LEVEL_BITS)
+
+/**
+ * @brief Wheel levels, each 64 times coarser than the one below.
+ */
+#define TIMERWHEEL_LEVELS                    4U
+
+/**
+ * @brief Longest delay in ticks, 2^24 - 1.
+ */
+#define TIMERWHEEL_MAX_TICKS                 ((1UL << (TIMERWHEEL_LEVEL_BITS * TIMERWHEEL_LEVELS)) - 1UL)
+
+/*****************************************************************************/
+/* Timer Wheel Types                                                         */
+/*****************************************************************************/
+
+typedef struct TimerWheelTimer_s TimerWheelTimer_t;
+
+/**
+ * @brief Called when a timer expires, with the timer that expired.
+ */
+typedef void (*TimerWheelCallback_t)(TimerWheelTimer_t *timer);
+
+/*****************************************************************************/
+/* Timer Wheel Structures                                                    */
+/*****************************************************************************/
+
+/**
+ * @brief One timer, owned by the caller; a zeroed timer is stopped.
+ */
+struct TimerWheelTimer_s
+{
+	TimerWheelTimer_t *next;          /**< Next timer in the slot */
+	TimerWheelTimer_t **pprev;        /**< Link pointing at this timer, NULL while stopped */
+	uint32_t expires;                 /**< Tick of the expiry */
+	uint32_t period;                  /**< Reload in ticks, 0 = one-shot */
+	TimerWheelCallback_t callback;    /**< Called on expiry */
+	uint8_t level;                    /**< Level of the slot while queued */
+	uint8_t index;                    /**< Slot in the level while queued */
+};
+
+/**
+ * @brief Wheel state, a slot list head and an occupancy bit per slot.
+ */
+typedef struct
+{
+	TimerWheelTimer_t *slots[TIMERWHEEL_LEVELS][TIMERWHEEL_SLOTS]; /**< Timers of each slot */
+	uint64_t occupied[TIMERWHEEL_LEVELS]; /**< Bit n set while slot n has timers */
+	uint32_t now;                     /**< Tick the wheel was advanced to */
+	uint32_t count;                   /**< Timers queued */
+}TimerWheel_t;
+
+/*****************************************************************************/
+/* Timer Wheel Function Declarations                                         */
+/*****************************************************************************/
+
+/**
+ * @brief Empties the wheel and sets its time.
+ */
+void TimerWheel_Init(TimerWheel_t *wheel, uint32_t now);
+
+/**
+ * @brief Starts (or restarts) a timer, O(1).
+ *
+ * @param[in] wheel     Wheel.
+ * @param[in] timer     Timer, stays in use until it expires or is stopped.
+ * @param[in] now       Current tick, at or after the wheel time.
+ * @param[in] delay     Ticks to the first expiry, 1 ... TIMERWHEEL_MAX_TICKS.
+ * @param[in] period    Ticks between later expiries, 0 = one-shot.
+ * @param[in] callback  Called from TimerWheel_Advance() on expiry.
+ */
+void TimerWheel_Start(TimerWheel_t *wheel, TimerWheelTimer_t *timer, uint32_t now, uint32_t delay,
+		uint32_t period, TimerWheelCallback_t callback);
+
+/**
+ * @brief Stops a timer, no callback follows; O(1).
+ */
+void TimerWheel_Stop(TimerWheel_t *wheel, TimerWheelTimer_t *timer);
+
+/**
+ * @brief Whether a timer is queued.
+ */
+bool TimerWheel_IsRunning(const TimerWheelTimer_t *timer);
+
+/**
+ * @brief Moves the wheel time to now and calls every timer due.
+ */
+void TimerWheel_Advance(TimerWheel_t *wheel, uint32_t now);
+
+/**
+ * @brief Tick at which the wheel next needs TimerWheel_Advance().
+ *
+ * @param[in]  wheel  Wheel.
+ * @param[out] at     Expiry of the next timer, or a slot of the coarser
+ *                    levels to hand down first.
+ *
+ * @return false if no timer is queued.
+ */
+bool TimerWheel_NextEvent(const TimerWheel_t *wheel, uint32_t *at);
+
+/**
+ * @brief Number of timers queued.
+ */
+uint32_t TimerWheel_GetCount(const TimerWheel_t *wheel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIMERWHEEL_H_ */
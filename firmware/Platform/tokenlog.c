@@ -0,0 +1,107 @@
+/**
+ * \file           tokenlog.c
+ * \brief          Tokenized binary log source file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "main.h"   /** stdUtil_write() **/
+#include "tokenlog.h"
+/*****************************************************************************/
+/* Private Functions                                                         */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Appends one value as unsigned LEB128.
+ *
+ * @param[out] frame     Frame buffer.
+ * @param[in]  position  Next free byte.
+ * @param[in]  value     Value.
+ *
+ * @return uint32_t Next free byte, 1 to 5 bytes later.
+ *****************************************************************************/
+static inline uint32_t tokenLogPut(uint8_t *frame, uint32_t position, uint32_t value)
+{
+	while(value >= 0x80U)
+	{
+		frame[position++] = (uint8_t)(value | 0x80U);
+		value >>= 7;
+	}
+	frame[position++] = (uint8_t)value;
+	return position;
+}
+
+/*****************************************************************************/
+/* Token Log Functions                                                       */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Encodes one frame and hands it to stdUtil_write().
+ *
+ * @details The frame is built on the stack and written as one block, so
+ *          the UART output queues or drops it as a whole and the stream
+ *          stays in sync. Costs a few cycles per argument byte plus the
+ *          write, no formatting.
+ *
+ * @param[in] format  Format string in the .tokenlog section.
+ * @param[in] args    Arguments.
+ * @param[in] count   Number of arguments.
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @see TOKEN_LOG(), Tools/tokenlog_decode.py
+ *****************************************************************************/
+void TokenLog_Write(const char *format, const uint32_t *args, uint32_t count)
+{
+	uint8_t frame[TOKENLOG_FRAME_MAX];
+	uint32_t length;
+	uint8_t sum = 0;
+
+	if(count > TOKENLOG_MAX_ARGS)
+	{
+		count = TOKENLOG_MAX_ARGS;
+	}
+
+	length = tokenLogPut(frame, 2U, (uint32_t)(uintptr_t)format);
+	for(uint32_t i = 0; i < count; i++)
+	{
+		length = tokenLogPut(frame, length, args[i]);
+	}
+	frame[0] = TOKENLOG_SYNC;
+	frame[1] = (uint8_t)(length - 2U);
+	for(uint32_t i = 1; i < length; i++)
+	{
+		sum += frame[i];
+	}
+	frame[length++] = (uint8_t)(0xFFU - sum);
+
+	stdUtil_write((const char *)frame, length);
+}
+/*************************************END*************************************/
@@ -0,0 +1,144 @@
+/**
+ * \file           tokenlog.h
+ * \brief          Tokenized binary log header file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+#ifndef TOKENLOG_H_
+#define TOKENLOG_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include <stdint.h>
+#include "AppConfig.h"   /** Not main.h, a host capture may define stdUtil_write() next to it **/
+
+/*
+ * Frame sent for every TOKEN_LOG() call, through stdUtil_write():
+ *
+ *   0xA5  length  id  argument ...  checksum
+ *
+ * length   bytes of id and arguments
+ * id       address of the format string in the .tokenlog section
+ * argument the 32-bit arguments in call order
+ * checksum 0xFF minus the sum of length, id and arguments, modulo 256
+ *
+ * The id and the arguments are unsigned LEB128 (7 bits per byte, the top bit
+ * set on all but the last byte), so small values take one byte.
+ */
+
+/*****************************************************************************/
+/* Token Log Macros                                                          */
+/*****************************************************************************/
+
+/**
+ * @brief First byte of every frame.
+ */
+#define TOKENLOG_SYNC                        0xA5U
+
+/**
+ * @brief Most arguments of one TOKEN_LOG() call.
+ */
+#define TOKENLOG_MAX_ARGS                    8U
+
+/**
+ * @brief Longest frame in bytes: sync, length, id, arguments, checksum.
+ */
+#define TOKENLOG_FRAME_MAX                   (3U + (5U * (1U + TOKENLOG_MAX_ARGS)))
+
+/**
+ * @brief Sends a log line as a frame, formatted later on the host.
+ *
+ * @details The format string is placed in the .tokenlog section, which the
+ *          linker script keeps out of the flash image, and only its address
+ *          is sent. Every argument is converted to uint32_t; %d and %i are
+ *          printed signed by the decoder, %c as a character and %s is read
+ *          from the ELF, so it must point to a string constant in flash
+ *          (pass it through TOKENLOG_STRING()). Floating point arguments are
+ *          not supported.
+ *
+ * @param[in] format  printf format, a string literal.
+ * @param[in] ...     Up to TOKENLOG_MAX_ARGS integer arguments.
+ */
+#define TOKEN_LOG(format, ...) do { \
+	static const char tokenlogformat[] __attribute__((section(".tokenlog"), used)) = format; \
+	const uint32_t tokenlogargs[] = { 0U, ##__VA_ARGS__ }; \
+	_Static_assert((sizeof(tokenlogargs) / sizeof(tokenlogargs[0])) <= (TOKENLOG_MAX_ARGS + 1U), "too many TOKEN_LOG() arguments"); \
+	TokenLog_Write(tokenlogformat, &tokenlogargs[1], (uint32_t)(sizeof(tokenlogargs) / sizeof(tokenlogargs[0])) - 1U); \
+	} while(0)
+
+/**
+ * @brief Passes a string constant to TOKEN_LOG() as its flash address.
+ */
+#define TOKENLOG_STRING(text)                ((uint32_t)(uintptr_t)(text))
+
+#if APP_DEBUG_TOKENIZED
+/**
+ * @brief Debug log line, tokenized (see APP_DEBUG_TOKENIZED).
+ */
+#define DEBUG_LOG(format, ...)               TOKEN_LOG(format, ##__VA_ARGS__)
+
+/**
+ * @brief String argument of DEBUG_LOG().
+ */
+#define DEBUG_LOG_STRING(text)               TOKENLOG_STRING(text)
+#else
+/**
+ * @brief Debug log line, formatted on the target (see APP_DEBUG_TOKENIZED).
+ */
+#define DEBUG_LOG(format, ...)               debugPrintf(format, ##__VA_ARGS__)
+
+/**
+ * @brief String argument of DEBUG_LOG().
+ */
+#define DEBUG_LOG_STRING(text)               (text)
+#endif
+
+/*****************************************************************************/
+/* Token Log Function Declarations                                           */
+/*****************************************************************************/
+
+/**
+ * @brief Encodes one frame and hands it to stdUtil_write(), use TOKEN_LOG().
+ *
+ * @param[in] format  Format string in the .tokenlog section.
+ * @param[in] args    Arguments.
+ * @param[in] count   Number of arguments, at most TOKENLOG_MAX_ARGS.
+ */
+void TokenLog_Write(const char *format, const uint32_t *args, uint32_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOKENLOG_H_ */
@@ -0,0 +1,318 @@
+/**
+ * \file           watchdog.c
+ * \brief          IWDG supervisor and reset cause source file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "watchdog.h"
+#include "tokenlog.h"
+
+/*****************************************************************************/
+/* Private Defines                                                           */
+/*****************************************************************************/
+#define WATCHDOG_PRESCALER_DIV     256U         /** LSI divider **/
+#define WATCHDOG_PRESCALER_PR      6U           /** IWDG_PR value of the divider **/
+#define WATCHDOG_RELOAD            4095U        /** Largest reload: 32.8 s at 32 kHz **/
+#define WATCHDOG_LSI_MAX_HZ        47000U       /** Fastest LSI in the datasheet, 22.3 s **/
+
+_Static_assert(((uint64_t)APP_WATCHDOG_IDLE_WAKE * WATCHDOG_LSI_MAX_HZ) <
+               ((uint64_t)(WATCHDOG_RELOAD + 1U) * WATCHDOG_PRESCALER_DIV),
+               "APP_WATCHDOG_IDLE_WAKE must be shorter than the shortest IWDG period");
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+/**
+ * @brief Seconds each task may go without checking in.
+ *
+ * @details The supervisor clock moves with the RTC wake-ups, one second at
+ *          a time with the timer running and APP_WATCHDOG_IDLE_WAKE seconds
+ *          while it is stopped; a pass that finds a task late is not fed,
+ *          the next one may be. The buzzer only checks in when silent, its
+ *          deadline covers the longest queued cues.
+ */
+static const uint8_t watchdogdeadlines[WatchdogTask_Count] =
+{
+	[WatchdogTask_Input]   = 2U,
+	[WatchdogTask_Session] = 2U,
+	[WatchdogTask_Display] = 2U,
+	[WatchdogTask_Buzzer]  = 15U,
+};
+
+static const char *const watchdogcausenames[ResetCause_Count] =
+{
+	[ResetCause_PowerOn]        = "power-on",
+	[ResetCause_Brownout]       = "brownout",
+	[ResetCause_Pin]            = "pin",
+	[ResetCause_Software]       = "software",
+	[ResetCause_Watchdog]       = "watchdog",
+	[ResetCause_WindowWatchdog] = "window watchdog",
+	[ResetCause_LowPower]       = "low-power",
+	[ResetCause_Wakeup]         = "wake-up",
+}; /** Names printed by Watchdog_Report() **/
+
+static volatile uint32_t watchdogseconds = 0; /** Supervisor clock, RTC wake-up interrupt only **/
+
+static uint32_t watchdogcheckins = 0; /** Tasks checked in since the last pass **/
+
+static uint32_t watchdoglast[WatchdogTask_Count]; /** Supervisor clock at each task's last check-in **/
+
+static ResetCause_e watchdogcause = ResetCause_PowerOn; /** Read by Watchdog_Init() **/
+
+static uint32_t watchdoglatetasks = 0; /** Late tasks before a watchdog reset **/
+
+static uint32_t watchdoglate[2] __attribute__((section(".noinit"))); /** Late tasks of the last unfed pass and their complement, kept over the reset **/
+
+/*****************************************************************************/
+/* Private Functions                                                         */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Decodes the RCC reset flags.
+ *
+ * @details A power-on also sets the brownout and pin flags, the IWDG also
+ *          pulls NRST, so the flags are tested from the most specific one.
+ *          A wake-up from STANDBY by the WKUP pin sets none of them.
+ *
+ * @param[in] flags    RCC->CSR.
+ * @param[in] standby  The MCU was in STANDBY.
+ *
+ * @return ResetCause_e Reset cause.
+ *****************************************************************************/
+static ResetCause_e watchdogDecodeCause(uint32_t flags, bool standby)
+{
+	if((flags & RCC_CSR_LPWRRSTF) != 0U)
+	{
+		return ResetCause_LowPower;
+	}
+	if((flags & RCC_CSR_WWDGRSTF) != 0U)
+	{
+		return ResetCause_WindowWatchdog;
+	}
+	if((flags & RCC_CSR_IWDGRSTF) != 0U)
+	{
+		return ResetCause_Watchdog;
+	}
+	if((flags & RCC_CSR_SFTRSTF) != 0U)
+	{
+		return ResetCause_Software;
+	}
+	if((flags & RCC_CSR_PORRSTF) != 0U)
+	{
+		return ResetCause_PowerOn;
+	}
+	if((flags & RCC_CSR_BORRSTF) != 0U)
+	{
+		return ResetCause_Brownout;
+	}
+	if(standby && ((flags & RCC_CSR_PINRSTF) == 0U))
+	{
+		return ResetCause_Wakeup;
+	}
+	return ResetCause_Pin;
+}
+
+/*****************************************************************************/
+/* Watchdog Functions                                                        */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Reads and clears the reset cause.
+ *
+ * @details The IWDG cannot be stopped and keeps counting in STANDBY, so a
+ *          switched off timer is reset by it once. That start finds the
+ *          STANDBY flag with a watchdog reset and goes straight back: the
+ *          reset stopped the IWDG, so it stays there until NRST or a power
+ *          cycle. Any other start clears the STANDBY flag.
+ *
+ * @param None
+ *
+ * @return bool true to go back to STANDBY.
+ *
+ * @note Call after SystemClock_Config(), the PWR clock must be on.
+ *****************************************************************************/
+bool Watchdog_Init(void)
+{
+	bool standby = APP_STANDBY_FLAG();
+
+	watchdogcause = watchdogDecodeCause(APP_RESET_FLAGS(), standby);
+	APP_RESET_FLAGS_CLEAR();
+
+	if(standby && (watchdogcause == ResetCause_Watchdog))
+	{
+		return true;
+	}
+	if(standby)
+	{
+		APP_STANDBY_FLAG_CLEAR();
+	}
+
+	watchdoglatetasks = 0U;
+	if((watchdogcause == ResetCause_Watchdog) && (watchdoglate[1] == ~watchdoglate[0]))
+	{
+		watchdoglatetasks = watchdoglate[0];
+	}
+	watchdoglate[0] = 0U;
+	watchdoglate[1] = ~0U;
+	return false;
+}
+/*****************************************************************************
+ * @brief Starts the IWDG.
+ *
+ * @details LSI / 256 with the largest reload: 22 ... 62 s over the LSI
+ *          tolerance, 32.8 s nominal. Every task starts as checked in.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Only a reset stops the IWDG again.
+ *****************************************************************************/
+void Watchdog_Start(void)
+{
+	uint32_t now = watchdogseconds;
+
+	for(uint32_t task = 0; task < WatchdogTask_Count; task++)
+	{
+		watchdoglast[task] = now;
+	}
+	watchdogcheckins = 0U;
+	APP_WATCHDOG_START(WATCHDOG_PRESCALER_PR, WATCHDOG_RELOAD);
+}
+/*****************************************************************************
+ * @brief Reports a task alive.
+ *
+ * @param[in] task  Task.
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Main loop only.
+ *****************************************************************************/
+void Watchdog_CheckIn(WatchdogTask_e task)
+{
+	watchdogcheckins |= (1UL << task);
+}
+/*****************************************************************************
+ * @brief Feeds the IWDG if every task checked in within its deadline.
+ *
+ * @details Called once per scheduler pass, before the MCU sleeps. A pass
+ *          that finds a late task leaves the IWDG alone and keeps the late
+ *          tasks in .noinit RAM, so the report after the reset names them.
+ *          A hang inside a task never gets here, the IWDG then runs out on
+ *          its own.
+ *
+ * @param None
+ *
+ * @return bool true if fed.
+ *
+ * @note Main loop only.
+ *****************************************************************************/
+bool Watchdog_Service(void)
+{
+	uint32_t now = watchdogseconds;
+	uint32_t late = 0U;
+
+	for(uint32_t task = 0; task < WatchdogTask_Count; task++)
+	{
+		if((watchdogcheckins & (1UL << task)) != 0U)
+		{
+			watchdoglast[task] = now;
+		}
+		else if((now - watchdoglast[task]) > watchdogdeadlines[task])
+		{
+			late |= (1UL << task);
+		}
+	}
+	watchdogcheckins = 0U;
+
+	if(late != 0U)
+	{
+		watchdoglate[0] = late;
+		watchdoglate[1] = ~late;
+		return false;
+	}
+	APP_WATCHDOG_FEED();
+	return true;
+}
+/*****************************************************************************
+ * @brief Moves the supervisor clock forward.
+ *
+ * @param[in] seconds  Seconds since the last wake-up.
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Runs in RTC_WKUP_IRQHandler().
+ *****************************************************************************/
+void Watchdog_ElapsedFromISR(uint32_t seconds)
+{
+	watchdogseconds = watchdogseconds + seconds;
+}
+/*****************************************************************************
+ * @brief Reset cause read by Watchdog_Init().
+ *
+ * @param None
+ *
+ * @return ResetCause_e Reset cause.
+ *****************************************************************************/
+ResetCause_e Watchdog_GetResetCause(void)
+{
+	return watchdogcause;
+}
+/*****************************************************************************
+ * @brief Tasks that were late when the IWDG last reset the MCU.
+ *
+ * @param None
+ *
+ * @return uint32_t Bit per WatchdogTask_e, 0 after any other reset.
+ *****************************************************************************/
+uint32_t Watchdog_GetLateTasks(void)
+{
+	return watchdoglatetasks;
+}
+/*****************************************************************************
+ * @brief Prints the reset cause through DEBUG_LOG().
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+void Watchdog_Report(void)
+{
+	DEBUG_LOG("reset: %s late %02lx\r\n", DEBUG_LOG_STRING(watchdogcausenames[watchdogcause]),
+			(unsigned long)watchdoglatetasks);
+}
+/*************************************END*************************************/
@@ -0,0 +1,140 @@
+/**
+ * \file           watchdog.h
+ * \brief          IWDG supervisor and reset cause header file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+#ifndef WATCHDOG_H_
+#define WATCHDOG_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "Platform_Translate.h"
+
+#if APP_WATCHDOG && (APP_TIMEBASE != APP_TIMEBASE_RTC)
+#error "APP_WATCHDOG needs APP_TIMEBASE_RTC, the RTC wake-up timer feeds the idle MCU"
+#endif
+
+/*****************************************************************************/
+/* Watchdog Enums                                                            */
+/*****************************************************************************/
+
+/**
+ * @brief Tasks that have to check in for the watchdog to be fed.
+ */
+typedef enum
+{
+	WatchdogTask_Input,               /**< Event queue drained, buttons handled */
+	WatchdogTask_Session,             /**< Session engine updated */
+	WatchdogTask_Display,             /**< Display bus idle, no frame stuck */
+	WatchdogTask_Buzzer,              /**< Buzzer silent */
+	WatchdogTask_Count,               /**< Number of tasks */
+}WatchdogTask_e;
+
+/**
+ * @brief Why the MCU last started, from the RCC reset flags.
+ */
+typedef enum
+{
+	ResetCause_PowerOn,               /**< Power-on or power-down reset */
+	ResetCause_Brownout,              /**< Brownout reset */
+	ResetCause_Pin,                   /**< NRST pin (reset button) */
+	ResetCause_Software,              /**< NVIC_SystemReset(), e.g. after a recorded fault */
+	ResetCause_Watchdog,              /**< Independent watchdog */
+	ResetCause_WindowWatchdog,        /**< Window watchdog */
+	ResetCause_LowPower,              /**< Illegal STOP/STANDBY entry */
+	ResetCause_Wakeup,                /**< Wake-up from STANDBY by the WKUP pin */
+	ResetCause_Count,                 /**< Number of causes */
+}ResetCause_e;
+
+/*****************************************************************************/
+/* Watchdog Function Declarations                                            */
+/*****************************************************************************/
+
+/**
+ * @brief Reads and clears the reset cause.
+ *
+ * @return true if the MCU was in STANDBY and must go back there (the
+ *         IWDG kept running and reset it), see Power_Standby().
+ *
+ * @note Call first thing in main(), after FaultCapture_Init().
+ */
+bool Watchdog_Init(void);
+
+/**
+ * @brief Starts the IWDG, it cannot be stopped again.
+ */
+void Watchdog_Start(void);
+
+/**
+ * @brief Reports a task alive. Main loop only.
+ *
+ * @param[in] task  Task.
+ */
+void Watchdog_CheckIn(WatchdogTask_e task);
+
+/**
+ * @brief Feeds the IWDG if every task checked in within its deadline. Main loop only.
+ *
+ * @return true if fed.
+ */
+bool Watchdog_Service(void);
+
+/**
+ * @brief Moves the supervisor clock forward, called by the RTC wake-up interrupt.
+ *
+ * @param[in] seconds  Seconds since the last wake-up.
+ */
+void Watchdog_ElapsedFromISR(uint32_t seconds);
+
+/**
+ * @brief Reset cause read by Watchdog_Init().
+ */
+ResetCause_e Watchdog_GetResetCause(void);
+
+/**
+ * @brief Tasks (bit per WatchdogTask_e) that were late when the IWDG last
+ *        reset the MCU, 0 if it did not.
+ */
+uint32_t Watchdog_GetLateTasks(void);
+
+/**
+ * @brief Prints the reset cause through DEBUG_LOG().
+ */
+void Watchdog_Report(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WATCHDOG_H_ */
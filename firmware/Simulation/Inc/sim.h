@@ -0,0 +1,382 @@
+/**
+ * \file           sim.h
+ * \brief          Host simulation virtual clock and probes header file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+#ifndef SIM_H_
+#define SIM_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "main.h"
+
+/*****************************************************************************/
+/* Simulation Macros                                                         */
+/*****************************************************************************/
+
+/**
+ * @brief TIM3 update period in microseconds.
+ *
+ * @details PSC 7199 and ARR 10000 at 72 MHz: 10001 ticks of 100 us, the
+ *          same 1.0001 s "second" the firmware counts on the board.
+ */
+#define SIM_TIM3_PERIOD_US                   1000100ULL
+
+/**
+ * @brief TIM4 (hwtimer) tick length in microseconds.
+ */
+#define SIM_HWTIMER_TICK_US                  (1000000ULL / HWTIMER_TICK_HZ)
+
+/**
+ * @brief Maximum number of scripted pin edges.
+ */
+#define SIM_INPUT_MAX_EDGES                  64U
+
+/*****************************************************************************/
+/* Simulation Enums                                                          */
+/*****************************************************************************/
+
+/**
+ * @brief Sources of simulated interrupts, one deadline each.
+ */
+typedef enum
+{
+	SimTimer_Tim3,          /**< TIM3 update, session second */
+	SimTimer_HwTimer,       /**< TIM4 CC1, next timer wheel event */
+	SimTimer_Input,         /**< Next scripted button edge (EXTI) */
+	SimTimer_Count,         /**< Number of sources */
+}SimTimer_e;
+
+/*****************************************************************************/
+/* Simulation Types                                                          */
+/*****************************************************************************/
+
+/**
+ * @brief Interrupt handler of a simulated source.
+ */
+typedef void (*SimHandler_t)(void);
+
+/**
+ * @brief Counters collected by the simulated peripherals.
+ */
+typedef struct
+{
+	uint32_t tim3Ticks;          /**< TIM3 updates since Sim_Reset() */
+	uint32_t stopEntries;        /**< Idle periods spent in STOP */
+	uint32_t sleepEntries;       /**< Idle periods spent in SLEEP */
+	uint32_t stopViolations;     /**< STOP entered while TIM3 or TIM4 was counting */
+	uint32_t timerWakes;         /**< TIM4 compare interrupts of the timer wheel */
+	uint32_t beeps;              /**< Buzzer on edges */
+	uint64_t beepOnUs;           /**< Total buzzer on time */
+	uint32_t busFrames;          /**< TM1637 start/stop frames decoded */
+	uint32_t busBytes;           /**< TM1637 bytes decoded */
+	uint32_t busErrors;          /**< Malformed TM1637 frames */
+}SimStats_t;
+
+/**
+ * @brief Counters of the flash model, kept over Sim_Reset().
+ */
+typedef struct
+{
+	uint32_t programs;           /**< Words programmed */
+	uint32_t erases;             /**< Sector erases */
+	uint32_t violations;         /**< Programs that asked for a one over a zero bit */
+	uint32_t cuts;               /**< Power cuts injected */
+	uint32_t errors;             /**< Program errors injected */
+}SimFlashStats_t;
+
+/**
+ * @brief Reset flags and IWDG of the watchdog model, see sim_watchdog.c.
+ */
+typedef struct
+{
+	uint32_t resetFlags;         /**< RCC_CSR reset flags of this start */
+	bool standby;                /**< PWR_CSR SBF */
+	bool running;                /**< IWDG started since the last reset */
+	uint32_t prescaler;          /**< IWDG_PR written at the start */
+	uint32_t reload;             /**< IWDG_RLR written at the start */
+	uint32_t starts;             /**< IWDG starts */
+	uint32_t feeds;              /**< Reloads of a running IWDG */
+}SimWatchdogStats_t;
+
+/**
+ * @brief Clock and counters of the RTC model, see sim_rtc.c.
+ */
+typedef struct
+{
+	uint32_t hz;                 /**< RTCCLK of the selected oscillator */
+	uint64_t cycles;             /**< RTCCLK cycles since Sim_RtcReset() */
+	uint32_t spreEdges;          /**< ck_spre edges (SSR reloads) */
+	uint32_t wakeups;            /**< WUTF set by the wake-up timer */
+	uint32_t shifts;             /**< Shift operations taken */
+	uint32_t alarms;             /**< ALRAF set by alarm A */
+	uint32_t violations;         /**< Writes the RTC would ignore or refuse */
+}SimRtcStats_t;
+
+/*****************************************************************************/
+/* Simulation Function Declarations                                          */
+/*****************************************************************************/
+
+/**
+ * @brief Resets the virtual clock, all pins, timers and counters.
+ */
+void Sim_Reset(void);
+
+/**
+ * @brief Returns the virtual time in microseconds.
+ */
+uint64_t Sim_Now(void);
+
+/**
+ * @brief Arms a source to fire at an absolute virtual time.
+ */
+void Sim_TimerArm(SimTimer_e timer, uint64_t deadline, SimHandler_t handler);
+
+/**
+ * @brief Disarms a source.
+ */
+void Sim_TimerDisarm(SimTimer_e timer);
+
+/**
+ * @brief Returns true if a source is armed.
+ */
+bool Sim_TimerIsArmed(SimTimer_e timer);
+
+/**
+ * @brief Jumps to the earliest armed deadline not later than limit and runs its handler.
+ *
+ * @retval true   A handler ran.
+ * @retval false  Nothing armed before limit, the clock is moved to limit.
+ */
+bool Sim_AdvanceToNextEvent(uint64_t limit);
+
+/**
+ * @brief Moves the clock forward by a duration, running every handler on the way.
+ */
+void Sim_Advance(uint64_t microseconds);
+
+/**
+ * @brief Sets the time __WFI() wakes up at when nothing else is armed.
+ */
+void Sim_SetHorizon(uint64_t horizon);
+
+/**
+ * @brief Sets the function called every time the firmware goes idle.
+ */
+void Sim_SetIdleHook(SimHandler_t hook);
+
+/**
+ * @brief Runs the idle hook, called by Power_Idle().
+ */
+void Sim_RunIdleHook(void);
+
+/**
+ * @brief Returns the counters of the simulated peripherals.
+ */
+SimStats_t *Sim_GetStats(void);
+
+/**
+ * @brief Returns true if the TIM3 timebase is counting.
+ */
+bool Sim_Tim3IsRunning(void);
+
+/**
+ * @brief Schedules a button press with contact bounce.
+ *
+ * @param[in] pin       GPIO_PIN_0 (control) or GPIO_PIN_1 (function).
+ * @param[in] at        Virtual time of the first press edge.
+ * @param[in] holdms    Time the button is held in milliseconds.
+ * @param[in] bounces   Extra edge pairs at press and release, 1 ms apart.
+ */
+void Sim_InputPress(uint16_t pin, uint64_t at, uint32_t holdms, uint8_t bounces);
+
+/**
+ * @brief Called by the GPIO model on every write to the TM1637 pins.
+ */
+void Sim_Tm1637Sample(bool clk, bool dio);
+
+/**
+ * @brief Called by the GPIO model on every write to the buzzer pin.
+ */
+void Sim_BuzzerSample(bool level);
+
+/**
+ * @brief Renders the digits currently shown by the decoded TM1637 as "MM:SS".
+ *
+ * @param[out] text  At least 6 characters, '?' for an unknown pattern.
+ *
+ * @retval true   The colon is lit.
+ * @retval false  The colon is dark.
+ */
+bool Sim_Tm1637Text(char *text);
+
+/**
+ * @brief Returns true once all four digits were written since Sim_Reset().
+ */
+bool Sim_Tm1637IsValid(void);
+
+/**
+ * @brief Returns true if the last display control command switched the display on.
+ */
+bool Sim_Tm1637IsOn(void);
+
+/**
+ * @brief Erases the flash model (a new chip) and clears its counters.
+ */
+void Sim_FlashReset(void);
+
+/**
+ * @brief Cuts the power in the middle of a later flash operation.
+ *
+ * @details The operation-th word program or erase from now is left half
+ *          done (a word with only some of its bits cleared, a sector with
+ *          only some of its words erased) and cut is called, which must
+ *          not return (longjmp to the reboot).
+ *
+ * @param[in] operation  1 = the next program or erase, 0 = disarm.
+ * @param[in] cut        Power cut handler.
+ */
+void Sim_FlashArmCut(uint32_t operation, SimHandler_t cut);
+
+/**
+ * @brief Fails a later word program, FlashRegion_Program() returns false.
+ *
+ * @param[in] operation  1 = the next word program, 0 = disarm.
+ */
+void Sim_FlashArmError(uint32_t operation);
+
+/**
+ * @brief Returns the counters of the flash model.
+ */
+SimFlashStats_t *Sim_FlashGetStats(void);
+
+/**
+ * @brief Sets what the fault status registers read, see APP_FAULT_STATUS_READ().
+ */
+void Sim_FaultSetStatus(uint32_t cfsr, uint32_t hfsr, uint32_t mmfar, uint32_t bfar);
+
+/**
+ * @brief Sets the handlers of a reset and of STANDBY after a recorded fault.
+ *
+ * @details Neither may return (longjmp to the reboot). Without a handler
+ *          the simulation stops with an error.
+ *
+ * @param[in] reset  APP_SYSTEM_RESET() handler.
+ * @param[in] park   APP_FAULT_PARK() handler.
+ */
+void Sim_FaultSetHandlers(SimHandler_t reset, SimHandler_t park);
+
+/**
+ * @brief Starts the MCU again after a reset.
+ *
+ * @details Sets what the reset flags and the STANDBY flag read; the reset
+ *          stops the IWDG, as on the MCU. Counters are kept.
+ *
+ * @param[in] resetFlags  RCC_CSR reset flags, RCC_CSR_*RSTF.
+ * @param[in] standby     The MCU was in STANDBY.
+ */
+void Sim_WatchdogBoot(uint32_t resetFlags, bool standby);
+
+/**
+ * @brief Returns the registers and counters of the watchdog model.
+ */
+SimWatchdogStats_t *Sim_WatchdogGetStats(void);
+
+/**
+ * @brief Powers the backup domain up with the RTC off.
+ *
+ * @param[in] lseok  false: the LSE does not start, for the LSI fallback.
+ */
+void Sim_RtcReset(bool lseok);
+
+/**
+ * @brief Resets the MCU: the LSI, PWR, EXTI and NVIC, the RTC keeps running.
+ */
+void Sim_RtcMcuReset(void);
+
+/**
+ * @brief Runs the RTC model.
+ *
+ * @details Takes the register writes of the firmware first and returns as
+ *          soon as the wake-up or the alarm interrupt becomes pending.
+ *
+ * @param[in] cycles  RTCCLK cycles to run.
+ *
+ * @return RTCCLK cycles run.
+ */
+uint32_t Sim_RtcRun(uint32_t cycles);
+
+/**
+ * @brief Returns true if the RTC wake-up interrupt is pending and enabled.
+ */
+bool Sim_RtcIrqPending(void);
+
+/**
+ * @brief Returns true if the RTC alarm interrupt is pending and enabled.
+ */
+bool Sim_RtcAlarmPending(void);
+
+/**
+ * @brief Returns the clock and counters of the RTC model.
+ */
+SimRtcStats_t *Sim_RtcGetStats(void);
+
+/**
+ * @brief Power cycle without VBAT, the backup registers read zero.
+ */
+void Sim_BackupPowerCycle(void);
+
+/**
+ * @brief Cuts the power before a later backup register write.
+ *
+ * @details The write-th register write from now is not done and cut is
+ *          called, which must not return (longjmp to the reboot). The
+ *          registers keep what was written before, as over a reset.
+ *
+ * @param[in] write  1 = the next write, 0 = disarm.
+ * @param[in] cut    Power cut handler.
+ */
+void Sim_BackupArmCut(uint32_t write, SimHandler_t cut);
+
+/**
+ * @brief Returns the backup register writes since the start.
+ */
+uint32_t Sim_BackupGetWrites(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_H_ */
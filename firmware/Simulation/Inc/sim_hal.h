@@ -0,0 +1,351 @@
+/**
+ * \file           sim_hal.h
+ * \brief          Host simulation HAL subset header file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+#ifndef SIM_HAL_H_
+#define SIM_HAL_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*****************************************************************************/
+/* HAL Types                                                                 */
+/*****************************************************************************/
+
+/**
+ * @brief HAL status, same values as stm32f4xx_hal_def.h.
+ */
+typedef enum
+{
+	HAL_OK       = 0x00U,
+	HAL_ERROR    = 0x01U,
+	HAL_BUSY     = 0x02U,
+	HAL_TIMEOUT  = 0x03U
+}HAL_StatusTypeDef;
+
+/**
+ * @brief Pin level, same values as stm32f4xx_hal_gpio.h.
+ */
+typedef enum
+{
+	GPIO_PIN_RESET = 0U,
+	GPIO_PIN_SET
+}GPIO_PinState;
+
+/**
+ * @brief Simulated GPIO port: output latch and input levels.
+ */
+typedef struct
+{
+	uint32_t ODR;   /**< Output data, written by HAL_GPIO_WritePin() and BSRR */
+	uint32_t IDR;   /**< Input data, driven by the simulation inputs */
+	uint32_t BSRR;  /**< Unused, BSRR writes go through Sim_GpioWriteBsrr() */
+}GPIO_TypeDef;
+
+/**
+ * @brief Simulated timer handle, only identifies the timer.
+ */
+typedef struct
+{
+	void *Instance;   /**< Unused */
+}TIM_HandleTypeDef;
+
+/**
+ * @brief Interrupt numbers of the simulated peripherals.
+ */
+typedef enum
+{
+	RTC_WKUP_IRQn  = 3,
+	RTC_Alarm_IRQn = 41
+}IRQn_Type;
+
+/**
+ * @brief RTC registers used by rtcclock.c, modelled by sim_rtc.c.
+ */
+typedef struct
+{
+	volatile uint32_t TR;     /**< Time, only read to unlock the shadows */
+	volatile uint32_t DR;     /**< Date, only read to unlock the shadows */
+	volatile uint32_t CR;     /**< WUTE, WUTIE, WUCKSEL, ALRAE, ALRAIE */
+	volatile uint32_t ISR;    /**< INIT and the status flags */
+	volatile uint32_t PRER;   /**< Prescalers, loaded when INIT is left */
+	volatile uint32_t WUTR;   /**< Wake-up reload */
+	volatile uint32_t ALRMAR; /**< Alarm A, only all fields masked is modelled */
+	volatile uint32_t WPR;    /**< Write protection keys, not checked */
+	volatile uint32_t SSR;    /**< Synchronous prescaler counter */
+	volatile uint32_t SHIFTR; /**< Shift, reads zero once taken */
+	volatile uint32_t CALR;   /**< Smooth calibration, not modelled */
+	volatile uint32_t ALRMASSR; /**< Alarm A subsecond value and MASKSS */
+}RTC_TypeDef;
+
+/**
+ * @brief RCC backup domain and LSI control of the RTC model.
+ */
+typedef struct
+{
+	volatile uint32_t BDCR;   /**< LSEON/LSERDY, RTCSEL, RTCEN */
+	volatile uint32_t CSR;    /**< LSION/LSIRDY */
+}RCC_TypeDef;
+
+/**
+ * @brief PWR control, DBP only.
+ */
+typedef struct
+{
+	volatile uint32_t CR;     /**< DBP */
+}PWR_TypeDef;
+
+/**
+ * @brief EXTI lines 22 and 17 of the RTC wake-up and alarm.
+ */
+typedef struct
+{
+	volatile uint32_t IMR;    /**< Interrupt mask */
+	volatile uint32_t RTSR;   /**< Rising edge trigger */
+	volatile uint32_t PR;     /**< Pending, written with ones to clear */
+}EXTI_TypeDef;
+
+/*****************************************************************************/
+/* HAL Macros                                                                */
+/*****************************************************************************/
+extern GPIO_TypeDef simGpioA;
+extern GPIO_TypeDef simGpioB;
+extern GPIO_TypeDef simGpioC;
+
+#define GPIOA                                (&simGpioA)
+#define GPIOB                                (&simGpioB)
+#define GPIOC                                (&simGpioC)
+
+#define GPIO_PIN_0                           ((uint16_t)0x0001)
+#define GPIO_PIN_1                           ((uint16_t)0x0002)
+#define GPIO_PIN_9                           ((uint16_t)0x0200)
+#define GPIO_PIN_12                          ((uint16_t)0x1000)
+#define GPIO_PIN_13                          ((uint16_t)0x2000)
+
+extern RTC_TypeDef simRtc;
+extern RCC_TypeDef simRcc;
+extern PWR_TypeDef simPwr;
+extern EXTI_TypeDef simExti;
+
+#define RTC                                  (&simRtc)
+#define RCC                                  (&simRcc)
+#define PWR                                  (&simPwr)
+#define EXTI                                 (&simExti)
+
+/**
+ * @brief RTC, RCC, PWR and EXTI bits, same values as stm32f401xc.h.
+ */
+#define RTC_ISR_RECALPF                      0x00010000U
+#define RTC_ISR_WUTF                         0x00000400U
+#define RTC_ISR_INIT                         0x00000080U
+#define RTC_ISR_INITF                        0x00000040U
+#define RTC_ISR_RSF                          0x00000020U
+#define RTC_ISR_SHPF                         0x00000008U
+#define RTC_ISR_WUTWF                        0x00000004U
+#define RTC_ISR_ALRAF                        0x00000100U
+#define RTC_ISR_ALRAWF                       0x00000001U
+#define RTC_CR_WUTIE                         0x00004000U
+#define RTC_CR_ALRAIE                        0x00001000U
+#define RTC_CR_WUTE                          0x00000400U
+#define RTC_CR_ALRAE                         0x00000100U
+#define RTC_CR_WUCKSEL                       0x00000007U
+#define RTC_CR_WUCKSEL_2                     0x00000004U
+#define RTC_PRER_PREDIV_A_Pos                16U
+#define RTC_PRER_PREDIV_A                    0x007F0000U
+#define RTC_PRER_PREDIV_S                    0x00007FFFU
+#define RTC_SSR_SS                           0x0000FFFFU
+#define RTC_SHIFTR_SUBFS                     0x00007FFFU
+#define RTC_CALR_CALP                        0x00008000U
+#define RTC_ALRMAR_MSK4                      0x80000000U
+#define RTC_ALRMAR_MSK3                      0x00800000U
+#define RTC_ALRMAR_MSK2                      0x00008000U
+#define RTC_ALRMAR_MSK1                      0x00000080U
+#define RTC_ALRMASSR_MASKSS_Pos              24U
+#define RTC_ALRMASSR_MASKSS                  0x0F000000U
+#define RTC_ALRMASSR_SS                      0x00007FFFU
+#define RCC_BDCR_BDRST                       0x00010000U
+#define RCC_BDCR_RTCEN                       0x00008000U
+#define RCC_BDCR_RTCSEL                      0x00000300U
+#define RCC_BDCR_RTCSEL_0                    0x00000100U
+#define RCC_BDCR_RTCSEL_1                    0x00000200U
+#define RCC_BDCR_LSERDY                      0x00000002U
+#define RCC_BDCR_LSEON                       0x00000001U
+#define RCC_CSR_LSIRDY                       0x00000002U
+#define RCC_CSR_LSION                        0x00000001U
+#define PWR_CR_DBP                           0x00000100U
+#define EXTI_IMR_MR22                        0x00400000U
+#define EXTI_RTSR_TR22                       0x00400000U
+#define EXTI_PR_PR22                         0x00400000U
+#define EXTI_IMR_MR17                        0x00020000U
+#define EXTI_RTSR_TR17                       0x00020000U
+#define EXTI_PR_PR17                         0x00020000U
+
+#define __HAL_RCC_PWR_CLK_ENABLE()           ((void)0)
+
+/**
+ * @brief Route the gpiopin.h BSRR stores through the pin probes.
+ */
+#define GPIOPIN_BSRR_WRITE(port, value)      Sim_GpioWriteBsrr((port), (value))
+
+/**
+ * @brief TIM3 phase restart on the simulated timer, see Sim_Tim3PhaseReset().
+ *        The RTC timebase (APP_TIMEBASE 1) of sim_rtc.c keeps its own.
+ */
+#if (APP_TIMEBASE == 0)
+#define TIMER_PHASE_RESET()                  Sim_Tim3PhaseReset()
+#endif
+
+/**
+ * @brief The scripted button edges always reach HAL_GPIO_EXTI_Callback().
+ */
+#define BUTTON_IRQ_ENABLE()                  ((void)0)
+
+/**
+ * @brief Host replacement of the DWT cycle counter, see Sim_CycleCounter().
+ */
+#define APP_CYCLE_COUNTER_INIT()             ((void)0)
+#define APP_CYCLE_COUNTER()                  Sim_CycleCounter()
+
+/**
+ * @brief Clock of the boot until the PLL runs, as stm32f4xx_hal_conf.h.
+ */
+#define HSI_VALUE                            16000000U
+
+/**
+ * @brief LSE start-up timeout in ms, as stm32f4xx_hal_conf.h.
+ */
+#define LSE_STARTUP_TIMEOUT                  5000U
+
+/**
+ * @brief No Cortex-M fault handlers on the host, faultcapture.c only records.
+ */
+#define FAULTCAPTURE_HANDLERS                0
+
+/**
+ * @brief Reset and STANDBY of the fault capture, see Sim_FaultSetHandlers().
+ */
+#define APP_SYSTEM_RESET()                   Sim_FaultReset()
+#define APP_FAULT_PARK()                     Sim_FaultPark()
+#define APP_FAULT_ENABLE()                   ((void)0)
+
+/**
+ * @brief Fault status registers set by Sim_FaultSetStatus().
+ */
+#define APP_FAULT_STATUS_READ(record)        Sim_FaultStatusRead(&(record)->cfsr, &(record)->hfsr, \
+                                                                 &(record)->mmfar, &(record)->bfar)
+
+/**
+ * @brief Any host pointer is RAM.
+ */
+#define APP_RAM_CONTAINS(address, size)      ((address) != NULL)
+
+/**
+ * @brief RCC_CSR reset flags.
+ */
+#define RCC_CSR_LPWRRSTF                     0x80000000U
+#define RCC_CSR_WWDGRSTF                     0x40000000U
+#define RCC_CSR_IWDGRSTF                     0x20000000U
+#define RCC_CSR_SFTRSTF                      0x10000000U
+#define RCC_CSR_PORRSTF                      0x08000000U
+#define RCC_CSR_PINRSTF                      0x04000000U
+#define RCC_CSR_BORRSTF                      0x02000000U
+
+/**
+ * @brief Reset flags, STANDBY flag and IWDG of the watchdog model, see
+ *        Sim_WatchdogBoot().
+ */
+#define APP_RESET_FLAGS()                    Sim_ResetFlags()
+#define APP_RESET_FLAGS_CLEAR()              Sim_ResetFlagsClear()
+#define APP_STANDBY_FLAG()                   Sim_StandbyFlag()
+#define APP_STANDBY_FLAG_CLEAR()             Sim_StandbyFlagClear()
+#define APP_WATCHDOG_START(prescaler, reload) Sim_WatchdogStart((prescaler), (reload))
+#define APP_WATCHDOG_FEED()                  Sim_WatchdogFeed()
+
+/**
+ * @brief RTC backup registers of the model, see Sim_BackupArmCut().
+ */
+#define APP_BACKUP_READ(index)               Sim_BackupRead((index))
+#define APP_BACKUP_WRITE(index, value)       Sim_BackupWrite((index), (value))
+
+/*****************************************************************************/
+/* HAL Function Declarations                                                 */
+/*****************************************************************************/
+extern uint32_t SystemCoreClock;
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin);
+void Sim_GpioWriteBsrr(GPIO_TypeDef *GPIOx, uint32_t value);
+uint32_t Sim_CycleCounter(void);
+void Sim_FaultReset(void) __attribute__((noreturn));
+void Sim_FaultPark(void) __attribute__((noreturn));
+void Sim_FaultStatusRead(uint32_t *cfsr, uint32_t *hfsr, uint32_t *mmfar, uint32_t *bfar);
+uint32_t Sim_ResetFlags(void);
+void Sim_ResetFlagsClear(void);
+bool Sim_StandbyFlag(void);
+void Sim_StandbyFlagClear(void);
+void Sim_WatchdogStart(uint32_t prescaler, uint32_t reload);
+void Sim_WatchdogFeed(void);
+uint32_t Sim_BackupRead(uint32_t index);
+void Sim_BackupWrite(uint32_t index, uint32_t value);
+
+void HAL_Delay(uint32_t Delay);
+uint32_t HAL_GetTick(void);
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority);
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn);
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef *htim);
+void Sim_Tim3PhaseReset(void);
+
+/*****************************************************************************/
+/* CMSIS Intrinsics                                                          */
+/*****************************************************************************/
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t priMask);
+void __disable_irq(void);
+void __WFI(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_HAL_H_ */
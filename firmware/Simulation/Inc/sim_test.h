@@ -0,0 +1,89 @@
+/**
+ * \file           sim_test.h
+ * \brief          Host test check counting and random numbers header file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+#ifndef SIM_TEST_H_
+#define SIM_TEST_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include <stdint.h>
+
+/*****************************************************************************/
+/* Test Function Declarations                                                */
+/*****************************************************************************/
+
+/**
+ * @brief Records a failed check, the first 10 are printed to stderr.
+ *
+ * @param[in] what   What was checked.
+ * @param[in] value  Value found.
+ */
+void Sim_TestFail(const char *what, unsigned long value);
+
+/**
+ * @brief Records a failed check, printed with a printf() format.
+ *
+ * @param[in] format  printf() format of the message, without "FAIL".
+ */
+void Sim_TestFailf(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+/**
+ * @brief Restarts the random numbers of Sim_TestRandom().
+ *
+ * @param[in] seed  xorshift32 state, not 0.
+ */
+void Sim_TestSeed(uint32_t seed);
+
+/**
+ * @brief Deterministic pseudo random numbers (xorshift32), seed 1 at start.
+ *
+ * @return uint32_t Next value.
+ */
+uint32_t Sim_TestRandom(void);
+
+/**
+ * @brief Prints the "PASS"/"FAIL" line of the test.
+ *
+ * @return int Exit status of main(), 0 without failed checks.
+ */
+int Sim_TestResult(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_TEST_H_ */
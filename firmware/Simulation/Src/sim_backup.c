@@ -0,0 +1,131 @@
+/**
+ * \file           sim_backup.c
+ * \brief          Simulated RTC backup registers
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include "sim.h"
+
+/*****************************************************************************/
+/* Private Defines                                                           */
+/*****************************************************************************/
+#define SIM_BACKUP_REGISTERS       20U          /** RTC_BKP0R ... RTC_BKP19R **/
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static uint32_t simbackup[SIM_BACKUP_REGISTERS]; /** Register contents **/
+
+static uint32_t simbackupwrites = 0; /** Register writes since the start **/
+
+static uint32_t simbackupcut = 0; /** Writes until the power cut, 0 = none **/
+
+static SimHandler_t simbackupcuthandler = NULL; /** Called at the power cut **/
+
+/*****************************************************************************/
+/* Private Functions                                                         */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Stops the simulation on a register the MCU does not have.
+ *****************************************************************************/
+static void simBackupCheck(uint32_t index)
+{
+	if(index >= SIM_BACKUP_REGISTERS)
+	{
+		fprintf(stderr, "sim: backup register %lu does not exist\n", (unsigned long)index);
+		exit(1);
+	}
+}
+
+/*****************************************************************************/
+/* Simulation Functions                                                      */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Power cycle without VBAT: the registers read zero.
+ *****************************************************************************/
+void Sim_BackupPowerCycle(void)
+{
+	for(uint32_t i = 0; i < SIM_BACKUP_REGISTERS; i++)
+	{
+		simbackup[i] = 0U;
+	}
+}
+/*****************************************************************************
+ * @brief Cuts the power before a later register write.
+ *****************************************************************************/
+void Sim_BackupArmCut(uint32_t write, SimHandler_t cut)
+{
+	simbackupcut = write;
+	simbackupcuthandler = cut;
+}
+/*****************************************************************************
+ * @brief Register writes since the start.
+ *****************************************************************************/
+uint32_t Sim_BackupGetWrites(void)
+{
+	return simbackupwrites;
+}
+
+/*****************************************************************************/
+/* HAL Replacements                                                          */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief APP_BACKUP_READ().
+ *****************************************************************************/
+uint32_t Sim_BackupRead(uint32_t index)
+{
+	simBackupCheck(index);
+	return simbackup[index];
+}
+/*****************************************************************************
+ * @brief APP_BACKUP_WRITE().
+ *****************************************************************************/
+void Sim_BackupWrite(uint32_t index, uint32_t value)
+{
+	simBackupCheck(index);
+	if((simbackupcut != 0U) && (--simbackupcut == 0U))
+	{
+		SimHandler_t cut = simbackupcuthandler;
+
+		simbackupcuthandler = NULL;
+		if(cut != NULL)
+		{
+			cut();
+		}
+		fprintf(stderr, "sim: backup power cut without a handler\n");
+		exit(1);
+	}
+	simbackup[index] = value;
+	simbackupwrites++;
+}
+/*************************************END*************************************/
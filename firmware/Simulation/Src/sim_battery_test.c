@@ -0,0 +1,462 @@
+/**
+ * \file           sim_battery_test.c
+ * \brief          Host test of the battery filter against discharge curves
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "battery.h"
+#include "sim_test.h"
+
+/*****************************************************************************/
+/* Private Defines                                                           */
+/*****************************************************************************/
+#define TEST_MAX_POINTS            4096U        /** Rows of one curve file **/
+#define TEST_MAX_EXPECT            8U           /** Expected level changes of one curve **/
+#define TEST_BURST_LENGTH          8U           /** Pairs per burst, as BATTERYADC_BURST_LENGTH **/
+#define TEST_VREFINT_MV            1210U        /** VREFINT of the simulated part **/
+#define TEST_VREFINT_CAL           1501U        /** Its reading at VDDA = 3.3 V **/
+#define TEST_VDDA_MV               3300         /** Nominal LDO output **/
+#define TEST_VDDA_SPREAD_MV        50           /** LDO output varies by +- this per burst **/
+#define TEST_NOISE_MV              8            /** Uniform noise on every battery sample, +- mV **/
+#define TEST_CONVERT_TOLERANCE_MV  6            /** battery_ToMillivolts() against the exact value **/
+#define TEST_TRACK_TOLERANCE_MV    20           /** Filter against the curve once settled, plus the ramp lag **/
+#define TEST_SPIKE_TOLERANCE_MV    12           /** Filter with spikes against the one without **/
+#define TEST_SETTLE_BURSTS         16U          /** Bursts before the tracking check starts **/
+#define TEST_LEVEL_MV              25           /** A level changes with the curve this close to the threshold ... **/
+#define TEST_LEVEL_MINUTES         5            /** ... or this close in time to the crossing (steps) **/
+
+/*****************************************************************************/
+/* Private Types                                                             */
+/*****************************************************************************/
+/**
+ * @brief One row of a discharge curve.
+ */
+typedef struct
+{
+	uint32_t minutes;   /**< Time since the start of the curve */
+	uint32_t millivolts;/**< Cell voltage */
+}TestPoint_t;
+
+/**
+ * @brief A discharge curve and the level changes it must produce.
+ */
+typedef struct
+{
+	TestPoint_t points[TEST_MAX_POINTS];     /**< Rows in time order */
+	uint32_t count;                          /**< Number of rows */
+	BatteryLevel_e expect[TEST_MAX_EXPECT];  /**< Expected level changes in order */
+	uint32_t expectcount;                    /**< Number of expected changes */
+}TestCurve_t;
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static TestCurve_t testcurve; /** Curve under test **/
+
+static const char *const testlevelnames[] = { "ok", "low", "critical" }; /** Names in the expect line **/
+
+static const int32_t testthresholds[] = /** Curve voltage at which each level is entered **/
+{
+	APP_BATTERY_LOW_MV + APP_BATTERY_HYSTERESIS_MV, APP_BATTERY_LOW_MV, APP_BATTERY_CRITICAL_MV,
+};
+
+/*****************************************************************************/
+/* Helpers                                                                   */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Uniform random value in -spread ... +spread.
+ *
+ * @param[in] spread  Half width.
+ *
+ * @return int32_t Value.
+ *****************************************************************************/
+static int32_t testSpread(int32_t spread)
+{
+	return (int32_t)(Sim_TestRandom() % (uint32_t)((2 * spread) + 1)) - spread;
+}
+/*****************************************************************************
+ * @brief ADC reading of a voltage, rounded and clamped like the 12-bit ADC.
+ *
+ * @param[in] millivolts  Input voltage.
+ * @param[in] vdda        Reference voltage.
+ *
+ * @return uint16_t Reading.
+ *****************************************************************************/
+static uint16_t testAdc(int32_t millivolts, int32_t vdda)
+{
+	int32_t raw = ((millivolts * 4095) + (vdda / 2)) / vdda;
+	if(raw < 0)
+	{
+		raw = 0;
+	}
+	return (raw > 4095) ? 4095U : (uint16_t)raw;
+}
+/*****************************************************************************
+ * @brief Records a failed check.
+ *****************************************************************************/
+static void testFail(const char *name, const char *what, long value, long limit)
+{
+	Sim_TestFailf("%s: %s %ld (limit %ld)", name, what, value, limit);
+}
+
+/*****************************************************************************/
+/* Curve Files                                                               */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Loads a curve file.
+ *
+ * @details Rows are "minutes,millivolts". Lines starting with '#' are
+ *          comments, "# expect: low critical" lists the level changes the
+ *          curve must produce.
+ *
+ * @param[in] path  File to load.
+ *
+ * @return bool true if at least two rows were read.
+ *****************************************************************************/
+static bool testLoadCurve(const char *path)
+{
+	FILE *file = fopen(path, "r");
+	char line[256];
+
+	memset(&testcurve, 0, sizeof(testcurve));
+	if(file == NULL)
+	{
+		perror(path);
+		return false;
+	}
+	while(fgets(line, sizeof(line), file) != NULL)
+	{
+		unsigned long minutes;
+		unsigned long millivolts;
+
+		if(strncmp(line, "# expect:", 9) == 0)
+		{
+			for(char *word = strtok(&line[9], " \t\r\n"); word != NULL; word = strtok(NULL, " \t\r\n"))
+			{
+				for(uint32_t level = 0; level < 3U; level++)
+				{
+					if((strcmp(word, testlevelnames[level]) == 0) && (testcurve.expectcount < TEST_MAX_EXPECT))
+					{
+						testcurve.expect[testcurve.expectcount++] = (BatteryLevel_e)level;
+					}
+				}
+			}
+		}
+		else if((line[0] != '#') && (sscanf(line, "%lu,%lu", &minutes, &millivolts) == 2) &&
+				(testcurve.count < TEST_MAX_POINTS))
+		{
+			testcurve.points[testcurve.count].minutes = (uint32_t)minutes;
+			testcurve.points[testcurve.count].millivolts = (uint32_t)millivolts;
+			testcurve.count++;
+		}
+	}
+	fclose(file);
+	return testcurve.count >= 2U;
+}
+/*****************************************************************************
+ * @brief Cell voltage at a point in time, linear between the rows.
+ *
+ * @param[in] seconds  Time since the start of the curve.
+ *
+ * @return int32_t Voltage in mV.
+ *****************************************************************************/
+static int32_t testCurveAt(uint32_t seconds)
+{
+	for(uint32_t i = 1; i < testcurve.count; i++)
+	{
+		uint32_t t0 = testcurve.points[i - 1U].minutes * 60U;
+		uint32_t t1 = testcurve.points[i].minutes * 60U;
+		if(seconds <= t1)
+		{
+			int32_t v0 = (int32_t)testcurve.points[i - 1U].millivolts;
+			int32_t v1 = (int32_t)testcurve.points[i].millivolts;
+			return v0 + (int32_t)(((int64_t)(v1 - v0) * (int32_t)(seconds - t0)) / (int32_t)(t1 - t0));
+		}
+	}
+	return (int32_t)testcurve.points[testcurve.count - 1U].millivolts;
+}
+
+/*****************************************************************************
+ * @brief Finds when the clean curve first passes each threshold.
+ *
+ * @details Low and critical are the first time below their threshold, ok
+ *          is the first time back above the low threshold plus hysteresis
+ *          after low was reached.
+ *
+ * @param[out] crossed  Seconds per BatteryLevel_e, UINT32_MAX if never.
+ *****************************************************************************/
+static void testCrossings(uint32_t crossed[3])
+{
+	uint32_t end = testcurve.points[testcurve.count - 1U].minutes * 60U;
+
+	crossed[BatteryLevel_Ok] = UINT32_MAX;
+	crossed[BatteryLevel_Low] = UINT32_MAX;
+	crossed[BatteryLevel_Critical] = UINT32_MAX;
+	for(uint32_t seconds = 0; seconds <= end; seconds += APP_BATTERY_PERIOD)
+	{
+		int32_t truth = testCurveAt(seconds);
+		if((crossed[BatteryLevel_Low] == UINT32_MAX) && (truth < APP_BATTERY_LOW_MV))
+		{
+			crossed[BatteryLevel_Low] = seconds;
+		}
+		if((crossed[BatteryLevel_Critical] == UINT32_MAX) && (truth < APP_BATTERY_CRITICAL_MV))
+		{
+			crossed[BatteryLevel_Critical] = seconds;
+		}
+		if((crossed[BatteryLevel_Low] != UINT32_MAX) && (crossed[BatteryLevel_Ok] == UINT32_MAX) &&
+				(truth >= (APP_BATTERY_LOW_MV + APP_BATTERY_HYSTERESIS_MV)))
+		{
+			crossed[BatteryLevel_Ok] = seconds;
+		}
+	}
+}
+
+/*****************************************************************************/
+/* Tests                                                                     */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Checks the ADC to mV conversion over the whole cell range.
+ *
+ * @details Every battery voltage from 2.5 to 4.4 V at VDDA from 3.2 to 3.4 V
+ *          goes through an exact ADC model and battery_ToMillivolts().
+ *****************************************************************************/
+static void testConversion(void)
+{
+	int32_t worst = 0;
+
+	for(int32_t vdda = 3200; vdda <= 3400; vdda += 10)
+	{
+		uint16_t vrefint = testAdc(TEST_VREFINT_MV, vdda);
+		for(int32_t millivolts = 2500; millivolts <= 4400; millivolts++)
+		{
+			uint16_t raw = testAdc((millivolts * APP_BATTERY_DIVIDER_DEN) / APP_BATTERY_DIVIDER_NUM, vdda);
+			int32_t error = (int32_t)battery_ToMillivolts(vrefint, raw, TEST_VREFINT_CAL) - millivolts;
+			error = (error < 0) ? -error : error;
+			if(error > worst)
+			{
+				worst = error;
+			}
+		}
+	}
+
+	/* Mostly the VREFINT quantisation, 1 LSB at 1.2 V is about 0.07 % or 3 mV */
+	printf("%-26s max error %ld mV\n", "conversion", (long)worst);
+	if(worst > TEST_CONVERT_TOLERANCE_MV)
+	{
+		testFail("conversion", "max error mV", worst, TEST_CONVERT_TOLERANCE_MV);
+	}
+}
+/*****************************************************************************
+ * @brief Replays the curve through the filter, one burst per APP_BATTERY_PERIOD.
+ *
+ * @details Each burst sees a new LDO voltage, noise on every sample and,
+ *          when spikes are on, up to three samples pulled down by a load
+ *          step (buzzer, display) or one pulled up. The level changes are
+ *          compared with the expect line of the curve and the time the
+ *          clean curve crossed the threshold.
+ *
+ * @param[in]  name      Curve name for the report.
+ * @param[in]  spikes    Add the load spikes.
+ * @param[out] filtered  Filtered mV per burst, compared between both runs.
+ * @param[in]  check     Check levels and tracking (the run with spikes).
+ *
+ * @return uint32_t Number of bursts.
+ *****************************************************************************/
+static uint32_t testReplay(const char *name, bool spikes, uint16_t *filtered, bool check)
+{
+	BatteryFilter_t filter;
+	BatteryLevel_e level = BatteryLevel_Ok;
+	uint32_t end = testcurve.points[testcurve.count - 1U].minutes * 60U;
+	uint32_t bursts = 0;
+	uint32_t changes = 0;
+	int32_t worsttrack = 0;
+	int32_t lasttruth = testCurveAt(0);
+	int32_t slopes[TEST_SETTLE_BURSTS] = { 0 };
+	uint32_t crossed[3];
+
+	testCrossings(crossed);
+	battery_FilterInit(&filter);
+	Sim_TestSeed(0x2545F491U); /** Same noise for both runs **/
+
+	for(uint32_t seconds = 0; seconds <= end; seconds += APP_BATTERY_PERIOD, bursts++)
+	{
+		int32_t truth = testCurveAt(seconds);
+		int32_t vdda = TEST_VDDA_MV + testSpread(TEST_VDDA_SPREAD_MV);
+		uint16_t millivolts[TEST_BURST_LENGTH];
+		uint32_t spikeroll = Sim_TestRandom();
+		uint32_t lowspikes = ((spikeroll & 3U) == 0U) ? (1U + ((spikeroll >> 2) % 3U)) : 0U;
+		bool highspike = ((spikeroll >> 8) & 7U) == 0U;
+
+		for(uint32_t i = 0; i < TEST_BURST_LENGTH; i++)
+		{
+			int32_t sample = truth + testSpread(TEST_NOISE_MV);
+			int32_t spike = 200 + (int32_t)(Sim_TestRandom() % 400U);
+			if(spikes && (i < lowspikes))
+			{
+				sample -= spike;
+			}
+			else if(spikes && highspike && (i == (TEST_BURST_LENGTH - 1U)))
+			{
+				sample += spike;
+			}
+			uint16_t vrefint = testAdc(TEST_VREFINT_MV + testSpread(1), vdda);
+			uint16_t raw = testAdc((sample * APP_BATTERY_DIVIDER_DEN) / APP_BATTERY_DIVIDER_NUM, vdda);
+			millivolts[i] = battery_ToMillivolts(vrefint, raw, TEST_VREFINT_CAL);
+		}
+
+		BatteryLevel_e next = battery_FilterBurst(&filter, millivolts, TEST_BURST_LENGTH);
+		filtered[bursts] = battery_FilterMillivolts(&filter);
+
+		/* A ramp of the curve lags by 2^BATTERY_IIR_SHIFT - 1 bursts, allowed on top
+		   with the steepest slope of the last TEST_SETTLE_BURSTS bursts */
+		slopes[bursts % TEST_SETTLE_BURSTS] = (truth > lasttruth) ? (truth - lasttruth) : (lasttruth - truth);
+		lasttruth = truth;
+		int32_t slope = 0;
+		for(uint32_t i = 0; i < TEST_SETTLE_BURSTS; i++)
+		{
+			slope = (slopes[i] > slope) ? slopes[i] : slope;
+		}
+
+		if(check && (bursts >= TEST_SETTLE_BURSTS) && (truth >= APP_BATTERY_CRITICAL_MV))
+		{
+			int32_t error = (int32_t)filtered[bursts] - truth;
+			error = (error < 0) ? -error : error;
+			error -= slope * (int32_t)((1U << BATTERY_IIR_SHIFT) - 1U);
+			worsttrack = (error > worsttrack) ? error : worsttrack;
+		}
+
+		if(check && (next != level))
+		{
+			long delay = ((long)seconds - (long)crossed[next]) / 60L;
+			long distance = (long)truth - (long)testthresholds[next];
+			printf("%-26s %-8s -> %-8s at %5lu min, %+4ld min / %+4ld mV from the curve crossing\n", name,
+					testlevelnames[level], testlevelnames[next], (unsigned long)(seconds / 60U), delay, distance);
+			if((changes >= testcurve.expectcount) || (testcurve.expect[changes] != next))
+			{
+				testFail(name, "unexpected level change, index", (long)changes, (long)testcurve.expectcount);
+			}
+			else if((crossed[next] == UINT32_MAX) ||
+					(((distance < -TEST_LEVEL_MV) || (distance > TEST_LEVEL_MV)) &&
+					 ((delay < -TEST_LEVEL_MINUTES) || (delay > TEST_LEVEL_MINUTES))))
+			{
+				testFail(name, "level change away from the threshold mV", distance, TEST_LEVEL_MV);
+			}
+			changes++;
+			if(next == BatteryLevel_Critical)
+			{
+				break; /** The firmware shuts down here **/
+			}
+		}
+		level = next;
+	}
+
+	if(check)
+	{
+		printf("%-26s %lu bursts, max tracking error %ld mV\n", name, (unsigned long)bursts, (long)worsttrack);
+		if(changes != testcurve.expectcount)
+		{
+			testFail(name, "level changes", (long)changes, (long)testcurve.expectcount);
+		}
+		if(worsttrack > TEST_TRACK_TOLERANCE_MV)
+		{
+			testFail(name, "max tracking error mV", worsttrack, TEST_TRACK_TOLERANCE_MV);
+		}
+	}
+	return bursts;
+}
+/*****************************************************************************
+ * @brief Runs one curve without and with spikes.
+ *
+ * @param[in] path  Curve file.
+ *****************************************************************************/
+static void testCurve(const char *path)
+{
+	static uint16_t clean[TEST_MAX_POINTS * 10U];
+	static uint16_t spiked[TEST_MAX_POINTS * 10U];
+	const char *name = strrchr(path, '/');
+	name = (name != NULL) ? (name + 1) : path;
+
+	if(testLoadCurve(path) == false)
+	{
+		testFail(name, "rows", (long)testcurve.count, 2);
+		return;
+	}
+	if(((testcurve.points[testcurve.count - 1U].minutes * 60U) / APP_BATTERY_PERIOD) >= (TEST_MAX_POINTS * 10U))
+	{
+		testFail(name, "minutes", (long)testcurve.points[testcurve.count - 1U].minutes, (long)TEST_MAX_POINTS);
+		return;
+	}
+
+	uint32_t bursts = testReplay(name, false, clean, false);
+	uint32_t checked = testReplay(name, true, spiked, true);
+	int32_t worst = 0;
+
+	for(uint32_t i = 0; (i < bursts) && (i < checked); i++)
+	{
+		int32_t difference = (int32_t)spiked[i] - (int32_t)clean[i];
+		difference = (difference < 0) ? -difference : difference;
+		worst = (difference > worst) ? difference : worst;
+	}
+	printf("%-26s spikes move the filter by %ld mV at most\n", name, (long)worst);
+	if(worst > TEST_SPIKE_TOLERANCE_MV)
+	{
+		testFail(name, "spike influence mV", worst, TEST_SPIKE_TOLERANCE_MV);
+	}
+}
+
+/*****************************************************************************/
+/* Main                                                                      */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Tests the conversion, then every curve given on the command line.
+ *
+ * @param[in] argc  Argument count.
+ * @param[in] argv  Curve files (Data/ *.csv).
+ *
+ * @return int 0 if every check passed.
+ *****************************************************************************/
+int main(int argc, char *argv[])
+{
+	testConversion();
+	for(int i = 1; i < argc; i++)
+	{
+		testCurve(argv[i]);
+	}
+	if(argc < 2)
+	{
+		Sim_TestFailf("usage: %s curve.csv ...", argv[0]);
+	}
+	return Sim_TestResult();
+}
+/*************************************END*************************************/
@@ -0,0 +1,264 @@
+/**
+ * \file           sim_bootstage_test.c
+ * \brief          Host test of the boot stage timestamps
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include <stdio.h>
+#include "bootstage.h"
+#include "sim_test.h"
+
+/*****************************************************************************/
+/* Private Defines                                                           */
+/*****************************************************************************/
+#define TEST_HSI_HZ                16000000U    /** Clock up to BootStage_Clock **/
+#define TEST_PLL_HZ                72000000U    /** Clock from BootStage_Clock on **/
+#define TEST_POWER_UP_US           10000U       /** As TM1637_POWER_UP_US **/
+
+/*****************************************************************************/
+/* Private Types                                                             */
+/*****************************************************************************/
+/**
+ * @brief One stage of a model boot.
+ */
+typedef struct
+{
+	BootStage_e stage;               /**< Stage marked */
+	uint32_t span;                   /**< Microseconds since the previous mark */
+	uint32_t clock;                  /**< SystemCoreClock from the mark on */
+}TestStage_t;
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+uint32_t SystemCoreClock = TEST_HSI_HZ; /** Core clock seen by BootStage_Mark() **/
+
+static uint32_t testcycles = 0; /** DWT->CYCCNT of the model **/
+
+static uint32_t teststep = 0; /** Cycles the counter moves on every read **/
+
+static uint32_t testreads = 0; /** Counter reads **/
+
+/**
+ * @brief Boot of the LL build after a pin reset: no power-up wait.
+ */
+static const TestStage_t testwarmboot[] =
+{
+	{ BootStage_Main,       180U,   TEST_HSI_HZ },
+	{ BootStage_Clock,      310U,   TEST_PLL_HZ },
+	{ BootStage_Drivers,    25U,    TEST_PLL_HZ },
+	{ BootStage_Display,    40U,    TEST_PLL_HZ },
+	{ BootStage_FirstFrame, 720U,   TEST_PLL_HZ },
+	{ BootStage_Deferred,   2100U,  TEST_PLL_HZ },
+};
+
+/*****************************************************************************/
+/* Host Platform                                                             */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Cycle counter of the model, moves teststep cycles per read.
+ *****************************************************************************/
+uint32_t Sim_CycleCounter(void)
+{
+	testreads++;
+	testcycles += teststep;
+	return testcycles;
+}
+
+/*****************************************************************************/
+/* Helpers                                                                   */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Runs a model boot from reset: the counter moves by the span of
+ *        each stage at the clock of the previous one, then it is marked.
+ *
+ * @return uint32_t Microseconds from reset to the last stage.
+ *****************************************************************************/
+static uint32_t testBoot(const TestStage_t *stages, uint32_t count, uint32_t start)
+{
+	uint32_t microseconds = 0;
+
+	testcycles = start;
+	teststep = 0;
+	SystemCoreClock = TEST_HSI_HZ;
+	for(uint32_t i = 0; i < count; i++)
+	{
+		testcycles += stages[i].span * (SystemCoreClock / 1000000U);
+		SystemCoreClock = stages[i].clock;
+		BootStage_Mark(stages[i].stage);
+		microseconds += stages[i].span;
+	}
+	return microseconds;
+}
+
+/*****************************************************************************/
+/* Tests                                                                     */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Every stage is converted at the clock it ran on, the first ones
+ *        at the HSI.
+ *****************************************************************************/
+static void testStages(void)
+{
+	uint32_t count = sizeof(testwarmboot) / sizeof(testwarmboot[0]);
+	uint32_t expected = 0;
+
+	(void)testBoot(testwarmboot, count, 0U);
+	for(uint32_t i = 0; i < count; i++)
+	{
+		expected += testwarmboot[i].span;
+		if(BootStage_GetMicroseconds(testwarmboot[i].stage) != expected)
+		{
+			Sim_TestFail("stage time", BootStage_GetMicroseconds(testwarmboot[i].stage));
+		}
+	}
+	if(BootStage_Report() == false)
+	{
+		Sim_TestFail("warm boot over the budget", BootStage_GetMicroseconds(BootStage_FirstFrame));
+	}
+	printf("bootstage   warm boot: first frame %lu us, userMain %lu us\n",
+			(unsigned long)BootStage_GetMicroseconds(BootStage_FirstFrame),
+			(unsigned long)BootStage_GetMicroseconds(BootStage_Deferred));
+}
+/*****************************************************************************
+ * @brief A cold start waits for the display from reset: the stages before
+ *        it already count, the wait only takes the rest.
+ *****************************************************************************/
+static void testPowerUpWait(void)
+{
+	(void)testBoot(testwarmboot, 3U, 0U);
+	teststep = 7U; /** Cycles of one pass of the wait loop **/
+	BootStage_WaitUntil(TEST_POWER_UP_US);
+	teststep = 0;
+	uint32_t elapsed = BootStage_GetElapsed();
+	if((elapsed < TEST_POWER_UP_US) || (elapsed > (TEST_POWER_UP_US + 1U)))
+	{
+		Sim_TestFail("power-up wait", elapsed);
+	}
+
+	/** Already past it: a single read **/
+	testreads = 0;
+	BootStage_WaitUntil(100U);
+	if(testreads != 1U)
+	{
+		Sim_TestFail("wait when already past", testreads);
+	}
+}
+/*****************************************************************************
+ * @brief A boot over the budget is flagged.
+ *****************************************************************************/
+static void testBudget(void)
+{
+	TestStage_t slow[sizeof(testwarmboot) / sizeof(testwarmboot[0])];
+	uint32_t count = sizeof(slow) / sizeof(slow[0]);
+
+	for(uint32_t i = 0; i < count; i++)
+	{
+		slow[i] = testwarmboot[i];
+	}
+	slow[3].span = (APP_BOOT_FRAME_BUDGET_MS * 1000U) - 1235U; /** Display: the frame lands on the budget **/
+	(void)testBoot(slow, count, 0U);
+	if((BootStage_GetMicroseconds(BootStage_FirstFrame) != (APP_BOOT_FRAME_BUDGET_MS * 1000U)) ||
+	   (BootStage_Report() == false))
+	{
+		Sim_TestFail("frame on the budget", BootStage_GetMicroseconds(BootStage_FirstFrame));
+	}
+	slow[3].span++;
+	(void)testBoot(slow, count, 0U);
+	if(BootStage_Report())
+	{
+		Sim_TestFail("frame over the budget", BootStage_GetMicroseconds(BootStage_FirstFrame));
+	}
+}
+/*****************************************************************************
+ * @brief A boot longer than the 59.6 s the 32-bit counter spans at
+ *        72 MHz (a very slow LSE start) still converts, every stage is
+ *        shorter than that.
+ *****************************************************************************/
+static void testWrap(void)
+{
+	TestStage_t lse[sizeof(testwarmboot) / sizeof(testwarmboot[0])];
+	uint32_t count = sizeof(lse) / sizeof(lse[0]);
+
+	for(uint32_t i = 0; i < count; i++)
+	{
+		lse[i] = testwarmboot[i];
+	}
+	lse[3].span = 30000000U; /** 30 s to the display **/
+	lse[5].span = 30000000U; /** The counter wraps in the deferred stage **/
+	uint32_t total = testBoot(lse, count, 0U);
+	if(BootStage_GetMicroseconds(BootStage_Deferred) != total)
+	{
+		Sim_TestFail("wrapped stage", BootStage_GetMicroseconds(BootStage_Deferred));
+	}
+	if(testcycles >= (lse[3].span * (TEST_PLL_HZ / 1000000U)))
+	{
+		Sim_TestFail("counter did not wrap", testcycles);
+	}
+}
+/*****************************************************************************
+ * @brief A host build that only marks the first frame converts from reset
+ *        at the HSI; stages never marked report 0. Runs first, marks
+ *        are only dropped by marking an earlier stage.
+ *****************************************************************************/
+static void testMissing(void)
+{
+	static const TestStage_t frame[] = { { BootStage_FirstFrame, 900U, TEST_HSI_HZ } };
+
+	(void)testBoot(frame, 1U, 0U);
+	if(BootStage_GetMicroseconds(BootStage_FirstFrame) != 900U)
+	{
+		Sim_TestFail("frame without earlier marks", BootStage_GetMicroseconds(BootStage_FirstFrame));
+	}
+	if((BootStage_GetMicroseconds(BootStage_Main) != 0U) || (BootStage_GetMicroseconds(BootStage_Count) != 0U))
+	{
+		Sim_TestFail("unmarked stage", BootStage_GetMicroseconds(BootStage_Main));
+	}
+	if(BootStage_Report() == false)
+	{
+		Sim_TestFail("report of a frame only boot", 0);
+	}
+}
+
+/*****************************************************************************/
+/* Main                                                                      */
+/*****************************************************************************/
+int main(void)
+{
+	testMissing();
+	testStages();
+	testPowerUpWait();
+	testBudget();
+	testWrap();
+
+	return Sim_TestResult();
+}
+/*************************************END*************************************/
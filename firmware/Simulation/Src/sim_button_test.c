@@ -0,0 +1,287 @@
+/**
+ * \file           sim_button_test.c
+ * \brief          Host test of the button event stream against bounce traces
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include "sim.h"
+#include "button.h"
+#include "sim_test.h"
+
+/*****************************************************************************/
+/* Private Defines                                                           */
+/*****************************************************************************/
+#define TEST_MAX_EVENTS            16U      /** Events kept per trace **/
+#define TEST_DEBOUNCE_US           ((uint64_t)BUTTON_DEBOUNCE_MS * 1000U)
+#define TEST_LONG_PRESS_US         ((uint64_t)BUTTON_LONG_PRESS_MS * 1000U)
+#define TEST_SLACK_US              SIM_HWTIMER_TICK_US /** Event time resolution, one TIM4 tick **/
+#define TEST_START_US              100000U  /** Traces start after the boot **/
+#define TEST_SETTLE_US             100000U  /** Quiet time run after the last edge **/
+
+#define DOWN                       false    /** Active low, pin pulled to ground **/
+#define UP                         true
+
+/*****************************************************************************/
+/* Private Types                                                             */
+/*****************************************************************************/
+/**
+ * @brief One edge of a bounce trace.
+ */
+typedef struct
+{
+	uint32_t at;                     /**< Microseconds after the trace start */
+	uint16_t pin;                    /**< GPIO_PIN_0 control, GPIO_PIN_1 function */
+	bool level;                      /**< Pin level after the edge */
+}TestEdge_t;
+
+/**
+ * @brief One event the trace must produce.
+ */
+typedef struct
+{
+	AppEvent_e event;                /**< Event */
+	uint32_t at;                     /**< Microseconds after the trace start */
+}TestEvent_t;
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static TestEvent_t testevents[TEST_MAX_EVENTS]; /** Events posted while replaying **/
+static uint32_t testeventcount = 0;             /** Entries in testevents **/
+
+/*
+ * Contact bounce of the tactile switches as seen on PA0/PA1: a burst of
+ * sub-millisecond chatter, a few longer bounces and the settled level.
+ * Times are in microseconds from the start of each trace.
+ */
+
+/** Control press held 180 ms **/
+static const TestEdge_t traceshort[] =
+{
+	{      0, GPIO_PIN_0, DOWN }, {    140, GPIO_PIN_0, UP   }, {    310, GPIO_PIN_0, DOWN },
+	{    720, GPIO_PIN_0, UP   }, {   1180, GPIO_PIN_0, DOWN }, {   2950, GPIO_PIN_0, UP   },
+	{   3400, GPIO_PIN_0, DOWN },
+	{ 180000, GPIO_PIN_0, UP   }, { 180090, GPIO_PIN_0, DOWN }, { 180410, GPIO_PIN_0, UP   },
+	{ 181200, GPIO_PIN_0, DOWN }, { 181900, GPIO_PIN_0, UP   },
+};
+static const TestEvent_t expectshort[] =
+{
+	{ AppEvent_ControlPress,      3400U + TEST_DEBOUNCE_US },
+	{ AppEvent_ControlRelease,    181900U + TEST_DEBOUNCE_US },
+	{ AppEvent_ControlShortPress, 181900U + TEST_DEBOUNCE_US },
+};
+
+/** Function press held 2.6 s **/
+static const TestEdge_t tracelong[] =
+{
+	{       0, GPIO_PIN_1, DOWN }, {      60, GPIO_PIN_1, UP   }, {     250, GPIO_PIN_1, DOWN },
+	{     480, GPIO_PIN_1, UP   }, {    1900, GPIO_PIN_1, DOWN }, {    4700, GPIO_PIN_1, UP   },
+	{    5300, GPIO_PIN_1, DOWN },
+	{ 2600000, GPIO_PIN_1, UP   }, { 2600350, GPIO_PIN_1, DOWN }, { 2602100, GPIO_PIN_1, UP   },
+};
+static const TestEvent_t expectlong[] =
+{
+	{ AppEvent_FunctionPress,     5300U + TEST_DEBOUNCE_US },
+	{ AppEvent_FunctionLongPress, TEST_LONG_PRESS_US },
+	{ AppEvent_FunctionRelease,   2602100U + TEST_DEBOUNCE_US },
+};
+
+/** Glitches on the released control button, all shorter than the debounce **/
+static const TestEdge_t traceglitch[] =
+{
+	{      0, GPIO_PIN_0, DOWN }, {     60, GPIO_PIN_0, UP   },
+	{  50000, GPIO_PIN_0, DOWN }, {  53000, GPIO_PIN_0, UP   },
+	{ 100000, GPIO_PIN_0, DOWN }, { 100000U + TEST_DEBOUNCE_US - 1000U, GPIO_PIN_0, UP },
+	{ 200000, GPIO_PIN_0, DOWN }, { 200800, GPIO_PIN_0, UP   }, { 206000, GPIO_PIN_0, DOWN },
+	{ 206300, GPIO_PIN_0, UP   }, { 215000, GPIO_PIN_0, DOWN }, { 218500, GPIO_PIN_0, UP   },
+};
+
+/** Control held 2.5 s with release glitches before and after the long press **/
+static const TestEdge_t traceheld[] =
+{
+	{       0, GPIO_PIN_0, DOWN }, {     90, GPIO_PIN_0, UP   }, {    700, GPIO_PIN_0, DOWN },
+	{ 1000000, GPIO_PIN_0, UP   }, { 1004000, GPIO_PIN_0, DOWN },
+	{ 1990000, GPIO_PIN_0, UP   }, { 1990000U + TEST_DEBOUNCE_US - 1000U, GPIO_PIN_0, DOWN },
+	{ 2200000, GPIO_PIN_0, UP   }, { 2200200, GPIO_PIN_0, DOWN },
+	{ 2500000, GPIO_PIN_0, UP   }, { 2500400, GPIO_PIN_0, DOWN }, { 2501000, GPIO_PIN_0, UP   },
+};
+static const TestEvent_t expectheld[] =
+{
+	{ AppEvent_ControlPress,      700U + TEST_DEBOUNCE_US },
+	{ AppEvent_ControlLongPress,  1990000U + TEST_DEBOUNCE_US - 1000U + TEST_DEBOUNCE_US },
+	{ AppEvent_ControlRelease,    2501000U + TEST_DEBOUNCE_US },
+};
+
+/** Function pressed while the control button is held, both short **/
+static const TestEdge_t traceboth[] =
+{
+	{      0, GPIO_PIN_0, DOWN }, {    200, GPIO_PIN_0, UP   }, {    900, GPIO_PIN_0, DOWN },
+	{ 100000, GPIO_PIN_1, DOWN }, { 100150, GPIO_PIN_1, UP   }, { 101000, GPIO_PIN_1, DOWN },
+	{ 300000, GPIO_PIN_0, UP   }, { 300500, GPIO_PIN_0, DOWN }, { 301500, GPIO_PIN_0, UP   },
+	{ 400000, GPIO_PIN_1, UP   },
+};
+static const TestEvent_t expectboth[] =
+{
+	{ AppEvent_ControlPress,       900U + TEST_DEBOUNCE_US },
+	{ AppEvent_FunctionPress,      101000U + TEST_DEBOUNCE_US },
+	{ AppEvent_ControlRelease,     301500U + TEST_DEBOUNCE_US },
+	{ AppEvent_ControlShortPress,  301500U + TEST_DEBOUNCE_US },
+	{ AppEvent_FunctionRelease,    400000U + TEST_DEBOUNCE_US },
+	{ AppEvent_FunctionShortPress, 400000U + TEST_DEBOUNCE_US },
+};
+
+/*****************************************************************************/
+/* Helpers                                                                   */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Not reached, the traces stay within the input script.
+ *****************************************************************************/
+void Error_Handler(void)
+{
+	exit(2);
+}
+/*****************************************************************************
+ * @brief EXTI0/1 callback, wired like the firmware.
+ *****************************************************************************/
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+	if(GPIO_Pin == GPIO_PIN_0)
+	{
+		button_Edge(ButtonId_Control);
+	}
+	else if(GPIO_Pin == GPIO_PIN_1)
+	{
+		button_Edge(ButtonId_Function);
+	}
+}
+/*****************************************************************************
+ * @brief Moves the virtual clock to a time, taking the posted events with
+ *        the time of the TIM4 interrupt that posted them.
+ *****************************************************************************/
+static void testRunUntil(uint64_t until)
+{
+	bool ran;
+
+	do
+	{
+		ran = Sim_AdvanceToNextEvent(until);
+		for(AppEvent_e event = eventQueue_Get(); event != AppEvent_None; event = eventQueue_Get())
+		{
+			if(testeventcount < TEST_MAX_EVENTS)
+			{
+				testevents[testeventcount].event = event;
+				testevents[testeventcount].at = (uint32_t)(Sim_Now() - TEST_START_US);
+			}
+			testeventcount++;
+		}
+	}while(ran);
+}
+/*****************************************************************************
+ * @brief Replays a bounce trace from a fresh boot and compares the event
+ *        stream with the expected one.
+ *
+ * @details Each edge sets the pin and raises its EXTI callback at the
+ *          trace time; TIM4 runs on the virtual clock in between. An event
+ *          must come in order and within one TIM4 tick of its time.
+ *****************************************************************************/
+static void testTrace(const char *name, const TestEdge_t *trace, uint32_t edges,
+                      const TestEvent_t *expect, uint32_t events)
+{
+	Sim_Reset();
+	HwTimer_Init();
+	eventQueue_Init();
+	button_Init();
+	testeventcount = 0;
+
+	testRunUntil(TEST_START_US);
+	for(uint32_t e = 0; e < edges; e++)
+	{
+		testRunUntil(TEST_START_US + trace[e].at);
+		if(trace[e].level)
+		{
+			GPIOA->IDR |= trace[e].pin;
+		}
+		else
+		{
+			GPIOA->IDR &= ~(uint32_t)trace[e].pin;
+		}
+		HAL_GPIO_EXTI_Callback(trace[e].pin);
+	}
+	testRunUntil(TEST_START_US + trace[edges - 1U].at + TEST_SETTLE_US);
+
+	if(testeventcount != events)
+	{
+		fprintf(stderr, "%s: %lu events, expected %lu\n", name, (unsigned long)testeventcount, (unsigned long)events);
+		Sim_TestFail(name, testeventcount);
+	}
+	for(uint32_t e = 0; (e < events) && (e < testeventcount) && (e < TEST_MAX_EVENTS); e++)
+	{
+		if(testevents[e].event != expect[e].event)
+		{
+			fprintf(stderr, "%s: event %lu is %d, expected %d\n", name, (unsigned long)e,
+					(int)testevents[e].event, (int)expect[e].event);
+			Sim_TestFail(name, e);
+		}
+		else if((testevents[e].at + TEST_SLACK_US < expect[e].at) ||
+				(testevents[e].at > expect[e].at + TEST_SLACK_US))
+		{
+			fprintf(stderr, "%s: event %lu at %lu us, expected %lu us\n", name, (unsigned long)e,
+					(unsigned long)testevents[e].at, (unsigned long)expect[e].at);
+			Sim_TestFail(name, e);
+		}
+	}
+	if(HwTimer_IsActive())
+	{
+		Sim_TestFail("timer left running after the trace", testeventcount);
+	}
+	printf("button      %-12s %2lu edges -> %lu events\n", name, (unsigned long)edges, (unsigned long)testeventcount);
+}
+
+/*****************************************************************************/
+/* Main                                                                      */
+/*****************************************************************************/
+int main(void)
+{
+	testTrace("short press", traceshort, sizeof(traceshort) / sizeof(traceshort[0]),
+			expectshort, sizeof(expectshort) / sizeof(expectshort[0]));
+	testTrace("long press", tracelong, sizeof(tracelong) / sizeof(tracelong[0]),
+			expectlong, sizeof(expectlong) / sizeof(expectlong[0]));
+	testTrace("glitches", traceglitch, sizeof(traceglitch) / sizeof(traceglitch[0]), NULL, 0U);
+	testTrace("held", traceheld, sizeof(traceheld) / sizeof(traceheld[0]),
+			expectheld, sizeof(expectheld) / sizeof(expectheld[0]));
+	testTrace("both", traceboth, sizeof(traceboth) / sizeof(traceboth[0]),
+			expectboth, sizeof(expectboth) / sizeof(expectboth[0]));
+
+	return Sim_TestResult();
+}
+/*************************************END*************************************/
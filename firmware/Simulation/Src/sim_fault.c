@@ -0,0 +1,113 @@
+/**
+ * \file           sim_fault.c
+ * \brief          Simulated fault status registers, reset and STANDBY
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include "sim.h"
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static uint32_t simfaultstatus[4]; /** CFSR, HFSR, MMFAR, BFAR **/
+
+static SimHandler_t simfaultreset = NULL; /** APP_SYSTEM_RESET() handler **/
+
+static SimHandler_t simfaultpark = NULL; /** APP_FAULT_PARK() handler **/
+
+/*****************************************************************************/
+/* Private Functions                                                         */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Runs a handler that must not return.
+ *****************************************************************************/
+static void __attribute__((noreturn)) simFaultExit(SimHandler_t handler, const char *what)
+{
+	if(handler != NULL)
+	{
+		handler();
+	}
+	fprintf(stderr, "sim: %s after a fault, nothing to return to\n", what);
+	exit(1);
+}
+
+/*****************************************************************************/
+/* Simulation Functions                                                      */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Sets what the fault status registers read.
+ *****************************************************************************/
+void Sim_FaultSetStatus(uint32_t cfsr, uint32_t hfsr, uint32_t mmfar, uint32_t bfar)
+{
+	simfaultstatus[0] = cfsr;
+	simfaultstatus[1] = hfsr;
+	simfaultstatus[2] = mmfar;
+	simfaultstatus[3] = bfar;
+}
+/*****************************************************************************
+ * @brief Sets the handlers of a reset and of STANDBY after a recorded fault.
+ *****************************************************************************/
+void Sim_FaultSetHandlers(SimHandler_t reset, SimHandler_t park)
+{
+	simfaultreset = reset;
+	simfaultpark = park;
+}
+
+/*****************************************************************************/
+/* HAL Replacements                                                          */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief APP_FAULT_STATUS_READ().
+ *****************************************************************************/
+void Sim_FaultStatusRead(uint32_t *cfsr, uint32_t *hfsr, uint32_t *mmfar, uint32_t *bfar)
+{
+	*cfsr = simfaultstatus[0];
+	*hfsr = simfaultstatus[1];
+	*mmfar = simfaultstatus[2];
+	*bfar = simfaultstatus[3];
+}
+/*****************************************************************************
+ * @brief APP_SYSTEM_RESET().
+ *****************************************************************************/
+void Sim_FaultReset(void)
+{
+	simFaultExit(simfaultreset, "reset");
+}
+/*****************************************************************************
+ * @brief APP_FAULT_PARK().
+ *****************************************************************************/
+void Sim_FaultPark(void)
+{
+	simFaultExit(simfaultpark, "standby");
+}
+/*************************************END*************************************/
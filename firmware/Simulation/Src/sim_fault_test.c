@@ -0,0 +1,407 @@
+/**
+ * \file           sim_fault_test.c
+ * \brief          Host fault injection test of the fault capture record
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+#include "faultcapture.h"
+#include "sim_test.h"
+
+/*****************************************************************************/
+/* Private Defines                                                           */
+/*****************************************************************************/
+#define TEST_EXIT_RESET            1            /** APP_SYSTEM_RESET() was called **/
+#define TEST_EXIT_PARK             2            /** APP_FAULT_PARK() was called **/
+#define TEST_EXC_RETURN            0xFFFFFFFDU  /** Thread mode, PSP **/
+#define TEST_ERROR_CALLER          0x08001235U  /** Return address given to FaultCapture_Error() **/
+#define TEST_CFSR                  0x00008200U  /** BFARVALID | PRECISERR **/
+#define TEST_HFSR                  0x40000000U  /** FORCED **/
+#define TEST_MMFAR                 0xE000ED34U  /** Reset value, not valid **/
+#define TEST_BFAR                  0x20010004U  /** Just past the end of RAM **/
+
+/*****************************************************************************/
+/* Record Format                                                             */
+/*****************************************************************************/
+/** The layout the host tools and the report rely on **/
+_Static_assert(sizeof(FaultRecord_t) == 84U, "record size");
+_Static_assert(offsetof(FaultRecord_t, cause) == 4U, "cause offset");
+_Static_assert(offsetof(FaultRecord_t, events) == 7U, "events offset");
+_Static_assert(offsetof(FaultRecord_t, frame) == 8U, "frame offset");
+_Static_assert(offsetof(FaultRecord_t, sp) == 40U, "sp offset");
+_Static_assert(offsetof(FaultRecord_t, cfsr) == 48U, "cfsr offset");
+_Static_assert(offsetof(FaultRecord_t, uptime) == 64U, "uptime offset");
+_Static_assert(offsetof(FaultRecord_t, count) == 68U, "count offset");
+_Static_assert(offsetof(FaultRecord_t, history) == 72U, "history offset");
+_Static_assert(offsetof(FaultRecord_t, crc) == 80U, "crc offset");
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static jmp_buf testreboot; /** Where a reset or STANDBY continues **/
+
+static uint32_t testfaults = 0; /** Faults injected **/
+
+static uint32_t testparks = 0; /** Faults that ended in STANDBY **/
+
+static bool testmasked = false; /** Interrupts masked since the last injection **/
+
+/*****************************************************************************/
+/* Platform Overrides                                                        */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Interrupt mask of the test, sim_hal.c is not linked.
+ *****************************************************************************/
+void __disable_irq(void)
+{
+	testmasked = true;
+}
+
+/*****************************************************************************/
+/* Helpers                                                                   */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Reset handler of the fault capture.
+ *****************************************************************************/
+static void testReset(void)
+{
+	if(testmasked == false)
+	{
+		Sim_TestFail("reset with interrupts enabled", 0);
+	}
+	longjmp(testreboot, TEST_EXIT_RESET);
+}
+/*****************************************************************************
+ * @brief STANDBY handler of the fault capture.
+ *****************************************************************************/
+static void testPark(void)
+{
+	if(testmasked == false)
+	{
+		Sim_TestFail("standby with interrupts enabled", 0);
+	}
+	longjmp(testreboot, TEST_EXIT_PARK);
+}
+/*****************************************************************************
+ * @brief Reference CRC-32 (IEEE), independent of StdUtil.h.
+ *****************************************************************************/
+static uint32_t testCrc32(const uint8_t *bytes, uint32_t length)
+{
+	uint32_t crc = 0xFFFFFFFFU;
+
+	while(length-- > 0U)
+	{
+		crc ^= *bytes++;
+		for(uint32_t bit = 0; bit < 8U; bit++)
+		{
+			crc = (crc & 1U) ? ((crc >> 1) ^ 0xEDB88320U) : (crc >> 1);
+		}
+	}
+	return ~crc;
+}
+/*****************************************************************************
+ * @brief Injects a fault, then boots again.
+ *
+ * @param[in] cause  Fault cause, FaultCause_Error goes through FaultCapture_Error().
+ * @param[in] frame  Stacked registers given to the handler.
+ *
+ * @return int TEST_EXIT_RESET or TEST_EXIT_PARK.
+ *****************************************************************************/
+static int testInject(FaultCause_e cause, const uint32_t *frame)
+{
+	int result = setjmp(testreboot);
+
+	if(result == 0)
+	{
+		testfaults++;
+		testmasked = false;
+		if(cause == FaultCause_Error)
+		{
+			FaultCapture_Error(TEST_ERROR_CALLER);
+		}
+		FaultCapture_Handler(frame, TEST_EXC_RETURN, cause);
+	}
+	if(result == TEST_EXIT_PARK)
+	{
+		testparks++;
+		FaultCapture_Clear(); /** STANDBY does not keep SRAM **/
+	}
+	FaultCapture_Init(); /** The boot after the reset **/
+	return result;
+}
+/*****************************************************************************
+ * @brief Reads the record and checks its magic and CRC byte by byte.
+ *****************************************************************************/
+static bool testRecord(FaultRecord_t *record, uint32_t magic)
+{
+	if(FaultCapture_GetRecord(record) == false)
+	{
+		Sim_TestFail("record missing", 0);
+		return false;
+	}
+	const uint8_t *bytes = (const uint8_t *)record;
+	if(record->magic != magic)
+	{
+		Sim_TestFail("record magic", record->magic);
+	}
+	if(record->crc != testCrc32(&bytes[4], 76U))
+	{
+		Sim_TestFail("record crc", record->crc);
+	}
+	return true;
+}
+
+/*****************************************************************************/
+/* Tests                                                                     */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Power-up: no record, no count.
+ *****************************************************************************/
+static void testPowerUp(void)
+{
+	FaultRecord_t record;
+
+	FaultCapture_Init();
+	if(FaultCapture_IsPending() || FaultCapture_GetRecord(&record) || (FaultCapture_GetCount() != 0U))
+	{
+		Sim_TestFail("power-up state", FaultCapture_GetCount());
+	}
+	FaultCapture_Report(); /** Nothing to print **/
+}
+/*****************************************************************************
+ * @brief A BusFault with a known frame, every field of the record.
+ *****************************************************************************/
+static void testBusFault(void)
+{
+	static const uint32_t frame[FaultFrame_Count] =
+	{
+		0x11111111U, 0x22222222U, 0x33333333U, 0x44444444U,
+		0xCCCCCCCCU, 0x08000F01U, 0x08001A2CU, 0x21000000U
+	};
+	FaultRecord_t record;
+
+	for(uint8_t event = 1; event <= 11U; event++)
+	{
+		FaultCapture_Event(event); /** Wraps the history ring **/
+	}
+	FaultCapture_SetMode(0x12U);
+	for(uint32_t second = 0; second < 5U; second++)
+	{
+		FaultCapture_SecondTick();
+	}
+	Sim_FaultSetStatus(TEST_CFSR, TEST_HFSR, TEST_MMFAR, TEST_BFAR);
+
+	if(testInject(FaultCause_BusFault, frame) != TEST_EXIT_RESET)
+	{
+		Sim_TestFail("first fault did not reset", 0);
+	}
+	if(FaultCapture_IsPending() == false)
+	{
+		Sim_TestFail("record not pending after the reset", 0);
+	}
+	if(testRecord(&record, FAULTCAPTURE_MAGIC_NEW) == false)
+	{
+		return;
+	}
+	if((record.cause != FaultCause_BusFault) || (record.mode != 0x12U) || (record.frameValid != 1U))
+	{
+		Sim_TestFail("cause, mode or frame flag", record.cause);
+	}
+	if(memcmp(record.frame, frame, sizeof(frame)) != 0)
+	{
+		Sim_TestFail("stacked registers", record.frame[FaultFrame_Pc]);
+	}
+	if((record.sp != (uint32_t)(uintptr_t)frame) || (record.excReturn != TEST_EXC_RETURN))
+	{
+		Sim_TestFail("sp or exc_return", record.excReturn);
+	}
+	if((record.cfsr != TEST_CFSR) || (record.hfsr != TEST_HFSR) ||
+			(record.mmfar != TEST_MMFAR) || (record.bfar != TEST_BFAR))
+	{
+		Sim_TestFail("status registers", record.cfsr);
+	}
+	if((record.uptime != 5U) || (record.count != 1U) || (FaultCapture_GetCount() != 1U))
+	{
+		Sim_TestFail("uptime or count", record.uptime);
+	}
+	if(record.events != FAULTCAPTURE_HISTORY)
+	{
+		Sim_TestFail("history length", record.events);
+	}
+	for(uint32_t index = 0; index < FAULTCAPTURE_HISTORY; index++)
+	{
+		if(record.history[index] != (uint8_t)(4U + index))
+		{
+			Sim_TestFail("history order", index);
+		}
+	}
+
+	/** Printed once, kept for later reads **/
+	FaultCapture_Report();
+	if(FaultCapture_IsPending())
+	{
+		Sim_TestFail("record pending after the report", 0);
+	}
+	(void)testRecord(&record, FAULTCAPTURE_MAGIC_REPORTED);
+	FaultCapture_Init();
+	if(FaultCapture_IsPending() || (FaultCapture_GetRecord(&record) == false))
+	{
+		Sim_TestFail("reported record after a reset", 0);
+	}
+}
+/*****************************************************************************
+ * @brief Error_Handler() path and a frame outside RAM: no registers kept.
+ *****************************************************************************/
+static void testNoFrame(void)
+{
+	FaultRecord_t record;
+
+	FaultCapture_Event(7U);
+	FaultCapture_Event(9U);
+	(void)testInject(FaultCause_Error, NULL);
+	if(testRecord(&record, FAULTCAPTURE_MAGIC_NEW) &&
+			((record.cause != FaultCause_Error) || (record.frameValid != 0U) ||
+			 (record.frame[FaultFrame_Pc] != TEST_ERROR_CALLER) || (record.frame[FaultFrame_Lr] != 0U) ||
+			 (record.events != 2U) || (record.history[0] != 7U) || (record.history[1] != 9U) ||
+			 (record.count != 2U)))
+	{
+		Sim_TestFail("error record", record.frame[FaultFrame_Pc]);
+	}
+
+	for(uint32_t second = 0; second < APP_FAULT_STABLE_SECONDS; second++)
+	{
+		FaultCapture_SecondTick(); /** Not a fault in a row **/
+	}
+	(void)testInject(FaultCause_HardFault, NULL);
+	if(testRecord(&record, FAULTCAPTURE_MAGIC_NEW) &&
+			((record.cause != FaultCause_HardFault) || (record.frameValid != 0U) ||
+			 (record.sp != 0U) || (record.events != 0U) || (record.count != 3U)))
+	{
+		Sim_TestFail("record without a frame", record.frameValid);
+	}
+}
+/*****************************************************************************
+ * @brief APP_FAULT_RESET_LIMIT faults in a row park the MCU, running
+ *        APP_FAULT_STABLE_SECONDS starts the count again.
+ *****************************************************************************/
+static void testResetLimit(void)
+{
+	static const uint32_t frame[FaultFrame_Count] = { 0 };
+
+	FaultCapture_Clear();
+	FaultCapture_Init();
+	for(uint32_t fault = 1; fault < APP_FAULT_RESET_LIMIT; fault++)
+	{
+		if(testInject(FaultCause_UsageFault, frame) != TEST_EXIT_RESET)
+		{
+			Sim_TestFail("reset before the limit", fault);
+		}
+	}
+	if(testInject(FaultCause_UsageFault, frame) != TEST_EXIT_PARK)
+	{
+		Sim_TestFail("no standby at the limit", APP_FAULT_RESET_LIMIT);
+	}
+	if(FaultCapture_IsPending() || (FaultCapture_GetCount() != 0U))
+	{
+		Sim_TestFail("record kept over standby", FaultCapture_GetCount());
+	}
+	/** Woken by NRST: all the tries again **/
+	for(uint32_t fault = 1; fault < APP_FAULT_RESET_LIMIT; fault++)
+	{
+		if(testInject(FaultCause_UsageFault, frame) != TEST_EXIT_RESET)
+		{
+			Sim_TestFail("reset after the wake-up", fault);
+		}
+	}
+
+	/** Running long enough, the firmware gets all its tries back **/
+	for(uint32_t second = 0; second < APP_FAULT_STABLE_SECONDS; second++)
+	{
+		FaultCapture_SecondTick();
+	}
+	for(uint32_t fault = 1; fault < APP_FAULT_RESET_LIMIT; fault++)
+	{
+		if(testInject(FaultCause_MemManage, frame) != TEST_EXIT_RESET)
+		{
+			Sim_TestFail("reset after a stable run", fault);
+		}
+	}
+	/** Not stable yet: one second short **/
+	for(uint32_t second = 1; second < APP_FAULT_STABLE_SECONDS; second++)
+	{
+		FaultCapture_SecondTick();
+	}
+	if(FaultCapture_GetCount() != (2U * (APP_FAULT_RESET_LIMIT - 1U)))
+	{
+		Sim_TestFail("fault count over the resets", FaultCapture_GetCount());
+	}
+	if(testInject(FaultCause_MemManage, frame) != TEST_EXIT_PARK)
+	{
+		Sim_TestFail("no standby after a short run", 0);
+	}
+}
+/*****************************************************************************
+ * @brief FaultCapture_Clear() is a power-up.
+ *****************************************************************************/
+static void testClear(void)
+{
+	FaultRecord_t record;
+
+	FaultCapture_Clear();
+	FaultCapture_Init();
+	if(FaultCapture_IsPending() || FaultCapture_GetRecord(&record) || (FaultCapture_GetCount() != 0U))
+	{
+		Sim_TestFail("state after clear", FaultCapture_GetCount());
+	}
+}
+
+/*****************************************************************************/
+/* Main                                                                      */
+/*****************************************************************************/
+int main(void)
+{
+	Sim_FaultSetHandlers(testReset, testPark);
+
+	testPowerUp();
+	testBusFault();
+	testNoFrame();
+	testResetLimit();
+	testClear();
+
+	printf("faults      %lu injected, %lu ended in standby, record %lu bytes\n",
+			(unsigned long)testfaults, (unsigned long)testparks, (unsigned long)sizeof(FaultRecord_t));
+	return Sim_TestResult();
+}
+/*************************************END*************************************/
@@ -0,0 +1,248 @@
+/**
+ * \file           sim_flash.c
+ * \brief          Host simulation flash sector model source file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+#include "flashregion.h"
+
+/*****************************************************************************/
+/* Private Defines                                                           */
+/*****************************************************************************/
+#define SIM_FLASH_WORDS            (128U * 1024U / 4U)   /** Largest region, sector 5 **/
+#define SIM_FLASH_ERASED           0xFFFFFFFFU           /** Erased word **/
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static uint32_t simflash[FlashRegion_Count][SIM_FLASH_WORDS]; /** Contents of the data sectors **/
+
+static const uint32_t simflashwords[FlashRegion_Count] = /** Words of each region, as in STM32F401CCUX_FLASH.ld **/
+{
+	[FlashRegion_SessionLog] = 128U * 1024U / 4U,
+	[FlashRegion_Profiles]   = 64U * 1024U / 4U,
+};
+
+static bool simflashformatted = false; /** simflash was erased once **/
+
+static SimFlashStats_t simflashstats; /** Counters **/
+
+static uint32_t simflashcut = 0; /** Operations until the power cut, 0 = none **/
+
+static SimHandler_t simflashcuthandler = NULL; /** Called at the power cut **/
+
+static uint32_t simflasherror = 0; /** Word programs until the failing one, 0 = none **/
+
+static uint32_t simflashrandom = 0x6C078965U; /** Pattern of half done operations **/
+
+/*****************************************************************************/
+/* Private Functions                                                         */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Xorshift32 step.
+ *****************************************************************************/
+static uint32_t simFlashRandom(void)
+{
+	simflashrandom ^= simflashrandom << 13;
+	simflashrandom ^= simflashrandom >> 17;
+	simflashrandom ^= simflashrandom << 5;
+	return simflashrandom;
+}
+/*****************************************************************************
+ * @brief Erases the model once before its first use.
+ *****************************************************************************/
+static void simFlashFormat(void)
+{
+	if(simflashformatted == false)
+	{
+		Sim_FlashReset();
+	}
+}
+/*****************************************************************************
+ * @brief Counts one flash operation down to the armed power cut.
+ *
+ * @return bool true if the power fails during this operation.
+ *****************************************************************************/
+static bool simFlashCutNow(void)
+{
+	if((simflashcut == 0U) || (--simflashcut != 0U))
+	{
+		return false;
+	}
+	simflashstats.cuts++;
+	return true;
+}
+/*****************************************************************************
+ * @brief Runs the power cut handler, does not return.
+ *****************************************************************************/
+static void simFlashCut(void)
+{
+	SimHandler_t cut = simflashcuthandler;
+
+	simflashcuthandler = NULL;
+	if(cut != NULL)
+	{
+		cut();
+	}
+	fprintf(stderr, "sim: flash power cut without a handler\n");
+	exit(1);
+}
+
+/*****************************************************************************/
+/* Flash Model                                                               */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Erases the flash model and clears its counters.
+ *****************************************************************************/
+void Sim_FlashReset(void)
+{
+	for(uint32_t region = 0; region < (uint32_t)FlashRegion_Count; region++)
+	{
+		for(uint32_t i = 0; i < SIM_FLASH_WORDS; i++)
+		{
+			simflash[region][i] = SIM_FLASH_ERASED;
+		}
+	}
+	memset(&simflashstats, 0, sizeof(simflashstats));
+	simflashcut = 0;
+	simflashcuthandler = NULL;
+	simflasherror = 0;
+	simflashformatted = true;
+}
+/*****************************************************************************
+ * @brief Arms or disarms the power cut.
+ *****************************************************************************/
+void Sim_FlashArmCut(uint32_t operation, SimHandler_t cut)
+{
+	simflashcut = operation;
+	simflashcuthandler = cut;
+}
+/*****************************************************************************
+ * @brief Arms or disarms the failing word program.
+ *****************************************************************************/
+void Sim_FlashArmError(uint32_t operation)
+{
+	simflasherror = operation;
+}
+/*****************************************************************************
+ * @brief Returns the counters of the flash model.
+ *****************************************************************************/
+SimFlashStats_t *Sim_FlashGetStats(void)
+{
+	return &simflashstats;
+}
+
+/*****************************************************************************/
+/* Flash Region Replacement                                                  */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Returns the first word of a region of the model.
+ *****************************************************************************/
+const volatile uint32_t *FlashRegion_GetBase(FlashRegion_e region)
+{
+	simFlashFormat();
+	return simflash[region];
+}
+/*****************************************************************************
+ * @brief Returns the size of a region of the model.
+ *****************************************************************************/
+uint32_t FlashRegion_GetSize(FlashRegion_e region)
+{
+	return simflashwords[region] * 4U;
+}
+/*****************************************************************************
+ * @brief Erases a region of the model, or a random part of it at a power cut.
+ *****************************************************************************/
+bool FlashRegion_Erase(FlashRegion_e region)
+{
+	simFlashFormat();
+	simflashstats.erases++;
+	if(simFlashCutNow())
+	{
+		for(uint32_t i = 0; i < simflashwords[region]; i++)
+		{
+			if((simFlashRandom() & 1U) != 0U)
+			{
+				simflash[region][i] = SIM_FLASH_ERASED;
+			}
+		}
+		simFlashCut();
+	}
+	for(uint32_t i = 0; i < simflashwords[region]; i++)
+	{
+		simflash[region][i] = SIM_FLASH_ERASED;
+	}
+	return true;
+}
+/*****************************************************************************
+ * @brief Programs words of the model, bits can only be cleared.
+ *
+ * @details Asking for a one where the word holds a zero counts as a
+ *          violation, the bit would stay zero on the chip. At a power cut
+ *          the word being programmed gets only some of its zero bits. An
+ *          armed error stops the program at its word, as a flash error
+ *          flag would, and returns false.
+ *****************************************************************************/
+bool FlashRegion_Program(FlashRegion_e region, uint32_t offset, const uint32_t *words, uint32_t count)
+{
+	simFlashFormat();
+	if(((offset & 3U) != 0U) || ((offset + (count * 4U)) > (simflashwords[region] * 4U)))
+	{
+		return false;
+	}
+	for(uint32_t i = 0; i < count; i++)
+	{
+		uint32_t *word = &simflash[region][(offset / 4U) + i];
+
+		if((simflasherror != 0U) && (--simflasherror == 0U))
+		{
+			simflashstats.errors++;
+			return false;
+		}
+		simflashstats.programs++;
+		if((*word & words[i]) != words[i])
+		{
+			simflashstats.violations++;
+		}
+		if(simFlashCutNow())
+		{
+			*word &= words[i] | simFlashRandom();
+			simFlashCut();
+		}
+		*word &= words[i];
+	}
+	return true;
+}
+/*************************************END*************************************/
@@ -0,0 +1,598 @@
+/**
+ * \file           sim_hal.c
+ * \brief          Host simulation HAL subset and virtual clock source file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "sim.h"
+#include "eventqueue.h"
+#include "timebase.h"
+
+/*****************************************************************************/
+/* Private Types                                                             */
+/*****************************************************************************/
+
+/**
+ * @brief One scripted button edge.
+ */
+typedef struct
+{
+	uint64_t at;            /**< Virtual time of the edge */
+	uint16_t pin;           /**< GPIOA pin mask */
+	bool level;             /**< Pin level after the edge, false = pressed */
+}SimInputEdge_t;
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+GPIO_TypeDef simGpioA; /** Buttons PA0/PA1 **/
+GPIO_TypeDef simGpioB; /** TM1637 PB12/PB13, buzzer PB9 **/
+GPIO_TypeDef simGpioC; /** LED PC13 **/
+
+uint32_t SystemCoreClock = 72000000U; /** Same value as the board, used for reports only **/
+
+TIM_HandleTypeDef htim3; /** Timer handler used for counting seconds **/
+
+static uint64_t simnow = 0; /** Virtual time in microseconds **/
+
+static uint64_t simdeadline[SimTimer_Count]; /** Absolute deadline of each armed source **/
+
+static SimHandler_t simhandler[SimTimer_Count]; /** Handler of each armed source, NULL = disarmed **/
+
+static uint64_t simhorizon = UINT64_MAX; /** __WFI() never moves the clock past this time **/
+
+static SimHandler_t simidlehook = NULL; /** Called by Power_Idle() before the core sleeps **/
+
+static uint32_t simprimask = 0; /** Emulated PRIMASK, bookkeeping only **/
+
+static bool simtim3running = false; /** TIM3 counter enabled **/
+
+static uint64_t simtim3remaining = SIM_TIM3_PERIOD_US; /** Time to the next update when TIM3 was stopped **/
+
+static SimInputEdge_t siminput[SIM_INPUT_MAX_EDGES]; /** Scripted edges sorted by time **/
+
+static uint8_t siminputcount = 0; /** Number of scripted edges **/
+
+static uint8_t siminputnext = 0; /** Next edge to apply **/
+
+static SimStats_t simstats; /** Counters of the simulated peripherals **/
+
+/*****************************************************************************/
+/* Virtual Clock                                                             */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Resets the virtual clock, all pins, timers and counters.
+ *
+ * @details Buttons are released (pull-ups), the buzzer is off and both
+ *          TM1637 lines are high, as after MX_GPIO_Init().
+ *
+ * @param None
+ *
+ * @return None
+ *****************************************************************************/
+void Sim_Reset(void)
+{
+	simnow = 0;
+	simhorizon = UINT64_MAX;
+	simidlehook = NULL;
+	memset(simdeadline, 0, sizeof(simdeadline));
+	memset(simhandler, 0, sizeof(simhandler));
+	memset(&simstats, 0, sizeof(simstats));
+	simprimask = 0;
+	simtim3running = false;
+	simtim3remaining = SIM_TIM3_PERIOD_US;
+	siminputcount = 0;
+	siminputnext = 0;
+
+	simGpioA.IDR = GPIO_PIN_0 | GPIO_PIN_1;
+	simGpioA.ODR = 0;
+	simGpioB.ODR = GPIO_PIN_9 | GPIO_PIN_12 | GPIO_PIN_13;
+	simGpioB.IDR = simGpioB.ODR;
+	simGpioC.ODR = 0;
+	simGpioC.IDR = 0;
+}
+/*****************************************************************************
+ * @brief Returns the virtual time.
+ *
+ * @param None
+ *
+ * @return uint64_t Microseconds since Sim_Reset().
+ *****************************************************************************/
+uint64_t Sim_Now(void)
+{
+	return simnow;
+}
+/*****************************************************************************
+ * @brief Arms a source.
+ *
+ * @param[in] timer     Source to arm.
+ * @param[in] deadline  Absolute virtual time in microseconds.
+ * @param[in] handler   Called from Sim_AdvanceToNextEvent() at the deadline.
+ *
+ * @return None
+ *****************************************************************************/
+void Sim_TimerArm(SimTimer_e timer, uint64_t deadline, SimHandler_t handler)
+{
+	simdeadline[timer] = (deadline < simnow) ? simnow : deadline;
+	simhandler[timer] = handler;
+}
+/*****************************************************************************
+ * @brief Disarms a source.
+ *
+ * @param[in] timer  Source to disarm.
+ *
+ * @return None
+ *****************************************************************************/
+void Sim_TimerDisarm(SimTimer_e timer)
+{
+	simhandler[timer] = NULL;
+}
+/*****************************************************************************
+ * @brief Returns true if a source is armed.
+ *
+ * @param[in] timer  Source to check.
+ *
+ * @return bool
+ *****************************************************************************/
+bool Sim_TimerIsArmed(SimTimer_e timer)
+{
+	return (simhandler[timer] != NULL);
+}
+/*****************************************************************************
+ * @brief Jumps to the earliest armed deadline and runs its handler.
+ *
+ * @details The source is disarmed before its handler runs, periodic sources
+ *          re-arm themselves. Ties go to the lower source number, which is
+ *          the NVIC order of the real interrupts as well.
+ *
+ * @param[in] limit  Do not move the clock past this time.
+ *
+ * @return bool
+ *
+ * @retval true   A handler ran.
+ * @retval false  Nothing armed up to limit, the clock now equals limit.
+ *****************************************************************************/
+bool Sim_AdvanceToNextEvent(uint64_t limit)
+{
+	int next = -1;
+
+	for(int t = 0; t < SimTimer_Count; t++)
+	{
+		if((simhandler[t] != NULL) && ((next < 0) || (simdeadline[t] < simdeadline[next])))
+		{
+			next = t;
+		}
+	}
+
+	if((next < 0) || (simdeadline[next] > limit))
+	{
+		if(limit > simnow)
+		{
+			simnow = limit;
+		}
+		return false;
+	}
+
+	SimHandler_t handler = simhandler[next];
+	simhandler[next] = NULL;
+	if(simdeadline[next] > simnow)
+	{
+		simnow = simdeadline[next];
+	}
+	handler();
+	return true;
+}
+/*****************************************************************************
+ * @brief Moves the clock forward, running every handler on the way.
+ *
+ * @param[in] microseconds  Duration.
+ *
+ * @return None
+ *****************************************************************************/
+void Sim_Advance(uint64_t microseconds)
+{
+	uint64_t limit = simnow + microseconds;
+
+	while(Sim_AdvanceToNextEvent(limit))
+	{
+	}
+}
+/*****************************************************************************
+ * @brief Sets the time __WFI() wakes up at when nothing else is armed.
+ *
+ * @param[in] horizon  Absolute virtual time, normally the end of the run.
+ *
+ * @return None
+ *****************************************************************************/
+void Sim_SetHorizon(uint64_t horizon)
+{
+	simhorizon = horizon;
+}
+/*****************************************************************************
+ * @brief Sets the function called every time the firmware goes idle.
+ *
+ * @details At that point a scheduler pass is complete, so this is where the
+ *          simulation compares the pins with the firmware state.
+ *
+ * @param[in] hook  Function to call, NULL for none.
+ *
+ * @return None
+ *****************************************************************************/
+void Sim_SetIdleHook(SimHandler_t hook)
+{
+	simidlehook = hook;
+}
+/*****************************************************************************
+ * @brief Runs the idle hook, called by Power_Idle().
+ *
+ * @param None
+ *
+ * @return None
+ *****************************************************************************/
+void Sim_RunIdleHook(void)
+{
+	if(simidlehook != NULL)
+	{
+		simidlehook();
+	}
+}
+/*****************************************************************************
+ * @brief Returns the counters of the simulated peripherals.
+ *
+ * @param None
+ *
+ * @return SimStats_t* Live counters.
+ *****************************************************************************/
+SimStats_t *Sim_GetStats(void)
+{
+	return &simstats;
+}
+
+/*****************************************************************************/
+/* Button Inputs                                                             */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Applies the next scripted edge, the EXTI0/1 interrupt.
+ *
+ * @param None
+ *
+ * @return None
+ *****************************************************************************/
+static void simInputEdge(void)
+{
+	const SimInputEdge_t *edge = &siminput[siminputnext++];
+
+	if(edge->level)
+	{
+		simGpioA.IDR |= edge->pin;
+	}
+	else
+	{
+		simGpioA.IDR &= ~(uint32_t)edge->pin;
+	}
+
+	if(siminputnext < siminputcount)
+	{
+		Sim_TimerArm(SimTimer_Input, siminput[siminputnext].at, simInputEdge);
+	}
+	HAL_GPIO_EXTI_Callback(edge->pin);
+}
+/*****************************************************************************
+ * @brief Inserts one edge into the sorted script.
+ *
+ * @param[in] at     Virtual time.
+ * @param[in] pin    GPIOA pin mask.
+ * @param[in] level  Level after the edge.
+ *
+ * @return None
+ *****************************************************************************/
+static void simInputAdd(uint64_t at, uint16_t pin, bool level)
+{
+	if(siminputcount >= SIM_INPUT_MAX_EDGES)
+	{
+		/* Compact: drop the edges already applied */
+		memmove(siminput, &siminput[siminputnext], (siminputcount - siminputnext) * sizeof(siminput[0]));
+		siminputcount -= siminputnext;
+		siminputnext = 0;
+		if(siminputcount >= SIM_INPUT_MAX_EDGES)
+		{
+			Error_Handler();
+		}
+	}
+
+	uint8_t i = siminputcount;
+	while((i > siminputnext) && (siminput[i - 1U].at > at))
+	{
+		siminput[i] = siminput[i - 1U];
+		i--;
+	}
+	siminput[i].at = at;
+	siminput[i].pin = pin;
+	siminput[i].level = level;
+	siminputcount++;
+
+	Sim_TimerArm(SimTimer_Input, siminput[siminputnext].at, simInputEdge);
+}
+/*****************************************************************************
+ * @brief Schedules a button press with contact bounce.
+ *
+ * @param[in] pin       GPIO_PIN_0 (control) or GPIO_PIN_1 (function).
+ * @param[in] at        Virtual time of the first press edge.
+ * @param[in] holdms    Time the button is held in milliseconds.
+ * @param[in] bounces   Extra edge pairs at press and release, 1 ms apart.
+ *
+ * @return None
+ *****************************************************************************/
+void Sim_InputPress(uint16_t pin, uint64_t at, uint32_t holdms, uint8_t bounces)
+{
+	uint64_t release = at + ((uint64_t)holdms * 1000U);
+
+	for(uint8_t b = 0; b <= bounces; b++)
+	{
+		simInputAdd(at + (b * 2000U), pin, false);
+		if(b < bounces)
+		{
+			simInputAdd(at + (b * 2000U) + 1000U, pin, true);
+		}
+	}
+	for(uint8_t b = 0; b <= bounces; b++)
+	{
+		simInputAdd(release + (b * 2000U), pin, true);
+		if(b < bounces)
+		{
+			simInputAdd(release + (b * 2000U) + 1000U, pin, false);
+		}
+	}
+}
+
+/*****************************************************************************/
+/* GPIO                                                                      */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Applies a BSRR word and feeds the pin probes.
+ *
+ * @param[in] GPIOx  Port.
+ * @param[in] value  Low half sets pins, high half resets them.
+ *
+ * @return None
+ *****************************************************************************/
+void Sim_GpioWriteBsrr(GPIO_TypeDef *GPIOx, uint32_t value)
+{
+	uint32_t pins = (value | (value >> 16U)) & 0xFFFFU;
+
+	GPIOx->ODR = (GPIOx->ODR & ~(value >> 16U)) | (value & 0xFFFFU);
+	GPIOx->IDR = (GPIOx == GPIOA) ? GPIOx->IDR : GPIOx->ODR;
+
+	if(GPIOx == GPIOB)
+	{
+		if(pins & (GPIO_PIN_12 | GPIO_PIN_13))
+		{
+			Sim_Tm1637Sample((GPIOB->ODR & GPIO_PIN_12) != 0U, (GPIOB->ODR & GPIO_PIN_13) != 0U);
+		}
+		if(pins & GPIO_PIN_9)
+		{
+			Sim_BuzzerSample((GPIOB->ODR & GPIO_PIN_9) != 0U);
+		}
+	}
+}
+/*****************************************************************************
+ * @brief Writes an output pin and feeds the pin probes.
+ *
+ * @param[in] GPIOx     Port.
+ * @param[in] GPIO_Pin  Pin mask.
+ * @param[in] PinState  Level.
+ *
+ * @return None
+ *****************************************************************************/
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+	Sim_GpioWriteBsrr(GPIOx, (PinState != GPIO_PIN_RESET) ? GPIO_Pin : ((uint32_t)GPIO_Pin << 16U));
+}
+/*****************************************************************************
+ * @brief Reads an input pin.
+ *
+ * @param[in] GPIOx     Port.
+ * @param[in] GPIO_Pin  Pin mask.
+ *
+ * @return GPIO_PinState
+ *****************************************************************************/
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+	return ((GPIOx->IDR & GPIO_Pin) != 0U) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+/*****************************************************************************
+ * @brief Toggles an output pin.
+ *
+ * @param[in] GPIOx     Port.
+ * @param[in] GPIO_Pin  Pin mask.
+ *
+ * @return None
+ *****************************************************************************/
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+	HAL_GPIO_WritePin(GPIOx, GPIO_Pin, ((GPIOx->ODR & GPIO_Pin) != 0U) ? GPIO_PIN_RESET : GPIO_PIN_SET);
+}
+
+/*****************************************************************************/
+/* SysTick and Delays                                                        */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Blocking delay, interrupts keep firing while it runs.
+ *
+ * @param[in] Delay  Milliseconds.
+ *
+ * @return None
+ *****************************************************************************/
+void HAL_Delay(uint32_t Delay)
+{
+	Sim_Advance((uint64_t)Delay * 1000U);
+}
+/*****************************************************************************
+ * @brief Returns the SysTick millisecond count.
+ *
+ * @param None
+ *
+ * @return uint32_t Milliseconds since Sim_Reset().
+ *****************************************************************************/
+uint32_t HAL_GetTick(void)
+{
+	return (uint32_t)(simnow / 1000U);
+}
+
+/*****************************************************************************/
+/* TIM3                                                                      */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief TIM3 update interrupt, same work as TIM3_IRQHandler().
+ *
+ * @param None
+ *
+ * @return None
+ *****************************************************************************/
+static void simTim3Update(void)
+{
+	simstats.tim3Ticks++;
+	Sim_TimerArm(SimTimer_Tim3, simnow + SIM_TIM3_PERIOD_US, simTim3Update);
+
+	timeBase_SecondTickFromISR();
+	(void)eventQueue_Post(AppEvent_SecondTick);
+}
+/*****************************************************************************
+ * @brief Starts TIM3, the counter continues from where it was stopped.
+ *
+ * @param[in] htim  Unused.
+ *
+ * @return HAL_StatusTypeDef HAL_OK
+ *****************************************************************************/
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim)
+{
+	(void)htim;
+	if(simtim3running == false)
+	{
+		simtim3running = true;
+		Sim_TimerArm(SimTimer_Tim3, simnow + simtim3remaining, simTim3Update);
+	}
+	return HAL_OK;
+}
+/*****************************************************************************
+ * @brief Stops TIM3 and keeps the counter value.
+ *
+ * @param[in] htim  Unused.
+ *
+ * @return HAL_StatusTypeDef HAL_OK
+ *****************************************************************************/
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef *htim)
+{
+	(void)htim;
+	if(simtim3running)
+	{
+		simtim3running = false;
+		simtim3remaining = simdeadline[SimTimer_Tim3] - simnow;
+		Sim_TimerDisarm(SimTimer_Tim3);
+	}
+	return HAL_OK;
+}
+/*****************************************************************************
+ * @brief Reloads TIM3 (update generation), the next update is a full period away.
+ *
+ * @param None
+ *
+ * @return None
+ *****************************************************************************/
+void Sim_Tim3PhaseReset(void)
+{
+	simtim3remaining = SIM_TIM3_PERIOD_US;
+	if(simtim3running)
+	{
+		Sim_TimerArm(SimTimer_Tim3, simnow + SIM_TIM3_PERIOD_US, simTim3Update);
+	}
+}
+/*****************************************************************************
+ * @brief Returns true if the TIM3 timebase is counting.
+ *
+ * @param None
+ *
+ * @return bool
+ *****************************************************************************/
+bool Sim_Tim3IsRunning(void)
+{
+	return simtim3running;
+}
+
+/*****************************************************************************/
+/* CMSIS Intrinsics                                                          */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Host stand-in for DWT->CYCCNT.
+ *
+ * @details Advances by one microsecond worth of cycles on every read so
+ *          busy-waits such as delay_Us() terminate. It does not move the virtual clock, code
+ *          between two interrupts takes no virtual time.
+ *****************************************************************************/
+uint32_t Sim_CycleCounter(void)
+{
+	static uint32_t cycles = 0;
+
+	cycles += SystemCoreClock / 1000000U;
+	return cycles;
+}
+/*****************************************************************************
+ * @brief Returns the emulated PRIMASK.
+ *****************************************************************************/
+uint32_t __get_PRIMASK(void)
+{
+	return simprimask;
+}
+/*****************************************************************************
+ * @brief Restores the emulated PRIMASK.
+ *
+ * @note Handlers only run from Sim_AdvanceToNextEvent(), so masking needs
+ *       no further emulation.
+ *****************************************************************************/
+void __set_PRIMASK(uint32_t priMask)
+{
+	simprimask = priMask;
+}
+/*****************************************************************************
+ * @brief Sets the emulated PRIMASK.
+ *****************************************************************************/
+void __disable_irq(void)
+{
+	simprimask = 1U;
+}
+/*****************************************************************************
+ * @brief Waits for the next interrupt, at most until the horizon.
+ *****************************************************************************/
+void __WFI(void)
+{
+	(void)Sim_AdvanceToNextEvent(simhorizon);
+}
+/*************************************END*************************************/
@@ -0,0 +1,896 @@
+/**
+ * \file           sim_main.c
+ * \brief          Host simulation entry point and Pomodoro day scenario
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "sim.h"
+#include "hwtimer.h"
+#include "buzzer.h"
+#include "timebase.h"
+#include "sessionlog.h"
+#include "profilestore.h"
+
+/*****************************************************************************/
+/* External Variables                                                        */
+/*****************************************************************************/
+extern uint32_t glbLastSecondsCount;
+extern bool glbLastDotState;
+extern bool glbBlinkOff;
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static const char *const simmodename[] = { "pomodoro", "short break", "long break" }; /** Indexed by PomodoroFunctions_e **/
+
+static const uint32_t simmodetime[] = { POMODOROMODE_TIME, SHORTBREAK_TIME, LONGBREAK_TIME }; /** Indexed by PomodoroFunctions_e **/
+
+/**
+ * @brief State of the day being simulated, used by the idle hook.
+ */
+typedef struct
+{
+	uint32_t day;                 /**< Day number, for the messages */
+	PomodoroFunctions_e mode;     /**< Mode seen at the last idle */
+	uint8_t cycles;               /**< Reference model cycle count */
+	uint32_t modeStart;           /**< TIM3 updates when mode started */
+	uint32_t mismatches;          /**< Display mismatches reported */
+	bool colonKnown;              /**< glbLastDotState tracks the colon */
+	uint32_t *sessions;           /**< Completed sessions per mode */
+	bool running;                 /**< Timer counting at the last idle */
+	bool paused;                  /**< Timer paused at the last idle */
+	uint64_t lastIdle;            /**< Virtual time of the last idle */
+	uint64_t runUs;               /**< Time counted in the current mode */
+	uint64_t phaseErrorUs;        /**< Sum of |counted time - mode length| */
+	uint64_t pausedUs;            /**< Time spent paused */
+	uint32_t pausesLeft;          /**< Pauses still to make */
+	uint64_t nextPress;           /**< Earliest time of the next pause/resume press */
+	uint64_t pauseEnd;            /**< No new pause after this time */
+	uint32_t random;              /**< xorshift32 state */
+}SimDay_t;
+
+static SimDay_t simday; /** Day being simulated **/
+
+static bool simverbose = false; /** Print every mode change **/
+
+static uint32_t simfailures = 0; /** Checks that failed **/
+
+/**
+ * @brief What the session engine hooks saw, for simRunEngine().
+ */
+typedef struct
+{
+	uint32_t timerCalls;          /**< Timer hook calls */
+	SessionTimer_e timer;         /**< Last timer action */
+	uint32_t modeEnds;            /**< Mode end hook calls */
+	PomodoroFunctions_e finished; /**< Last finished mode */
+	SessionEvent_e cause;         /**< Last mode end cause */
+	uint32_t elapsed;             /**< Last displayed value */
+	uint32_t ends;                /**< Session end hook calls */
+	SessionSummary_t summary;     /**< Last session summary */
+}SimEngine_t;
+
+static SimEngine_t simengine; /** Engine hook record **/
+
+/*****************************************************************************/
+/* Platform Hooks                                                            */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Reports a firmware error and ends the simulation.
+ *
+ * @param None
+ *
+ * @return None
+ *****************************************************************************/
+void Error_Handler(void)
+{
+	fprintf(stderr, "sim: Error_Handler() at %.6f s\n", (double)Sim_Now() / 1e6);
+	exit(2);
+}
+/*****************************************************************************
+ * @brief Clock tree setup, nothing to do on the host.
+ *
+ * @param None
+ *
+ * @return None
+ *****************************************************************************/
+void SystemClock_Config(void)
+{
+}
+
+/*****************************************************************************/
+/* Checks                                                                    */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Reports a failed check.
+ *
+ * @param[in] format  printf format of the message.
+ *
+ * @return None
+ *****************************************************************************/
+static void simFail(const char *format, ...)
+{
+	va_list args;
+
+	fprintf(stderr, "FAIL %10.3f s: ", (double)Sim_Now() / 1e6);
+	va_start(args, format);
+	vfprintf(stderr, format, args);
+	va_end(args);
+	fputc('\n', stderr);
+	simfailures++;
+}
+/*****************************************************************************
+ * @brief Compares the decoded display with the firmware state.
+ *
+ * @details The display must show glbLastSecondsCount as MM:SS. Once
+ *          updateDisplay() has drawn a second, the colon follows
+ *          glbLastDotState (inverted); userBootDisplay() draws it dark. The
+ *          display is on unless the pause blink switched it off.
+ *
+ * @param None
+ *
+ * @return bool
+ *
+ * @retval true   Display matches.
+ * @retval false  Mismatch, already reported.
+ *****************************************************************************/
+static bool simCheckDisplay(void)
+{
+	char shown[8];
+	char expected[8];
+	uint32_t seconds = (uint32_t)glbLastSecondsCount;
+
+	bool colon = Sim_Tm1637Text(shown);
+	snprintf(expected, sizeof(expected), "%02lu:%02lu",
+			(unsigned long)((seconds / 60U) % 100U), (unsigned long)(seconds % 60U));
+
+	if((Sim_Tm1637IsValid() == false) || (strcmp(shown, expected) != 0) ||
+			(simday.colonKnown && (colon == glbLastDotState)))
+	{
+		simFail("display \"%s\" colon %d, expected \"%s\" colon %d",
+				shown, colon, expected, !glbLastDotState);
+		return false;
+	}
+	if((Sim_Tm1637IsOn() == glbBlinkOff) || (glbBlinkOff && (session_IsPaused() == false)))
+	{
+		simFail("display %s, blink %s while %s", Sim_Tm1637IsOn() ? "on" : "off",
+				glbBlinkOff ? "off" : "on", session_IsPaused() ? "paused" : "not paused");
+		return false;
+	}
+	return true;
+}
+/*****************************************************************************
+ * @brief xorshift32 pseudo random number, the same sequence on every run.
+ *
+ * @param[in,out] state  Generator state, not zero.
+ *
+ * @return uint32_t Next number.
+ *****************************************************************************/
+static uint32_t simRandom(uint32_t *state)
+{
+	*state ^= *state << 13U;
+	*state ^= *state >> 17U;
+	*state ^= *state << 5U;
+	return *state;
+}
+/*****************************************************************************
+ * @brief Next mode after a completed session, reference model.
+ *
+ * @param[in]     mode    Completed mode.
+ * @param[in,out] cycles  Completed Pomodoros and short breaks.
+ *
+ * @return PomodoroFunctions_e
+ *****************************************************************************/
+static PomodoroFunctions_e simNextMode(PomodoroFunctions_e mode, uint8_t *cycles)
+{
+	switch(mode)
+	{
+		case PomodoroFunctions_PomodoroMode:
+			(*cycles)++;
+			return PomodoroFunctions_ShortBreak;
+		case PomodoroFunctions_ShortBreak:
+			(*cycles)++;
+			if(*cycles >= NO_OF_CYCLES)
+			{
+				*cycles = 0;
+				return PomodoroFunctions_LongBreak;
+			}
+			return PomodoroFunctions_PomodoroMode;
+		default:
+			return PomodoroFunctions_PomodoroMode;
+	}
+}
+
+/*****************************************************************************/
+/* Session Engine                                                            */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Engine timer hook, records the action.
+ *****************************************************************************/
+static void simEngineTimer(SessionTimer_e action)
+{
+	simengine.timerCalls++;
+	simengine.timer = action;
+}
+/*****************************************************************************
+ * @brief Engine mode end hook, records the mode and cause.
+ *****************************************************************************/
+static void simEngineModeEnd(PomodoroFunctions_e finished, SessionEvent_e cause)
+{
+	simengine.modeEnds++;
+	simengine.finished = finished;
+	simengine.cause = cause;
+}
+/*****************************************************************************
+ * @brief Engine display hook, records the value.
+ *****************************************************************************/
+static void simEngineDisplay(uint32_t elapsed)
+{
+	simengine.elapsed = elapsed;
+}
+
+/*****************************************************************************
+ * @brief Engine session end hook, records the summary.
+ *****************************************************************************/
+static void simEngineEnded(const SessionSummary_t *summary)
+{
+	simengine.ends++;
+	simengine.summary = *summary;
+}
+
+static const SessionHooks_t simenginehooks = { simEngineTimer, simEngineModeEnd, simEngineDisplay, simEngineEnded }; /** Recording hooks **/
+
+/*****************************************************************************
+ * @brief Drives the session engine alone with random events.
+ *
+ * @details No HAL involved: start/pause/resume, restart/stop, skip and end
+ *          of time events (the time through session_Update(), overshooting
+ *          by 0..3 s) are fed in a pseudo random order and every step is
+ *          checked against simNextMode() and the hook calls it must make,
+ *          the session summaries included.
+ *
+ * @param[in] count  Number of events.
+ *
+ * @return None
+ *****************************************************************************/
+static void simRunEngine(uint32_t count)
+{
+	struct timespec start;
+	struct timespec stop;
+	uint32_t random = 0x2545F491U;
+	uint32_t transitions = 0;
+	uint32_t failures = 0;
+	PomodoroFunctions_e mode = PomodoroFunctions_PomodoroMode;
+	uint8_t cycles = 0;
+	uint8_t pauses = 0;
+	SessionRun_e run = SessionRun_Stopped;
+
+	memset(&simengine, 0, sizeof(simengine));
+	session_Init(&simenginehooks);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for(uint32_t step = 0; step < count; step++)
+	{
+		uint32_t modeends = simengine.modeEnds;
+		uint32_t timercalls = simengine.timerCalls;
+		uint32_t ends = simengine.ends;
+		uint32_t value = simRandom(&random);
+		SessionTimer_e zero = (run == SessionRun_Running) ? SessionTimer_Restart : SessionTimer_Zero;
+		SessionEnd_e end = SessionEnd_Count;
+		PomodoroFunctions_e endmode = mode;
+		bool ok = true;
+
+		switch(value & 15U)
+		{
+			case 0:
+				session_Dispatch(SessionEvent_StartPause);
+				if(run == SessionRun_Stopped)
+				{
+					run = SessionRun_Running;
+					mode = PomodoroFunctions_PomodoroMode;
+					cycles = 0;
+					ok = (simengine.timer == SessionTimer_Start);
+				}
+				else if(run == SessionRun_Running)
+				{
+					run = SessionRun_Paused;
+					pauses += (pauses < UINT8_MAX) ? 1U : 0U;
+					ok = (simengine.timer == SessionTimer_Pause);
+				}
+				else
+				{
+					run = SessionRun_Running;
+					ok = (simengine.timer == SessionTimer_Resume);
+				}
+				ok = ok && (simengine.timerCalls == (timercalls + 1U)) && (simengine.modeEnds == modeends);
+				break;
+			case 1:
+				session_Dispatch(SessionEvent_Restart);
+				end = (run == SessionRun_Paused) ? SessionEnd_Stop :
+						(run == SessionRun_Running) ? SessionEnd_Restart : SessionEnd_Count;
+				if(run == SessionRun_Paused)
+				{
+					run = SessionRun_Stopped;
+					mode = PomodoroFunctions_PomodoroMode;
+					cycles = 0;
+					ok = (simengine.timer == SessionTimer_Stop) && (session_GetElapsed() == 0U);
+				}
+				else
+				{
+					ok = (simengine.timer == zero) && (session_GetElapsed() == 0U);
+				}
+				ok = ok && (simengine.timerCalls == (timercalls + 1U)) && (simengine.modeEnds == modeends);
+				break;
+			case 2:
+			case 3:
+				session_Dispatch(SessionEvent_Skip);
+				end = (run != SessionRun_Stopped) ? SessionEnd_Skip : SessionEnd_Count;
+				ok = (simengine.finished == mode) && (simengine.cause == SessionEvent_Skip) &&
+						(simengine.modeEnds == (modeends + 1U)) && (simengine.timer == zero);
+				mode = simNextMode(mode, &cycles);
+				transitions++;
+				break;
+			default:
+			{
+				uint32_t over = (value >> 8U) & 3U;
+				uint32_t consumed = session_Update(simmodetime[mode] + over);
+				end = (run != SessionRun_Stopped) ? SessionEnd_TimeUp : SessionEnd_Count;
+				ok = (consumed == simmodetime[mode]) && (simengine.finished == mode) &&
+						(simengine.cause == SessionEvent_TimeUp) && (simengine.modeEnds == (modeends + 1U)) &&
+						(session_GetElapsed() == over) && (simengine.elapsed == over);
+				mode = simNextMode(mode, &cycles);
+				transitions++;
+				break;
+			}
+		}
+
+		if(end == SessionEnd_Count)
+		{
+			ok = ok && (simengine.ends == ends);
+		}
+		else
+		{
+			ok = ok && (simengine.ends == (ends + 1U)) && (simengine.summary.reason == end) &&
+					(simengine.summary.mode == endmode) && (simengine.summary.pauses == pauses) &&
+					(simengine.summary.planned == simmodetime[endmode]) &&
+					((end != SessionEnd_TimeUp) || (simengine.summary.actual == simmodetime[endmode]));
+			pauses = 0;
+		}
+
+		if((ok == false) || (session_GetMode() != mode) || (session_GetCycles() != cycles) ||
+				(session_GetRun() != run) || (session_GetDuration() != simmodetime[mode]))
+		{
+			if(failures++ < 10U)
+			{
+				simFail("engine step %lu: %s cycles %u, expected %s cycles %u", (unsigned long)step,
+						simmodename[session_GetMode()], session_GetCycles(), simmodename[mode], cycles);
+			}
+			else
+			{
+				simfailures++;
+			}
+			session_Init(&simenginehooks);
+			mode = PomodoroFunctions_PomodoroMode;
+			cycles = 0;
+			pauses = 0;
+			run = SessionRun_Stopped;
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &stop);
+	double wall = (double)(stop.tv_sec - start.tv_sec) + ((double)(stop.tv_nsec - start.tv_nsec) / 1e9);
+
+	printf("engine      %lu events, %lu transitions, %.1f M transitions/s\n", (unsigned long)count,
+			(unsigned long)transitions, (wall > 0.0) ? ((double)transitions / wall) / 1e6 : 0.0);
+}
+
+/*****************************************************************************/
+/* Scenario                                                                  */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Presses the control button to pause or resume at a random phase.
+ *
+ * @details Pauses are spread over the day with random running and paused
+ *          times, the press itself lands anywhere inside a TIM3 second.
+ *          The last pause ends well before the end of the day.
+ *
+ * @param None
+ *
+ * @return None
+ *****************************************************************************/
+static void simPauseStep(void)
+{
+	uint64_t now = Sim_Now();
+	bool running = session_IsRunning();
+
+	if((now < simday.nextPress) || ((running == false) && (session_IsPaused() == false)))
+	{
+		return;
+	}
+	if(running && ((simday.pausesLeft == 0U) || (now >= simday.pauseEnd)))
+	{
+		return;
+	}
+
+	uint64_t at = now + (simRandom(&simday.random) % 1000000U); /** Any phase of the second **/
+	uint64_t left = (simday.pauseEnd > now) ? (simday.pauseEnd - now) : 0U;
+	uint64_t spread = (left / (simday.pausesLeft + 1U)) / 1000000U;
+	uint64_t mean = running ? 10U : ((spread > 13U) ? (spread - 13U) : 0U); /** Paused 10 s, running spread over the day **/
+	uint64_t next = 1000000ULL + ((simRandom(&simday.random) % ((2U * mean) + 1U)) * 1000000ULL) +
+			(simRandom(&simday.random) % 1000000U);
+
+	Sim_InputPress(GPIO_PIN_0, at, 150U, 3U);
+	simday.nextPress = at + next;
+	if(running)
+	{
+		simday.pausesLeft--;
+	}
+}
+/*****************************************************************************
+ * @brief Checks the firmware at the end of every scheduler pass.
+ *
+ * @details Runs from Power_Idle(), i.e. after the pass has drawn the display
+ *          and before the core sleeps. Checks the decoded display and the
+ *          length and order of every completed session, in TIM3 updates and
+ *          in time counted: the time the timer was running in the mode must
+ *          be the mode length to the microsecond, however often it was
+ *          paused.
+ *
+ * @param None
+ *
+ * @return None
+ *****************************************************************************/
+static void simIdleCheck(void)
+{
+	uint64_t now = Sim_Now();
+	PomodoroFunctions_e current = session_GetMode();
+
+	if(simday.running)
+	{
+		simday.runUs += now - simday.lastIdle;
+	}
+	if(simday.paused)
+	{
+		simday.pausedUs += now - simday.lastIdle;
+	}
+	simday.lastIdle = now;
+	simday.running = session_IsRunning();
+	simday.paused = session_IsPaused();
+
+	if(glbLastSecondsCount != 0U)
+	{
+		simday.colonKnown = true;
+	}
+
+	if((simday.mismatches < 10U) && (simCheckDisplay() == false))
+	{
+		simday.mismatches++;
+	}
+
+	if(session_GetRun() == SessionRun_Stopped)
+	{
+		/* Not started yet or stopped again: the next start is a fresh first Pomodoro */
+		simday.mode = current;
+		simday.cycles = 0;
+		simday.modeStart = Sim_GetStats()->tim3Ticks;
+		simday.runUs = 0;
+	}
+	else if(current != simday.mode)
+	{
+		PomodoroFunctions_e mode = simday.mode;
+		uint32_t ticks = Sim_GetStats()->tim3Ticks - simday.modeStart;
+		uint64_t length = (uint64_t)simmodetime[mode] * SIM_TIM3_PERIOD_US;
+		uint64_t error = (simday.runUs > length) ? (simday.runUs - length) : (length - simday.runUs);
+		PomodoroFunctions_e expected = simNextMode(mode, &simday.cycles);
+
+		if(ticks != simmodetime[mode])
+		{
+			simFail("day %lu: %s lasted %lu s, expected %lu s", (unsigned long)simday.day,
+					simmodename[mode], (unsigned long)ticks, (unsigned long)simmodetime[mode]);
+		}
+		if(error != 0U)
+		{
+			simFail("day %lu: %s counted %llu us, expected %llu us", (unsigned long)simday.day,
+					simmodename[mode], (unsigned long long)simday.runUs, (unsigned long long)length);
+		}
+		if(current != expected)
+		{
+			simFail("day %lu: %s followed by %s, expected %s", (unsigned long)simday.day,
+					simmodename[mode], simmodename[current], simmodename[expected]);
+		}
+		if(simverbose)
+		{
+			printf("day %lu %10.3f s: %-11s done after %4lu s -> %s\n", (unsigned long)simday.day,
+					(double)now / 1e6, simmodename[mode], (unsigned long)ticks,
+					simmodename[current]);
+		}
+		simday.phaseErrorUs += error;
+		simday.sessions[mode]++;
+		simday.mode = current;
+		simday.modeStart = Sim_GetStats()->tim3Ticks;
+		simday.runUs = 0;
+	}
+
+	simPauseStep();
+}
+/*****************************************************************************
+ * @brief Runs one Pomodoro day.
+ *
+ * @details Presses the control button (with bounce) after one second, lets
+ *          the timer run for the requested time with simIdleCheck() watching
+ *          every scheduler pass, then pauses and stops the timer again.
+ *          With pauses the timer is first started, paused and stopped once
+ *          so TIM3 is left in the middle of a second, and the real start
+ *          must still begin with a full one.
+ *
+ * @param[in]  day       Day number, for the messages.
+ * @param[in]  hours     Length of the day.
+ * @param[in]  pauses    Pauses to make during the day.
+ * @param[out] sessions  Completed sessions per mode, accumulated.
+ *
+ * @return None
+ *****************************************************************************/
+static void simRunDay(uint32_t day, uint32_t hours, uint32_t pauses, uint32_t sessions[3])
+{
+	uint64_t end = 1000000ULL + ((uint64_t)hours * 3600ULL * 1000000ULL);
+	uint64_t start = 1000000ULL;
+
+	memset(&simday, 0, sizeof(simday));
+	simday.day = day;
+	simday.mode = PomodoroFunctions_PomodoroMode;
+	simday.sessions = sessions;
+	simday.pausesLeft = pauses;
+	simday.random = 0x9E3779B9U ^ day;
+
+	Sim_Reset();
+	HwTimer_Init(); /** A reboot, the virtual clock starts at 0 again **/
+	Sim_SetHorizon(end);
+	userBootDisplay();
+	userInit();
+	Sim_SetIdleHook(simIdleCheck);
+	if(pauses != 0U)
+	{
+		Sim_InputPress(GPIO_PIN_0, start, 150U, 3U);           /** Start **/
+		Sim_InputPress(GPIO_PIN_0, start + 437000U, 150U, 3U); /** Pause in the middle of the first second **/
+		Sim_InputPress(GPIO_PIN_0, start + 1000000U, 2500U, 3U); /** Long press: stop **/
+		start += 5000000U;
+	}
+	Sim_InputPress(GPIO_PIN_0, start, 150U, 3U);
+	simday.nextPress = start + 60000000ULL;
+	simday.pauseEnd = end - 120000000ULL;
+
+	while(Sim_Now() < end)
+	{
+		userProcess();
+	}
+
+	if(session_IsRunning() == false)
+	{
+		simFail("day %lu: timer not running at the end of the day", (unsigned long)day);
+	}
+	if(simday.pausesLeft != 0U)
+	{
+		simFail("day %lu: %lu pauses not made", (unsigned long)day, (unsigned long)simday.pausesLeft);
+	}
+
+	/* Pause and stop the timer and let the alarm and button settle */
+	Sim_SetIdleHook(NULL);
+	end = Sim_Now() + 10000000ULL;
+	Sim_SetHorizon(end);
+	Sim_InputPress(GPIO_PIN_0, Sim_Now() + 100000ULL, 150U, 3U);
+	Sim_InputPress(GPIO_PIN_0, Sim_Now() + 1000000ULL, 2500U, 3U);
+	while(Sim_Now() < end)
+	{
+		userProcess();
+	}
+	if((session_GetRun() != SessionRun_Stopped) || Sim_Tim3IsRunning() || Buzzer_IsBusy() || HwTimer_IsActive())
+	{
+		simFail("day %lu: timer, alarm or one-shot still running after stop", (unsigned long)day);
+	}
+	(void)simCheckDisplay();
+}
+
+/*****************************************************************************
+ * @brief Presses the function button and runs the firmware until the press,
+ *        the cue and the button settled.
+ *
+ * @param[in] holdms  Time the button is held in milliseconds.
+ *
+ * @return uint32_t Beeps played meanwhile.
+ *****************************************************************************/
+static uint32_t simFunctionPress(uint32_t holdms)
+{
+	uint32_t beeps = Sim_GetStats()->beeps;
+	uint64_t end = Sim_Now() + 100000ULL + ((uint64_t)holdms * 1000U) + 5000000ULL;
+
+	Sim_SetHorizon(end);
+	Sim_InputPress(GPIO_PIN_1, Sim_Now() + 100000ULL, holdms, 3U);
+	while(Sim_Now() < end)
+	{
+		userProcess();
+	}
+	return Sim_GetStats()->beeps - beeps;
+}
+/*****************************************************************************
+ * @brief Checks the function button on a stopped timer.
+ *
+ * @details A long press must only select the next profile and play its
+ *          cue, one beep per profile number: the mode, the run state and
+ *          the mode change cue must not be touched. Three long presses go
+ *          round the default profiles back to the first one. A short press must skip
+ *          to the next mode and keep the profile.
+ *
+ * @param None
+ *
+ * @return None
+ *****************************************************************************/
+static void simRunFunctionButton(void)
+{
+	Sim_Reset();
+	HwTimer_Init(); /** A reboot, the virtual clock starts at 0 again **/
+	userBootDisplay();
+	userInit();
+
+	PomodoroFunctions_e mode = session_GetMode();
+	uint8_t count = profileStore_GetCount();
+
+	for(uint8_t press = 1; press <= count; press++)
+	{
+		uint8_t expected = (uint8_t)(press % count);
+		uint32_t beeps = simFunctionPress(2500U);
+		uint8_t selected = profileStore_GetSelected();
+
+		if(selected != expected)
+		{
+			simFail("function long press %u: profile %u, expected %u", (unsigned)press, (unsigned)selected,
+					(unsigned)expected);
+		}
+		if((session_GetMode() != mode) || (session_GetRun() != SessionRun_Stopped))
+		{
+			simFail("function long press %u: mode %s, run %d, expected %s stopped", (unsigned)press,
+					simmodename[session_GetMode()], (int)session_GetRun(), simmodename[mode]);
+		}
+		if(session_GetDuration() != profileStore_Get(selected)->profile.duration[mode])
+		{
+			simFail("function long press %u: %lu s, not the length of profile %u", (unsigned)press,
+					(unsigned long)session_GetDuration(), (unsigned)selected);
+		}
+		if(beeps != (uint32_t)selected + 1U)
+		{
+			simFail("function long press %u: %lu beeps, expected the %u beep profile cue", (unsigned)press,
+					(unsigned long)beeps, (unsigned)selected + 1U);
+		}
+	}
+
+	(void)simFunctionPress(150U);
+	if((session_GetMode() == mode) || (profileStore_GetSelected() != 0U) ||
+	   (session_GetRun() != SessionRun_Stopped))
+	{
+		simFail("function short press: mode %s, profile %u, run %d", simmodename[session_GetMode()],
+				(unsigned)profileStore_GetSelected(), (int)session_GetRun());
+	}
+	if(HwTimer_IsActive() || Buzzer_IsBusy())
+	{
+		simFail("function button: one-shot or buzzer still running");
+	}
+	printf("function    %u long presses through the profiles, short press skips\n", (unsigned)count);
+}
+
+/*****************************************************************************
+ * @brief Checks the session history the days left in flash.
+ *
+ * @details Every day starts with userInit(), i.e. a reboot that finds the
+ *          log again. All records must be valid and nothing may still be
+ *          staged after the idle time at the end of the day. The sessions
+ *          that ran their full length must match the mode changes counted
+ *          by simIdleCheck().
+ *
+ * @param[in] sessions  Completed sessions per mode.
+ *
+ * @return None
+ *****************************************************************************/
+static void simCheckHistory(const uint32_t sessions[3])
+{
+	uint32_t timeup[3] = { 0 };
+
+	for(uint32_t index = 0; index < sessionLog_GetCount(); index++)
+	{
+		SessionLogRecord_t record;
+
+		if(sessionLog_Read(index, &record) == false)
+		{
+			simFail("history record %lu invalid", (unsigned long)index);
+		}
+		else if(record.summary.reason == SessionEnd_TimeUp)
+		{
+			timeup[record.summary.mode]++;
+		}
+	}
+	for(uint32_t mode = 0; mode < 3U; mode++)
+	{
+		if(timeup[mode] != sessions[mode])
+		{
+			simFail("history has %lu full %s sessions, %lu ran", (unsigned long)timeup[mode], simmodename[mode],
+					(unsigned long)sessions[mode]);
+		}
+	}
+	if((sessionLog_GetStaged() != 0U) || (sessionLog_GetDropped() != 0U) || (Sim_FlashGetStats()->violations != 0U))
+	{
+		simFail("history %lu staged, %lu dropped, %lu flash violations", (unsigned long)sessionLog_GetStaged(),
+				(unsigned long)sessionLog_GetDropped(), (unsigned long)Sim_FlashGetStats()->violations);
+	}
+}
+
+/*****************************************************************************/
+/* Main Function                                                             */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Simulation entry point.
+ *
+ * @details Options: -d days (1), -H hours per day (4), -p pauses per day
+ *          (0), -t session engine events (1000000, 0 = none), -v print
+ *          every mode change.
+ *          Exits with 0 if every check passed.
+ *
+ * @param[in] argc  Argument count.
+ * @param[in] argv  Arguments.
+ *
+ * @return int Exit status.
+ *****************************************************************************/
+int main(int argc, char *argv[])
+{
+	uint32_t days = 1;
+	uint32_t hours = 4;
+	uint32_t engineevents = 1000000;
+	uint32_t pauses = 0;
+	uint64_t pausedus = 0;
+	uint64_t phaseerrorus = 0;
+	uint32_t sessions[3] = { 0 };
+	uint64_t simulated = 0;
+	uint32_t beeps = 0;
+	uint64_t beepus = 0;
+	uint32_t busbytes = 0;
+	uint32_t buserrors = 0;
+	uint32_t stops = 0;
+	uint32_t violations = 0;
+	uint32_t timerwakes = 0;
+	int option;
+
+	while((option = getopt(argc, argv, "d:H:p:t:v")) != -1)
+	{
+		switch(option)
+		{
+			case 'd':
+				days = (uint32_t)strtoul(optarg, NULL, 0);
+				break;
+			case 'H':
+				hours = (uint32_t)strtoul(optarg, NULL, 0);
+				break;
+			case 'p':
+				pauses = (uint32_t)strtoul(optarg, NULL, 0);
+				break;
+			case 't':
+				engineevents = (uint32_t)strtoul(optarg, NULL, 0);
+				break;
+			case 'v':
+				simverbose = true;
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-d days] [-H hours] [-p pauses] [-t events] [-v]\n", argv[0]);
+				return 2;
+		}
+	}
+
+	if(engineevents != 0U)
+	{
+		simRunEngine(engineevents);
+	}
+
+	struct timespec start;
+	struct timespec stop;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	Sim_Reset();
+	Sim_FlashReset();
+	timeBase_Init();
+	HwTimer_Init();
+	TM1637_Init();
+	Buzzer_Init();
+
+	for(uint32_t day = 1; day <= days; day++)
+	{
+		simRunDay(day, hours, pauses, sessions);
+		pausedus += simday.pausedUs;
+		phaseerrorus += simday.phaseErrorUs;
+
+		SimStats_t *stats = Sim_GetStats();
+		simulated += Sim_Now();
+		beeps += stats->beeps;
+		beepus += stats->beepOnUs;
+		busbytes += stats->busBytes;
+		buserrors += stats->busErrors;
+		stops += stats->stopEntries;
+		violations += stats->stopViolations;
+		timerwakes += stats->timerWakes;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &stop);
+	double wall = (double)(stop.tv_sec - start.tv_sec) + ((double)(stop.tv_nsec - start.tv_nsec) / 1e9);
+
+	if(buserrors != 0U)
+	{
+		simFail("%lu malformed TM1637 frames", (unsigned long)buserrors);
+	}
+	if(violations != 0U)
+	{
+		simFail("%lu STOP entries with TIM3/TIM4 counting", (unsigned long)violations);
+	}
+	if(TM1637_GetBusByteCount() != busbytes)
+	{
+		simFail("driver counted %lu TM1637 bytes, %lu on the bus", (unsigned long)TM1637_GetBusByteCount(),
+				(unsigned long)busbytes);
+	}
+	if(((uint64_t)busbytes * 4U) > ((uint64_t)TM1637_GetUpdateCount() * TM1637_FULL_FRAME_BYTES * 3U))
+	{
+		simFail("%lu TM1637 bytes for %lu updates, over 3/4 of full frames", (unsigned long)busbytes,
+				(unsigned long)TM1637_GetUpdateCount());
+	}
+	simCheckHistory(sessions);
+	simRunFunctionButton();
+
+	printf("simulated   %lu day(s) of %lu h, %.1f s virtual\n", (unsigned long)days, (unsigned long)hours, (double)simulated / 1e6);
+	printf("sessions    pomodoro %lu, short break %lu, long break %lu\n",
+			(unsigned long)sessions[PomodoroFunctions_PomodoroMode],
+			(unsigned long)sessions[PomodoroFunctions_ShortBreak],
+			(unsigned long)sessions[PomodoroFunctions_LongBreak]);
+	printf("buzzer      %lu beeps, %.1f s on\n", (unsigned long)beeps, (double)beepus / 1e6);
+	printf("display     %lu bytes on the TM1637 bus for %lu updates, %.2f per update of %u\n",
+			(unsigned long)busbytes, (unsigned long)TM1637_GetUpdateCount(),
+			(TM1637_GetUpdateCount() != 0U) ? (double)busbytes / (double)TM1637_GetUpdateCount() : 0.0,
+			(unsigned)TM1637_FULL_FRAME_BYTES);
+	if(pauses != 0U)
+	{
+		printf("pauses      %lu per day, %.1f s paused, phase error %llu us\n", (unsigned long)pauses,
+				(double)pausedus / 1e6, (unsigned long long)phaseerrorus);
+	}
+	printf("power       %lu STOP entries, %lu violations\n", (unsigned long)stops, (unsigned long)violations);
+	printf("timers      %lu TIM4 compare interrupts\n", (unsigned long)timerwakes);
+	printf("history     %lu records in flash, %lu words programmed\n", (unsigned long)sessionLog_GetCount(),
+			(unsigned long)Sim_FlashGetStats()->programs);
+	printf("wall time   %.3f s (%.0fx real time)\n", wall, (wall > 0.0) ? ((double)simulated / 1e6) / wall : 0.0);
+	printf("%s: %lu failed check(s)\n", (simfailures == 0U) ? "PASS" : "FAIL", (unsigned long)simfailures);
+
+	return (simfailures == 0U) ? 0 : 1;
+}
+/*************************************END*************************************/
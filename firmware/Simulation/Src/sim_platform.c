@@ -0,0 +1,266 @@
+/**
+ * \file           sim_platform.c
+ * \brief          Host simulation of the hwtimer and power platform modules
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "sim.h"
+#include "hwtimer.h"
+#include "power.h"
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static TimerWheel_t hwtimerwheel; /** All software timers, the firmware wheel **/
+
+static bool hwtimeradvancing = false; /** In TimerWheel_Advance(), the compare is set after it **/
+
+static uint32_t powerstopcount = 0; /** Number of STOP mode entries **/
+
+/*****************************************************************************/
+/* HW Timer Functions                                                        */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Wheel time, the TIM4 counter extended to 32 bits.
+ *
+ * @param None
+ *
+ * @return uint32_t Ticks since Sim_Reset().
+ *****************************************************************************/
+static uint32_t hwTimerTicks(void)
+{
+	return (uint32_t)(Sim_Now() / SIM_HWTIMER_TICK_US);
+}
+/*****************************************************************************
+ * @brief Arms the single TIM4 compare for the next wheel event.
+ *
+ * @details Limited to HWTIMER_MAX_COMPARE_TICKS ahead like on the board.
+ *
+ * @param None
+ *
+ * @return None
+ *****************************************************************************/
+static void hwTimerProgram(void)
+{
+	uint32_t at;
+
+	if(TimerWheel_NextEvent(&hwtimerwheel, &at) == false)
+	{
+		Sim_TimerDisarm(SimTimer_HwTimer);
+		return;
+	}
+	uint32_t ahead = at - hwTimerTicks();
+	if((int32_t)ahead <= 0)
+	{
+		ahead = 0U;
+	}
+	else if(ahead > HWTIMER_MAX_COMPARE_TICKS)
+	{
+		ahead = HWTIMER_MAX_COMPARE_TICKS;
+	}
+	Sim_TimerArm(SimTimer_HwTimer, ((Sim_Now() / SIM_HWTIMER_TICK_US) + ahead) * SIM_HWTIMER_TICK_US, HwTimer_IRQHandler);
+}
+/*****************************************************************************
+ * @brief Resets the wheel, TIM4 itself needs no setup.
+ *
+ * @param None
+ *
+ * @return None
+ *****************************************************************************/
+void HwTimer_Init(void)
+{
+	hwtimeradvancing = false;
+	TimerWheel_Init(&hwtimerwheel, hwTimerTicks());
+	Sim_TimerDisarm(SimTimer_HwTimer);
+}
+/*****************************************************************************
+ * @brief Starts a one-shot timer.
+ *
+ * @param[in] timer         Timer.
+ * @param[in] milliseconds  Delay, clamped to HWTIMER_MAX_DELAY_MS.
+ * @param[in] callback      Called when the delay expired.
+ *
+ * @return None
+ *****************************************************************************/
+void HwTimer_Start(HwTimer_t *timer, uint32_t milliseconds, HwTimerCallback_t callback)
+{
+	if(milliseconds > HWTIMER_MAX_DELAY_MS)
+	{
+		milliseconds = HWTIMER_MAX_DELAY_MS;
+	}
+	TimerWheel_Start(&hwtimerwheel, timer, hwTimerTicks(), HWTIMER_MS_TO_TICKS(milliseconds), 0U, callback);
+	if(hwtimeradvancing == false)
+	{
+		hwTimerProgram();
+	}
+}
+/*****************************************************************************
+ * @brief Starts a periodic timer.
+ *
+ * @param[in] timer         Timer.
+ * @param[in] milliseconds  Period, clamped to 1 ... HWTIMER_MAX_DELAY_MS.
+ * @param[in] callback      Called on every expiry.
+ *
+ * @return None
+ *****************************************************************************/
+void HwTimer_StartPeriodic(HwTimer_t *timer, uint32_t milliseconds, HwTimerCallback_t callback)
+{
+	if(milliseconds > HWTIMER_MAX_DELAY_MS)
+	{
+		milliseconds = HWTIMER_MAX_DELAY_MS;
+	}
+	uint32_t ticks = HWTIMER_MS_TO_TICKS(milliseconds);
+	if(ticks == 0U)
+	{
+		ticks = 1U;
+	}
+	TimerWheel_Start(&hwtimerwheel, timer, hwTimerTicks(), ticks, ticks, callback);
+	if(hwtimeradvancing == false)
+	{
+		hwTimerProgram();
+	}
+}
+/*****************************************************************************
+ * @brief Stops a timer.
+ *
+ * @param[in] timer  Timer.
+ *
+ * @return None
+ *****************************************************************************/
+void HwTimer_Stop(HwTimer_t *timer)
+{
+	if(TimerWheel_IsRunning(timer))
+	{
+		TimerWheel_Stop(&hwtimerwheel, timer);
+		if(hwtimeradvancing == false)
+		{
+			hwTimerProgram();
+		}
+	}
+}
+/*****************************************************************************
+ * @brief Tells whether a timer is started.
+ *
+ * @param[in] timer  Timer.
+ *
+ * @return bool
+ *****************************************************************************/
+bool HwTimer_IsRunning(const HwTimer_t *timer)
+{
+	return TimerWheel_IsRunning(timer);
+}
+/*****************************************************************************
+ * @brief Tells whether any timer is started.
+ *
+ * @param None
+ *
+ * @return bool
+ *****************************************************************************/
+bool HwTimer_IsActive(void)
+{
+	return (TimerWheel_GetCount(&hwtimerwheel) != 0U);
+}
+/*****************************************************************************
+ * @brief Returns the free running tick count.
+ *
+ * @param None
+ *
+ * @return uint16_t Ticks of 1 / HWTIMER_TICK_HZ, differences are modulo 2^16.
+ *****************************************************************************/
+uint16_t HwTimer_Now(void)
+{
+	return (uint16_t)(Sim_Now() / SIM_HWTIMER_TICK_US);
+}
+/*****************************************************************************
+ * @brief TIM4 compare interrupt: advances the wheel and sets the next
+ *        compare.
+ *
+ * @param None
+ *
+ * @return None
+ *****************************************************************************/
+void HwTimer_IRQHandler(void)
+{
+	Sim_GetStats()->timerWakes++;
+	hwtimeradvancing = true;
+	TimerWheel_Advance(&hwtimerwheel, hwTimerTicks());
+	hwtimeradvancing = false;
+	hwTimerProgram();
+}
+
+/*****************************************************************************/
+/* Power Functions                                                           */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Sleeps until the next interrupt.
+ *
+ * @details Runs the simulation idle hook, then jumps the virtual clock to
+ *          the next armed source and runs it.
+ *          STOP is counted as a violation when TIM3 or a TIM4 wheel timer is
+ *          still counting, those timers would freeze on the board.
+ *
+ * @param[in] mode  PowerIdle_Sleep or PowerIdle_Stop.
+ *
+ * @return None
+ *****************************************************************************/
+void Power_Idle(PowerIdle_e mode)
+{
+	SimStats_t *stats = Sim_GetStats();
+
+	Sim_RunIdleHook();
+
+	if(mode == PowerIdle_Stop)
+	{
+		powerstopcount++;
+		stats->stopEntries++;
+		if(Sim_Tim3IsRunning() || HwTimer_IsActive())
+		{
+			stats->stopViolations++;
+		}
+	}
+	else
+	{
+		stats->sleepEntries++;
+	}
+	APP_WAIT_FOR_INTERRUPT();
+}
+/*****************************************************************************
+ * @brief Returns the number of STOP mode entries.
+ *
+ * @param None
+ *
+ * @return uint32_t STOP entries since boot.
+ *****************************************************************************/
+uint32_t Power_GetStopCount(void)
+{
+	return powerstopcount;
+}
+/*************************************END*************************************/
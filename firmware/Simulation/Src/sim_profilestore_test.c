@@ -0,0 +1,424 @@
+/**
+ * \file           sim_profilestore_test.c
+ * \brief          Host test of the session profile store against a flash model with power cuts
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+#include "flashregion.h"
+#include "profilestore.h"
+#include "sim_test.h"
+
+/*****************************************************************************/
+/* Private Defines                                                           */
+/*****************************************************************************/
+#define TEST_SELECTIONS            3000U        /** Profile selections, about 3.5 sector rollovers **/
+#define TEST_CUT_ONE_IN            6U           /** The power fails during one save in this many ... **/
+#define TEST_CUT_WINDOW            24U          /** ... within this many flash operations **/
+#define TEST_REBOOT_ONE_IN         10U          /** Clean reboot after one save in this many **/
+#define TEST_DEFAULTS              3U           /** Profiles compiled into profilestore.c **/
+
+/*****************************************************************************/
+/* Private Types                                                             */
+/*****************************************************************************/
+/**
+ * @brief A profile the test expects, lengths in minutes.
+ */
+typedef struct
+{
+	const char *name;                 /**< Name */
+	uint16_t minutes[PomodoroFunctions_Count]; /**< Pomodoro, short and long break */
+	uint8_t cycles;                   /**< Cycles to the long break */
+}TestProfile_t;
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+/**
+ * @brief What Tools/profile_image.py was asked for by the Makefile,
+ *        "deep=52/17/30x3" "sprint=15/3/10x7" with -s 1.
+ */
+static const TestProfile_t testimage[] =
+{
+	{ "deep",   { 52U, 17U, 30U }, 3U },
+	{ "sprint", { 15U, 3U, 10U },  7U },
+};
+
+static jmp_buf testreboot; /** Where a power cut continues **/
+
+static uint32_t testsaves = 0; /** Selections written **/
+static uint32_t testreboots = 0; /** Boots checked **/
+static uint32_t testrollbacks = 0; /** Boots that found the selection before a cut save **/
+static uint32_t testlosses = 0; /** Boots that found the defaults after a cut erase **/
+
+static uint32_t testselected = 0; /** Last selection confirmed written **/
+static uint32_t testpending = 0; /** Selection being written when the power failed **/
+static bool testsaved = false; /** A selection was confirmed since the last cut erase **/
+
+/*****************************************************************************/
+/* Helpers                                                                   */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Power cut handler of the flash model, reboots.
+ *****************************************************************************/
+static void testPowerCut(void)
+{
+	longjmp(testreboot, 1);
+}
+/*****************************************************************************
+ * @brief Checks the profiles in the store against the compiled defaults.
+ *****************************************************************************/
+static void testCheckDefaults(void)
+{
+	const ProfileStoreEntry_t *first = profileStore_Get(0);
+
+	if(profileStore_GetCount() != TEST_DEFAULTS)
+	{
+		Sim_TestFail("default profile count", profileStore_GetCount());
+	}
+	if((first == NULL) || (strcmp(first->name, "25/5") != 0) ||
+			(first->profile.duration[PomodoroFunctions_PomodoroMode] != POMODOROMODE_TIME) ||
+			(first->profile.duration[PomodoroFunctions_ShortBreak] != SHORTBREAK_TIME) ||
+			(first->profile.duration[PomodoroFunctions_LongBreak] != LONGBREAK_TIME) ||
+			(first->profile.cycles != NO_OF_CYCLES))
+	{
+		Sim_TestFail("first default profile is not the one of session.h", 0);
+	}
+	for(uint8_t i = 0; i < profileStore_GetCount(); i++)
+	{
+		if(session_IsProfileValid(&profileStore_Get(i)->profile) == false)
+		{
+			Sim_TestFail("default profile not valid", i);
+		}
+	}
+}
+/*****************************************************************************
+ * @brief Programs a raw image into slot 0 of an erased sector.
+ *****************************************************************************/
+static void testProgramImage(const uint32_t *words)
+{
+	Sim_FlashReset();
+	if(FlashRegion_Program(FlashRegion_Profiles, 0, words, PROFILESTORE_IMAGE_WORDS) == false)
+	{
+		Sim_TestFail("image program", 0);
+	}
+}
+
+/*****************************************************************************/
+/* Tests                                                                     */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief An erased sector gives the compiled defaults, not loaded.
+ *****************************************************************************/
+static void testBlank(void)
+{
+	Sim_FlashReset();
+	profileStore_Init();
+	if(profileStore_IsLoaded() || (profileStore_GetSelected() != 0U))
+	{
+		Sim_TestFail("blank sector does not give the defaults", profileStore_GetSelected());
+	}
+	testCheckDefaults();
+	if((profileStore_Get(TEST_DEFAULTS) != NULL) || profileStore_Select(TEST_DEFAULTS))
+	{
+		Sim_TestFail("profile out of range accepted", TEST_DEFAULTS);
+	}
+}
+/*****************************************************************************
+ * @brief A failed program leaves the selection to the next service call.
+ *
+ * @details The error hits a word inside the image, so the spoilt slot must
+ *          be stepped over and the selection written to the next one.
+ *****************************************************************************/
+static void testProgramError(void)
+{
+	Sim_FlashReset();
+	profileStore_Init();
+	(void)profileStore_Select(1U);
+	Sim_FlashArmError(4U);
+	profileStore_Service();
+	Sim_FlashArmError(0U);
+	profileStore_Service();
+
+	profileStore_Init();
+	if((profileStore_IsLoaded() == false) || (profileStore_GetSelected() != 1U))
+	{
+		Sim_TestFail("selection lost after a program error, found", profileStore_GetSelected());
+	}
+	if(Sim_FlashGetStats()->errors != 1U)
+	{
+		Sim_TestFail("program errors injected", Sim_FlashGetStats()->errors);
+	}
+}
+/*****************************************************************************
+ * @brief An image of Tools/profile_image.py loads as asked for.
+ *
+ * @details The same image with another layout version or one broken bit
+ *          must give the defaults.
+ *
+ * @param[in] path  Image file.
+ *****************************************************************************/
+static void testToolImage(const char *path)
+{
+	uint32_t words[PROFILESTORE_IMAGE_WORDS];
+	FILE *file = fopen(path, "rb");
+
+	if((file == NULL) || (fread(words, 1, sizeof(words), file) != sizeof(words)))
+	{
+		Sim_TestFail("image file missing or short", 0);
+		if(file != NULL)
+		{
+			fclose(file);
+		}
+		return;
+	}
+	fclose(file);
+
+	testProgramImage(words);
+	profileStore_Init();
+	if((profileStore_IsLoaded() == false) || (profileStore_GetCount() != 2U) || (profileStore_GetSelected() != 1U))
+	{
+		Sim_TestFail("tool image not loaded, profiles", profileStore_GetCount());
+	}
+	for(uint8_t i = 0; (i < 2U) && (i < profileStore_GetCount()); i++)
+	{
+		const ProfileStoreEntry_t *entry = profileStore_Get(i);
+
+		if((strcmp(entry->name, testimage[i].name) != 0) || (entry->profile.cycles != testimage[i].cycles))
+		{
+			Sim_TestFail("tool image profile name or cycles", i);
+		}
+		for(uint32_t mode = 0; mode < (uint32_t)PomodoroFunctions_Count; mode++)
+		{
+			if(entry->profile.duration[mode] != (testimage[i].minutes[mode] * 60U))
+			{
+				Sim_TestFail("tool image profile length", mode);
+			}
+		}
+	}
+
+	words[1] += 1U; /** Next layout version **/
+	words[PROFILESTORE_IMAGE_WORDS - 1U] = ~stdUtil_crc32(STDUTIL_CRC32_INIT, words, (PROFILESTORE_IMAGE_WORDS - 1U) * 4U);
+	testProgramImage(words);
+	profileStore_Init();
+	if(profileStore_IsLoaded())
+	{
+		Sim_TestFail("image of another layout version loaded", words[1] & 0xFFU);
+	}
+	testCheckDefaults();
+
+	words[1] -= 1U;
+	words[4] ^= 0x00010000U; /** One bit of the first Pomodoro length, CRC not updated **/
+	testProgramImage(words);
+	profileStore_Init();
+	if(profileStore_IsLoaded())
+	{
+		Sim_TestFail("image with a bad CRC loaded", 0);
+	}
+}
+/*****************************************************************************
+ * @brief Boots and checks the selection against what was written.
+ *
+ * @details After a cut save the old or the new selection is allowed; after
+ *          a cut erase the defaults are too.
+ *
+ * @param[in] cut    A power cut happened.
+ * @param[in] erase  The cut hit the sector erase.
+ *****************************************************************************/
+static void testBoot(bool cut, bool erase)
+{
+	uint32_t selected;
+
+	Sim_FlashArmCut(0, NULL);
+	profileStore_Init();
+	selected = profileStore_GetSelected();
+	testreboots++;
+
+	if(cut && erase && (profileStore_IsLoaded() == false))
+	{
+		testlosses++;
+		testsaved = false;
+		testselected = 0;
+	}
+	else if(cut && (selected != testselected) && (selected == testpending))
+	{
+		testselected = selected;
+		testsaved = true;
+	}
+	else if(cut && (selected == testselected) && (testpending != testselected))
+	{
+		testrollbacks++;
+	}
+
+	if(selected != testselected)
+	{
+		Sim_TestFail("selection after boot, found", selected);
+	}
+	if(testsaved != profileStore_IsLoaded())
+	{
+		Sim_TestFail("saved selection not loaded, saves", testsaves);
+	}
+	testCheckDefaults();
+}
+/*****************************************************************************
+ * @brief Selects random profiles, with power cuts and reboots in between.
+ *****************************************************************************/
+static void testSelections(void)
+{
+	static uint32_t round;
+	static uint32_t erases;
+
+	Sim_FlashReset();
+	profileStore_Init();
+	testselected = 0;
+	testsaved = false;
+
+	for(round = 0; round < TEST_SELECTIONS; round++)
+	{
+		uint32_t value = Sim_TestRandom();
+
+		testpending = (testselected + 1U + (value % (TEST_DEFAULTS - 1U))) % TEST_DEFAULTS;
+		erases = Sim_FlashGetStats()->erases;
+		if(setjmp(testreboot) != 0)
+		{
+			testBoot(true, Sim_FlashGetStats()->erases != erases);
+			continue;
+		}
+		if(((value >> 8) % TEST_CUT_ONE_IN) == 0U)
+		{
+			Sim_FlashArmCut(1U + ((value >> 16) % TEST_CUT_WINDOW), testPowerCut);
+		}
+		(void)profileStore_Select((uint8_t)testpending);
+		profileStore_Service();
+		Sim_FlashArmCut(0, NULL);
+		testselected = testpending;
+		testsaved = true;
+		testsaves++;
+
+		if(((value >> 24) % TEST_REBOOT_ONE_IN) == 0U)
+		{
+			testBoot(false, false);
+		}
+	}
+	testBoot(false, false);
+}
+/*****************************************************************************
+ * @brief Session engine hooks of testEngine(), no hardware behind them.
+ *****************************************************************************/
+static void testEngineTimer(SessionTimer_e action) { (void)action; }
+static void testEngineModeEnd(PomodoroFunctions_e finished, SessionEvent_e cause) { (void)finished; (void)cause; }
+static void testEngineDisplay(uint32_t elapsed) { (void)elapsed; }
+static void testEngineEnded(const SessionSummary_t *summary) { (void)summary; }
+/*****************************************************************************
+ * @brief The session engine runs the lengths of the profile it was given.
+ *
+ * @details 3/1/2 s with 3 cycles: P S P S L. The profile is refused while
+ *          the timer is not stopped.
+ *****************************************************************************/
+static void testEngine(void)
+{
+	static const SessionHooks_t hooks = { testEngineTimer, testEngineModeEnd, testEngineDisplay, testEngineEnded };
+	static const SessionProfile_t profile = { { 3U, 1U, 2U }, 3U };
+	static const SessionProfile_t broken = { { 3U, 0U, 2U }, 3U };
+	static const PomodoroFunctions_e expected[] = { PomodoroFunctions_ShortBreak, PomodoroFunctions_PomodoroMode,
+			PomodoroFunctions_ShortBreak, PomodoroFunctions_LongBreak };
+	uint32_t seconds = 0;
+
+	session_Init(&hooks);
+	if(session_SetProfile(&broken) || (session_SetProfile(&profile) == false))
+	{
+		Sim_TestFail("profile validation of the engine", 0);
+	}
+	session_Dispatch(SessionEvent_StartPause);
+	if(session_SetProfile(&profile))
+	{
+		Sim_TestFail("profile taken by a running engine", 0);
+	}
+	for(uint32_t i = 0; i < (sizeof(expected) / sizeof(expected[0])); i++)
+	{
+		uint32_t duration = session_GetDuration();
+		uint32_t consumed = 0;
+
+		for(uint32_t tick = 0; (tick < 10U) && (consumed == 0U); tick++)
+		{
+			seconds++;
+			consumed = session_Update(seconds);
+		}
+		if((consumed != duration) || (session_GetMode() != expected[i]))
+		{
+			Sim_TestFail("engine mode sequence with a profile, step", i);
+		}
+		seconds -= consumed;
+	}
+}
+
+/*****************************************************************************/
+/* Test Entry                                                                */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Runs the profile store tests.
+ *
+ * @details Usage: profilestore-test profiles.bin, an image made by
+ *          Tools/profile_image.py with the profiles of testimage.
+ *
+ * @return int Exit status.
+ *****************************************************************************/
+int main(int argc, char *argv[])
+{
+	if(argc != 2)
+	{
+		fprintf(stderr, "usage: %s profiles.bin\n", argv[0]);
+		return 2;
+	}
+
+	testBlank();
+	testProgramError();
+	testToolImage(argv[1]);
+	testEngine();
+	testSelections();
+
+	printf("profiles    %lu selections saved, %lu boots, %lu power cuts, %lu erases\n",
+			(unsigned long)testsaves, (unsigned long)testreboots,
+			(unsigned long)Sim_FlashGetStats()->cuts, (unsigned long)Sim_FlashGetStats()->erases);
+	printf("cuts        %lu boot(s) with the selection before the cut, %lu with the defaults after a cut erase\n",
+			(unsigned long)testrollbacks, (unsigned long)testlosses);
+
+	if(Sim_FlashGetStats()->violations != 0U)
+	{
+		Sim_TestFail("programs of a one over a zero bit", Sim_FlashGetStats()->violations);
+	}
+	return Sim_TestResult();
+}
+/*************************************END*************************************/
@@ -0,0 +1,414 @@
+/**
+ * \file           sim_rtc.c
+ * \brief          RTC prescaler and wake-up timer model
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "sim.h"
+
+/*****************************************************************************/
+/* Private Defines                                                           */
+/*****************************************************************************/
+#define SIM_RTC_LSE_HZ             32768U       /** LSE crystal **/
+#define SIM_RTC_LSI_HZ             32000U       /** LSI, nominal **/
+
+/*****************************************************************************/
+/* Private Types                                                             */
+/*****************************************************************************/
+/**
+ * @brief Hardware side of the RTC, the register contents are the bus side.
+ */
+typedef struct
+{
+	bool lseok;                      /**< The LSE starts when switched on */
+	bool init;                       /**< Initialisation mode, prescalers held */
+	uint32_t prer;                   /**< PRER taken when initialisation mode was left */
+	uint32_t async;                  /**< RTCCLK cycles into the current ck_apre cycle */
+	uint32_t ss;                     /**< Synchronous prescaler counter */
+	bool shift;                      /**< SHIFTR written, taken on the next cycle */
+	uint32_t subfs;                  /**< SUBFS of the pending shift */
+	bool rsf;                        /**< Shadow registers synchronised */
+	bool wute;                       /**< Wake-up timer enabled */
+	uint32_t wutr;                   /**< WUTR taken when the timer was enabled */
+	uint32_t cksel;                  /**< WUCKSEL taken when the timer was enabled */
+	uint32_t wutcount;               /**< Wake-up clock cycles to the next WUTF */
+	bool wutf;                       /**< Wake-up flag */
+	bool nvic;                       /**< RTC_WKUP_IRQn enabled */
+	bool alrae;                      /**< Alarm A enabled */
+	uint32_t alrmassr;               /**< ALRMASSR taken when the alarm was enabled */
+	bool alraf;                      /**< Alarm A flag */
+	bool alarmnvic;                  /**< RTC_Alarm_IRQn enabled */
+	uint32_t isr;                    /**< ISR as last written back, any other value is a write */
+}SimRtc_t;
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+RTC_TypeDef simRtc;   /** Bus side of the RTC registers **/
+RCC_TypeDef simRcc;   /** Bus side of BDCR and CSR **/
+PWR_TypeDef simPwr;   /** Bus side of PWR_CR **/
+EXTI_TypeDef simExti; /** Bus side of the EXTI registers **/
+
+static SimRtc_t simrtc; /** Hardware state **/
+
+static SimRtcStats_t simrtcstats; /** Counters of the model **/
+
+/*****************************************************************************/
+/* Private Functions                                                         */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Returns true if the RTC is clocked from a ready oscillator.
+ *****************************************************************************/
+static bool simRtcClocked(void)
+{
+	uint32_t bdcr = simRcc.BDCR;
+
+	if((bdcr & RCC_BDCR_RTCEN) == 0U)
+	{
+		return false;
+	}
+	if((bdcr & RCC_BDCR_RTCSEL) == RCC_BDCR_RTCSEL_0)
+	{
+		return (bdcr & RCC_BDCR_LSERDY) != 0U;
+	}
+	if((bdcr & RCC_BDCR_RTCSEL) == RCC_BDCR_RTCSEL_1)
+	{
+		return (simRcc.CSR & RCC_CSR_LSIRDY) != 0U;
+	}
+	return false;
+}
+/*****************************************************************************
+ * @brief Takes what the firmware wrote since the last call and updates the
+ *        flags it reads.
+ *
+ * @details The registers are plain memory for the firmware, so only the
+ *          state at each call is seen. The firmware waits for a flag (and so
+ *          calls HAL_GetTick()) between the writes the RM orders, which is
+ *          where the model runs. ISR differing from what the model left in
+ *          it was written: its rc_w0 flags written as zero are cleared. A write that the RTC would ignore (WUTR or
+ *          WUCKSEL with the wake-up timer enabled, the alarm registers
+ *          with the alarm enabled, PRER outside initialisation mode) is
+ *          counted as a violation, as is an alarm on calendar fields,
+ *          which the model does not keep.
+ *****************************************************************************/
+static void simRtcSync(void)
+{
+	if(((simRcc.BDCR & RCC_BDCR_LSEON) != 0U) && simrtc.lseok)
+	{
+		simRcc.BDCR |= RCC_BDCR_LSERDY;
+	}
+	else
+	{
+		simRcc.BDCR &= ~RCC_BDCR_LSERDY;
+	}
+	if((simRcc.CSR & RCC_CSR_LSION) != 0U)
+	{
+		simRcc.CSR |= RCC_CSR_LSIRDY;
+	}
+	simrtcstats.hz = ((simRcc.BDCR & RCC_BDCR_RTCSEL) == RCC_BDCR_RTCSEL_1) ? SIM_RTC_LSI_HZ : SIM_RTC_LSE_HZ;
+
+	uint32_t isr = simRtc.ISR;
+	if(isr != simrtc.isr)
+	{
+		if((isr & RTC_ISR_WUTF) == 0U) /** rc_w0 **/
+		{
+			simrtc.wutf = false;
+		}
+		if((isr & RTC_ISR_RSF) == 0U)
+		{
+			simrtc.rsf = false;
+		}
+		if((isr & RTC_ISR_ALRAF) == 0U)
+		{
+			simrtc.alraf = false;
+		}
+	}
+	if(((isr & RTC_ISR_INIT) != 0U) && (simrtc.init == false))
+	{
+		simrtc.init = true;
+		simrtc.rsf = false;
+	}
+	else if(((isr & RTC_ISR_INIT) == 0U) && simrtc.init)
+	{
+		simrtc.init = false;
+		simrtc.prer = simRtc.PRER;
+		simrtc.async = 0U;
+		simrtc.ss = simrtc.prer & RTC_PRER_PREDIV_S;
+	}
+	else if((simrtc.init == false) && (simRtc.PRER != simrtc.prer))
+	{
+		simrtcstats.violations++;
+		simRtc.PRER = simrtc.prer;
+	}
+
+	if(simRtc.SHIFTR != 0U)
+	{
+		if(simrtc.init || simrtc.shift || ((simrtc.ss & 0x8000U) != 0U))
+		{
+			simrtcstats.violations++;
+		}
+		else
+		{
+			simrtc.shift = true;
+			simrtc.subfs = simRtc.SHIFTR & RTC_SHIFTR_SUBFS;
+			simrtc.rsf = false;
+			simrtcstats.shifts++;
+		}
+		simRtc.SHIFTR = 0U; /** Write only **/
+	}
+
+	uint32_t cr = simRtc.CR;
+	if((cr & RTC_CR_WUTE) != 0U)
+	{
+		if(simrtc.wute == false)
+		{
+			simrtc.wute = true;
+			simrtc.wutr = simRtc.WUTR & 0xFFFFU;
+			simrtc.cksel = cr & RTC_CR_WUCKSEL;
+			simrtc.wutcount = simrtc.wutr + 1U;
+		}
+		else if((simRtc.WUTR != simrtc.wutr) || ((cr & RTC_CR_WUCKSEL) != simrtc.cksel))
+		{
+			simrtcstats.violations++;
+			simRtc.WUTR = simrtc.wutr;
+		}
+	}
+	else
+	{
+		simrtc.wute = false;
+	}
+
+	uint32_t masks = RTC_ALRMAR_MSK4 | RTC_ALRMAR_MSK3 | RTC_ALRMAR_MSK2 | RTC_ALRMAR_MSK1;
+	if((cr & RTC_CR_ALRAE) != 0U)
+	{
+		if(simrtc.alrae == false)
+		{
+			simrtc.alrae = true;
+			simrtc.alrmassr = simRtc.ALRMASSR;
+			if((simRtc.ALRMAR & masks) != masks)
+			{
+				simrtcstats.violations++;
+			}
+		}
+		else if(simRtc.ALRMASSR != simrtc.alrmassr)
+		{
+			simrtcstats.violations++;
+			simRtc.ALRMASSR = simrtc.alrmassr;
+		}
+	}
+	else
+	{
+		simrtc.alrae = false;
+	}
+
+	simrtc.isr = (isr & RTC_ISR_INIT) |
+	             (simrtc.init ? RTC_ISR_INITF : 0U) |
+	             (simrtc.rsf ? RTC_ISR_RSF : 0U) |
+	             (simrtc.shift ? RTC_ISR_SHPF : 0U) |
+	             (simrtc.wute ? 0U : RTC_ISR_WUTWF) |
+	             (simrtc.wutf ? RTC_ISR_WUTF : 0U) |
+	             (simrtc.alrae ? 0U : RTC_ISR_ALRAWF) |
+	             (simrtc.alraf ? RTC_ISR_ALRAF : 0U);
+	simRtc.ISR = simrtc.isr;
+	simRtc.SSR = simrtc.ss;
+}
+/*****************************************************************************
+ * @brief Runs the RTC for one RTCCLK cycle.
+ *
+ * @details The asynchronous prescaler divides RTCCLK by PREDIV_A + 1 into
+ *          ck_apre, which counts SSR down; ck_spre is the reload of SSR
+ *          from 0 to PREDIV_S. A shift adds SUBFS to SSR. The wake-up clock
+ *          is ck_spre (WUCKSEL 10x) or RTCCLK / 16, 8, 4, 2 from a divider
+ *          that initialisation mode does not reset. Alarm A matches when
+ *          the SSR bits below MASKSS reach its SS value.
+ *****************************************************************************/
+static void simRtcCycle(void)
+{
+	bool spre = false;
+	bool clocked = simRtcClocked();
+
+	if(clocked && (simrtc.init == false))
+	{
+		if(simrtc.shift)
+		{
+			simrtc.ss += simrtc.subfs;
+			simrtc.shift = false;
+		}
+		else
+		{
+			simrtc.rsf = true;
+		}
+		if(++simrtc.async > ((simrtc.prer & RTC_PRER_PREDIV_A) >> RTC_PRER_PREDIV_A_Pos))
+		{
+			simrtc.async = 0U;
+			if(simrtc.ss == 0U)
+			{
+				simrtc.ss = simrtc.prer & RTC_PRER_PREDIV_S;
+				spre = true;
+				simrtcstats.spreEdges++;
+			}
+			else
+			{
+				simrtc.ss--;
+			}
+			uint32_t mask = (1UL << ((simrtc.alrmassr & RTC_ALRMASSR_MASKSS) >> RTC_ALRMASSR_MASKSS_Pos)) - 1U;
+			if(simrtc.alrae && (((simrtc.ss ^ simrtc.alrmassr) & mask) == 0U))
+			{
+				simrtc.alraf = true;
+				simrtcstats.alarms++;
+			}
+		}
+	}
+
+	simrtcstats.cycles++;
+
+	if(clocked && simrtc.wute)
+	{
+		bool edge;
+		if((simrtc.cksel & RTC_CR_WUCKSEL_2) != 0U)
+		{
+			edge = spre;
+		}
+		else
+		{
+			edge = (simrtcstats.cycles % (16U >> simrtc.cksel)) == 0U;
+		}
+		if(edge && (--simrtc.wutcount == 0U))
+		{
+			simrtc.wutf = true;
+			simrtc.wutcount = simrtc.wutr + 1U;
+			simrtcstats.wakeups++;
+		}
+	}
+}
+
+/*****************************************************************************/
+/* Simulation Functions                                                      */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Powers the backup domain up, the RTC is off.
+ *****************************************************************************/
+void Sim_RtcReset(bool lseok)
+{
+	simRtc = (RTC_TypeDef){ .PRER = 0x007F00FFU };
+	simRcc = (RCC_TypeDef){ 0 };
+	simPwr = (PWR_TypeDef){ 0 };
+	simExti = (EXTI_TypeDef){ 0 };
+	simrtc = (SimRtc_t){ .lseok = lseok, .prer = 0x007F00FFU, .ss = 0xFFU };
+	simrtcstats = (SimRtcStats_t){ .hz = SIM_RTC_LSE_HZ };
+	simRtcSync();
+}
+/*****************************************************************************
+ * @brief Resets the MCU, the backup domain and the RTC keep running.
+ *****************************************************************************/
+void Sim_RtcMcuReset(void)
+{
+	simRtcSync();
+	simRcc.CSR = 0U; /** The LSI is switched off by a system reset **/
+	simPwr = (PWR_TypeDef){ 0 };
+	simExti = (EXTI_TypeDef){ 0 };
+	simrtc.nvic = false;
+	simrtc.alarmnvic = false;
+	simRtcSync();
+}
+/*****************************************************************************
+ * @brief Runs the RTC, stops early on a cycle that leaves the wake-up or
+ *        the alarm interrupt pending.
+ *****************************************************************************/
+uint32_t Sim_RtcRun(uint32_t cycles)
+{
+	uint32_t done = 0;
+
+	simRtcSync();
+	while(done < cycles)
+	{
+		simRtcCycle();
+		done++;
+		if(Sim_RtcIrqPending() || Sim_RtcAlarmPending())
+		{
+			break;
+		}
+	}
+	simRtcSync();
+	return done;
+}
+/*****************************************************************************
+ * @brief Returns true if RTC_WKUP_IRQHandler() would run.
+ *****************************************************************************/
+bool Sim_RtcIrqPending(void)
+{
+	return simrtc.wutf && simrtc.nvic &&
+	       ((simRtc.CR & RTC_CR_WUTIE) != 0U) &&
+	       ((simExti.IMR & EXTI_IMR_MR22) != 0U) &&
+	       ((simExti.RTSR & EXTI_RTSR_TR22) != 0U);
+}
+/*****************************************************************************
+ * @brief Returns true if RTC_Alarm_IRQHandler() would run.
+ *****************************************************************************/
+bool Sim_RtcAlarmPending(void)
+{
+	return simrtc.alraf && simrtc.alarmnvic &&
+	       ((simRtc.CR & RTC_CR_ALRAIE) != 0U) &&
+	       ((simExti.IMR & EXTI_IMR_MR17) != 0U) &&
+	       ((simExti.RTSR & EXTI_RTSR_TR17) != 0U);
+}
+/*****************************************************************************
+ * @brief Returns the counters of the RTC model.
+ *****************************************************************************/
+SimRtcStats_t *Sim_RtcGetStats(void)
+{
+	return &simrtcstats;
+}
+
+/*****************************************************************************/
+/* HAL Replacements                                                          */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Only the RTC wake-up and alarm have an interrupt in this model.
+ *****************************************************************************/
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+}
+/*****************************************************************************
+ * @brief Enables RTC_WKUP_IRQn or RTC_Alarm_IRQn.
+ *****************************************************************************/
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+	if(IRQn == RTC_WKUP_IRQn)
+	{
+		simrtc.nvic = true;
+	}
+	else if(IRQn == RTC_Alarm_IRQn)
+	{
+		simrtc.alarmnvic = true;
+	}
+}
+/*************************************END*************************************/
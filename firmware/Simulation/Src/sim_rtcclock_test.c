@@ -0,0 +1,396 @@
+/**
+ * \file           sim_rtcclock_test.c
+ * \brief          Host test of the RTC timebase over pauses at random phases
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include "sim.h"
+#include "rtcclock.h"
+#include "sim_test.h"
+
+/*****************************************************************************/
+/* Private Defines                                                           */
+/*****************************************************************************/
+#define TEST_PAUSES                400U     /** Pauses per oscillator **/
+#define TEST_RESTART_EVERY         50U      /** Every n-th pause is a restart (phase reset) instead **/
+#define TEST_STEP_CYCLES           16U      /** One SSR step, PREDIV_A + 1 RTCCLK cycles **/
+#define TEST_SLACK_CYCLES          2U       /** Flag polls of TIMER_ON()/TIMER_OFF() **/
+#define TEST_BLINK_STEPS           1024U    /** SSR steps between two blink alarms **/
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static bool testrunning = false; /** Between TIMER_ON() and TIMER_OFF() **/
+static bool testinirq = false; /** RtcClock_IRQHandler() running, no nesting **/
+static uint32_t testpausesin = 0; /** Pauses since the last second **/
+static uint32_t testafter = 0; /** 1: the last second ended a partial one **/
+static uint64_t testruncycles = 0; /** RTCCLK cycles of running session time **/
+static uint64_t testlast = 0; /** testruncycles at the last second **/
+static uint32_t testseconds = 0; /** Session seconds counted **/
+static uint32_t testpaused = 0; /** Seconds counted while stopped **/
+static int64_t testerror = 0; /** Sum of the second length errors after pauses **/
+static uint32_t testworst = 0; /** Largest second length error after a pause **/
+static bool testblinking = false; /** Between RtcClock_SetBlink(true) and (false) **/
+static uint64_t testblinkcycles = 0; /** RTCCLK cycles with the blink alarm on **/
+static uint64_t testblinklast = 0; /** Cycle of the last blink of this pause, 0 = none yet **/
+static uint32_t testblinks = 0; /** Blink alarms taken **/
+
+/*****************************************************************************/
+/* Helpers                                                                   */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Random run or pause length in RTCCLK cycles.
+ *
+ * @details Within one SSR step, within the partial first second, anywhere
+ *          inside a second and over several seconds.
+ *****************************************************************************/
+static uint32_t testLength(uint32_t hz)
+{
+	switch(Sim_TestRandom() % 8U)
+	{
+	case 0:
+		return 1U + (Sim_TestRandom() % (2U * TEST_STEP_CYCLES));
+	case 1:
+		return 1U + (Sim_TestRandom() % (hz / 64U));
+	case 6:
+	case 7:
+		return hz + (Sim_TestRandom() % (3U * hz));
+	default:
+		return 1U + (Sim_TestRandom() % hz);
+	}
+}
+/*****************************************************************************
+ * @brief Runs RTC_Alarm_IRQHandler() if the model has it pending and checks
+ *        the time between two blinks of a pause.
+ *
+ * @details One blink every TEST_BLINK_STEPS SSR steps; on the LSI (2000
+ *          steps a second) every other gap is the rest of the second.
+ *****************************************************************************/
+static void testServiceAlarm(void)
+{
+	SimRtcStats_t *stats = Sim_RtcGetStats();
+	uint32_t steps = (stats->hz / TEST_STEP_CYCLES) - TEST_BLINK_STEPS;
+
+	testinirq = true;
+	bool blink = RtcClock_AlarmIRQHandler();
+	testinirq = false;
+	(void)Sim_RtcRun(0U);
+	if(blink == false)
+	{
+		return;
+	}
+	if(testblinking == false)
+	{
+		Sim_TestFail("blink alarm with the blink off", testblinks);
+	}
+	if(testblinklast != 0U)
+	{
+		uint64_t gap = stats->cycles - testblinklast;
+		uint64_t one = (uint64_t)TEST_BLINK_STEPS * TEST_STEP_CYCLES;
+		uint64_t other = (uint64_t)steps * TEST_STEP_CYCLES;
+		if(((gap + TEST_STEP_CYCLES) < other) || (gap > (one + TEST_STEP_CYCLES)))
+		{
+			Sim_TestFail("cycles between two blinks", (unsigned long)gap);
+		}
+	}
+	testblinklast = stats->cycles;
+	testblinks++;
+}
+/*****************************************************************************
+ * @brief Runs RTC_WKUP_IRQHandler() if the model has it pending and checks
+ *        the length of each counted second in running session time.
+ *****************************************************************************/
+static void testService(void)
+{
+	if(testinirq)
+	{
+		return;
+	}
+	if(Sim_RtcAlarmPending())
+	{
+		testServiceAlarm();
+	}
+	if(Sim_RtcIrqPending() == false)
+	{
+		return;
+	}
+	testinirq = true;
+	bool second = RtcClock_IRQHandler();
+	testinirq = false;
+	(void)Sim_RtcRun(0U); /** Take the flag clear before the next write to ISR **/
+	if(second == false)
+	{
+		return;
+	}
+
+	uint32_t hz = Sim_RtcGetStats()->hz;
+	int64_t error = (int64_t)(testruncycles - testlast) - hz;
+	uint32_t magnitude = (uint32_t)((error < 0) ? -error : error);
+	if(testrunning == false)
+	{
+		testpaused++;
+	}
+	else if(magnitude > (TEST_SLACK_CYCLES + ((testpausesin + testafter) * TEST_STEP_CYCLES)))
+	{
+		fprintf(stderr, "second %lu: %ld cycles off after %lu pause(s)\n", (unsigned long)testseconds,
+				(long)error, (unsigned long)testpausesin);
+		Sim_TestFail("second length, cycles off", magnitude);
+	}
+	if((testpausesin + testafter) != 0U)
+	{
+		testerror += error;
+		testworst = (magnitude > testworst) ? magnitude : testworst;
+	}
+	testafter = (testpausesin != 0U) ? 1U : 0U;
+	testpausesin = 0;
+	testlast = testruncycles;
+	testseconds++;
+}
+/*****************************************************************************
+ * @brief Runs the RTC for the given time, serving the wake-ups.
+ *****************************************************************************/
+static void testRun(uint32_t cycles)
+{
+	while(cycles > 0U)
+	{
+		uint32_t run = Sim_RtcRun(cycles);
+		if(testrunning)
+		{
+			testruncycles += run;
+		}
+		if(testblinking)
+		{
+			testblinkcycles += run;
+		}
+		cycles -= run;
+		testService();
+	}
+}
+/*****************************************************************************
+ * @brief TIMER_ON(), after TIMER_PHASE_RESET() for a start or restart.
+ *****************************************************************************/
+static void testOn(bool reset)
+{
+	if(reset)
+	{
+		TIMER_PHASE_RESET();
+	}
+	if(TIMER_ON() != HAL_OK)
+	{
+		Sim_TestFail("TIMER_ON()", 0U);
+	}
+	testrunning = true;
+	if(reset)
+	{
+		testpausesin = 0;
+		testafter = 0;
+		testlast = testruncycles;
+	}
+	else
+	{
+		testpausesin++;
+	}
+}
+/*****************************************************************************
+ * @brief TIMER_OFF().
+ *****************************************************************************/
+static void testOff(void)
+{
+	if(TIMER_OFF() != HAL_OK)
+	{
+		Sim_TestFail("TIMER_OFF()", 0U);
+	}
+	testrunning = false;
+}
+/*****************************************************************************
+ * @brief RtcClock_SetBlink() of the pause.
+ *****************************************************************************/
+static void testBlink(bool enable)
+{
+	if(RtcClock_SetBlink(enable) != HAL_OK)
+	{
+		Sim_TestFail("RtcClock_SetBlink()", enable ? 1U : 0U);
+	}
+	testblinking = enable;
+	testblinklast = 0;
+}
+/*****************************************************************************
+ * @brief Sessions with pauses at random phases on one oscillator, blinking
+ *        on the RTC alarm, then a warm reset that must keep the running RTC.
+ *
+ * @param[in] name    Oscillator name for the report.
+ * @param[in] lseok   false: the LSE does not start, the LSI is used.
+ *****************************************************************************/
+static void testOscillator(const char *name, bool lseok)
+{
+	Sim_RtcReset(lseok);
+	testrunning = false;
+	testpausesin = 0;
+	testafter = 0;
+	testruncycles = 0;
+	testlast = 0;
+	testseconds = 0;
+	testpaused = 0;
+	testerror = 0;
+	testworst = 0;
+	testblinkcycles = 0;
+	testblinks = 0;
+
+	RtcClock_Init();
+	SimRtcStats_t *stats = Sim_RtcGetStats();
+	if(RtcClock_GetSource() != (lseok ? RtcClockSource_Lse : RtcClockSource_Lsi))
+	{
+		Sim_TestFail("oscillator", (unsigned long)RtcClock_GetSource());
+	}
+
+	testOn(true);
+	uint32_t pauses = 0;
+	for(uint32_t p = 1; p <= TEST_PAUSES; p++)
+	{
+		testRun(testLength(stats->hz));
+		testOff();
+		testBlink(true);
+		testRun(testLength(stats->hz));
+		testBlink(false);
+		testOn((p % TEST_RESTART_EVERY) == 0U);
+		pauses += ((p % TEST_RESTART_EVERY) == 0U) ? 0U : 1U;
+	}
+	testRun(3U * stats->hz);
+	testOff();
+	uint32_t wakeups = stats->wakeups;
+	testRun(5U * stats->hz);
+
+	if(testpaused != 0U)
+	{
+		Sim_TestFail("seconds counted while stopped", testpaused);
+	}
+	if(stats->wakeups != wakeups)
+	{
+		Sim_TestFail("wake-ups of the stopped timer", stats->wakeups - wakeups);
+	}
+	uint64_t blinks = (testblinkcycles * 2U) / stats->hz;
+	if(((testblinks > blinks) ? (testblinks - blinks) : (blinks - testblinks)) > TEST_PAUSES)
+	{
+		Sim_TestFail("blinks against the paused time", testblinks);
+	}
+
+	Sim_RtcMcuReset(); /** Warm reset: the RTC and its oscillator are kept, no LSE wait **/
+	uint64_t boot = stats->cycles;
+	RtcClock_Init();
+	if((stats->cycles - boot) > (stats->hz / 100U))
+	{
+		Sim_TestFail("warm reset RtcClock_Init() RTCCLK cycles", (unsigned long)(stats->cycles - boot));
+	}
+	if(RtcClock_GetSource() != (lseok ? RtcClockSource_Lse : RtcClockSource_Lsi))
+	{
+		Sim_TestFail("oscillator after a warm reset", (unsigned long)RtcClock_GetSource());
+	}
+
+	if(stats->violations != 0U)
+	{
+		Sim_TestFail("RTC writes the hardware would ignore", stats->violations);
+	}
+	uint64_t expected = testruncycles / stats->hz;
+	if((testseconds > expected) || ((expected - testseconds) > (TEST_PAUSES / TEST_RESTART_EVERY)))
+	{
+		Sim_TestFail("seconds counted against the running time", testseconds);
+	}
+	int64_t perpause = testerror / (int64_t)pauses;
+	if((perpause > (int64_t)TEST_STEP_CYCLES) || (perpause < -(int64_t)TEST_STEP_CYCLES))
+	{
+		Sim_TestFail("mean phase error per pause over one SSR step, cycles", (unsigned long)((perpause < 0) ? -perpause : perpause));
+	}
+	printf("rtcclock    %s %3lu pauses %5lu s, second +-%lu cycles, %+ld cycles/pause (%lu shifts, %lu blinks)\n",
+			name, (unsigned long)pauses, (unsigned long)testseconds, (unsigned long)testworst,
+			(long)perpause, (unsigned long)stats->shifts, (unsigned long)testblinks);
+}
+
+/*****************************************************************************/
+/* HAL Replacements                                                          */
+/*****************************************************************************/
+uint32_t SystemCoreClock = 72000000U; /** Only scales the cycle counter **/
+
+/*****************************************************************************
+ * @brief One flag poll: runs the RTC for one RTCCLK cycle, the RTC
+ *        interrupt can come between two polls.
+ *****************************************************************************/
+static SimRtcStats_t *testPoll(void)
+{
+	uint32_t run = Sim_RtcRun(1U);
+	if(testrunning)
+	{
+		testruncycles += run;
+	}
+	if(testblinking)
+	{
+		testblinkcycles += run;
+	}
+	testService();
+	return Sim_RtcGetStats();
+}
+/*****************************************************************************
+ * @brief SysTick of the flag waits in thread mode.
+ *****************************************************************************/
+uint32_t HAL_GetTick(void)
+{
+	SimRtcStats_t *stats = testPoll();
+	return (uint32_t)((stats->cycles * 1000U) / stats->hz);
+}
+/*****************************************************************************
+ * @brief APP_CYCLE_COUNTER(), the flag waits in the wake-up interrupt.
+ *****************************************************************************/
+uint32_t Sim_CycleCounter(void)
+{
+	SimRtcStats_t *stats = testPoll();
+	return (uint32_t)(stats->cycles * (SystemCoreClock / stats->hz));
+}
+/*****************************************************************************
+ * @brief A flag that never comes, the RTC model does not fail.
+ *****************************************************************************/
+void Error_Handler(void)
+{
+	fprintf(stderr, "FAIL Error_Handler()\n");
+	exit(2);
+}
+
+/*****************************************************************************/
+/* Main                                                                      */
+/*****************************************************************************/
+int main(void)
+{
+	testOscillator("lse", true);
+	testOscillator("lsi", false);
+
+	return Sim_TestResult();
+}
+/*************************************END*************************************/
@@ -0,0 +1,409 @@
+/**
+ * \file           sim_sessionlog_test.c
+ * \brief          Host test of the session history log against a flash model with power cuts
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+#include "flashregion.h"
+#include "sessionlog.h"
+#include "sim_test.h"
+
+/*****************************************************************************/
+/* Private Defines                                                           */
+/*****************************************************************************/
+#define TEST_YEARS                 10U          /** Default years of use **/
+#define TEST_DAYS_PER_YEAR         365U         /** Days of use per year **/
+#define TEST_SESSIONS_MAX          16U          /** 0 ... this many sessions a day, 8 on average **/
+#define TEST_PAUSE_ONE_IN          3U           /** A session is followed by a pause one time in this many **/
+#define TEST_CUT_ONE_IN            12U          /** The power fails on one day in this many ... **/
+#define TEST_CUT_WINDOW            40U          /** ... within this many flash operations **/
+#define TEST_DIRECTED_CUTS         16U          /** Cuts at each word program or erase of a sector rollover **/
+#define TEST_ENDURANCE_CYCLES      10000U       /** Erase cycles the sector is specified for **/
+#define TEST_SLOTS_MAX             8192U        /** Slots of the 128 KB sector **/
+
+/*****************************************************************************/
+/* Private Types                                                             */
+/*****************************************************************************/
+/**
+ * @brief What the test knows is in one slot of the current sector.
+ */
+typedef struct
+{
+	bool confirmed;                   /**< sessionLog_Service() returned after writing it */
+	SessionSummary_t summary;         /**< Record written */
+}TestSlot_t;
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static TestSlot_t testmodel[TEST_SLOTS_MAX]; /** Confirmed records by index **/
+
+static uint32_t testmodelerases = 0; /** Flash model erase count testmodel belongs to **/
+
+static SessionSummary_t testpending[APP_SESSION_LOG_STAGING]; /** Copy of the staging buffer **/
+
+static uint32_t testpendingcount = 0; /** Records in testpending **/
+
+static jmp_buf testreboot; /** Where a power cut continues **/
+
+static bool testcut = false; /** A power cut happened since the last boot **/
+
+static uint32_t testsessions = 0; /** Sessions appended **/
+static uint32_t testconfirmed = 0; /** Records confirmed written **/
+static uint32_t testlost = 0; /** Staged records lost at power cuts **/
+static uint32_t testdropped = 0; /** Records dropped, staging full **/
+static uint32_t testrollovers = 0; /** Erases of a full sector **/
+static uint32_t testrecoveries = 0; /** Erases at boot after a power cut **/
+static uint32_t testtorn = 0; /** Most torn slots seen in one sector **/
+
+static const uint16_t testplanned[] = { POMODOROMODE_TIME, SHORTBREAK_TIME, LONGBREAK_TIME }; /** Indexed by PomodoroFunctions_e **/
+
+/*****************************************************************************/
+/* Helpers                                                                   */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Power cut handler of the flash model, reboots.
+ *****************************************************************************/
+static void testPowerCut(void)
+{
+	longjmp(testreboot, 1);
+}
+/*****************************************************************************
+ * @brief Compares two summaries field by field.
+ *****************************************************************************/
+static bool testSame(const SessionSummary_t *a, const SessionSummary_t *b)
+{
+	return (a->mode == b->mode) && (a->planned == b->planned) && (a->actual == b->actual) &&
+			(a->pauses == b->pauses) && (a->reason == b->reason);
+}
+/*****************************************************************************
+ * @brief Record capacity of the sector, the header slot excluded.
+ *****************************************************************************/
+static uint32_t testRecords(void)
+{
+	return (FlashRegion_GetSize(FlashRegion_SessionLog) / SESSIONLOG_RECORD_SIZE) - 1U;
+}
+/*****************************************************************************
+ * @brief Forgets the model once the sector was erased.
+ *****************************************************************************/
+static void testModelSync(void)
+{
+	if(Sim_FlashGetStats()->erases != testmodelerases)
+	{
+		memset(testmodel, 0, sizeof(testmodel));
+		testmodelerases = Sim_FlashGetStats()->erases;
+	}
+}
+
+/*****************************************************************************/
+/* Session Log Driver                                                        */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Appends a random session.
+ *****************************************************************************/
+static void testAppend(void)
+{
+	SessionSummary_t summary;
+	uint32_t value = Sim_TestRandom();
+
+	summary.mode = (PomodoroFunctions_e)(value % 3U);
+	summary.reason = (SessionEnd_e)((value >> 4) % (uint32_t)SessionEnd_Count);
+	summary.planned = testplanned[summary.mode];
+	summary.actual = (summary.reason == SessionEnd_TimeUp) ? summary.planned : (uint16_t)((value >> 8) % summary.planned);
+	summary.pauses = (uint8_t)((value >> 24) % 4U);
+
+	testsessions++;
+	if(sessionLog_Append(&summary))
+	{
+		testpending[testpendingcount++] = summary;
+	}
+	else
+	{
+		testdropped++;
+	}
+}
+/*****************************************************************************
+ * @brief Services the log and records what it confirmed.
+ *
+ * @details The records that left staging are the oldest pending ones, the
+ *          newest of them must read back from the end of the sector. An
+ *          erase is only allowed while idle and when the records did not
+ *          fit any more.
+ *
+ * @param[in] idle  Timer paused or stopped.
+ *****************************************************************************/
+static void testService(bool idle)
+{
+	uint32_t count = sessionLog_GetCount();
+	uint32_t erases = Sim_FlashGetStats()->erases;
+	uint32_t written;
+	uint32_t inflash;
+
+	sessionLog_Service(idle);
+	written = testpendingcount - sessionLog_GetStaged();
+
+	if(Sim_FlashGetStats()->erases != erases)
+	{
+		if((idle == false) || ((count + written) <= testRecords()))
+		{
+			Sim_TestFail("erase of a sector that was not full, records", count);
+		}
+		testrollovers++;
+	}
+	testModelSync();
+
+	inflash = sessionLog_GetCount();
+	inflash = (written < inflash) ? written : inflash;
+	for(uint32_t k = 0; k < inflash; k++)
+	{
+		uint32_t index = sessionLog_GetCount() - inflash + k;
+		const SessionSummary_t *summary = &testpending[written - inflash + k];
+		SessionLogRecord_t record;
+
+		if((sessionLog_Read(index, &record) == false) || (testSame(&record.summary, summary) == false))
+		{
+			Sim_TestFail("record does not read back after writing, index", index);
+		}
+		testmodel[index].confirmed = true;
+		testmodel[index].summary = *summary;
+	}
+
+	testconfirmed += written;
+	testpendingcount -= written;
+	memmove(&testpending[0], &testpending[written], testpendingcount * sizeof(SessionSummary_t));
+}
+/*****************************************************************************
+ * @brief Boots: finds the log again and checks it against the model.
+ *
+ * @details Every confirmed record of the current sector must be there,
+ *          every other valid record must be in sequence, torn slots are
+ *          only allowed after power cuts.
+ *****************************************************************************/
+static void testBoot(void)
+{
+	uint32_t erases = Sim_FlashGetStats()->erases;
+	uint32_t count;
+	uint32_t torn = 0;
+	uint32_t sequence = 0;
+	uint32_t previous = 0;
+	bool first = true;
+
+	Sim_FlashArmCut(0, NULL);
+	testlost += testpendingcount;
+	testpendingcount = 0;
+
+	sessionLog_Init();
+	if(Sim_FlashGetStats()->erases != erases)
+	{
+		if(testcut == false)
+		{
+			Sim_TestFail("erase at boot without a power cut, erases", Sim_FlashGetStats()->erases);
+		}
+		testrecoveries++;
+	}
+	testcut = false;
+	testModelSync();
+
+	count = sessionLog_GetCount();
+	for(uint32_t index = 0; index < testRecords(); index++)
+	{
+		SessionLogRecord_t record;
+
+		if((index < count) && sessionLog_Read(index, &record))
+		{
+			if(testmodel[index].confirmed && (testSame(&record.summary, &testmodel[index].summary) == false))
+			{
+				Sim_TestFail("record changed, index", index);
+			}
+			if((first == false) && (record.sequence != (sequence + (index - previous))))
+			{
+				Sim_TestFail("sequence out of order, index", index);
+			}
+			sequence = record.sequence;
+			previous = index;
+			first = false;
+		}
+		else if(testmodel[index].confirmed)
+		{
+			Sim_TestFail("confirmed record lost, index", index);
+		}
+		else if(index < count)
+		{
+			torn++;
+		}
+	}
+	if(torn > Sim_FlashGetStats()->cuts)
+	{
+		Sim_TestFail("more torn slots than power cuts", torn);
+	}
+	testtorn = (torn > testtorn) ? torn : testtorn;
+}
+/*****************************************************************************
+ * @brief One day of use: boot, sessions with pauses, stop.
+ *
+ * @details On some days the power fails during one of the flash operations
+ *          of the day, testPowerCut() jumps back into main().
+ *****************************************************************************/
+static void testDay(void)
+{
+	uint32_t sessions = Sim_TestRandom() % (TEST_SESSIONS_MAX + 1U);
+
+	testBoot();
+	if((Sim_TestRandom() % TEST_CUT_ONE_IN) == 0U)
+	{
+		Sim_FlashArmCut(1U + (Sim_TestRandom() % TEST_CUT_WINDOW), testPowerCut);
+	}
+	for(uint32_t session = 0; session < sessions; session++)
+	{
+		testAppend();
+		testService(false);
+		if((Sim_TestRandom() % TEST_PAUSE_ONE_IN) == 0U)
+		{
+			testService(true);
+		}
+	}
+	testService(true);
+	Sim_FlashArmCut(0, NULL);
+}
+/*****************************************************************************
+ * @brief Cuts the power at every operation of a sector rollover.
+ *
+ * @details Fills the sector, then lets the header invalidation, the erase,
+ *          the new header and the first records fail in turn. The next boot must find a usable log.
+ *****************************************************************************/
+static void testRolloverCuts(void)
+{
+	static uint32_t operation;
+
+	for(operation = 1; operation <= TEST_DIRECTED_CUTS; operation++)
+	{
+		if(setjmp(testreboot) != 0)
+		{
+			continue;
+		}
+		testBoot();
+		while(sessionLog_GetCount() < testRecords())
+		{
+			testAppend();
+			testService(true);
+		}
+		testAppend();
+		testAppend();
+		testcut = true;
+		Sim_FlashArmCut(operation, testPowerCut);
+		testService(true);
+		testcut = false;
+		Sim_TestFail("power cut did not happen, operation", operation);
+	}
+	testBoot();
+}
+
+/*****************************************************************************/
+/* Main Function                                                             */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Test entry point.
+ *
+ * @details Options: -y years of daily use (10). Exits with 0 if every
+ *          check passed.
+ *
+ * @param[in] argc  Argument count.
+ * @param[in] argv  Arguments.
+ *
+ * @return int Exit status.
+ *****************************************************************************/
+int main(int argc, char *argv[])
+{
+	static uint32_t day;
+	static uint32_t years = TEST_YEARS;
+	uint32_t cuts;
+	uint32_t rollovers;
+	double perYear;
+
+	if((argc == 3) && (strcmp(argv[1], "-y") == 0))
+	{
+		years = (uint32_t)strtoul(argv[2], NULL, 0);
+	}
+	else if(argc != 1)
+	{
+		fprintf(stderr, "usage: %s [-y years]\n", argv[0]);
+		return 2;
+	}
+
+	Sim_FlashReset();
+	for(day = 0; day < (years * TEST_DAYS_PER_YEAR); day++)
+	{
+		if(setjmp(testreboot) == 0)
+		{
+			testDay();
+		}
+		else
+		{
+			testcut = true;
+		}
+	}
+	testBoot();
+
+	cuts = Sim_FlashGetStats()->cuts;
+	rollovers = testrollovers;
+	perYear = (years > 0U) ? ((double)rollovers / (double)years) : 0.0;
+
+	printf("sessionlog  %lu year(s), %lu sessions, %lu confirmed, %lu lost in staging at power cuts, %lu dropped\n",
+			(unsigned long)years, (unsigned long)testsessions, (unsigned long)testconfirmed,
+			(unsigned long)testlost, (unsigned long)testdropped);
+	printf("flash       %lu rollover erases, %lu recovery erases, %lu power cuts, at most %lu torn slot(s)\n",
+			(unsigned long)rollovers, (unsigned long)testrecoveries, (unsigned long)cuts, (unsigned long)testtorn);
+	if(perYear > 0.0)
+	{
+		printf("endurance   %.2f erases per year, %u cycles last %.0f years\n", perYear,
+				TEST_ENDURANCE_CYCLES, (double)TEST_ENDURANCE_CYCLES / perYear);
+	}
+
+	testRolloverCuts();
+	printf("rollover    power cut at each of the first %u flash operations, %lu recovery erases in total\n",
+			TEST_DIRECTED_CUTS, (unsigned long)testrecoveries);
+
+	if(Sim_FlashGetStats()->violations != 0U)
+	{
+		Sim_TestFail("programs of a one over a zero bit", Sim_FlashGetStats()->violations);
+	}
+	if(testdropped != 0U)
+	{
+		Sim_TestFail("records dropped from a full staging buffer", testdropped);
+	}
+	return Sim_TestResult();
+}
+/*************************************END*************************************/
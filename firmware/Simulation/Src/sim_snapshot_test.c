@@ -0,0 +1,396 @@
+/**
+ * \file           sim_snapshot_test.c
+ * \brief          Host test of the session snapshot in the RTC backup registers
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include <setjmp.h>
+#include <stdio.h>
+#include "sim.h"
+#include "snapshot.h"
+#include "sim_test.h"
+
+/*****************************************************************************/
+/* Private Defines                                                           */
+/*****************************************************************************/
+#define TEST_SENTINEL              0xA5C30000U  /** Registers the snapshot must not touch, plus the index **/
+#define TEST_REGISTERS             20U          /** RTC_BKP0R ... RTC_BKP19R **/
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static jmp_buf testreboot; /** Where a power cut continues **/
+
+static uint32_t teststates = 0; /** States saved and restored **/
+
+static uint32_t testrejected = 0; /** Broken snapshots rejected **/
+
+static const SessionProfile_t testprofiles[] = /** Compiled default and a short one **/
+{
+	{ .duration = { POMODOROMODE_TIME, SHORTBREAK_TIME, LONGBREAK_TIME }, .cycles = NO_OF_CYCLES },
+	{ .duration = { 7U, 3U, 5U }, .cycles = 2U },
+};
+
+/*****************************************************************************/
+/* Session Hooks                                                             */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Hooks of the engine; session_SetState() must not call them.
+ *****************************************************************************/
+static void testHookCalled(void)
+{
+	Sim_TestFailf("hook called while restoring");
+}
+static void testTimer(SessionTimer_e action) { (void)action; testHookCalled(); }
+static void testModeEnd(PomodoroFunctions_e finished, SessionEvent_e cause) { (void)finished; (void)cause; testHookCalled(); }
+static void testDisplay(uint32_t elapsed) { (void)elapsed; testHookCalled(); }
+static void testEnded(const SessionSummary_t *summary) { (void)summary; testHookCalled(); }
+
+static const SessionHooks_t testhooks = { testTimer, testModeEnd, testDisplay, testEnded };
+
+/*****************************************************************************/
+/* Helpers                                                                   */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Power cut handler of the backup register model.
+ *****************************************************************************/
+static void testCut(void)
+{
+	longjmp(testreboot, 1);
+}
+/*****************************************************************************
+ * @brief Whether two snapshots are the same.
+ *****************************************************************************/
+static bool testSame(const Snapshot_t *a, const Snapshot_t *b)
+{
+	return (a->state.mode == b->state.mode) && (a->state.run == b->state.run) &&
+			(a->state.elapsed == b->state.elapsed) && (a->state.cycles == b->state.cycles) &&
+			(a->state.pauses == b->state.pauses) && (a->profile == b->profile) && (a->reason == b->reason);
+}
+/*****************************************************************************
+ * @brief Fills the registers the snapshot does not own with a pattern.
+ *****************************************************************************/
+static void testFillOthers(void)
+{
+	for(uint32_t index = SNAPSHOT_FIRST_REGISTER + SNAPSHOT_REGISTERS; index < TEST_REGISTERS; index++)
+	{
+		Sim_BackupWrite(index, TEST_SENTINEL + index);
+	}
+}
+/*****************************************************************************
+ * @brief Checks the registers the snapshot does not own.
+ *****************************************************************************/
+static void testCheckOthers(void)
+{
+	for(uint32_t index = SNAPSHOT_FIRST_REGISTER + SNAPSHOT_REGISTERS; index < TEST_REGISTERS; index++)
+	{
+		if(Sim_BackupRead(index) != (TEST_SENTINEL + index))
+		{
+			Sim_TestFail("register outside the snapshot changed", index);
+		}
+	}
+}
+/*****************************************************************************
+ * @brief Whether the engine can be in this state.
+ *****************************************************************************/
+static bool testReachable(const SessionProfile_t *profile, const SessionState_t *state)
+{
+	return (state->elapsed < profile->duration[state->mode]) && (state->cycles <= profile->cycles) &&
+			((state->run != SessionRun_Stopped) || ((state->elapsed == 0U) && (state->pauses == 0U)));
+}
+
+/*****************************************************************************/
+/* Tests                                                                     */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Every state the engine can be in goes through the registers and
+ *        back into the engine unchanged; the others are refused.
+ *****************************************************************************/
+static void testRoundTrip(void)
+{
+	static const uint8_t pauses[] = { 0U, 1U, 17U, UINT8_MAX };
+
+	for(uint8_t profile = 0; profile < (sizeof(testprofiles) / sizeof(testprofiles[0])); profile++)
+	{
+		const SessionProfile_t *lengths = &testprofiles[profile];
+		for(uint32_t mode = 0; mode < PomodoroFunctions_Count; mode++)
+		{
+			uint32_t duration = lengths->duration[mode];
+			const uint32_t elapsed[] = { 0U, 1U, duration / 2U, duration - 1U, duration };
+			for(uint32_t run = SessionRun_Stopped; run <= SessionRun_Paused; run++)
+			{
+				for(uint32_t e = 0; e < (sizeof(elapsed) / sizeof(elapsed[0])); e++)
+				{
+					for(uint32_t cycles = 0; cycles <= (lengths->cycles + 1U); cycles++)
+					{
+						for(uint32_t p = 0; p < (sizeof(pauses) * SnapshotReason_Count); p++)
+						{
+							Snapshot_t saved =
+							{
+								.state = { (PomodoroFunctions_e)mode, (SessionRun_e)run, (uint16_t)elapsed[e],
+										(uint8_t)cycles, pauses[p % sizeof(pauses)] },
+								.profile = profile,
+								.reason = (SnapshotReason_e)(p / sizeof(pauses)),
+							};
+							Snapshot_t loaded;
+							SessionState_t state;
+
+							uint32_t writes = Sim_BackupGetWrites();
+							snapshot_Save(&saved);
+							if((Sim_BackupGetWrites() - writes) != SNAPSHOT_REGISTERS)
+							{
+								Sim_TestFail("writes per save", Sim_BackupGetWrites() - writes);
+							}
+							if((snapshot_Load(&loaded) == false) || (testSame(&saved, &loaded) == false))
+							{
+								Sim_TestFail("snapshot round trip", mode);
+								continue;
+							}
+
+							session_Init(&testhooks);
+							(void)session_SetProfile(&testprofiles[loaded.profile]);
+							bool reachable = testReachable(lengths, &saved.state);
+							if(session_SetState(&loaded.state) != reachable)
+							{
+								Sim_TestFail("state accepted or refused wrongly", (mode << 16) | (run << 8) | cycles);
+								continue;
+							}
+							session_GetState(&state);
+							if(reachable && ((state.mode != saved.state.mode) || (state.run != saved.state.run) ||
+									(state.elapsed != saved.state.elapsed) || (state.cycles != saved.state.cycles) ||
+									(state.pauses != saved.state.pauses)))
+							{
+								Sim_TestFail("engine state after the restore", mode);
+							}
+							if((reachable == false) && ((state.mode != PomodoroFunctions_PomodoroMode) ||
+									(state.run != SessionRun_Stopped) || (state.elapsed != 0U)))
+							{
+								Sim_TestFail("refused state changed the engine", mode);
+							}
+							teststates += reachable ? 1U : 0U;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	/** Out of range encodings **/
+	SessionState_t bad = { PomodoroFunctions_Count, SessionRun_Paused, 0U, 0U, 0U };
+	session_Init(&testhooks);
+	if(session_SetState(&bad))
+	{
+		Sim_TestFail("mode out of range accepted", bad.mode);
+	}
+	bad.mode = PomodoroFunctions_PomodoroMode;
+	bad.run = (SessionRun_e)(SessionRun_Paused + 1);
+	if(session_SetState(&bad))
+	{
+		Sim_TestFail("run state out of range accepted", bad.run);
+	}
+}
+/*****************************************************************************
+ * @brief Any single bit flipped, and a reason out of range, reads as no
+ *        snapshot.
+ *****************************************************************************/
+static void testCorruption(void)
+{
+	const Snapshot_t saved =
+	{
+		.state = { PomodoroFunctions_ShortBreak, SessionRun_Paused, 123U, 3U, 2U },
+		.profile = 1U,
+		.reason = SnapshotReason_Idle,
+	};
+	Snapshot_t loaded;
+
+	for(uint32_t word = 0; word < SNAPSHOT_REGISTERS; word++)
+	{
+		for(uint32_t bit = 0; bit < 32U; bit++)
+		{
+			snapshot_Save(&saved);
+			uint32_t index = SNAPSHOT_FIRST_REGISTER + word;
+			Sim_BackupWrite(index, Sim_BackupRead(index) ^ (1UL << bit));
+			if(snapshot_Load(&loaded) || snapshot_IsSaved())
+			{
+				Sim_TestFail("flipped bit accepted", (word << 8) | bit);
+			}
+			else
+			{
+				testrejected++;
+			}
+		}
+	}
+
+	Snapshot_t unknown = saved;
+	unknown.reason = SnapshotReason_Count;
+	snapshot_Save(&unknown);
+	if(snapshot_Load(&loaded))
+	{
+		Sim_TestFail("unknown reason accepted", unknown.reason);
+	}
+}
+/*****************************************************************************
+ * @brief A power cut during a save leaves the old snapshot or none, never
+ *        a mix of the two.
+ *****************************************************************************/
+static void testPowerCut(void)
+{
+	const Snapshot_t old =
+	{
+		.state = { PomodoroFunctions_PomodoroMode, SessionRun_Paused, 600U, 1U, 1U },
+		.profile = 0U,
+		.reason = SnapshotReason_Idle,
+	};
+	const Snapshot_t new =
+	{
+		.state = { PomodoroFunctions_LongBreak, SessionRun_Stopped, 0U, 0U, 0U },
+		.profile = 2U,
+		.reason = SnapshotReason_Idle,
+	};
+	Snapshot_t loaded;
+
+	for(volatile uint32_t write = 1; write <= SNAPSHOT_REGISTERS; write++)
+	{
+		snapshot_Save(&old);
+		if(setjmp(testreboot) == 0)
+		{
+			Sim_BackupArmCut(write, testCut);
+			snapshot_Save(&new);
+			Sim_BackupArmCut(0U, NULL);
+			Sim_TestFail("no power cut", write);
+			continue;
+		}
+		bool valid = snapshot_Load(&loaded);
+		if(valid && (testSame(&loaded, &old) == false))
+		{
+			Sim_TestFail("mixed snapshot after a cut", write);
+		}
+		if((write == 1U) && (valid == false))
+		{
+			Sim_TestFail("old snapshot lost before the first write", write);
+		}
+		testrejected += valid ? 0U : 1U;
+	}
+	snapshot_Save(&new);
+	if((snapshot_Load(&loaded) == false) || (testSame(&loaded, &new) == false))
+	{
+		Sim_TestFail("snapshot after the cuts", 0);
+	}
+}
+/*****************************************************************************
+ * @brief Clear and a power cycle remove the snapshot.
+ *****************************************************************************/
+static void testClear(void)
+{
+	const Snapshot_t saved =
+	{
+		.state = { PomodoroFunctions_PomodoroMode, SessionRun_Stopped, 0U, 0U, 0U },
+		.profile = 0U,
+		.reason = SnapshotReason_Idle,
+	};
+
+	snapshot_Save(&saved);
+	snapshot_Clear();
+	if(snapshot_IsSaved())
+	{
+		Sim_TestFail("snapshot after clear", 0);
+	}
+	snapshot_Save(&saved);
+	Sim_BackupPowerCycle();
+	if(snapshot_IsSaved())
+	{
+		Sim_TestFail("snapshot after a power cycle", 0);
+	}
+}
+
+/*****************************************************************************
+ * @brief The snapshot time kept for the next boot is read once and is not
+ *        touched by the snapshot itself.
+ *****************************************************************************/
+static void testCycles(void)
+{
+	const Snapshot_t saved =
+	{
+		.state = { PomodoroFunctions_PomodoroMode, SessionRun_Running, 1234U, 2U, 0U },
+		.profile = 0U,
+		.reason = SnapshotReason_PowerFail,
+	};
+	Snapshot_t loaded;
+
+	if(snapshot_TakeCycles() != 0U)
+	{
+		Sim_TestFail("snapshot time at power-up", 0);
+	}
+	snapshot_Save(&saved);
+	snapshot_SetCycles(321U);
+	if((snapshot_Load(&loaded) == false) || (testSame(&saved, &loaded) == false))
+	{
+		Sim_TestFail("snapshot after its time", 0);
+	}
+	snapshot_Clear();
+	uint32_t cycles = snapshot_TakeCycles();
+	if(cycles != 321U)
+	{
+		Sim_TestFail("snapshot time", cycles);
+	}
+	if(snapshot_TakeCycles() != 0U)
+	{
+		Sim_TestFail("snapshot time read twice", 0);
+	}
+}
+
+/*****************************************************************************/
+/* Main                                                                      */
+/*****************************************************************************/
+int main(void)
+{
+	Sim_BackupPowerCycle();
+	if(snapshot_IsSaved())
+	{
+		Sim_TestFail("snapshot at power-up", 0);
+	}
+	testFillOthers();
+
+	testRoundTrip();
+	testCorruption();
+	testPowerCut();
+	testClear();
+	Sim_BackupPowerCycle();
+	testCycles();
+	testFillOthers();
+	testRoundTrip();
+	testCheckOthers();
+
+	printf("snapshot    %lu states restored, %lu broken snapshots rejected, %lu backup writes\n",
+			(unsigned long)teststates, (unsigned long)testrejected, (unsigned long)Sim_BackupGetWrites());
+	return Sim_TestResult();
+}
+/*************************************END*************************************/
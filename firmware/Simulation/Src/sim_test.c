@@ -0,0 +1,102 @@
+/**
+ * \file           sim_test.c
+ * \brief          Host test check counting and random numbers
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include <stdarg.h>
+#include <stdio.h>
+#include "sim_test.h"
+
+/*****************************************************************************/
+/* Private Defines                                                           */
+/*****************************************************************************/
+#define SIM_TEST_PRINTED           10U      /** Failed checks printed, the rest only counted **/
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static uint32_t simtestfailures = 0; /** Checks that failed **/
+
+static uint32_t simtestseed = 1; /** xorshift state **/
+
+/*****************************************************************************/
+/* Test Functions                                                            */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Records a failed check.
+ *****************************************************************************/
+void Sim_TestFail(const char *what, unsigned long value)
+{
+	Sim_TestFailf("%s (%lu)", what, value);
+}
+/*****************************************************************************
+ * @brief Records a failed check with a formatted message.
+ *****************************************************************************/
+void Sim_TestFailf(const char *format, ...)
+{
+	va_list args;
+
+	if(simtestfailures++ < SIM_TEST_PRINTED)
+	{
+		va_start(args, format);
+		fputs("FAIL ", stderr);
+		vfprintf(stderr, format, args);
+		fputc('\n', stderr);
+		va_end(args);
+	}
+}
+/*****************************************************************************
+ * @brief Sets the xorshift32 state.
+ *****************************************************************************/
+void Sim_TestSeed(uint32_t seed)
+{
+	simtestseed = seed;
+}
+/*****************************************************************************
+ * @brief Xorshift32 step.
+ *****************************************************************************/
+uint32_t Sim_TestRandom(void)
+{
+	simtestseed ^= simtestseed << 13;
+	simtestseed ^= simtestseed >> 17;
+	simtestseed ^= simtestseed << 5;
+	return simtestseed;
+}
+/*****************************************************************************
+ * @brief Prints the result line.
+ *****************************************************************************/
+int Sim_TestResult(void)
+{
+	printf("%s: %lu failed check(s)\n", (simtestfailures == 0U) ? "PASS" : "FAIL", (unsigned long)simtestfailures);
+	return (simtestfailures == 0U) ? 0 : 1;
+}
+/*************************************END*************************************/
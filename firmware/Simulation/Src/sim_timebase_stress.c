@@ -0,0 +1,187 @@
+/**
+ * \file           sim_timebase_stress.c
+ * \brief          Host stress test of the lock-free time base
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include <pthread.h>
+#include <stdlib.h>
+#include "sim.h"
+#include "timebase.h"
+
+/*****************************************************************************/
+/* Private Defines                                                           */
+/*****************************************************************************/
+#define STRESS_ROUNDS              200000U      /** Seconds per phase **/
+#define STRESS_SPIN                128U         /** Busy loop between two seconds, lets the reader overlap **/
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static volatile bool stressdone = false; /** Writer finished the phase **/
+
+static uint32_t stressfailures = 0; /** Checks that failed **/
+
+/*****************************************************************************/
+/* Platform Hooks                                                            */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Not reached, the time base does not report errors.
+ *****************************************************************************/
+void Error_Handler(void)
+{
+	exit(2);
+}
+
+/*****************************************************************************/
+/* Stress Threads                                                            */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Plays the TIM3/RTC interrupt.
+ *
+ * @details Counts STRESS_ROUNDS seconds with a short spin between two, so
+ *          the reader resets and consumes between and during increments.
+ *
+ * @param[in] argument  Unused.
+ *
+ * @return void* NULL
+ *****************************************************************************/
+static void *stressInterrupts(void *argument)
+{
+	(void)argument;
+
+	for(uint32_t round = 0; round < STRESS_ROUNDS; round++)
+	{
+		for(volatile uint32_t spin = 0; spin < STRESS_SPIN; spin++)
+		{
+		}
+		timeBase_SecondTickFromISR();
+	}
+	__atomic_store_n(&stressdone, true, __ATOMIC_SEQ_CST);
+	return NULL;
+}
+/*****************************************************************************
+ * @brief Reports a failed check, the first few only.
+ *****************************************************************************/
+static void stressFail(const char *what, uint64_t value, uint64_t previous)
+{
+	if(stressfailures < 10U)
+	{
+		fprintf(stderr, "FAIL %s: 0x%016llx after 0x%016llx\n", what,
+				(unsigned long long)value, (unsigned long long)previous);
+	}
+	stressfailures++;
+}
+/*****************************************************************************
+ * @brief Runs one phase: the interrupt thread against the main loop reader.
+ *
+ * @details With consume set the reader takes the elapsed seconds off with
+ *          timeBase_ConsumeSeconds() and checks that not a single second
+ *          got lost; otherwise it restarts them with
+ *          timeBase_ResetSeconds() and checks that the count after a reset
+ *          never goes backwards or underflows.
+ *
+ * @param[in] consume  Use timeBase_ConsumeSeconds() instead of timeBase_ResetSeconds().
+ *
+ * @return None
+ *****************************************************************************/
+static void stressPhase(bool consume)
+{
+	pthread_t thread;
+	uint32_t lastseconds = 0;
+	uint64_t consumed = 0;
+	uint64_t reads = 0;
+	uint32_t resets = 0;
+
+	timeBase_Init();
+	stressdone = false;
+	if(pthread_create(&thread, NULL, stressInterrupts, NULL) != 0)
+	{
+		fprintf(stderr, "pthread_create failed\n");
+		exit(2);
+	}
+
+	while(__atomic_load_n(&stressdone, __ATOMIC_SEQ_CST) == false)
+	{
+		uint32_t seconds = timeBase_GetSeconds();
+		if((seconds < lastseconds) || (seconds > STRESS_ROUNDS))
+		{
+			stressFail(consume ? "seconds (consume)" : "seconds (reset)", seconds, lastseconds);
+		}
+		lastseconds = seconds;
+
+		if((++reads % 1000U) == 0U)
+		{
+			if(consume)
+			{
+				timeBase_ConsumeSeconds(seconds);
+				consumed += seconds;
+			}
+			else
+			{
+				timeBase_ResetSeconds();
+			}
+			lastseconds = 0;
+			resets++;
+		}
+	}
+	pthread_join(thread, NULL);
+
+	if(consume && ((consumed + timeBase_GetSeconds()) != STRESS_ROUNDS))
+	{
+		stressFail("lost seconds", consumed + timeBase_GetSeconds(), STRESS_ROUNDS);
+	}
+
+	printf("%-8s %lu seconds, %llu concurrent reads, %lu %s\n", consume ? "consume" : "reset",
+			(unsigned long)STRESS_ROUNDS, (unsigned long long)reads, (unsigned long)resets,
+			consume ? "consumes" : "resets");
+}
+
+/*****************************************************************************/
+/* Main Function                                                             */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Stress test entry point.
+ *
+ * @details The time base is compiled unchanged; the interrupts run on a
+ *          second thread so reads, resets and increments really overlap.
+ *
+ * @return int 0 if every check passed.
+ *****************************************************************************/
+int main(void)
+{
+	stressPhase(true);
+	stressPhase(false);
+
+	printf("%s: %lu failed check(s)\n", (stressfailures == 0U) ? "PASS" : "FAIL", (unsigned long)stressfailures);
+	return (stressfailures == 0U) ? 0 : 1;
+}
+/*************************************END*************************************/
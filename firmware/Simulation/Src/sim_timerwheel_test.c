@@ -0,0 +1,337 @@
+/**
+ * \file           sim_timerwheel_test.c
+ * \brief          Host test and benchmark of the timer wheel
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include <stdio.h>
+#include <time.h>
+#include "timerwheel.h"
+#include "sim_test.h"
+
+/*****************************************************************************/
+/* Private Defines                                                           */
+/*****************************************************************************/
+#define TEST_TIMERS                4096U        /** Timers of the random test **/
+#define TEST_STEPS                 400000U      /** Wakes and thread operations of the random test **/
+#define TEST_COMPARE_TICKS         0x7FFFU      /** Furthest compare, as HWTIMER_MAX_COMPARE_TICKS **/
+#define TEST_MAX_DELAY             (TIMERWHEEL_MAX_TICKS - TEST_COMPARE_TICKS) /** Longest delay started, never clamped **/
+#define BENCH_MAX_TIMERS           65536U       /** Largest benchmark **/
+
+/*****************************************************************************/
+/* Private Types                                                             */
+/*****************************************************************************/
+/**
+ * @brief One timer of the test with the reference model of its expiries.
+ */
+typedef struct
+{
+	TimerWheelTimer_t timer;         /**< Wheel timer, first so the callback finds the rest */
+	uint32_t expected;               /**< Tick of the next expiry */
+	uint32_t period;                 /**< Reload, 0 = one-shot */
+	bool running;                    /**< Started, not stopped or expired */
+}TestTimer_t;
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static TimerWheel_t testwheel; /** Wheel under test **/
+
+static TestTimer_t testtimers[TEST_TIMERS]; /** Timers of the random test **/
+
+static uint32_t testnow = 0; /** Tick of the "hardware" counter **/
+
+static uint32_t testrunning = 0; /** Timers the model expects queued **/
+
+static uint32_t testexpiries = 0; /** Callbacks **/
+
+static uint32_t testwakes = 0; /** Compare interrupts **/
+
+static TimerWheelTimer_t benchtimers[BENCH_MAX_TIMERS]; /** Timers of the benchmark **/
+
+static uint32_t benchexpiries = 0; /** Callbacks of the benchmark **/
+
+/*****************************************************************************/
+/* Helpers                                                                   */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Random delay spread evenly over the bit lengths, so every level
+ *        gets timers.
+ *****************************************************************************/
+static uint32_t testDelay(uint32_t limit)
+{
+	uint32_t bits = 1U + (Sim_TestRandom() % 24U);
+	uint32_t delay = 1U + (Sim_TestRandom() & ((1UL << bits) - 1UL));
+
+	return (delay > limit) ? limit : delay;
+}
+/*****************************************************************************
+ * @brief Monotonic wall clock in nanoseconds.
+ *****************************************************************************/
+static uint64_t testClock(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+/*****************************************************************************/
+/* Random Test                                                               */
+/*****************************************************************************/
+static void testExpired(TimerWheelTimer_t *timer);
+
+/*****************************************************************************
+ * @brief Starts a timer at the current counter tick and notes its expiry.
+ *****************************************************************************/
+static void testStart(TestTimer_t *test)
+{
+	uint32_t delay = testDelay(TEST_MAX_DELAY);
+	uint32_t period = ((Sim_TestRandom() % 4U) == 0U) ? testDelay(1UL << 16) : 0U;
+
+	if(test->running == false)
+	{
+		testrunning++;
+	}
+	TimerWheel_Start(&testwheel, &test->timer, testnow, delay, period, testExpired);
+	test->expected = testnow + delay;
+	test->period = period;
+	test->running = true;
+}
+/*****************************************************************************
+ * @brief Stops a timer.
+ *****************************************************************************/
+static void testStop(TestTimer_t *test)
+{
+	if(test->running)
+	{
+		testrunning--;
+	}
+	TimerWheel_Stop(&testwheel, &test->timer);
+	test->running = false;
+}
+/*****************************************************************************
+ * @brief Expiry callback: checks the tick against the model, then starts
+ *        or stops another timer now and then, possibly one due in the same
+ *        tick.
+ *****************************************************************************/
+static void testExpired(TimerWheelTimer_t *timer)
+{
+	TestTimer_t *test = (TestTimer_t *)timer;
+
+	testexpiries++;
+	if(test->running == false)
+	{
+		Sim_TestFail("stopped timer expired", (unsigned long)(test - testtimers));
+		return;
+	}
+	if(testwheel.now != test->expected)
+	{
+		Sim_TestFail("expiry off by ticks", (unsigned long)(testwheel.now - test->expected));
+	}
+	if((int32_t)(testnow - testwheel.now) < 0)
+	{
+		Sim_TestFail("expiry in the future", (unsigned long)(testwheel.now - testnow));
+	}
+	if(test->period != 0U)
+	{
+		test->expected += test->period;
+	}
+	else
+	{
+		test->running = false;
+		testrunning--;
+	}
+	if(TimerWheel_IsRunning(timer) != test->running)
+	{
+		Sim_TestFail("running state after the expiry", (unsigned long)(test - testtimers));
+	}
+
+	switch(Sim_TestRandom() % 8U)
+	{
+	case 0:
+		testStart(&testtimers[Sim_TestRandom() % TEST_TIMERS]);
+		break;
+	case 1:
+		testStop(&testtimers[Sim_TestRandom() % TEST_TIMERS]);
+		break;
+	default:
+		break;
+	}
+}
+/*****************************************************************************
+ * @brief Runs the wheel like the TIM4 driver: compare interrupts at the
+ *        next event, limited to TEST_COMPARE_TICKS ahead and sometimes a
+ *        few ticks late, with thread context starts and stops between them.
+ *        Every expiry must come at exactly its tick, once, and none may be
+ *        missed.
+ *****************************************************************************/
+static void testRandomWheel(void)
+{
+	uint32_t at;
+
+	TimerWheel_Init(&testwheel, testnow);
+	for(uint32_t i = 0; i < TEST_TIMERS; i++)
+	{
+		testStart(&testtimers[i]);
+	}
+
+	for(uint32_t step = 0; step < TEST_STEPS; step++)
+	{
+		bool pending = TimerWheel_NextEvent(&testwheel, &at);
+		if((Sim_TestRandom() % 10U) < 7U)
+		{
+			if(pending == false)
+			{
+				testnow += 1U + (Sim_TestRandom() % 1000U);
+			}
+			else if((at - testnow) > TEST_COMPARE_TICKS)
+			{
+				testnow += TEST_COMPARE_TICKS;
+			}
+			else
+			{
+				testnow = at + (((Sim_TestRandom() % 16U) == 0U) ? (Sim_TestRandom() % 4U) : 0U);
+			}
+			testwakes++;
+			TimerWheel_Advance(&testwheel, testnow);
+		}
+		else
+		{
+			if(pending && ((at - testnow) > 64U) && ((at - testnow) <= TEST_COMPARE_TICKS))
+			{
+				testnow += Sim_TestRandom() % 64U; /** Time passes in thread context **/
+			}
+			TestTimer_t *test = &testtimers[Sim_TestRandom() % TEST_TIMERS];
+			if((Sim_TestRandom() % 3U) == 0U)
+			{
+				testStop(test);
+			}
+			else
+			{
+				testStart(test);
+			}
+		}
+		if(TimerWheel_GetCount(&testwheel) != testrunning)
+		{
+			Sim_TestFail("queued timers", TimerWheel_GetCount(&testwheel));
+			break;
+		}
+	}
+
+	/* Nothing due may be left behind */
+	for(uint32_t i = 0; i < TEST_TIMERS; i++)
+	{
+		if(testtimers[i].running && ((int32_t)(testtimers[i].expected - testwheel.now) <= 0))
+		{
+			Sim_TestFail("missed expiry", i);
+		}
+	}
+}
+
+/*****************************************************************************/
+/* Benchmark                                                                 */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Expiry callback of the benchmark.
+ *****************************************************************************/
+static void benchExpired(TimerWheelTimer_t *timer)
+{
+	(void)timer;
+	benchexpiries++;
+}
+/*****************************************************************************
+ * @brief Starts count timers spread over 2^20 ticks, stops every other
+ *        one and runs the rest to expiry from compare interrupt to compare
+ *        interrupt; prints the time per operation and the interrupts per
+ *        expiry.
+ *****************************************************************************/
+static void benchWheel(uint32_t count)
+{
+	uint32_t at;
+	uint32_t wakes = 0;
+
+	Sim_TestSeed(0x9E3779B9U ^ count);
+	benchexpiries = 0;
+	for(uint32_t i = 0; i < count; i++)
+	{
+		benchtimers[i].pprev = NULL;
+	}
+	TimerWheel_Init(&testwheel, 0U);
+
+	uint64_t t0 = testClock();
+	for(uint32_t i = 0; i < count; i++)
+	{
+		TimerWheel_Start(&testwheel, &benchtimers[i], 0U, testDelay(1UL << 20), 0U, benchExpired);
+	}
+	uint64_t t1 = testClock();
+	for(uint32_t i = 0; i < count; i += 2U)
+	{
+		TimerWheel_Stop(&testwheel, &benchtimers[i]);
+	}
+	uint64_t t2 = testClock();
+	while(TimerWheel_NextEvent(&testwheel, &at))
+	{
+		wakes++;
+		TimerWheel_Advance(&testwheel, at);
+	}
+	uint64_t t3 = testClock();
+
+	uint32_t started = count;
+	uint32_t stopped = (count + 1U) / 2U;
+	if(benchexpiries != (started - stopped))
+	{
+		Sim_TestFail("benchmark expiries", benchexpiries);
+	}
+	printf("%-8lu %9.1f %9.1f %9.1f %13.2f\n", (unsigned long)count,
+			(double)(t1 - t0) / started, (double)(t2 - t1) / stopped,
+			(double)(t3 - t2) / benchexpiries, (double)wakes / benchexpiries);
+}
+
+/*****************************************************************************/
+/* Main                                                                      */
+/*****************************************************************************/
+int main(void)
+{
+	Sim_TestSeed(0x2545F491U);
+	testRandomWheel();
+	printf("timerwheel  %lu timers, %lu expiries at their tick, %lu compare interrupts\n",
+			(unsigned long)TEST_TIMERS, (unsigned long)testexpiries, (unsigned long)testwakes);
+
+	printf("timers   start ns   stop ns expiry ns  wakes/expiry\n");
+	for(uint32_t count = 1024U; count <= BENCH_MAX_TIMERS; count *= 4U)
+	{
+		benchWheel(count);
+	}
+
+	return Sim_TestResult();
+}
+/*************************************END*************************************/
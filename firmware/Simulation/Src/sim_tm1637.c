@@ -0,0 +1,267 @@
+/**
+ * \file           sim_tm1637.c
+ * \brief          Host simulation TM1637 pin decoder source file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "sim.h"
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static const uint8_t simdigitpattern[] = { 0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F }; /** 0 ... 9 **/
+
+static bool simclk = true; /** Last CLK level **/
+static bool simdio = true; /** Last DIO level **/
+
+static bool siminframe = false; /** Between a start and a stop condition **/
+static uint8_t simbit = 0; /** Clock count inside the current byte, 8 = ACK clock **/
+static uint8_t simshift = 0; /** Byte being received, LSB first **/
+static uint8_t simframe[TM1637_BUS_MAX_BYTES]; /** Bytes of the current frame **/
+static uint8_t simframelength = 0; /** Number of bytes in simframe **/
+
+static bool simfixedaddress = false; /** Last data command selected fixed addressing **/
+static uint8_t simdisplay[MAX_NO_OF_CHARACTERS]; /** Segment registers of the TM1637 **/
+static uint8_t simwritten = 0; /** Bit per digit register written **/
+static uint8_t simcontrol = 0; /** Last display control command **/
+
+static bool simbuzzeron = false; /** Buzzer currently sounding **/
+static uint64_t simbuzzersince = 0; /** Virtual time the buzzer was switched on **/
+
+/*****************************************************************************/
+/* TM1637 Decoder                                                            */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Executes one complete frame.
+ *
+ * @details 0x40 data command (bit 2 = fixed address), 0xC0 | address
+ *          followed by segment data, 0x80 display control.
+ *
+ * @param None
+ *
+ * @return None
+ *****************************************************************************/
+static void simFrame(void)
+{
+	SimStats_t *stats = Sim_GetStats();
+	uint8_t command = simframe[0];
+
+	stats->busFrames++;
+	stats->busBytes += simframelength;
+
+	switch(command & 0xC0U)
+	{
+		case DATA_COMMAND:
+			simfixedaddress = ((command & FIX_ADDRESS) != 0U);
+			if(simframelength != 1U)
+			{
+				stats->busErrors++;
+			}
+			break;
+		case DISPLAY_1_REGISTER_ADDRESS:
+		{
+			uint8_t address = (uint8_t)(command & 0x0FU);
+			if((simfixedaddress && (simframelength != 2U)) || (simframelength < 2U))
+			{
+				stats->busErrors++;
+			}
+			for(uint8_t b = 1; b < simframelength; b++)
+			{
+				if(address >= MAX_NO_OF_CHARACTERS)
+				{
+					stats->busErrors++;
+					break;
+				}
+				simdisplay[address] = simframe[b];
+				simwritten |= (uint8_t)(1U << address);
+				if(simfixedaddress == false)
+				{
+					address++;
+				}
+			}
+			break;
+		}
+		case DISPLAY_COMMAND:
+			simcontrol = command;
+			if(simframelength != 1U)
+			{
+				stats->busErrors++;
+			}
+			break;
+		default:
+			stats->busErrors++;
+			break;
+	}
+}
+/*****************************************************************************
+ * @brief Samples the bus after a write to CLK or DIO.
+ *
+ * @details Start = DIO falls while CLK is high, stop = DIO rises while CLK
+ *          is high. Data bits are taken on the CLK rising edge, LSB first,
+ *          the ninth clock is the ACK. The clock the driver gives inside the
+ *          stop sequence leaves a partial byte, which is dropped.
+ *
+ * @param[in] clk  CLK level.
+ * @param[in] dio  DIO level.
+ *
+ * @return None
+ *****************************************************************************/
+void Sim_Tm1637Sample(bool clk, bool dio)
+{
+	if(clk && simclk && simdio && (dio == false))
+	{
+		siminframe = true;
+		simbit = 0;
+		simshift = 0;
+		simframelength = 0;
+	}
+	else if(clk && simclk && (simdio == false) && dio)
+	{
+		if(siminframe && (simframelength > 0U))
+		{
+			simFrame();
+		}
+		siminframe = false;
+	}
+	else if(siminframe && clk && (simclk == false))
+	{
+		if(simbit < 8U)
+		{
+			simshift |= (uint8_t)((dio ? 1U : 0U) << simbit);
+			simbit++;
+		}
+		else
+		{
+			if(simframelength < sizeof(simframe))
+			{
+				simframe[simframelength++] = simshift;
+			}
+			else
+			{
+				Sim_GetStats()->busErrors++;
+			}
+			simbit = 0;
+			simshift = 0;
+		}
+	}
+
+	simclk = clk;
+	simdio = dio;
+}
+/*****************************************************************************
+ * @brief Renders the digits currently shown as "MM:SS".
+ *
+ * @param[out] text  At least 6 characters, '?' for an unknown pattern.
+ *
+ * @return bool
+ *
+ * @retval true   The colon is lit.
+ * @retval false  The colon is dark.
+ *****************************************************************************/
+bool Sim_Tm1637Text(char *text)
+{
+	uint8_t t = 0;
+
+	for(uint8_t i = 0; i < NO_OF_DISPLAY_DIGITS; i++)
+	{
+		uint8_t segments = (uint8_t)(simdisplay[i] & 0x7FU);
+		char c = '?';
+		for(uint8_t d = 0; d < sizeof(simdigitpattern); d++)
+		{
+			if(simdigitpattern[d] == segments)
+			{
+				c = (char)('0' + d);
+			}
+		}
+		if(segments == 0x40U)
+		{
+			c = '-';
+		}
+		text[t++] = c;
+		if(i == TM1637_COLON_DIGIT)
+		{
+			text[t++] = ':';
+		}
+	}
+	text[t] = '\0';
+
+	return ((simdisplay[TM1637_COLON_DIGIT] & 0x80U) != 0U);
+}
+/*****************************************************************************
+ * @brief Returns true once all four digits were written.
+ *
+ * @param None
+ *
+ * @return bool
+ *****************************************************************************/
+bool Sim_Tm1637IsValid(void)
+{
+	return ((simwritten & 0x0FU) == 0x0FU);
+}
+/*****************************************************************************
+ * @brief Returns true if the last display control switched the display on.
+ *
+ * @param None
+ *
+ * @return bool
+ *****************************************************************************/
+bool Sim_Tm1637IsOn(void)
+{
+	return ((simcontrol & DISPLAY_ON) != 0U);
+}
+
+/*****************************************************************************/
+/* Buzzer Probe                                                              */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Samples the buzzer pin (PB9, active low).
+ *
+ * @param[in] level  Pin level.
+ *
+ * @return None
+ *****************************************************************************/
+void Sim_BuzzerSample(bool level)
+{
+	SimStats_t *stats = Sim_GetStats();
+	bool on = (level == false);
+
+	if(on && (simbuzzeron == false))
+	{
+		stats->beeps++;
+		simbuzzersince = Sim_Now();
+	}
+	else if((on == false) && simbuzzeron)
+	{
+		stats->beepOnUs += Sim_Now() - simbuzzersince;
+	}
+	simbuzzeron = on;
+}
+/*************************************END*************************************/
@@ -0,0 +1,299 @@
+/**
+ * \file           sim_tm1637bus_test.c
+ * \brief          Host test of the TM1637 DMA bus waveform encoder
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "TM1637.h"
+#include "sim_test.h"
+
+/*****************************************************************************/
+/* Private Defines                                                           */
+/*****************************************************************************/
+#define TEST_PINS                  ((uint32_t)TM1637_CLK_PIN | TM1637_DIO_PIN)
+#define TEST_MAX_BYTES             TM1637_BUS_MAX_BYTES
+#define TEST_SENTINEL              0xA5A5A5A5U  /** Table word never written **/
+
+/*****************************************************************************/
+/* Private Types                                                             */
+/*****************************************************************************/
+/**
+ * @brief Bytes and conditions decoded from a waveform.
+ */
+typedef struct
+{
+	uint8_t bytes[TEST_MAX_BYTES];   /**< Bytes of all transfers, back to back */
+	uint8_t lengths[TM1637_BUS_MAX_TRANSFERS]; /**< Bytes per transfer */
+	uint8_t transfers;               /**< Start ... stop sequences */
+	uint8_t count;                   /**< Bytes decoded */
+	uint32_t errors;                 /**< Protocol violations */
+}TestDecode_t;
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static uint32_t testtable[TM1637_BUS_TABLE_SIZE + 1U]; /** Waveform, one word past the end as a guard **/
+
+/*****************************************************************************/
+/* Helpers                                                                   */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Records a protocol violation of the decoder.
+ *****************************************************************************/
+static void testViolation(TestDecode_t *decode, const char *what, uint32_t word)
+{
+	decode->errors++;
+	Sim_TestFail(what, word);
+}
+/*****************************************************************************
+ * @brief Decodes a BSRR waveform as the TM1637 sees it.
+ *
+ * @details Every word must set or reset each line and touch nothing else.
+ *          The lines start idle (both high). Start = DIO falls while CLK is
+ *          high, stop = DIO rises while CLK is high; any other DIO change
+ *          has to happen with CLK low. Bits are sampled on the CLK rising
+ *          edge, LSB first; the ninth clock of each byte is the ACK slot,
+ *          where DIO must be low (driven low, or released to the TM1637
+ *          pulling it low). The stop sequence gives one more clock with
+ *          DIO low, which must be the only one after the last ACK; it is
+ *          taken as the first bit of a byte that the stop then drops.
+ *****************************************************************************/
+static void testDecode(const uint32_t *table, uint16_t words, TestDecode_t *decode)
+{
+	bool clk = true;
+	bool dio = true;
+	bool inframe = false;
+	uint8_t clocks = 0;
+	uint8_t shift = 0;
+
+	memset(decode, 0, sizeof(*decode));
+	for(uint16_t w = 0; w < words; w++)
+	{
+		uint32_t word = table[w];
+		uint32_t set = word & 0xFFFFU;
+		uint32_t reset = word >> 16U;
+		if(((set | reset) != TEST_PINS) || ((set & reset) != 0U))
+		{
+			testViolation(decode, "word does not define exactly CLK and DIO", w);
+			continue;
+		}
+		bool nclk = ((set & TM1637_CLK_PIN) != 0U);
+		bool ndio = ((set & TM1637_DIO_PIN) != 0U);
+
+		if(clk && nclk && (dio != ndio))
+		{
+			if(dio && (ndio == false))
+			{
+				if(inframe)
+				{
+					testViolation(decode, "start inside a transfer", w);
+				}
+				inframe = true;
+				clocks = 0;
+				shift = 0;
+				if(decode->transfers < TM1637_BUS_MAX_TRANSFERS)
+				{
+					decode->lengths[decode->transfers] = 0;
+				}
+			}
+			else
+			{
+				if((inframe == false) || (clocks != 1U) || (shift != 0U))
+				{
+					testViolation(decode, "stop without a whole number of bytes", w);
+				}
+				inframe = false;
+				decode->transfers++;
+			}
+		}
+		else if((clk == false) && nclk)
+		{
+			if(inframe == false)
+			{
+				testViolation(decode, "clock outside a transfer", w);
+			}
+			else if(clocks < 8U)
+			{
+				shift |= (uint8_t)((ndio ? 1U : 0U) << clocks);
+				clocks++;
+			}
+			else if(clocks == 8U)
+			{
+				if(ndio)
+				{
+					testViolation(decode, "DIO high in the ACK slot", w);
+				}
+				if((decode->count < TEST_MAX_BYTES) && (decode->transfers < TM1637_BUS_MAX_TRANSFERS))
+				{
+					decode->bytes[decode->count++] = shift;
+					decode->lengths[decode->transfers]++;
+				}
+				clocks = 0;
+				shift = 0;
+			}
+		}
+		clk = nclk;
+		dio = ndio;
+	}
+	if(inframe || (clk == false) || (dio == false))
+	{
+		testViolation(decode, "bus not idle at the end", words);
+	}
+}
+
+/*****************************************************************************/
+/* Tests                                                                     */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Encodes transfers, checks the word count and decodes them back.
+ *****************************************************************************/
+static void testFrame(const TM1637_Transfer_t *transfers, uint8_t count, const char *name)
+{
+	uint32_t expected = 0;
+	uint8_t bytes[TEST_MAX_BYTES];
+	uint8_t used = 0;
+
+	for(uint8_t t = 0; t < count; t++)
+	{
+		expected += TM1637_BUS_START_WORDS + TM1637_BUS_STOP_WORDS + ((uint32_t)transfers[t].length * TM1637_BUS_BYTE_WORDS);
+		memcpy(&bytes[used], transfers[t].data, transfers[t].length);
+		used = (uint8_t)(used + transfers[t].length);
+	}
+
+	for(uint32_t w = 0; w < (sizeof(testtable) / sizeof(testtable[0])); w++)
+	{
+		testtable[w] = TEST_SENTINEL;
+	}
+	uint16_t words = TM1637_Bus_Encode(transfers, count, testtable, TM1637_BUS_TABLE_SIZE);
+	if(words != expected)
+	{
+		Sim_TestFail(name, words);
+		return;
+	}
+	if(testtable[words] != TEST_SENTINEL)
+	{
+		Sim_TestFail("word written past the frame", words);
+	}
+
+	TestDecode_t decode;
+	testDecode(testtable, words, &decode);
+	if((decode.errors != 0U) || (decode.transfers != count) || (decode.count != used) ||
+	   (memcmp(decode.bytes, bytes, used) != 0))
+	{
+		Sim_TestFail(name, decode.errors);
+	}
+	for(uint8_t t = 0; (t < count) && (t < decode.transfers); t++)
+	{
+		if(decode.lengths[t] != transfers[t].length)
+		{
+			Sim_TestFail("transfer length", t);
+		}
+	}
+}
+/*****************************************************************************
+ * @brief A full display update: data command, address with the four
+ *        digits and the display control, as TM1637_Update_Data_Dots()
+ *        sends it.
+ *****************************************************************************/
+static void testDisplayFrame(void)
+{
+	static const uint8_t command[] = { DATA_COMMAND | WRITE_DATA_TO_DISPLAY | AUTOMATIC_ADDRESS_ADD | NORMAL_MODE };
+	static const uint8_t digits[] = { DISPLAY_1_REGISTER_ADDRESS, 0x3FU, 0x86U, 0x5BU, 0x4FU }; /** 0 1. 2 3 **/
+	static const uint8_t control[] = { DISPLAY_COMMAND | PULSE_WIDTH_SET_04_16 | DISPLAY_ON };
+	const TM1637_Transfer_t frame[] =
+	{
+		{ command, sizeof(command) },
+		{ digits, sizeof(digits) },
+		{ control, sizeof(control) },
+	};
+
+	testFrame(frame, 3U, "display frame");
+}
+/*****************************************************************************
+ * @brief Every byte value on its own, LSB first.
+ *****************************************************************************/
+static void testEveryByte(void)
+{
+	for(uint32_t value = 0; value < 256U; value++)
+	{
+		uint8_t byte = (uint8_t)value;
+		const TM1637_Transfer_t transfer = { &byte, 1U };
+		testFrame(&transfer, 1U, "byte value");
+	}
+}
+/*****************************************************************************
+ * @brief The largest frame fits, one word less is refused untouched.
+ *****************************************************************************/
+static void testTableSize(void)
+{
+	static uint8_t bytes[TEST_MAX_BYTES];
+	TM1637_Transfer_t transfers[TM1637_BUS_MAX_TRANSFERS];
+
+	for(uint8_t b = 0; b < TEST_MAX_BYTES; b++)
+	{
+		bytes[b] = (uint8_t)((b * 37U) + 1U);
+	}
+	for(uint8_t t = 0; t < TM1637_BUS_MAX_TRANSFERS; t++)
+	{
+		transfers[t].data = &bytes[2U * t];
+		transfers[t].length = 2U;
+	}
+	testFrame(transfers, TM1637_BUS_MAX_TRANSFERS, "largest frame");
+
+	testtable[0] = TEST_SENTINEL;
+	if((TM1637_Bus_Encode(transfers, TM1637_BUS_MAX_TRANSFERS, testtable, TM1637_BUS_TABLE_SIZE - 1U) != 0U) ||
+	   (testtable[0] != TEST_SENTINEL))
+	{
+		Sim_TestFail("frame larger than the table", 0);
+	}
+	if(TM1637_Bus_Encode(transfers, 0U, testtable, TM1637_BUS_TABLE_SIZE) != 0U)
+	{
+		Sim_TestFail("empty frame", 0);
+	}
+}
+
+/*****************************************************************************/
+/* Main                                                                      */
+/*****************************************************************************/
+int main(void)
+{
+	testDisplayFrame();
+	testEveryByte();
+	testTableSize();
+
+	printf("tm1637bus   %u words for a display frame, %u per byte, %u transfers at most\n",
+			(unsigned)(3U * (TM1637_BUS_START_WORDS + TM1637_BUS_STOP_WORDS) + (7U * TM1637_BUS_BYTE_WORDS)),
+			(unsigned)TM1637_BUS_BYTE_WORDS, (unsigned)TM1637_BUS_MAX_TRANSFERS);
+	return Sim_TestResult();
+}
+/*************************************END*************************************/
@@ -0,0 +1,191 @@
+/**
+ * \file           sim_tokenlog_test.c
+ * \brief          Host capture of TOKEN_LOG() frames for the decoder round trip test
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tokenlog.h"    /** Not main.h, this file provides stdUtil_write() **/
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static FILE *capture;           /** Bytes as the UART would send them **/
+static FILE *expected;          /** Text the decoder has to print **/
+static bool corruptNext;        /** Damage the checksum of the next frame **/
+static uint32_t frames;         /** Frames written **/
+static uint32_t frameBytes;     /** Bytes of all frames **/
+static uint32_t frameLongest;   /** Longest frame **/
+static uint32_t textBytes;      /** Bytes the same lines take formatted **/
+
+static const char testName[] = "focus";
+
+/*****************************************************************************/
+/* Platform Overrides                                                        */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Debug output of the test, writes the capture file.
+ *
+ * @details A frame marked by corruptNext gets a wrong checksum. The decoder
+ *          then passes its bytes through as text, so their printable part
+ *          is what it has to print in place of the line.
+ *
+ * @param[in] data    Bytes.
+ * @param[in] length  Number of bytes.
+ *
+ * @return None
+ *****************************************************************************/
+void stdUtil_write(const char *data, uint32_t length)
+{
+	unsigned char bytes[256];
+
+	memcpy(bytes, data, length);
+	if(bytes[0] == TOKENLOG_SYNC)
+	{
+		frames++;
+		frameBytes += length;
+		frameLongest = (length > frameLongest) ? length : frameLongest;
+	}
+	if(corruptNext)
+	{
+		corruptNext = false;
+		bytes[length - 1U] ^= 0x01U;
+		for(uint32_t i = 0; i < length; i++)
+		{
+			if((bytes[i] == '\t') || (bytes[i] == '\n') || ((bytes[i] >= 0x20U) && (bytes[i] < 0x7FU)))
+			{
+				fputc(bytes[i], expected);
+			}
+		}
+	}
+	fwrite(bytes, 1, length, capture);
+}
+
+/*****************************************************************************/
+/* Private Functions                                                         */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Adds the host printf() of a line to the expected text.
+ *
+ * @details Carriage returns are left out, the decoder strips them.
+ *
+ * @param[in] format  printf format.
+ * @param[in] ...     Arguments with their host types.
+ *
+ * @return None
+ *****************************************************************************/
+static void testExpect(const char *format, ...)
+{
+	char line[256];
+	va_list args;
+	int length;
+
+	va_start(args, format);
+	length = vsnprintf(line, sizeof(line), format, args);
+	va_end(args);
+	textBytes += (uint32_t)length;
+	for(int i = 0; i < length; i++)
+	{
+		if(line[i] != '\r')
+		{
+			fputc(line[i], expected);
+		}
+	}
+}
+
+/*****************************************************************************/
+/* Test Entry                                                                */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Writes a capture and the text the decoder must make of it.
+ *
+ * @details Usage: tokenlog-test capture.bin expected.txt
+ *          The Makefile decodes the capture with Tools/tokenlog_decode.py
+ *          and this executable, then compares with expected.txt.
+ *
+ * @return int 0 when both files are written.
+ *****************************************************************************/
+int main(int argc, char **argv)
+{
+	const int32_t negative = -123456;
+	const char *const plain = "plain debugPrintf text\r\n";
+
+	if(argc != 3)
+	{
+		fprintf(stderr, "usage: %s capture.bin expected.txt\n", argv[0]);
+		return 2;
+	}
+	capture = fopen(argv[1], "wb");
+	expected = fopen(argv[2], "w");
+	if((capture == NULL) || (expected == NULL))
+	{
+		perror("tokenlog-test");
+		return 2;
+	}
+
+	TOKEN_LOG("boot\r\n");
+	testExpect("boot\r\n");
+
+	TOKEN_LOG("bench: %lu cycles, %lu us\r\n", 0U, 0xFFFFFFFFU);
+	testExpect("bench: %lu cycles, %lu us\r\n", 0UL, 0xFFFFFFFFUL);
+
+	TOKEN_LOG("drift %ld us over %d s\r\n", negative, -1);
+	testExpect("drift %ld us over %d s\r\n", (long)negative, -1);
+
+	/* Text between the frames passes through */
+	stdUtil_write(plain, (uint32_t)strlen(plain));
+	testExpect("%s", plain);
+
+	TOKEN_LOG("%s: %u%% %c%c\r\n", TOKENLOG_STRING(testName), 100U, 'o', 'k');
+	testExpect("%s: %u%% %c%c\r\n", testName, 100U, 'o', 'k');
+
+	/* A damaged frame is dropped, the next one is found again */
+	corruptNext = true;
+	TOKEN_LOG("damaged %u\r\n", 0x12345U);
+
+	TOKEN_LOG("[%5u|%-4x|%08lX]\r\n", 42U, 0xABU, 0xC0FFEEUL);
+	testExpect("[%5u|%-4x|%08lX]\r\n", 42U, 0xABU, 0xC0FFEEUL);
+
+	TOKEN_LOG("%u %u %u %u %u %u %u %u\r\n", 1U, 128U, 16384U, 2097152U, 268435456U, 0x7FU, 0x3FFFU, 0xFFFFFFFFU);
+	testExpect("%u %u %u %u %u %u %u %u\r\n", 1U, 128U, 16384U, 2097152U, 268435456U, 0x7FU, 0x3FFFU, 0xFFFFFFFFU);
+
+	fclose(capture);
+	fclose(expected);
+
+	printf("tokenlog: %u frames, %u bytes (longest %u of %u), %u bytes formatted\n",
+	       frames, frameBytes, frameLongest, (unsigned)TOKENLOG_FRAME_MAX, textBytes);
+	return (frameLongest <= TOKENLOG_FRAME_MAX) ? 0 : 1;
+}
+/*************************************END*************************************/
@@ -0,0 +1,113 @@
+/**
+ * \file           sim_watchdog.c
+ * \brief          Simulated reset flags and independent watchdog
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "sim.h"
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static SimWatchdogStats_t simwatchdog; /** Registers and counters of the model **/
+
+/*****************************************************************************/
+/* Simulation Functions                                                      */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Starts the MCU again after a reset of the given cause.
+ *****************************************************************************/
+void Sim_WatchdogBoot(uint32_t resetFlags, bool standby)
+{
+	simwatchdog.resetFlags = resetFlags;
+	simwatchdog.standby = standby;
+	simwatchdog.running = false; /** Any reset stops the IWDG **/
+}
+/*****************************************************************************
+ * @brief Returns the registers and counters of the watchdog model.
+ *****************************************************************************/
+SimWatchdogStats_t *Sim_WatchdogGetStats(void)
+{
+	return &simwatchdog;
+}
+
+/*****************************************************************************/
+/* HAL Replacements                                                          */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief APP_RESET_FLAGS().
+ *****************************************************************************/
+uint32_t Sim_ResetFlags(void)
+{
+	return simwatchdog.resetFlags;
+}
+/*****************************************************************************
+ * @brief APP_RESET_FLAGS_CLEAR().
+ *****************************************************************************/
+void Sim_ResetFlagsClear(void)
+{
+	simwatchdog.resetFlags = 0U;
+}
+/*****************************************************************************
+ * @brief APP_STANDBY_FLAG().
+ *****************************************************************************/
+bool Sim_StandbyFlag(void)
+{
+	return simwatchdog.standby;
+}
+/*****************************************************************************
+ * @brief APP_STANDBY_FLAG_CLEAR().
+ *****************************************************************************/
+void Sim_StandbyFlagClear(void)
+{
+	simwatchdog.standby = false;
+}
+/*****************************************************************************
+ * @brief APP_WATCHDOG_START().
+ *****************************************************************************/
+void Sim_WatchdogStart(uint32_t prescaler, uint32_t reload)
+{
+	simwatchdog.prescaler = prescaler;
+	simwatchdog.reload = reload;
+	simwatchdog.running = true;
+	simwatchdog.starts++;
+}
+/*****************************************************************************
+ * @brief APP_WATCHDOG_FEED().
+ *****************************************************************************/
+void Sim_WatchdogFeed(void)
+{
+	if(simwatchdog.running)
+	{
+		simwatchdog.feeds++;
+	}
+}
+/*************************************END*************************************/
@@ -0,0 +1,324 @@
+/**
+ * \file           sim_watchdog_test.c
+ * \brief          Host test of the reset cause and the watchdog task supervisor
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include <stdio.h>
+#include "sim.h"
+#include "watchdog.h"
+#include "sim_test.h"
+
+/*****************************************************************************/
+/* Private Defines                                                           */
+/*****************************************************************************/
+#define TEST_ALL_TASKS             ((1UL << WatchdogTask_Count) - 1U)
+#define TEST_LSI_HZ                32000U       /** Nominal LSI **/
+#define TEST_LSI_MIN_HZ            17000U       /** Slowest LSI in the datasheet **/
+#define TEST_LSI_MAX_HZ            47000U       /** Fastest LSI in the datasheet **/
+#define TEST_SOAK_SECONDS          (8U * 3600U) /** A long day of sessions, one pass per second **/
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static uint32_t testpasses = 0; /** Supervisor passes run **/
+
+/*****************************************************************************/
+/* Helpers                                                                   */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Boots with the given reset, starts the supervisor.
+ *
+ * @return bool What Watchdog_Init() returned.
+ *****************************************************************************/
+static bool testBoot(uint32_t resetFlags, bool standby)
+{
+	Sim_WatchdogBoot(resetFlags, standby);
+	bool back = Watchdog_Init();
+	if(back == false)
+	{
+		Watchdog_Start();
+	}
+	return back;
+}
+/*****************************************************************************
+ * @brief One wake-up and one scheduler pass.
+ *
+ * @param[in] seconds  Seconds since the last wake-up.
+ * @param[in] tasks    Tasks that check in, bit per WatchdogTask_e.
+ *
+ * @return bool true if the IWDG was fed.
+ *****************************************************************************/
+static bool testPass(uint32_t seconds, uint32_t tasks)
+{
+	Watchdog_ElapsedFromISR(seconds);
+	for(uint32_t task = 0; task < WatchdogTask_Count; task++)
+	{
+		if((tasks & (1UL << task)) != 0U)
+		{
+			Watchdog_CheckIn((WatchdogTask_e)task);
+		}
+	}
+	testpasses++;
+	uint32_t feeds = Sim_WatchdogGetStats()->feeds;
+	bool fed = Watchdog_Service();
+	if(fed != (Sim_WatchdogGetStats()->feeds == (feeds + 1U)))
+	{
+		Sim_TestFail("feed and return value differ", feeds);
+	}
+	return fed;
+}
+/*****************************************************************************
+ * @brief IWDG period in ms for an LSI frequency.
+ *****************************************************************************/
+static uint32_t testPeriodMs(uint32_t lsi)
+{
+	const SimWatchdogStats_t *stats = Sim_WatchdogGetStats();
+	uint32_t divider = 4UL << stats->prescaler;
+
+	return (uint32_t)(((uint64_t)(stats->reload + 1U) * divider * 1000U) / lsi);
+}
+
+/*****************************************************************************/
+/* Tests                                                                     */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Reset flags to cause, the most specific flag wins.
+ *****************************************************************************/
+static void testCauses(void)
+{
+	static const struct
+	{
+		uint32_t flags;
+		ResetCause_e cause;
+	}cases[] =
+	{
+		{ RCC_CSR_PORRSTF | RCC_CSR_PINRSTF | RCC_CSR_BORRSTF, ResetCause_PowerOn },
+		{ RCC_CSR_BORRSTF | RCC_CSR_PINRSTF,                   ResetCause_Brownout },
+		{ RCC_CSR_PINRSTF,                                     ResetCause_Pin },
+		{ RCC_CSR_SFTRSTF | RCC_CSR_PINRSTF,                   ResetCause_Software },
+		{ RCC_CSR_IWDGRSTF | RCC_CSR_PINRSTF,                  ResetCause_Watchdog },
+		{ RCC_CSR_WWDGRSTF | RCC_CSR_PINRSTF,                  ResetCause_WindowWatchdog },
+		{ RCC_CSR_LPWRRSTF | RCC_CSR_PINRSTF,                  ResetCause_LowPower },
+	};
+
+	for(uint32_t index = 0; index < (sizeof(cases) / sizeof(cases[0])); index++)
+	{
+		if(testBoot(cases[index].flags, false))
+		{
+			Sim_TestFail("standby without the flag", index);
+		}
+		if(Watchdog_GetResetCause() != cases[index].cause)
+		{
+			Sim_TestFail("reset cause", index);
+		}
+		if(Sim_WatchdogGetStats()->resetFlags != 0U)
+		{
+			Sim_TestFail("reset flags not cleared", index);
+		}
+		Watchdog_Report();
+	}
+}
+/*****************************************************************************
+ * @brief IWDG period against the idle keep-alive over the LSI tolerance.
+ *****************************************************************************/
+static void testPeriod(void)
+{
+	(void)testBoot(RCC_CSR_PORRSTF | RCC_CSR_PINRSTF | RCC_CSR_BORRSTF, false);
+	if(Sim_WatchdogGetStats()->running == false)
+	{
+		Sim_TestFail("IWDG not started", 0);
+	}
+	if(testPeriodMs(TEST_LSI_MAX_HZ) <= (APP_WATCHDOG_IDLE_WAKE * 1000U))
+	{
+		Sim_TestFail("shortest period within the idle wake-up", testPeriodMs(TEST_LSI_MAX_HZ));
+	}
+	printf("iwdg        %lu ms nominal, %lu ... %lu ms over the LSI, idle wake-up %lu s\n",
+			(unsigned long)testPeriodMs(TEST_LSI_HZ), (unsigned long)testPeriodMs(TEST_LSI_MAX_HZ),
+			(unsigned long)testPeriodMs(TEST_LSI_MIN_HZ), (unsigned long)APP_WATCHDOG_IDLE_WAKE);
+}
+/*****************************************************************************
+ * @brief Every task on time: fed on every pass, running and idle.
+ *****************************************************************************/
+static void testHealthy(void)
+{
+	(void)testBoot(RCC_CSR_PINRSTF, false);
+	for(uint32_t second = 0; second < TEST_SOAK_SECONDS; second++)
+	{
+		uint32_t tasks = TEST_ALL_TASKS;
+		if((second % 600U) < 8U)
+		{
+			tasks &= ~(1UL << WatchdogTask_Buzzer); /** End-of-session beeps **/
+		}
+		if((second % 7U) == 0U)
+		{
+			tasks &= ~(1UL << WatchdogTask_Display); /** A frame in flight at this pass **/
+		}
+		if(testPass(1U, tasks) == false)
+		{
+			Sim_TestFail("not fed while running", second);
+			break;
+		}
+	}
+	for(uint32_t wake = 0; wake < 1000U; wake++)
+	{
+		if(testPass(APP_WATCHDOG_IDLE_WAKE, TEST_ALL_TASKS) == false)
+		{
+			Sim_TestFail("not fed while idle", wake);
+			break;
+		}
+	}
+	if(Watchdog_GetLateTasks() != 0U)
+	{
+		Sim_TestFail("late tasks after a pin reset", Watchdog_GetLateTasks());
+	}
+}
+/*****************************************************************************
+ * @brief A task past its deadline stops the feeding and is named after
+ *        the watchdog reset.
+ *****************************************************************************/
+static void testLate(WatchdogTask_e task, uint32_t deadline)
+{
+	uint32_t others = TEST_ALL_TASKS & ~(1UL << task);
+
+	(void)testBoot(RCC_CSR_PINRSTF, false);
+	for(uint32_t second = 1; second <= deadline; second++)
+	{
+		if(testPass(1U, others) == false)
+		{
+			Sim_TestFail("not fed within the deadline", (task << 8) | second);
+		}
+	}
+	if(testPass(1U, others))
+	{
+		Sim_TestFail("fed past the deadline", task);
+	}
+	/** Back on time before the IWDG runs out: fed again **/
+	if(testPass(1U, TEST_ALL_TASKS) == false)
+	{
+		Sim_TestFail("not fed after the check-in", task);
+	}
+	for(uint32_t second = 0; second <= deadline; second++)
+	{
+		(void)testPass(1U, others);
+	}
+
+	/** The IWDG runs out **/
+	if(testBoot(RCC_CSR_IWDGRSTF | RCC_CSR_PINRSTF, false))
+	{
+		Sim_TestFail("standby after a running watchdog reset", task);
+	}
+	if((Watchdog_GetResetCause() != ResetCause_Watchdog) || (Watchdog_GetLateTasks() != (1UL << task)))
+	{
+		Sim_TestFail("late task after the reset", Watchdog_GetLateTasks());
+	}
+	Watchdog_Report();
+
+	/** Named once: another reset starts clean **/
+	(void)testBoot(RCC_CSR_IWDGRSTF | RCC_CSR_PINRSTF, false);
+	if(Watchdog_GetLateTasks() != 0U)
+	{
+		Sim_TestFail("late task named twice", Watchdog_GetLateTasks());
+	}
+}
+/*****************************************************************************
+ * @brief A hang inside a task never reaches Watchdog_Service(): nothing
+ *        is named, the cause still says watchdog.
+ *****************************************************************************/
+static void testHang(void)
+{
+	(void)testBoot(RCC_CSR_PINRSTF, false);
+	(void)testPass(1U, TEST_ALL_TASKS);
+	Watchdog_ElapsedFromISR(40U); /** No pass any more **/
+
+	(void)testBoot(RCC_CSR_IWDGRSTF | RCC_CSR_PINRSTF, false);
+	if((Watchdog_GetResetCause() != ResetCause_Watchdog) || (Watchdog_GetLateTasks() != 0U))
+	{
+		Sim_TestFail("hang report", Watchdog_GetLateTasks());
+	}
+}
+/*****************************************************************************
+ * @brief STANDBY: the IWDG reset that follows goes straight back, any
+ *        other wake-up starts the firmware.
+ *****************************************************************************/
+static void testStandby(void)
+{
+	uint32_t starts = Sim_WatchdogGetStats()->starts;
+
+	if(testBoot(RCC_CSR_IWDGRSTF, true) == false)
+	{
+		Sim_TestFail("watchdog reset out of standby ran", 0);
+	}
+	if((Sim_WatchdogGetStats()->standby == false) || (Sim_WatchdogGetStats()->starts != starts))
+	{
+		Sim_TestFail("standby flag or IWDG after the return", starts);
+	}
+	/** The reset stopped the IWDG: the MCU stays in STANDBY until NRST **/
+	if(testBoot(RCC_CSR_PINRSTF, true))
+	{
+		Sim_TestFail("pin reset out of standby went back", 0);
+	}
+	if(Sim_WatchdogGetStats()->standby)
+	{
+		Sim_TestFail("standby flag not cleared", 0);
+	}
+	/** Woken by the WKUP pin: no reset flag **/
+	if(testBoot(0U, true) || (Watchdog_GetResetCause() != ResetCause_Wakeup))
+	{
+		Sim_TestFail("wake-up pin cause", Watchdog_GetResetCause());
+	}
+	/** A watchdog reset of the running firmware is not a STANDBY one **/
+	if(testBoot(RCC_CSR_IWDGRSTF, false))
+	{
+		Sim_TestFail("running watchdog reset went to standby", 0);
+	}
+}
+
+/*****************************************************************************/
+/* Main                                                                      */
+/*****************************************************************************/
+int main(void)
+{
+	testCauses();
+	testPeriod();
+	testHealthy();
+	testLate(WatchdogTask_Input, 2U);
+	testLate(WatchdogTask_Session, 2U);
+	testLate(WatchdogTask_Display, 2U);
+	testLate(WatchdogTask_Buzzer, 15U);
+	testHang();
+	testStandby();
+
+	printf("watchdog    %lu passes, %lu feeds, %lu starts\n", (unsigned long)testpasses,
+			(unsigned long)Sim_WatchdogGetStats()->feeds, (unsigned long)Sim_WatchdogGetStats()->starts);
+	return Sim_TestResult();
+}
+/*************************************END*************************************/
@@ -0,0 +1,166 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2024 Sourabh Potdar
+# SPDX-License-Identifier: MIT
+#
+"""Flash and RAM footprint per object file from a GNU ld map file.
+
+Sums the input sections of every object linked into the loadable output
+sections: flash is everything placed at 0x08xxxxxx plus the load image of
+.data, RAM is everything placed at 0x2xxxxxxx. Objects of the STM32 HAL,
+the C libraries and the application are totalled separately.
+
+usage: map_footprint.py [-a] MAP [MAP]
+
+  -a   list every object, not only the ones that differ or the 20 largest
+
+With two map files (e.g. APP_LL_DRIVERS=0 and =1) the second is compared
+against the first, object by object.
+
+example:
+  map_footprint.py Debug/pomodor-timer.map
+  map_footprint.py hal/pomodor-timer.map ll/pomodor-timer.map
+"""
+
+import argparse
+import re
+import sys
+
+FLASH = (0x08000000, 0x08100000)
+RAM = (0x20000000, 0x20020000)
+
+OUTPUT = re.compile(r"^(\.\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(\s+load address\s+0x([0-9a-fA-F]+))?")
+INPUT = re.compile(r"^ (\.\S+|COMMON)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+WRAPPED = re.compile(r"^ ?(\.\S+|COMMON)$")
+NOLOAD = re.compile(r"^\.(bss|noinit|_user_heap_stack)")
+
+
+def inside(address, region):
+    return region[0] <= address < region[1]
+
+
+def group(name):
+    """hal, lib or app for an object path as printed in the map."""
+    if "STM32F4xx_HAL_Driver" in name or "stm32f4xx_hal" in name:
+        return "hal"
+    if ".a(" in name or name.endswith(".a") or "/lib/gcc/" in name:
+        return "lib"
+    return "app"
+
+
+def short(name):
+    """Object path without the toolchain directories."""
+    match = re.search(r"([^/\\]+\.a\([^)]*\))$", name)
+    if match:
+        return match.group(1)
+    return name[2:] if name.startswith("./") else name
+
+
+def footprint(path):
+    """{object: [flash, ram]} of one map file."""
+    objects = {}
+    flash = ram = False
+    started = False
+    pending = None  # section name printed on a line of its own
+    with open(path, encoding="utf-8", errors="replace") as handle:
+        for line in handle:
+            line = line.rstrip("\r\n")
+            if not started:
+                started = line.startswith("Linker script and memory map")
+                continue
+            if line.startswith("Cross Reference Table"):
+                break
+            if pending is not None:
+                line = pending + " " + line.strip()
+                pending = None
+            wrapped = WRAPPED.match(line)
+            if wrapped:
+                pending = line
+                continue
+            output = OUTPUT.match(line)
+            if output:
+                address = int(output.group(2), 16)
+                loaded = output.group(4) is not None and NOLOAD.match(output.group(1)) is None
+                flash = inside(address, FLASH) or (loaded and inside(int(output.group(5), 16), FLASH))
+                ram = inside(address, RAM)
+                continue
+            match = INPUT.match(line)
+            if match is None or not (flash or ram):
+                continue
+            size = int(match.group(3), 16)
+            if size == 0:
+                continue
+            sizes = objects.setdefault(short(match.group(4).strip()), [0, 0])
+            if flash:
+                sizes[0] += size
+            if ram:
+                sizes[1] += size
+    if not started:
+        raise ValueError("%s: no memory map, link with -Wl,-Map" % path)
+    return objects
+
+
+def totals(objects):
+    result = {"hal": [0, 0], "lib": [0, 0], "app": [0, 0]}
+    for name, (flash, ram) in objects.items():
+        result[group(name)][0] += flash
+        result[group(name)][1] += ram
+    return result
+
+
+def report(objects, everything):
+    rows = sorted(objects.items(), key=lambda item: -item[1][0])
+    if not everything:
+        rows = rows[:20]
+    print("%8s %8s  %s" % ("flash", "ram", "object"))
+    for name, (flash, ram) in rows:
+        print("%8d %8d  %s" % (flash, ram, name))
+    print()
+    for name, (flash, ram) in totals(objects).items():
+        print("%8d %8d  total %s" % (flash, ram, name))
+    print("%8d %8d  total" % (sum(v[0] for v in objects.values()), sum(v[1] for v in objects.values())))
+
+
+def compare(before, after, everything):
+    names = sorted(set(before) | set(after))
+    rows = []
+    for name in names:
+        old = before.get(name, [0, 0])
+        new = after.get(name, [0, 0])
+        if everything or old != new:
+            rows.append((name, old, new))
+    rows.sort(key=lambda row: row[2][0] - row[1][0])
+    print("%8s %8s %8s %8s  %s" % ("flash", "delta", "ram", "delta", "object"))
+    for name, old, new in rows:
+        print("%8d %+8d %8d %+8d  %s" % (new[0], new[0] - old[0], new[1], new[1] - old[1], name))
+    print()
+    first, second = totals(before), totals(after)
+    for key in ("hal", "lib", "app"):
+        print("%8d %+8d %8d %+8d  total %s" % (second[key][0], second[key][0] - first[key][0],
+                                              second[key][1], second[key][1] - first[key][1], key))
+    old = [sum(v[i] for v in before.values()) for i in (0, 1)]
+    new = [sum(v[i] for v in after.values()) for i in (0, 1)]
+    print("%8d %+8d %8d %+8d  total" % (new[0], new[0] - old[0], new[1], new[1] - old[1]))
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(usage=__doc__)
+    parser.add_argument("-a", dest="everything", action="store_true")
+    parser.add_argument("maps", nargs="+")
+    args = parser.parse_args(argv)
+    if len(args.maps) > 2:
+        parser.error("one or two map files")
+    try:
+        maps = [footprint(path) for path in args.maps]
+    except (OSError, ValueError) as error:
+        print("map_footprint: %s" % error, file=sys.stderr)
+        return 1
+    if len(maps) == 1:
+        report(maps[0], args.everything)
+    else:
+        compare(maps[0], maps[1], args.everything)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2024 Sourabh Potdar
+# SPDX-License-Identifier: MIT
+#
+"""Builds a session profile image for flash sector 4 of the Pomodoro firmware.
+
+Each profile is NAME=WORK/SHORT/LONG[xCYCLES], lengths in minutes, CYCLES
+the Pomodoros and short breaks before the long break (5 when left out, as
+NO_OF_CYCLES). The layout is the one of UserApp/profilestore.c.
+
+usage: profile_image.py [-s INDEX] [-o FILE] PROFILE ...
+
+  -s INDEX  profile selected at boot, 0 = first (default)
+  -o FILE   output file (default profiles.bin)
+
+example:
+  profile_image.py "25/5=25/5/15" "52/17=52/17/30x3" "90/20=90/20/30x3"
+  st-flash write profiles.bin 0x08010000
+
+The firmware appends its own images after this one when a profile is
+selected with the buttons.
+"""
+
+import argparse
+import re
+import struct
+import sys
+import zlib
+
+MAGIC = 0x464F5250
+VERSION = 1
+MAX_PROFILES = 4
+NAME_LENGTH = 8
+DEFAULT_CYCLES = 5
+ADDRESS = 0x08010000
+
+PROFILE = re.compile(r"^([^=]{1,8})=(\d+)/(\d+)/(\d+)(?:x(\d+))?$")
+
+
+def parse(text):
+    """(name, [seconds x3], cycles) of one profile argument."""
+    match = PROFILE.match(text)
+    if match is None:
+        raise ValueError("bad profile %r, expected NAME=WORK/SHORT/LONG[xCYCLES]" % text)
+    name = match.group(1).encode("ascii")
+    seconds = [int(match.group(i)) * 60 for i in (2, 3, 4)]
+    cycles = int(match.group(5)) if match.group(5) else DEFAULT_CYCLES
+    if not all(0 < value <= 0xFFFF for value in seconds):
+        raise ValueError("%r: lengths must be 1 ... 1092 minutes" % text)
+    if not 0 < cycles <= 0xFF:
+        raise ValueError("%r: cycles must be 1 ... 255" % text)
+    return name, seconds, cycles
+
+
+def image(profiles, selected):
+    """The 76 byte image, CRC word included."""
+    words = struct.pack("<II", MAGIC, VERSION | (len(profiles) << 8) | (selected << 16))
+    for name, seconds, cycles in profiles:
+        words += name.ljust(NAME_LENGTH, b"\0")
+        words += struct.pack("<HHHH", seconds[0], seconds[1], seconds[2], cycles)
+    words += bytes(16 * (MAX_PROFILES - len(profiles)))
+    return words + struct.pack("<I", zlib.crc32(words) & 0xFFFFFFFF)
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(usage=__doc__)
+    parser.add_argument("-s", dest="selected", type=int, default=0)
+    parser.add_argument("-o", dest="output", default="profiles.bin")
+    parser.add_argument("profiles", nargs="+")
+    args = parser.parse_args(argv[1:])
+
+    try:
+        profiles = [parse(text) for text in args.profiles]
+    except ValueError as error:
+        parser.error(str(error))
+    if len(profiles) > MAX_PROFILES:
+        parser.error("at most %d profiles" % MAX_PROFILES)
+    if not 0 <= args.selected < len(profiles):
+        parser.error("-s must be 0 ... %d" % (len(profiles) - 1))
+
+    with open(args.output, "wb") as file:
+        file.write(image(profiles, args.selected))
+    sys.stderr.write("%s: %d profile(s), flash at 0x%08x\n" % (args.output, len(profiles), ADDRESS))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,188 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2024 Sourabh Potdar
+# SPDX-License-Identifier: MIT
+#
+"""Decodes the TOKEN_LOG() frames of the Pomodoro firmware back into text.
+
+The firmware sends the address of the format string (kept in the non-loaded
+.tokenlog section of the ELF) and the raw 32-bit arguments, see
+Platform/tokenlog.h for the frame layout. This script reads the format
+strings, and the string constants passed to %s, from the ELF the capture
+was made with and prints one line per frame. Bytes that are not part of a
+valid frame (debugPrintf() text, noise) are passed through unchanged.
+
+usage: tokenlog_decode.py firmware.elf [capture.bin]
+
+The capture is read from standard input when no file is given, e.g.
+  stty -F /dev/ttyUSB0 115200 raw && tokenlog_decode.py Debug/pomodor-timer.elf < /dev/ttyUSB0
+"""
+
+import re
+import struct
+import sys
+
+SYNC = 0xA5
+MAX_ARGS = 8
+MAX_PAYLOAD = 5 * (1 + MAX_ARGS)
+
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+CONVERSION = re.compile(r"%([-+ #0]*)(\d*)(?:\.(\d+))?(hh|h|ll|l|j|z|t)?([diouxXcsp%])")
+
+
+class Elf:
+    """The parts of an ELF file the decoder needs: its section contents."""
+
+    def __init__(self, path):
+        with open(path, "rb") as file:
+            self.data = file.read()
+        if self.data[:4] != b"\x7fELF":
+            raise ValueError("%s is not an ELF file" % path)
+        wide = self.data[4] == 2
+        endian = "<" if self.data[5] == 1 else ">"
+        if wide:
+            shoff = struct.unpack_from(endian + "Q", self.data, 0x28)[0]
+            shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", self.data, 0x3A)
+            layout = endian + "IIQQQQ"
+        else:
+            shoff = struct.unpack_from(endian + "I", self.data, 0x20)[0]
+            shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", self.data, 0x2E)
+            layout = endian + "IIIIII"
+
+        headers = [struct.unpack_from(layout, self.data, shoff + (i * shentsize)) for i in range(shnum)]
+        names = headers[shstrndx][4]
+        self.sections = {}
+        self.loaded = []
+        for name, kind, flags, address, offset, size in headers:
+            section = (self._cstring(names + name).decode(), kind, flags, address, offset, size)
+            self.sections[section[0]] = section
+            if (flags & SHF_ALLOC) and kind != SHT_NOBITS:
+                self.loaded.append(section)
+        if ".tokenlog" not in self.sections:
+            raise ValueError("%s has no .tokenlog section" % path)
+
+    def _cstring(self, offset):
+        end = self.data.index(b"\0", offset)
+        return self.data[offset:end]
+
+    def _lookup(self, sections, address):
+        for name, kind, flags, start, offset, size in sections:
+            if start <= address < start + size:
+                return self._cstring(offset + address - start).decode("utf-8", "replace")
+        return None
+
+    def format(self, token):
+        """Format string with this id, None if there is none."""
+        return self._lookup([self.sections[".tokenlog"]], token)
+
+    def string(self, address):
+        """String constant in the flash image at this address."""
+        text = self._lookup(self.loaded, address)
+        return "<bad string 0x%08x>" % address if text is None else text
+
+
+def conversions(fmt):
+    """Number of arguments a printf format consumes."""
+    return sum(1 for match in CONVERSION.finditer(fmt) if match.group(5) != "%")
+
+
+def render(elf, fmt, args):
+    """printf() of the firmware, on the host."""
+    values = iter(args)
+
+    def one(match):
+        flags, width, precision, _, conversion = match.groups()
+        if conversion == "%":
+            return "%"
+        value = next(values)
+        spec = "%" + flags + width + ("." + precision if precision else "")
+        if conversion in "di":
+            return (spec + "d") % (value - (1 << 32) if value & 0x80000000 else value)
+        if conversion == "u":
+            return (spec + "d") % value
+        if conversion == "c":
+            return (spec + "s") % chr(value & 0xFF)
+        if conversion == "s":
+            return (spec + "s") % elf.string(value)
+        if conversion == "p":
+            return "0x%08x" % value
+        return (spec + conversion) % value
+
+    return CONVERSION.sub(one, fmt)
+
+
+def leb128(payload):
+    """Unsigned LEB128 values of a frame payload, None if malformed."""
+    values = []
+    value = 0
+    shift = 0
+    for byte in payload:
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if byte & 0x80 == 0:
+            if value > 0xFFFFFFFF:
+                return None
+            values.append(value)
+            value = 0
+            shift = 0
+        elif shift > 28:
+            return None
+    return values if shift == 0 else None
+
+
+def decode(elf, stream, out):
+    """Writes the text of a capture, returns (frames, bytes skipped)."""
+    frames = 0
+    skipped = 0
+    text = bytearray()
+    position = 0
+
+    def flush():
+        if text:
+            out.write(text.decode("utf-8", "replace"))
+            text.clear()
+
+    while position < len(stream):
+        byte = stream[position]
+        if byte == SYNC and position + 1 < len(stream):
+            length = stream[position + 1]
+            end = position + 2 + length
+            if 1 <= length <= MAX_PAYLOAD and end < len(stream):
+                payload = stream[position + 2:end]
+                if (0xFF - ((length + sum(payload)) & 0xFF)) == stream[end]:
+                    values = leb128(payload)
+                    fmt = elf.format(values[0]) if values else None
+                    if fmt is not None and conversions(fmt) == len(values) - 1:
+                        flush()
+                        out.write(render(elf, fmt, values[1:]).replace("\r", ""))
+                        frames += 1
+                        position = end + 1
+                        continue
+        if byte in (0x09, 0x0A) or 0x20 <= byte < 0x7F:
+            text.append(byte)
+        elif byte != 0x0D:
+            skipped += 1
+        position += 1
+    flush()
+    return frames, skipped
+
+
+def main(argv):
+    if len(argv) not in (2, 3):
+        sys.stderr.write(__doc__)
+        return 2
+    elf = Elf(argv[1])
+    if len(argv) == 3:
+        with open(argv[2], "rb") as file:
+            stream = file.read()
+    else:
+        stream = sys.stdin.buffer.read()
+    frames, skipped = decode(elf, stream, sys.stdout)
+    sys.stderr.write("tokenlog: %d frame(s), %d byte(s) skipped\n" % (frames, skipped))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,331 @@
+/**
+ * \file           battery.c
+ * \brief          Battery voltage filter and level monitor source file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "battery.h"
+#if APP_BATTERY_MONITOR
+#include "batteryadc.h"
+#include "eventqueue.h"
+#endif
+/*****************************************************************************/
+/* Private Defines                                                           */
+/*****************************************************************************/
+#define BATTERY_VREFINT_CAL_MV10     33000U   /** VDDA of the VREFINT calibration in 0.1 mV **/
+#define BATTERY_ADC_FULL_SCALE       4095U    /** 12-bit ADC **/
+
+#if (APP_BATTERY_CRITICAL_MV + APP_BATTERY_HYSTERESIS_MV) > APP_BATTERY_LOW_MV
+#error "APP_BATTERY_CRITICAL_MV + APP_BATTERY_HYSTERESIS_MV must not be above APP_BATTERY_LOW_MV"
+#endif
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+#if APP_BATTERY_MONITOR
+static BatteryFilter_t batteryfilter; /** Filter of the battery measurements **/
+
+static uint32_t batteryseconds = 0; /** Timer seconds since the last measurement **/
+#endif
+
+/*****************************************************************************/
+/* Private Functions                                                         */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Median of a small sample set.
+ *
+ * @details Insertion sort, at most BATTERY_BURST_MAX samples. An even count
+ *          takes the mean of the two middle samples, so up to count / 2 - 1
+ *          samples pulled to the same side (a buzzer or display current
+ *          step, a spike) have no influence.
+ *
+ * @param[in,out] samples  Samples, sorted in place.
+ * @param[in]     count    Number of samples, at least 1.
+ *
+ * @return uint16_t Median.
+ *****************************************************************************/
+static uint16_t batteryMedian(uint16_t *samples, uint8_t count)
+{
+	for(uint8_t i = 1; i < count; i++)
+	{
+		uint16_t value = samples[i];
+		uint8_t j = i;
+		while((j > 0U) && (samples[j - 1U] > value))
+		{
+			samples[j] = samples[j - 1U];
+			j--;
+		}
+		samples[j] = value;
+	}
+
+	if((count & 1U) != 0U)
+	{
+		return samples[count / 2U];
+	}
+	return (uint16_t)(((uint32_t)samples[(count / 2U) - 1U] + samples[count / 2U] + 1U) / 2U);
+}
+/*****************************************************************************
+ * @brief Applies the thresholds with hysteresis.
+ *
+ * @details A level is entered below its threshold and only left again at
+ *          APP_BATTERY_HYSTERESIS_MV above it. Falling several levels at
+ *          once is allowed.
+ *
+ * @param[in] level       Current level.
+ * @param[in] millivolts  Filtered voltage.
+ *
+ * @return BatteryLevel_e New level.
+ *****************************************************************************/
+static BatteryLevel_e batteryClassify(BatteryLevel_e level, uint16_t millivolts)
+{
+	if(millivolts < APP_BATTERY_CRITICAL_MV)
+	{
+		return BatteryLevel_Critical;
+	}
+	if((level == BatteryLevel_Critical) && (millivolts < (APP_BATTERY_CRITICAL_MV + APP_BATTERY_HYSTERESIS_MV)))
+	{
+		return BatteryLevel_Critical;
+	}
+	if(millivolts < APP_BATTERY_LOW_MV)
+	{
+		return BatteryLevel_Low;
+	}
+	if((level != BatteryLevel_Ok) && (millivolts < (APP_BATTERY_LOW_MV + APP_BATTERY_HYSTERESIS_MV)))
+	{
+		return BatteryLevel_Low;
+	}
+	return BatteryLevel_Ok;
+}
+
+/*****************************************************************************/
+/* Battery Filter Functions                                                  */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Converts one ADC pair to the battery voltage.
+ *
+ * @details VDDA is taken from VREFINT against its factory reading, so the
+ *          result does not depend on the regulator output:
+ *          VDDA = 3.3 V * VREFINT_CAL / vrefint,
+ *          Vbat = VDDA * battery / 4095 * APP_BATTERY_DIVIDER_NUM / APP_BATTERY_DIVIDER_DEN.
+ *          VDDA is kept in 0.1 mV so both steps fit in 32 bits.
+ *
+ * @param[in] vrefint     ADC reading of VREFINT.
+ * @param[in] battery     ADC reading of the divided battery voltage.
+ * @param[in] vrefintcal  Factory VREFINT reading at VDDA = 3.3 V.
+ *
+ * @return uint16_t Battery voltage in mV, 0 if vrefint is 0.
+ *****************************************************************************/
+uint16_t battery_ToMillivolts(uint16_t vrefint, uint16_t battery, uint16_t vrefintcal)
+{
+	if(vrefint == 0U)
+	{
+		return 0;
+	}
+	uint32_t vdda = (BATTERY_VREFINT_CAL_MV10 * vrefintcal) / vrefint;
+	uint32_t millivolts = (vdda * battery * APP_BATTERY_DIVIDER_NUM) /
+			(BATTERY_ADC_FULL_SCALE * APP_BATTERY_DIVIDER_DEN * 10U);
+
+	return (millivolts > UINT16_MAX) ? UINT16_MAX : (uint16_t)millivolts;
+}
+/*****************************************************************************
+ * @brief Empties the filter.
+ *
+ * @param[out] filter  Filter state.
+ *
+ * @return None
+ *****************************************************************************/
+void battery_FilterInit(BatteryFilter_t *filter)
+{
+	filter->filtered = 0;
+	filter->level = BatteryLevel_Ok;
+	filter->primed = false;
+}
+/*****************************************************************************
+ * @brief Filters one burst and updates the level.
+ *
+ * @details The median of the burst removes the outliers within it, the
+ *          first order IIR y += (x - y) / 2^BATTERY_IIR_SHIFT then smooths
+ *          the load dependent sag from burst to burst. Integer only, y keeps
+ *          BATTERY_FRACTION_BITS fraction bits and is always positive:
+ *          y = y - y / 4 + x * 16 / 4 with the default shifts. The first
+ *          burst after battery_FilterInit() loads the filter directly.
+ *
+ * @param[in,out] filter      Filter state.
+ * @param[in,out] millivolts  Burst in mV, sorted in place.
+ * @param[in]     count       Number of samples, clamped to BATTERY_BURST_MAX.
+ *
+ * @return BatteryLevel_e Level after this burst, unchanged for an empty burst.
+ *****************************************************************************/
+BatteryLevel_e battery_FilterBurst(BatteryFilter_t *filter, uint16_t *millivolts, uint8_t count)
+{
+	if(count == 0U)
+	{
+		return filter->level;
+	}
+	if(count > BATTERY_BURST_MAX)
+	{
+		count = BATTERY_BURST_MAX;
+	}
+
+	uint32_t sample = (uint32_t)batteryMedian(millivolts, count) << BATTERY_FRACTION_BITS;
+
+	if(filter->primed)
+	{
+		filter->filtered = filter->filtered - (filter->filtered >> BATTERY_IIR_SHIFT) + (sample >> BATTERY_IIR_SHIFT);
+	}
+	else
+	{
+		filter->filtered = sample;
+		filter->primed = true;
+	}
+
+	filter->level = batteryClassify(filter->level, battery_FilterMillivolts(filter));
+	return filter->level;
+}
+/*****************************************************************************
+ * @brief Filtered voltage, rounded to mV.
+ *
+ * @param[in] filter  Filter state.
+ *
+ * @return uint16_t Voltage in mV.
+ *****************************************************************************/
+uint16_t battery_FilterMillivolts(const BatteryFilter_t *filter)
+{
+	return (uint16_t)((filter->filtered + (1UL << (BATTERY_FRACTION_BITS - 1U))) >> BATTERY_FRACTION_BITS);
+}
+
+#if APP_BATTERY_MONITOR
+/*****************************************************************************/
+/* Battery Monitor Functions                                                 */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Resets the monitor and measures once.
+ *
+ * @details The first burst gives the level at power up, so a cell that is
+ *          already critical shuts the timer down before it is used.
+ *
+ * @param None
+ *
+ * @return None
+ *****************************************************************************/
+void battery_Init(void)
+{
+	battery_FilterInit(&batteryfilter);
+	batteryseconds = 0;
+	battery_Measure();
+}
+/*****************************************************************************
+ * @brief Counts one timer second.
+ *
+ * @details Only running timer seconds are counted; a stopped timer lets the
+ *          MCU stay in STOP mode and the battery is not measured then.
+ *
+ * @param None
+ *
+ * @return None
+ *****************************************************************************/
+void battery_SecondTick(void)
+{
+	if(++batteryseconds >= APP_BATTERY_PERIOD)
+	{
+		battery_Measure();
+	}
+}
+/*****************************************************************************
+ * @brief Starts a measurement now.
+ *
+ * @param None
+ *
+ * @return None
+ *****************************************************************************/
+void battery_Measure(void)
+{
+	if(BatteryAdc_Start())
+	{
+		batteryseconds = 0;
+	}
+}
+/*****************************************************************************
+ * @brief Filters the completed burst.
+ *
+ * @details Converts every pair with its own VREFINT reading and posts the
+ *          event of the new level when it changed.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @note Call on AppEvent_BatterySample, before the next BatteryAdc_Start().
+ *****************************************************************************/
+void battery_Process(void)
+{
+	static const AppEvent_e levelevents[] =
+	{
+		[BatteryLevel_Ok]       = AppEvent_BatteryOk,
+		[BatteryLevel_Low]      = AppEvent_BatteryLow,
+		[BatteryLevel_Critical] = AppEvent_BatteryCritical,
+	};
+	const BatteryAdcSample_t *burst = BatteryAdc_GetBurst();
+	uint16_t vrefintcal = BatteryAdc_GetVrefintCal();
+	uint16_t millivolts[BATTERYADC_BURST_LENGTH];
+	BatteryLevel_e previous = batteryfilter.level;
+
+	for(uint8_t i = 0; i < BATTERYADC_BURST_LENGTH; i++)
+	{
+		millivolts[i] = battery_ToMillivolts(burst[i].vrefint, burst[i].battery, vrefintcal);
+	}
+
+	if(battery_FilterBurst(&batteryfilter, millivolts, BATTERYADC_BURST_LENGTH) != previous)
+	{
+		(void)eventQueue_Post(levelevents[batteryfilter.level]);
+	}
+}
+/*****************************************************************************
+ * @brief Current battery level.
+ *
+ * @return BatteryLevel_e Level of the filtered voltage.
+ *****************************************************************************/
+BatteryLevel_e battery_GetLevel(void)
+{
+	return batteryfilter.level;
+}
+/*****************************************************************************
+ * @brief Filtered battery voltage.
+ *
+ * @return uint16_t Voltage in mV.
+ *****************************************************************************/
+uint16_t battery_GetMillivolts(void)
+{
+	return battery_FilterMillivolts(&batteryfilter);
+}
+#endif
+/*************************************END*************************************/
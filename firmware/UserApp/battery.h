@@ -0,0 +1,180 @@
+/**
+ * \file           battery.h
+ * \brief          Battery voltage filter and level monitor header file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+#ifndef BATTERY_H_
+#define BATTERY_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "AppConfig.h"
+
+/*****************************************************************************/
+/* Battery Macros                                                            */
+/*****************************************************************************/
+
+/**
+ * @brief Largest burst battery_FilterBurst() takes.
+ */
+#define BATTERY_BURST_MAX                    16U
+
+/**
+ * @brief Fraction bits of the filtered voltage.
+ */
+#define BATTERY_FRACTION_BITS                4U
+
+/**
+ * @brief Weight of a new burst in the IIR filter, 1 / 2^BATTERY_IIR_SHIFT.
+ *
+ * @details 2 gives each burst a weight of 1/4, a step settles to 90 % in
+ *          8 bursts, i.e. 8 minutes at the default APP_BATTERY_PERIOD.
+ */
+#define BATTERY_IIR_SHIFT                    2U
+
+/*****************************************************************************/
+/* Battery Enums                                                             */
+/*****************************************************************************/
+
+/**
+ * @brief Battery level after the thresholds and their hysteresis.
+ */
+typedef enum
+{
+	BatteryLevel_Ok,                  /**< Above APP_BATTERY_LOW_MV */
+	BatteryLevel_Low,                 /**< Below APP_BATTERY_LOW_MV, warn */
+	BatteryLevel_Critical,            /**< Below APP_BATTERY_CRITICAL_MV, shut down */
+}BatteryLevel_e;
+
+/*****************************************************************************/
+/* Battery Structures                                                        */
+/*****************************************************************************/
+
+/**
+ * @brief State of the battery filter.
+ */
+typedef struct
+{
+	uint32_t filtered;                /**< Filtered voltage in mV, BATTERY_FRACTION_BITS fraction bits */
+	BatteryLevel_e level;             /**< Level of the filtered voltage */
+	bool primed;                      /**< A burst was filtered since battery_FilterInit() */
+}BatteryFilter_t;
+
+/*****************************************************************************/
+/* Battery Function Declarations                                             */
+/*****************************************************************************/
+
+/**
+ * @brief Converts one ADC pair to the battery voltage.
+ *
+ * @param[in] vrefint     ADC reading of VREFINT.
+ * @param[in] battery     ADC reading of the divided battery voltage.
+ * @param[in] vrefintcal  Factory VREFINT reading at VDDA = 3.3 V.
+ *
+ * @return Battery voltage in mV, 0 if vrefint is 0.
+ */
+uint16_t battery_ToMillivolts(uint16_t vrefint, uint16_t battery, uint16_t vrefintcal);
+
+/**
+ * @brief Empties the filter, the next burst is taken as it is.
+ *
+ * @param[out] filter Filter state.
+ */
+void battery_FilterInit(BatteryFilter_t *filter);
+
+/**
+ * @brief Filters one burst and updates the level.
+ *
+ * @param[in,out] filter      Filter state.
+ * @param[in,out] millivolts  Burst in mV, sorted in place.
+ * @param[in]     count       1 ... BATTERY_BURST_MAX samples.
+ *
+ * @return Level after this burst.
+ */
+BatteryLevel_e battery_FilterBurst(BatteryFilter_t *filter, uint16_t *millivolts, uint8_t count);
+
+/**
+ * @brief Filtered voltage, rounded to mV.
+ *
+ * @param[in] filter Filter state.
+ *
+ * @return Voltage in mV, 0 before the first burst.
+ */
+uint16_t battery_FilterMillivolts(const BatteryFilter_t *filter);
+
+#if APP_BATTERY_MONITOR
+/**
+ * @brief Resets the monitor and starts the first measurement.
+ *
+ * @note BatteryAdc_Init() must have been called.
+ */
+void battery_Init(void);
+
+/**
+ * @brief Counts one timer second and starts a measurement every APP_BATTERY_PERIOD.
+ */
+void battery_SecondTick(void);
+
+/**
+ * @brief Starts a measurement now, unless one is running.
+ */
+void battery_Measure(void);
+
+/**
+ * @brief Filters the completed burst and posts the level change events.
+ *
+ * @details AppEvent_BatteryOk, AppEvent_BatteryLow or AppEvent_BatteryCritical
+ *          is posted when the level changes.
+ */
+void battery_Process(void);
+
+/**
+ * @brief Current battery level.
+ */
+BatteryLevel_e battery_GetLevel(void);
+
+/**
+ * @brief Filtered battery voltage in mV.
+ */
+uint16_t battery_GetMillivolts(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BATTERY_H_ */
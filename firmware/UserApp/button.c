@@ -0,0 +1,286 @@
+/**
+ * \file           button.c
+ * \brief          Debounced push button events source file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "button.h"
+#include "profiler.h"
+/*****************************************************************************/
+/* Private Types                                                             */
+/*****************************************************************************/
+/**
+ * @brief Debounced state of one button.
+ */
+typedef enum
+{
+	ButtonState_Released,     /**< Up */
+	ButtonState_Pressed,      /**< Down, long press one-shot pending */
+	ButtonState_LongPressed,  /**< Down, long press already reported */
+}ButtonState_e;
+
+/**
+ * @brief Runtime state of one button.
+ */
+typedef struct
+{
+	ButtonState_e state;      /**< Debounced state */
+	HwTimer_t timer;          /**< One-shot used for debounce and long press */
+	bool settling;            /**< Debounce one-shot pending */
+	uint16_t edgetick;        /**< HwTimer_Now() of the first edge while settling */
+	uint16_t presstick;       /**< HwTimer_Now() of the accepted press */
+}Button_t;
+
+/**
+ * @brief Fixed wiring of one button.
+ */
+typedef struct
+{
+	HwTimerCallback_t expired;/**< One-shot expiry handler */
+	AppEvent_e press;         /**< Event posted on press */
+	AppEvent_e release;       /**< Event posted on release */
+	AppEvent_e shortpress;    /**< Event posted on release before BUTTON_LONG_PRESS_MS */
+	AppEvent_e longpress;     /**< Event posted after BUTTON_LONG_PRESS_MS held */
+}ButtonConfig_t;
+
+/*****************************************************************************/
+/* Private Function Declarations                                             */
+/*****************************************************************************/
+static void buttonControlExpired(HwTimer_t *timer);
+static void buttonFunctionExpired(HwTimer_t *timer);
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static Button_t buttons[ButtonId_Count]; /** Runtime state, touched only at EXTI/TIM4 priority **/
+
+static const ButtonConfig_t buttonconfig[ButtonId_Count] =
+{
+	[ButtonId_Control] =
+	{
+		buttonControlExpired,
+		AppEvent_ControlPress, AppEvent_ControlRelease, AppEvent_ControlShortPress, AppEvent_ControlLongPress,
+	},
+	[ButtonId_Function] =
+	{
+		buttonFunctionExpired,
+		AppEvent_FunctionPress, AppEvent_FunctionRelease, AppEvent_FunctionShortPress, AppEvent_FunctionLongPress,
+	},
+}; /** Wiring of each button **/
+
+/*****************************************************************************/
+/* Private Functions                                                         */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Reads the pin level of a button.
+ *
+ * @param[in] button  Button to read.
+ *
+ * @return bool
+ *
+ * @retval true   Button is down (pin low, active low with pull-up; the
+ *                control button high with APP_IDLE_STANDBY).
+ * @retval false  Button is up.
+ *****************************************************************************/
+static bool buttonIsDown(ButtonId_e button)
+{
+	if(button == ButtonId_Control)
+	{
+		return (CONTROLBUTTON_READ() == CONTROLBUTTON_PRESSED);
+	}
+	return (FUNCTIONBUTTON_READ() == GPIO_PIN_RESET);
+}
+/*****************************************************************************
+ * @brief Arms the long press one-shot for the time still missing.
+ *
+ * @details The hold time is counted from the accepted press, so a glitch
+ *          while the button is held does not extend the long press.
+ *
+ * @param[in] button  Button that is held.
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+static void buttonArmLongPress(ButtonId_e button)
+{
+	Button_t *state = &buttons[button];
+	const ButtonConfig_t *config = &buttonconfig[button];
+	uint32_t elapsed = (uint16_t)(HwTimer_Now() - state->presstick);
+	uint32_t hold = HWTIMER_MS_TO_TICKS(BUTTON_LONG_PRESS_MS);
+
+	if(elapsed >= hold)
+	{
+		state->state = ButtonState_LongPressed;
+		(void)eventQueue_Post(config->longpress);
+	}
+	else
+	{
+		HwTimer_Start(&state->timer, ((hold - elapsed) * 1000U) / HWTIMER_TICK_HZ, config->expired);
+	}
+}
+/*****************************************************************************
+ * @brief Runs the state machine of a button when its one-shot expires.
+ *
+ * @details A pending debounce means the pin was quiet for BUTTON_DEBOUNCE_MS:
+ *          the level is sampled and a changed level posts press, or release
+ *          plus short press if the long press was not reported yet. Without
+ *          a pending debounce the expiry is the long press time.
+ *
+ * @param[in] button  Button whose one-shot expired.
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Runs in the TIM4 interrupt.
+ *****************************************************************************/
+static void buttonExpired(ButtonId_e button)
+{
+	PROFILE_BEGIN(ProfileProbe_ButtonExpired);
+	Button_t *state = &buttons[button];
+	const ButtonConfig_t *config = &buttonconfig[button];
+
+	if(state->settling)
+	{
+		state->settling = false;
+		bool down = buttonIsDown(button);
+
+		if(down && (state->state == ButtonState_Released))
+		{
+			state->state = ButtonState_Pressed;
+			state->presstick = state->edgetick;
+			(void)eventQueue_Post(config->press);
+		}
+		else if((down == false) && (state->state != ButtonState_Released))
+		{
+			(void)eventQueue_Post(config->release);
+			if(state->state == ButtonState_Pressed)
+			{
+				(void)eventQueue_Post(config->shortpress);
+			}
+			state->state = ButtonState_Released;
+		}
+
+		if(state->state == ButtonState_Pressed)
+		{
+			buttonArmLongPress(button);
+		}
+	}
+	else if(state->state == ButtonState_Pressed)
+	{
+		state->state = ButtonState_LongPressed;
+		(void)eventQueue_Post(config->longpress);
+	}
+	PROFILE_END(ProfileProbe_ButtonExpired);
+}
+/*****************************************************************************
+ * @brief One-shot expiry of the control button.
+ *****************************************************************************/
+static void buttonControlExpired(HwTimer_t *timer)
+{
+	(void)timer;
+	buttonExpired(ButtonId_Control);
+}
+/*****************************************************************************
+ * @brief One-shot expiry of the function button.
+ *****************************************************************************/
+static void buttonFunctionExpired(HwTimer_t *timer)
+{
+	(void)timer;
+	buttonExpired(ButtonId_Function);
+}
+
+/*****************************************************************************/
+/* Button Functions                                                          */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Resets both button state machines.
+ *
+ * @details A button already held at boot starts in the long pressed state,
+ *          so it produces no press or short press, only its release. The
+ *          EXTI0/EXTI1 vectors are enabled last: HwTimer_Init() must have
+ *          run before, an edge starts a one-shot on the timer wheel.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @see button_Edge()
+ *****************************************************************************/
+void button_Init(void)
+{
+	for(uint32_t button = 0; button < ButtonId_Count; button++)
+	{
+		HwTimer_Stop(&buttons[button].timer);
+		buttons[button].settling = false;
+		buttons[button].edgetick = 0;
+		buttons[button].presstick = 0;
+		buttons[button].state = buttonIsDown((ButtonId_e)button) ? ButtonState_LongPressed : ButtonState_Released;
+	}
+	BUTTON_IRQ_ENABLE();
+}
+/*****************************************************************************
+ * @brief Handles an edge on a button pin.
+ *
+ * @details Every edge restarts the BUTTON_DEBOUNCE_MS quiet time on the
+ *          button's one-shot, which also suspends a pending long press until
+ *          the level is stable again.
+ *
+ * @param[in] button  Button whose pin changed.
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Runs in the EXTI interrupt, same priority as TIM4.
+ *****************************************************************************/
+void button_Edge(ButtonId_e button)
+{
+	if(button >= ButtonId_Count)
+	{
+		return;
+	}
+
+	PROFILE_BEGIN(ProfileProbe_ButtonEdge);
+	Button_t *state = &buttons[button];
+	if(state->settling == false)
+	{
+		state->settling = true;
+		state->edgetick = HwTimer_Now();
+	}
+	HwTimer_Start(&state->timer, BUTTON_DEBOUNCE_MS, buttonconfig[button].expired);
+	PROFILE_END(ProfileProbe_ButtonEdge);
+}
+/*************************************END*************************************/
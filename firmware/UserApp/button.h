@@ -0,0 +1,100 @@
+/**
+ * \file           button.h
+ * \brief          Debounced push button events header file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+#ifndef BUTTON_H_
+#define BUTTON_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "Platform_Translate.h"
+#include "eventqueue.h"
+#include "hwtimer.h"
+
+/*****************************************************************************/
+/* Button Macros                                                             */
+/*****************************************************************************/
+
+/**
+ * @brief Quiet time after the last edge before the pin level is accepted.
+ *
+ * @details Increase it if the output still flickers.
+ */
+#define BUTTON_DEBOUNCE_MS                   20U
+
+/**
+ * @brief Hold time after which a press is reported as long press.
+ */
+#define BUTTON_LONG_PRESS_MS                 2000U
+
+/*****************************************************************************/
+/* Button Enums                                                              */
+/*****************************************************************************/
+
+/**
+ * @brief Push buttons of the device.
+ */
+typedef enum
+{
+	ButtonId_Control,       /**< PA0, start/stop and reset */
+	ButtonId_Function,      /**< PA1, mode selection */
+	ButtonId_Count,         /**< Number of buttons */
+}ButtonId_e;
+
+/*****************************************************************************/
+/* Button Function Declarations                                              */
+/*****************************************************************************/
+
+/**
+ * @brief Resets both button state machines to the current pin levels and
+ *        enables the button interrupts.
+ *
+ * @note HwTimer_Init() must have been called.
+ */
+void button_Init(void);
+
+/**
+ * @brief Reports an edge on a button pin. Call from the EXTI callback.
+ *
+ * @param[in] button  Button whose pin changed.
+ */
+void button_Edge(ButtonId_e button);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BUTTON_H_ */
@@ -0,0 +1,163 @@
+/**
+ * \file           eventqueue.c
+ * \brief          Application event queue source file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "eventqueue.h"
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static volatile uint8_t eventqueuebuffer[EVENT_QUEUE_SIZE]; /** Event storage **/
+
+static volatile uint8_t eventqueuehead = 0; /** Next free slot, written by producers (ISRs) **/
+
+static volatile uint8_t eventqueuetail = 0; /** Oldest event, written by the consumer (main loop) **/
+
+static volatile uint32_t eventqueueoverflow = 0; /** Number of dropped events **/
+
+/*****************************************************************************/
+/* Event Queue Functions                                                     */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Empties the event queue.
+ *
+ * @details Resets head, tail and the overflow counter. Must be called before
+ *          the interrupts that post events are enabled.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+void eventQueue_Init(void)
+{
+	eventqueuehead = 0;
+	eventqueuetail = 0;
+	eventqueueoverflow = 0;
+}
+/*****************************************************************************
+ * @brief Posts an event to the queue.
+ *
+ * @details Several interrupts of different priority may post, so the slot
+ *          reservation is done with interrupts masked. The masked window is
+ *          a handful of instructions.
+ *
+ * @param[in] event  Event to post.
+ *
+ * @return bool
+ *
+ * @retval true   Event queued.
+ * @retval false  Queue full, event dropped and counted.
+ *
+ * @note The main loop wakes from WFI on the interrupt that posted the event.
+ *
+ * @see eventQueue_Get()
+ *****************************************************************************/
+bool eventQueue_Post(AppEvent_e event)
+{
+	bool status = true;
+	uint32_t irqstate = APP_IRQ_SAVE();
+	APP_IRQ_DISABLE();
+
+	uint8_t nexthead = (uint8_t)((eventqueuehead + 1U) & (EVENT_QUEUE_SIZE - 1U));
+	if(nexthead == eventqueuetail)
+	{
+		eventqueueoverflow++;
+		status = false;
+	}
+	else
+	{
+		eventqueuebuffer[eventqueuehead] = (uint8_t)event;
+		eventqueuehead = nexthead;
+	}
+
+	APP_IRQ_RESTORE(irqstate);
+	return status;
+}
+/*****************************************************************************
+ * @brief Takes the oldest event from the queue.
+ *
+ * @details Single consumer: only the main loop advances the tail, so no
+ *          masking is needed here. The producer publishes the head only
+ *          after the slot is written.
+ *
+ * @param None
+ *
+ * @return AppEvent_e
+ *
+ * @retval AppEvent_None  Queue empty.
+ *
+ * @see eventQueue_Post()
+ *****************************************************************************/
+AppEvent_e eventQueue_Get(void)
+{
+	AppEvent_e event = AppEvent_None;
+	uint8_t tail = eventqueuetail;
+
+	if(tail != eventqueuehead)
+	{
+		event = (AppEvent_e)eventqueuebuffer[tail];
+		eventqueuetail = (uint8_t)((tail + 1U) & (EVENT_QUEUE_SIZE - 1U));
+	}
+	return event;
+}
+/*****************************************************************************
+ * @brief Checks whether the queue is empty.
+ *
+ * @param None
+ *
+ * @return bool
+ *
+ * @retval true   No pending events.
+ * @retval false  At least one event pending.
+ *
+ * @note Call with interrupts masked right before WFI to close the race
+ *       between the check and the sleep.
+ *****************************************************************************/
+bool eventQueue_IsEmpty(void)
+{
+	return (eventqueuehead == eventqueuetail);
+}
+/*****************************************************************************
+ * @brief Returns the number of dropped events.
+ *
+ * @param None
+ *
+ * @return uint32_t Dropped events since eventQueue_Init().
+ *****************************************************************************/
+uint32_t eventQueue_GetOverflowCount(void)
+{
+	return eventqueueoverflow;
+}
+/*************************************END*************************************/
@@ -0,0 +1,128 @@
+/**
+ * \file           eventqueue.h
+ * \brief          Application event queue header file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+#ifndef EVENTQUEUE_H_
+#define EVENTQUEUE_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "Platform_Translate.h"
+
+/*****************************************************************************/
+/* Event Queue Macros                                                        */
+/*****************************************************************************/
+
+/**
+ * @brief Number of slots in the event queue.
+ *
+ * @note Must be a power of two. One slot is always kept free to tell a full
+ *       queue from an empty one.
+ */
+#define EVENT_QUEUE_SIZE                     16U
+
+/*****************************************************************************/
+/* Event Queue Enums                                                         */
+/*****************************************************************************/
+
+/**
+ * @brief Events posted by the interrupt handlers to the application.
+ */
+typedef enum
+{
+	AppEvent_None,                    /**< No event (queue empty) */
+	AppEvent_SecondTick,              /**< One second elapsed (TIM3 or RTC) */
+	AppEvent_ControlPress,            /**< Control button pressed (debounced) */
+	AppEvent_ControlRelease,          /**< Control button released (debounced) */
+	AppEvent_ControlShortPress,       /**< Control button released before the long press time */
+	AppEvent_ControlLongPress,        /**< Control button held for the long press time */
+	AppEvent_FunctionPress,           /**< Function button pressed (debounced) */
+	AppEvent_FunctionRelease,         /**< Function button released (debounced) */
+	AppEvent_FunctionShortPress,      /**< Function button released before the long press time */
+	AppEvent_FunctionLongPress,       /**< Function button held for the long press time */
+	AppEvent_DisplayBlink,            /**< Blink the display while the timer is paused */
+	AppEvent_BatterySample,           /**< Battery ADC burst completed */
+	AppEvent_BatteryOk,               /**< Battery back above the low level (charged) */
+	AppEvent_BatteryLow,              /**< Battery below APP_BATTERY_LOW_MV */
+	AppEvent_BatteryCritical,         /**< Battery below APP_BATTERY_CRITICAL_MV */
+	AppEvent_IdleWake,                /**< RTC wake-up of the stopped timer (APP_IDLE_TIMEOUT) */
+	AppEvent_Count,                   /**< Number of event types */
+}AppEvent_e;
+
+/*****************************************************************************/
+/* Event Queue Function Declarations                                         */
+/*****************************************************************************/
+
+/**
+ * @brief Empties the event queue and clears the overflow counter.
+ */
+void eventQueue_Init(void);
+
+/**
+ * @brief Posts an event to the queue. Safe to call from any interrupt.
+ *
+ * @param[in] event Event to post.
+ *
+ * @return true if queued, false if the queue was full and the event dropped.
+ */
+bool eventQueue_Post(AppEvent_e event);
+
+/**
+ * @brief Takes the oldest event from the queue. Main loop only.
+ *
+ * @return The oldest event or AppEvent_None if the queue is empty.
+ */
+AppEvent_e eventQueue_Get(void);
+
+/**
+ * @brief Checks whether the queue holds no events.
+ *
+ * @return true if empty.
+ */
+bool eventQueue_IsEmpty(void);
+
+/**
+ * @brief Number of events dropped because the queue was full.
+ *
+ * @return Dropped event count since eventQueue_Init().
+ */
+uint32_t eventQueue_GetOverflowCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EVENTQUEUE_H_ */
@@ -36,12 +36,39 @@
 /* Include Files                                                             */
 /*****************************************************************************/
 #include "../UserApp/pomodorotimer.h"
-/*****************************************************************************/
-/* Private Defines                                                           */
-/*****************************************************************************/
-#define DEBOUNCEDELAY        20      /* The De-bounce Time; increase it if the output still flicker */
-/** Minimum time in milliseconds to consider a button press valid and ignore bouncing **/
+#include "eventqueue.h"
+#include "power.h"
+#include "rtcclock.h"
+#include "button.h"
+#include "buzzer.h"
+#include "hwtimer.h"
+#include "profiler.h"
+#include "tokenlog.h"
+#include "timebase.h"
+#include "faultcapture.h"
+#if APP_BATTERY_MONITOR
+#include "battery.h"
+#include "batteryadc.h"
+#endif
+#if APP_SESSION_LOG
+#include "sessionlog.h"
+#endif
+#if APP_PROFILE_STORE
+#include "profilestore.h"
+#endif
+#if APP_WATCHDOG
+#include "watchdog.h"
+#endif
+#if (APP_IDLE_STANDBY || APP_BROWNOUT_RESUME)
+#include "snapshot.h"
+#endif
 
+#if APP_IDLE_TIMEOUT && (APP_TIMEBASE != APP_TIMEBASE_RTC)
+#error "APP_IDLE_TIMEOUT needs APP_TIMEBASE_RTC, the idle time is counted on the RTC wake-ups"
+#endif
+#if (APP_DEBUG_OUTPUT == APP_DEBUG_OUTPUT_UART)
+#include "debugout.h"
+#endif
 /*****************************************************************************/
 /* External Variables                                                        */
 /*****************************************************************************/
@@ -50,33 +77,94 @@ extern TIM_HandleTypeDef htim3; /** Timer handler used for counting seconds **/
 /*****************************************************************************/
 /* Private Variables                                                         */
 /*****************************************************************************/
-volatile uintmax_t glbSecondCounter = 0; /** Used to count total seconds since the timer started **/
-
-volatile uintmax_t glbSysTicks = 0; /** System tick value that increments periodically **/
-
-uintmax_t glbLastSecondsCount = 0; /** Stores the last updated value of glbSecondCounter **/
+uint32_t glbLastSecondsCount = 0; /** Stores the last displayed value of timeBase_GetSeconds() **/
 
 uint8_t displayData[] = {0,0,0,0}; /** 4-digit array used for display driver **/
 
 bool glbLastDotState = false; /** Tracks the state of colon/dot between digits on the display **/
-bool glbTimerState = false; /** Indicates whether the timer is currently running or stopped **/
+bool glbColonShown = false; /** Colon state of the last drawn frame **/
+bool glbBlinkOff = false; /** Display switched off by the pause blink **/
+
+static const uint16_t glbBeepOnceSteps[] = { 50, 50, 0 }; /** One short beep **/
+static const uint16_t glbLongBeepSteps[] = { 2000, 200, 0 }; /** 2 s beep at the end of each timer **/
+static const uint16_t glbFinalBeepSteps[] = { 100, 150, 0 }; /** 250 ms short beep, repeated for 5 s **/
+#if APP_BATTERY_MONITOR
+static const uint16_t glbBatteryBeepSteps[] = { 300, 100, 0 }; /** 300 ms beep of the battery warnings **/
+#endif
+
+static const BuzzerPattern_t glbBeepOnce = { glbBeepOnceSteps, 1 }; /** Cue: Pomodoro done, short break starts **/
+static const BuzzerPattern_t glbBeepTwice = { glbBeepOnceSteps, 2 }; /** Cue: short break done, Pomodoro starts **/
+static const BuzzerPattern_t glbBeepThrice = { glbBeepOnceSteps, 3 }; /** Cue: long break done, Pomodoro starts **/
+static const BuzzerPattern_t glbLongBeep = { glbLongBeepSteps, 1 }; /** Timer finished **/
+static const BuzzerPattern_t glbFinalBeeps = { glbFinalBeepSteps, 20 }; /** 5 s of short beeps after the long break **/
+#if APP_BATTERY_MONITOR
+static const BuzzerPattern_t glbBatteryLowBeeps = { glbBatteryBeepSteps, 3 }; /** Battery low **/
+static const BuzzerPattern_t glbBatteryCriticalBeeps = { glbBatteryBeepSteps, 5 }; /** Battery critical, shutting down **/
+
+bool glbBatteryLow = false; /** Show the low battery warning **/
+#endif
+
+static const BuzzerPattern_t *const glbModeEndCues[PomodoroFunctions_Count] = /** Cue per finished mode **/
+{
+	[PomodoroFunctions_PomodoroMode] = &glbBeepOnce,
+	[PomodoroFunctions_ShortBreak]   = &glbBeepTwice,
+	[PomodoroFunctions_LongBreak]    = &glbBeepThrice,
+};
+
+#if APP_PROFILE_STORE
+static const BuzzerPattern_t glbBeepFourTimes = { glbBeepOnceSteps, 4 }; /** Cue: fourth profile selected **/
+
+static const BuzzerPattern_t *const glbProfileCues[PROFILESTORE_MAX] = /** Cue per selected profile, one beep per number **/
+{
+	&glbBeepOnce, &glbBeepTwice, &glbBeepThrice, &glbBeepFourTimes,
+};
+#endif
+
+#if APP_SCHEDULER_STATS
+/**
+ * @brief Scheduler residency statistics for one report period.
+ */
+typedef struct
+{
+	uint64_t activeCycles;   /**< Core cycles spent awake */
+	uint32_t wakeups;        /**< Number of WFI exits */
+	uint32_t events;         /**< Number of dispatched events */
+	uint32_t seconds;        /**< Length of the period in seconds */
+}SchedulerStats_t;
+
+static SchedulerStats_t glbSchedulerStats = { 0 }; /** Statistics of the running report period **/
+
+static uint32_t glbWakeCycles = 0; /** DWT->CYCCNT when the core last woke up **/
+#endif
+
+#if (APP_IDLE_STANDBY || APP_BROWNOUT_RESUME)
+static Snapshot_t glbResumeSnapshot; /** Session drawn by userBootDisplay(), continued by userInit() **/
+
+static bool glbResumePending = false; /** glbResumeSnapshot restored but not yet continued **/
+#endif
+
+#if APP_PROFILER
+static uint32_t glbProfilerSeconds = 0; /** Seconds since the last profiler report **/
+#endif
 
-PomodoroFunctions_e glbModeSelection = PomodoroFunctions_PomodoroMode; /** Current mode of Pomodoro session **/
+static HwTimer_t glbBlinkTimer; /** Periodic pause blink **/
 
-uintmax_t glbCurrentModeTime = POMODOROMODE_TIME; /** Duration of the current mode **/
+#if APP_IDLE_TIMEOUT
+static uint32_t glbIdleSeconds = 0; /** Seconds since the last button press, counted while the timer is not running **/
 
-uint8_t glbPomodoroCycles = 0; /** Counter for the number of Pomodoro sessions completed **/
+static bool glbIdleAsleep = false; /** Display off in deep idle, the next press only wakes it **/
+
+static uint8_t glbIdleWakeButtons = 0; /** Buttons whose press woke the display, bit per ButtonId_e; their short and long press are dropped **/
+#endif
 
 /*****************************************************************************/
 /* User Function                                                             */
 /*****************************************************************************/
 /*****************************************************************************
- * @brief Handles the control button with software debounce logic.
+ * @brief Draws the current frame again, on or off for the pause blink.
  *
- * @details This function checks for a stable button press on GPIO_PIN_0.
- *          When pressed, it toggles the timer state between start and stop.
- *          It resets the Pomodoro mode, timer counter, and cycles when toggled.
- *          It also starts or stops the TIM3 interrupt accordingly.
+ * @details Only the display control command goes on the bus, the digits
+ *          and the colon are unchanged.
  *
  * @param   None
  *
@@ -84,263 +172,932 @@ uint8_t glbPomodoroCycles = 0; /** Counter for the number of Pomodoro sessions c
  *
  * @retval  None
  *
- * @note The function must be called periodically inside the main loop.
- *       It uses `glbSysTicks` as a system time base for debounce delay.
+ * @see TM1637_SetDisplayControl()
+ *****************************************************************************/
+static void displayRedraw(void)
+{
+	TM1637_SetDisplayControl(DISPLAY_COMMAND|PULSE_WIDTH_SET_04_16|(glbBlinkOff ? DISPLAY_OFF : DISPLAY_ON));
+	TM1637_Update_Data_Dots(displayData,glbColonShown);
+}
+/*****************************************************************************
+ * @brief Pause blink timer, asks for a blink.
+ *
+ * @note Runs in the TIM4 interrupt.
+ *****************************************************************************/
+static void displayBlinkExpired(HwTimer_t *timer)
+{
+	(void)timer;
+	(void)eventQueue_Post(AppEvent_DisplayBlink);
+}
+/*****************************************************************************
+ * @brief Starts or stops the clock of the pause blink.
+ *
+ * @details With the RTC timebase the blink runs on the RTC half second
+ *          alarm, which wakes the MCU from STOP, so a paused timer does not
+ *          hold selectIdleMode() in sleep. The periodic TIM4 software timer
+ *          is the clock of the TIM3 timebase and the fallback should the
+ *          alarm not start.
  *
- * @warning Assumes HAL_TIM_Base_Start_IT and HAL_TIM_Base_Stop_IT will
- *          handle timer errors through Error_Handler().
+ * @param[in] enable  true to start blinking.
  *
- * @see HAL_GPIO_ReadPin(), HAL_TIM_Base_Start_IT(), HAL_TIM_Base_Stop_IT()
+ * @return  None
+ *
+ * @retval  None
  *****************************************************************************/
-void buttonControlDebounce(void)
+static void displayBlinkClock(bool enable)
 {
-	static uintmax_t glbLastDebounceTime = 0;  /* The Last Time The Output Pin Was Toggled */
-	static uint8_t glbButtonState;            /* The Current Reading From The Input Pin */
-	static uint8_t glbLastButtonState = 0;    /* The previous reading from The Input Pin */
-
-	uint8_t tempButtonReading = CONTROLBUTTON_READ(); /* read the state of the switch into a local variable */
-	/** GPIO_PIN_0 is the control button used to start/stop the Pomodoro timer **/
-
-    if(tempButtonReading != glbLastButtonState) /* If the switch changed, due to noise or pressing */
-    {
-        glbLastDebounceTime = glbSysTicks; /* reset the debouncing timer */
-    }
-
-    if((glbSysTicks - glbLastDebounceTime) > DEBOUNCEDELAY)
-    {
-        if(tempButtonReading != glbButtonState)
-        {
-            glbButtonState = tempButtonReading;
-            if(glbButtonState == GPIO_PIN_RESET) /** Button is pressed **/
-            {
-            	if(glbTimerState == false)
-            	{
-            		/* Start counting seconds*/
-                    glbSecondCounter = 0;
-
-                    /*Reset Mode counter*/
-                    glbModeSelection = PomodoroFunctions_PomodoroMode;
-
-                    /* Reset Time selection*/
-                    glbCurrentModeTime = POMODOROMODE_TIME;
-
-                    /*Reset Pomodoro Cycles*/
-                    glbPomodoroCycles = 0;
-
-            		glbTimerState = true;
-            		/* Start The timer */
-            	    if (TIMER_ON() != HAL_OK)
-            		{
-            		  /* Starting Error */
-            		  Error_Handler();
-            		}
-            	}
-            	else if(glbTimerState == true)
-				{
-            		/* Start counting seconds*/
-                    glbSecondCounter = 0;
-
-                    /*Reset Mode counter*/
-                    glbModeSelection = PomodoroFunctions_PomodoroMode;
-
-                    /* Reset Time selection*/
-                    glbCurrentModeTime = POMODOROMODE_TIME;
-
-                    /*Reset Pomodoro Cycles*/
-                    glbPomodoroCycles = 0;
-
-            		glbTimerState = false;
-                	/* Stop The timer */
-                   if (TIMER_OFF() != HAL_OK)
-                   {
-                	   /* Stopping Error */
-                	   Error_Handler();
-                   }
-				}
-            }
-        }
-    }
-    glbLastButtonState = tempButtonReading; /** Store current reading for comparison in next cycle **/
+#if (APP_TIMEBASE == APP_TIMEBASE_RTC)
+	if(RtcClock_SetBlink(enable) == HAL_OK)
+	{
+		enable = false; /** The alarm blinks, no TIM4 timer **/
+	}
+#endif
+	if(enable)
+	{
+		HwTimer_StartPeriodic(&glbBlinkTimer, PAUSE_BLINK_TIME, displayBlinkExpired);
+	}
+	else
+	{
+		HwTimer_Stop(&glbBlinkTimer);
+	}
 }
 /*****************************************************************************
- * @brief Handles the function button to switch Pomodoro modes.
+ * @brief Starts or stops blinking the display.
  *
- * @details This function reads GPIO_PIN_1 and applies debounce logic. When the
- *          button is pressed, it transitions between Pomodoro, Short Break, and
- *          Long Break modes. It also resets the Pomodoro second counter and
- *          updates the mode time and cycle count.
+ * @details Blinking runs on the RTC alarm or a periodic software timer, so
+ *          the core still sleeps between the blinks. Stopping leaves the
+ *          display on.
  *
- * @param   None
+ * @param[in] enable  true while the timer is paused.
  *
  * @return  None
  *
  * @retval  None
+ *****************************************************************************/
+static void displayBlink(bool enable)
+{
+	displayBlinkClock(enable);
+	if(enable == false)
+	{
+		if(glbBlinkOff)
+		{
+			glbBlinkOff = false;
+			displayRedraw();
+		}
+	}
+}
+/*****************************************************************************
+ * @brief Session hook: drives the one second timebase and the elapsed seconds.
+ *
+ * @details Start, restart and zero begin a full second at zero elapsed
+ *          seconds, the phase of the timebase is restarted with the counter
+ *          stopped. Pause and resume only stop and start the timebase, TIM3
+ *          keeps its counter and prescaler meanwhile, so paused time is
+ *          left out exactly to the 100 us timer tick; the RTC timebase keeps
+ *          the rest of the paused second to one SSR step (~0.5 ms).
+ *          Stopping also silences a running alarm; the display blinks
+ *          while paused.
  *
- * @note Call this periodically in the main loop. The function uses a debounce
- *       timer based on `glbSysTicks`.
+ * @param[in] action  What the session engine asks for.
  *
- * @warning Cycle count wraps after 4 Pomodoro sessions(4 Pomodoros & 4 Short Breaks)
- *          and switches to a Long Break automatically.
+ * @return  None
  *
- * @see HAL_GPIO_ReadPin()
+ * @retval  None
+ *
+ * @warning Assumes TIMER_ON() and TIMER_OFF() errors are handled through
+ *          Error_Handler().
+ *
+ * @see session_Dispatch(), TIMER_PHASE_RESET()
  *****************************************************************************/
-void buttonFunctionDebounce(void)
+static void sessionTimer(SessionTimer_e action)
 {
-	static uintmax_t glbLastDebounceTime = 0;  /* The Last Time The Output Pin Was Toggled */
-	static uint8_t glbButtonState;            /* The Current Reading From The Input Pin */
-	static uint8_t glbLastButtonState = 0;    /* The previous reading from The Input Pin */
-
-	uint8_t tempButtonReading = FUNCTIONBUTTON_READ(); /* read the state of the switch into a local variable */
-	/** GPIO_PIN_1 is the function button used to switch between Pomodoro modes **/
-
-    if(tempButtonReading != glbLastButtonState) /* If the switch changed, due to noise or pressing */
-    {
-        glbLastDebounceTime = glbSysTicks; /* reset the debouncing timer */
-    }
-
-    if((glbSysTicks - glbLastDebounceTime) > DEBOUNCEDELAY)
-    {
-        if(tempButtonReading != glbButtonState)
-        {
-            glbButtonState = tempButtonReading;
-            if(glbButtonState == GPIO_PIN_RESET) /** Button is pressed **/
-            {
-            	glbSecondCounter = 0;
-            	if(glbModeSelection == PomodoroFunctions_PomodoroMode)
-            	{
-            		glbModeSelection = PomodoroFunctions_ShortBreak;
-            		glbCurrentModeTime = SHORTBREAK_TIME;
-            		glbPomodoroCycles++;
-            	}
-            	else if(glbModeSelection == PomodoroFunctions_ShortBreak)
-            	{
-            		glbPomodoroCycles++;
-            		if(glbPomodoroCycles >= NO_OF_CYCLES)
-            		{
-            			glbModeSelection = PomodoroFunctions_LongBreak;
-            			glbCurrentModeTime = LONGBREAK_TIME;
-            			glbPomodoroCycles = 0;
-            		}
-            		else
-            		{
-            			glbModeSelection = PomodoroFunctions_PomodoroMode;
-            			glbCurrentModeTime = POMODOROMODE_TIME;
-            		}
-            	}
-            	else if(glbModeSelection == PomodoroFunctions_LongBreak)
-            	{
-            		glbModeSelection = PomodoroFunctions_PomodoroMode;
-            		glbCurrentModeTime = POMODOROMODE_TIME;
-            	}
-            }
-        }
-    }
-    glbLastButtonState = tempButtonReading; /** Store current reading for comparison in next cycle **/
+	HAL_StatusTypeDef status = HAL_OK;
+
+	switch(action)
+	{
+		case SessionTimer_Start:
+			TIMER_PHASE_RESET();
+			timeBase_ResetSeconds();
+			status = TIMER_ON();
+#if APP_BATTERY_MONITOR
+			battery_Measure(); /** Not measured while the timer was stopped **/
+#endif
+			break;
+		case SessionTimer_Stop:
+			Buzzer_Stop(); /** Silence a running alarm **/
+			status = TIMER_OFF();
+			timeBase_ResetSeconds();
+			displayBlink(false);
+			break;
+		case SessionTimer_Pause:
+			status = TIMER_OFF();
+			displayBlink(true);
+			break;
+		case SessionTimer_Resume:
+			displayBlink(false);
+			status = TIMER_ON();
+			break;
+		case SessionTimer_Restart:
+			status = TIMER_OFF();
+			TIMER_PHASE_RESET();
+			timeBase_ResetSeconds();
+			if(status == HAL_OK)
+			{
+				status = TIMER_ON();
+			}
+			break;
+		default:
+			TIMER_PHASE_RESET();
+			timeBase_ResetSeconds();
+			break;
+	}
+
+	if (status != HAL_OK)
+	{
+		/* Timer Error */
+		Error_Handler();
+	}
 }
 /*****************************************************************************
- * @brief Updates the display with the current Pomodoro timer value.
+ * @brief Session hook: plays the buzzer cue when a mode ends.
  *
- * @details Compares `glbSecondCounter` with the previous value. If changed,
- *          the function converts the new value to digits for display. It also
- *          toggles the dot/colon visual on the display and manages transitions
- *          between Pomodoro, Short Break, and Long Break modes based on elapsed time.
+ * @details The cue of the finished mode (one, two or three short beeps)
+ *          plays for a skip as well as for the end of time. Only the end of
+ *          time is announced by the 2 s long beep first, and the end of the
+ *          long break adds 5 s of short beeps.
  *
- * @param   None
+ * @param[in] finished  Mode that just ended.
+ * @param[in] cause     SessionEvent_TimeUp or SessionEvent_Skip.
  *
  * @return  None
  *
  * @retval  None
  *
- * @note TM1637_Convert_To_Digits() converts the seconds into 4-digit format.
- *       TM1637_Update_Data_Dots() toggles the colon/dot every second for blinking.
+ * @note The patterns are queued to the buzzer pattern player and never
+ *       block the main loop.
+ *****************************************************************************/
+static void sessionModeEnd(PomodoroFunctions_e finished, SessionEvent_e cause)
+{
+	if(cause == SessionEvent_TimeUp)
+	{
+		(void)Buzzer_Play(&glbLongBeep);
+	}
+	(void)Buzzer_Play(glbModeEndCues[finished]);
+	if((cause == SessionEvent_TimeUp) && (finished == PomodoroFunctions_LongBreak))
+	{
+		(void)Buzzer_Play(&glbFinalBeeps); /** Whole Pomodoro cycle done **/
+	}
+}
+/*****************************************************************************
+ * @brief Session hook: shows the elapsed seconds of the current mode.
+ *
+ * @details Converts the seconds to digits and toggles the colon, so it
+ *          blinks with every new second. With a low battery every
+ *          BATTERY_WARNING_PERIOD-th second shows "----" instead.
+ *
+ * @param[in] elapsed  Elapsed seconds of the current mode.
+ *
+ * @return  None
+ *
+ * @retval  None
  *
  * @warning Be sure that the display is initialized before calling this.
  *
  * @see TM1637_Convert_To_Digits(), TM1637_Update_Data_Dots()
  *****************************************************************************/
-void updateDisplay(void)
+static void sessionDisplay(uint32_t elapsed)
 {
-	if(glbLastSecondsCount != glbSecondCounter)
+	glbLastSecondsCount = elapsed; /** Update the stored count for future comparison **/
+	TM1637_Convert_To_Digits(elapsed,&displayData[0]); /** Convert seconds to digit format **/
+#if APP_BATTERY_MONITOR
+	if(glbBatteryLow && ((elapsed % BATTERY_WARNING_PERIOD) == (BATTERY_WARNING_PERIOD - 1U)))
 	{
-		/** Time has changed, so update the display **/
-		if(glbSecondCounter == glbCurrentModeTime)
-		{
-        	glbSecondCounter = 0;
-        	if(glbModeSelection == PomodoroFunctions_PomodoroMode)
-        	{
-        		glbModeSelection = PomodoroFunctions_ShortBreak;
-        		glbCurrentModeTime = SHORTBREAK_TIME;
-        		glbPomodoroCycles++;
-        		BUZZER_ON();
-        		APP_DELAY(50);
-        		BUZZER_OFF();
-        	}
-        	else if(glbModeSelection == PomodoroFunctions_ShortBreak)
-        	{
-        		glbPomodoroCycles++;
-        		if(glbPomodoroCycles >= NO_OF_CYCLES)
-        		{
-        			glbModeSelection = PomodoroFunctions_LongBreak;
-        			glbCurrentModeTime = LONGBREAK_TIME;
-        			glbPomodoroCycles = 0;
-        		}
-        		else
-        		{
-        			glbModeSelection = PomodoroFunctions_PomodoroMode;
-        			glbCurrentModeTime = POMODOROMODE_TIME;
-        		}
-        		BUZZER_ON();
-        		APP_DELAY(50);
-        		BUZZER_OFF();
-        		APP_DELAY(50);
-        		BUZZER_ON();
-        		APP_DELAY(50);
-        		BUZZER_OFF();
-        	}
-        	else if(glbModeSelection == PomodoroFunctions_LongBreak)
-        	{
-        		glbModeSelection = PomodoroFunctions_PomodoroMode;
-        		glbCurrentModeTime = POMODOROMODE_TIME;
-
-        		BUZZER_ON();
-        		APP_DELAY(50);
-        		BUZZER_OFF();
-        		APP_DELAY(50);
-        		BUZZER_ON();
-        		APP_DELAY(50);
-        		BUZZER_OFF();
-        		APP_DELAY(50);
-        		BUZZER_ON();
-        		APP_DELAY(50);
-        		BUZZER_OFF();
-        	}
-		}
+		memset(displayData, TM1637_DIGIT_DASH, sizeof(displayData)); /** Low battery warning "----" **/
+	}
+#endif
 
-		glbLastSecondsCount = glbSecondCounter; /** Update the stored count for future comparison **/
-		TM1637_Convert_To_Digits(glbSecondCounter,&displayData[0]); /** Convert seconds to digit format **/
+	if(glbLastDotState == true)
+	{
+		glbLastDotState = false;
+		glbColonShown = true;
+		TM1637_Update_Data_Dots(displayData,true); /** Toggle dot ON **/
+	}
+	else if(glbLastDotState == false)
+	{
+		glbLastDotState = true;
+		glbColonShown = false;
+		TM1637_Update_Data_Dots(displayData,false); /** Toggle dot OFF **/
+	}
+}
 
-		if(glbLastDotState == true)
-		{
-			glbLastDotState = false;
-			TM1637_Update_Data_Dots(displayData,true); /** Toggle dot ON **/
-		}
-		else if(glbLastDotState == false)
+/*****************************************************************************
+ * @brief Session end hook of the engine.
+ *
+ * @details Stages the session in the history log, it is written to flash
+ *          from userProcess().
+ *
+ * @param[in] summary  Session that ended.
+ *
+ * @return  None
+ *
+ * @retval  None
+ *
+ * @see sessionLog_Append()
+ *****************************************************************************/
+static void sessionEnded(const SessionSummary_t *summary)
+{
+#if APP_SESSION_LOG
+	(void)sessionLog_Append(summary);
+#else
+	(void)summary;
+#endif
+}
+
+#if APP_PROFILE_STORE
+/*****************************************************************************
+ * @brief Selects the next session profile, only while the timer is stopped.
+ *
+ * @details The session engine takes a copy of the profile, the display
+ *          shows its Pomodoro length until the timer starts and the buzzer
+ *          beeps the profile number. The choice is written to flash from
+ *          userProcess().
+ *
+ * @param   None
+ *
+ * @return  None
+ *
+ * @retval  None
+ *
+ * @see profileStore_Select(), session_SetProfile()
+ *****************************************************************************/
+static void profileNext(void)
+{
+	uint8_t index = (uint8_t)((profileStore_GetSelected() + 1U) % profileStore_GetCount());
+	const ProfileStoreEntry_t *entry = profileStore_Get(index);
+
+	if((session_GetRun() != SessionRun_Stopped) || (session_SetProfile(&entry->profile) == false))
+	{
+		return;
+	}
+	(void)profileStore_Select(index);
+	sessionDisplay(entry->profile.duration[PomodoroFunctions_PomodoroMode]);
+	(void)Buzzer_Play(glbProfileCues[index]);
+}
+#endif
+
+#if APP_BATTERY_MONITOR
+/*****************************************************************************
+ * @brief Controlled shutdown on a critical battery.
+ *
+ * @details Stops the timer and the pause blink, shows "----" while the
+ *          critical beeps play to the end, switches the display off and
+ *          puts the MCU into STANDBY. The running session is written to the
+ *          history log, the timer starts again from reset once the battery
+ *          is charged.
+ *
+ * @param   None
+ *
+ * @return  None
+ *
+ * @retval  None
+ *
+ * @note Does not return. Blocks in WFI for the beeps, nothing else has to
+ *       run any more.
+ *
+ * @see Power_Standby()
+ *****************************************************************************/
+static void batteryShutdown(void)
+{
+#if APP_SESSION_LOG
+	SessionSummary_t summary;
+#endif
+
+	(void)TIMER_OFF();
+	displayBlinkClock(false);
+	Buzzer_Stop();
+#if APP_SESSION_LOG
+	if(session_GetSummary(SessionEnd_Shutdown, &summary))
+	{
+		(void)sessionLog_Append(&summary);
+	}
+	sessionLog_Flush(true);
+#endif
+
+	memset(displayData, TM1637_DIGIT_DASH, sizeof(displayData));
+	glbColonShown = false;
+	glbBlinkOff = false;
+	displayRedraw();
+
+	(void)Buzzer_Play(&glbBatteryCriticalBeeps);
+	while(Buzzer_IsBusy() || TM1637_Bus_IsBusy())
+	{
+		APP_WAIT_FOR_INTERRUPT();
+	}
+
+	glbBlinkOff = true;
+	displayRedraw(); /** Display off **/
+	while(TM1637_Bus_IsBusy())
+	{
+	}
+
+	Power_Standby();
+}
+#endif
+
+#if APP_IDLE_TIMEOUT
+/*****************************************************************************
+ * @brief Enters deep idle.
+ *
+ * @details Stops the pause blink and switches the display off. In STOP the
+ *          state stays in RAM and the next button press wakes the display.
+ *          With APP_IDLE_STANDBY the session and the selected profile are
+ *          saved into the RTC backup registers, the staged history goes
+ *          to flash and the MCU enters STANDBY; the control button starts
+ *          it again from reset, userBootDisplay() shows the saved session
+ *          and userInit() continues it.
+ *
+ * @param   None
+ *
+ * @return  None
+ *
+ * @retval  None
+ *
+ * @note Does not return with APP_IDLE_STANDBY.
+ *
+ * @see idleWake(), sessionRestore(), sessionResume()
+ *****************************************************************************/
+static void idleEnter(void)
+{
+	displayBlinkClock(false); /** Pause blink **/
+	glbIdleAsleep = true;
+	glbBlinkOff = true;
+	displayRedraw(); /** Display off **/
+
+#if APP_IDLE_STANDBY
+	Snapshot_t snapshot;
+
+	session_GetState(&snapshot.state);
+#if APP_PROFILE_STORE
+	snapshot.profile = profileStore_GetSelected();
+#else
+	snapshot.profile = 0U;
+#endif
+	snapshot.reason = SnapshotReason_Idle;
+	snapshot_Save(&snapshot);
+#if APP_SESSION_LOG
+	sessionLog_Flush(true);
+#endif
+
+	DEBUG_LOG("idle: standby\r\n");
+	while(TM1637_Bus_IsBusy())
+	{
+	}
+#if (APP_DEBUG_OUTPUT == APP_DEBUG_OUTPUT_UART)
+	while(DebugOut_IsBusy())
+	{
+	}
+#endif
+	Power_StandbyWakePin();
+#endif
+}
+/*****************************************************************************
+ * @brief Leaves deep idle in STOP: the display comes back, a paused timer
+ *        blinks again.
+ *
+ * @param   None
+ *
+ * @return  None
+ *
+ * @retval  None
+ *****************************************************************************/
+static void idleWake(void)
+{
+	glbIdleAsleep = false;
+	glbBlinkOff = false;
+	displayRedraw();
+	if(session_IsPaused())
+	{
+		displayBlink(true);
+	}
+}
+/*****************************************************************************
+ * @brief Counts the idle time and wakes the display on a button press.
+ *
+ * @details The RTC wake-ups of the stopped timer add their period. A press
+ *          starts the idle time again; in deep idle it only wakes the
+ *          display, and the short or long press it ends in is dropped too.
+ *
+ * @param[in] event  Event taken from the queue.
+ *
+ * @return  bool
+ *
+ * @retval  true   Event used up here.
+ * @retval  false  Dispatch it.
+ *****************************************************************************/
+static bool idleFilter(AppEvent_e event)
+{
+	bool consumed = false;
+	uint8_t button = 0;
+
+	switch(event)
+	{
+		case AppEvent_IdleWake:
+			if(session_IsRunning() == false)
+			{
+				glbIdleSeconds += RtcClock_GetWakePeriod();
+			}
+			consumed = true;
+			break;
+		case AppEvent_ControlPress:
+		case AppEvent_FunctionPress:
+			button = (uint8_t)(1U << ((event == AppEvent_ControlPress) ? ButtonId_Control : ButtonId_Function));
+			glbIdleSeconds = 0;
+			glbIdleWakeButtons &= (uint8_t)~button; /** A new press counts again **/
+			if(glbIdleAsleep)
+			{
+				idleWake();
+				glbIdleWakeButtons |= button;
+				consumed = true;
+			}
+			break;
+		case AppEvent_ControlShortPress:
+		case AppEvent_ControlLongPress:
+			consumed = ((glbIdleWakeButtons & (1U << ButtonId_Control)) != 0U);
+			break;
+		case AppEvent_FunctionShortPress:
+		case AppEvent_FunctionLongPress:
+			consumed = ((glbIdleWakeButtons & (1U << ButtonId_Function)) != 0U);
+			break;
+		case AppEvent_DisplayBlink:
+			consumed = glbIdleAsleep; /** Queued before the display went off **/
+			break;
+		default:
+			break;
+	}
+	return consumed;
+}
+/*****************************************************************************
+ * @brief Enters deep idle after APP_IDLE_TIMEOUT seconds without a press.
+ *
+ * @details Only with the timer stopped or paused and the buzzer silent.
+ *
+ * @param   None
+ *
+ * @return  None
+ *
+ * @retval  None
+ *****************************************************************************/
+static void idleService(void)
+{
+	if((glbIdleAsleep == false) && (session_IsRunning() == false) &&
+	   (glbIdleSeconds >= APP_IDLE_TIMEOUT) && (Buzzer_IsBusy() == false))
+	{
+		idleEnter();
+	}
+}
+#endif
+
+#if APP_BROWNOUT_RESUME
+/*****************************************************************************
+ * @brief Saves the session when the supply falls below the PVD level.
+ *
+ * @details Runs in the PVD interrupt, which nothing else preempts. A
+ *          running timer takes its elapsed seconds from the time base,
+ *          kept below the mode length, so a scheduler pass cut in the
+ *          middle of a mode change still gives a state session_SetState()
+ *          takes; at most that second is lost. The buzzer is stopped to
+ *          save current, then the MCU waits for the brownout reset. The
+ *          core cycles from here to the saved snapshot are kept for the
+ *          next boot, which prints them against APP_BROWNOUT_WINDOW_US.
+ *
+ * @param   None
+ *
+ * @return  None
+ *
+ * @retval  None
+ *
+ * @note Does not return.
+ *
+ * @see sessionRestore(), Power_BrownoutHold()
+ *****************************************************************************/
+void HAL_PWR_PVDCallback(void)
+{
+	uint32_t start = APP_CYCLE_COUNTER();
+	Snapshot_t snapshot;
+
+	session_GetState(&snapshot.state);
+	if(snapshot.state.run == SessionRun_Running)
+	{
+		uint32_t seconds = timeBase_GetSeconds();
+		uint32_t last = session_GetDuration() - 1U;
+		snapshot.state.elapsed = (uint16_t)((seconds < last) ? seconds : last);
+	}
+#if APP_PROFILE_STORE
+	snapshot.profile = profileStore_GetSelected();
+#else
+	snapshot.profile = 0U;
+#endif
+	snapshot.reason = SnapshotReason_PowerFail;
+	snapshot_Save(&snapshot);
+	snapshot_SetCycles(APP_CYCLE_COUNTER() - start);
+
+	Buzzer_Stop();
+	Power_BrownoutHold();
+}
+#endif
+
+#if (APP_IDLE_STANDBY || APP_BROWNOUT_RESUME)
+/*****************************************************************************
+ * @brief Puts the session saved before the last STANDBY or brownout back
+ *        on the display.
+ *
+ * @details Selects the saved profile, puts the session engine back into
+ *          the saved state and draws it. The snapshot is removed, it is
+ *          used once; sessionResume() starts the timer or the blink once
+ *          the timers run.
+ *
+ * @param   None
+ *
+ * @return  None
+ *
+ * @retval  None
+ *
+ * @note Called from userBootDisplay(), the timer is stopped.
+ *
+ * @see idleEnter(), HAL_PWR_PVDCallback(), session_SetState()
+ *****************************************************************************/
+static void sessionRestore(void)
+{
+	glbResumePending = false;
+	if(snapshot_Load(&glbResumeSnapshot) == false)
+	{
+		return;
+	}
+	snapshot_Clear();
+
+#if APP_PROFILE_STORE
+	if((glbResumeSnapshot.profile < profileStore_GetCount()) &&
+	   (glbResumeSnapshot.profile != profileStore_GetSelected()) &&
+	   session_SetProfile(&profileStore_Get(glbResumeSnapshot.profile)->profile))
+	{
+		(void)profileStore_Select(glbResumeSnapshot.profile);
+	}
+#endif
+	if(session_SetState(&glbResumeSnapshot.state) == false)
+	{
+		return; /** Not for this profile, start stopped **/
+	}
+
+	timeBase_SetSeconds(glbResumeSnapshot.state.elapsed);
+	sessionDisplay(glbResumeSnapshot.state.elapsed);
+	glbResumePending = true;
+}
+/*****************************************************************************
+ * @brief Continues the session put on the display by sessionRestore().
+ *
+ * @details A paused timer blinks again, a running one starts counting
+ *          with a full first second. After a brownout the time the
+ *          snapshot took is printed.
+ *
+ * @param   None
+ *
+ * @return  None
+ *
+ * @retval  None
+ *
+ * @note Called from userInit(), after the timers and the RTC are set up.
+ *
+ * @see sessionRestore()
+ *****************************************************************************/
+static void sessionResume(void)
+{
+	static const char *const reasons[SnapshotReason_Count] = { "idle", "brownout" };
+
+	if(glbResumePending == false)
+	{
+		return;
+	}
+	glbResumePending = false;
+
+	if(session_IsPaused())
+	{
+		displayBlink(true);
+	}
+	else if(session_IsRunning())
+	{
+		TIMER_PHASE_RESET();
+		if(TIMER_ON() != HAL_OK)
 		{
-			glbLastDotState = true;
-			TM1637_Update_Data_Dots(displayData,false); /** Toggle dot OFF **/
+			Error_Handler();
 		}
 	}
+	DEBUG_LOG("resume: %s, mode %u at %u s\r\n", DEBUG_LOG_STRING(reasons[glbResumeSnapshot.reason]),
+			(unsigned)glbResumeSnapshot.state.mode, (unsigned)glbResumeSnapshot.state.elapsed);
+#if APP_BROWNOUT_RESUME
+	uint32_t cycles = snapshot_TakeCycles();
+	if(glbResumeSnapshot.reason == SnapshotReason_PowerFail)
+	{
+		uint32_t us = cycles / (SystemCoreClock / 1000000U);
+		DEBUG_LOG("brownout: snapshot %lu cyc, %lu us of %lu us%s\r\n", (unsigned long)cycles,
+				(unsigned long)us, (unsigned long)APP_BROWNOUT_WINDOW_US,
+				DEBUG_LOG_STRING(((us * 4U) > APP_BROWNOUT_WINDOW_US) ? ", over a quarter" : ""));
+	}
+#endif
+}
+#endif
+
+/**
+ * @brief Hooks of the session engine.
+ */
+static const SessionHooks_t glbSessionHooks =
+{
+	.timer = sessionTimer,
+	.modeEnd = sessionModeEnd,
+	.display = sessionDisplay,
+	.ended = sessionEnded,
+};
+
+/*****************************************************************************
+ * @brief Updates the display with the current Pomodoro timer value.
+ *
+ * @details Takes one snapshot of the elapsed seconds from the time base and
+ *          hands it to the session engine, which redraws the display when it
+ *          changed and moves to the next mode when the current one is over.
+ *          The length of a finished mode is consumed from the time base, so
+ *          the next mode starts exactly where the last one ended.
+ *
+ * @param   None
+ *
+ * @return  None
+ *
+ * @retval  None
+ *
+ * @see session_Update(), timeBase_ConsumeSeconds()
+ *****************************************************************************/
+void updateDisplay(void)
+{
+	uint32_t consumed = session_Update(timeBase_GetSeconds()); /** One snapshot for the whole update **/
+
+	if(consumed != 0U)
+	{
+		timeBase_ConsumeSeconds(consumed);
+	}
+}
+
+/*****************************************************************************
+ * @brief EXTI callback for the control and function buttons.
+ *
+ * @details Called by HAL_GPIO_EXTI_IRQHandler() on every edge of PA0/PA1.
+ *          Hands the edge to the button state machine, which debounces it
+ *          and posts the press/release/short/long press events.
+ *
+ * @param[in] GPIO_Pin  Pin mask of the line that triggered.
+ *
+ * @return  None
+ *
+ * @retval  None
+ *
+ * @note Runs in interrupt context.
+ *
+ * @see button_Edge()
+ *****************************************************************************/
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+	if(GPIO_Pin == GPIO_PIN_0)
+	{
+		button_Edge(ButtonId_Control);
+	}
+	else if(GPIO_Pin == GPIO_PIN_1)
+	{
+		button_Edge(ButtonId_Function);
+	}
+}
+/*****************************************************************************
+ * @brief Dispatches one event taken from the event queue.
+ *
+ * @details Button events are translated into session events: control
+ *          short press starts, pauses and resumes the timer, control long
+ *          press restarts the current session (stops a paused timer), a
+ *          function short press skips to the next mode and a function long
+ *          press on a stopped timer selects the next profile. Second ticks need
+ *          no work here, the display is refreshed after the queue is
+ *          drained. A blink tick switches the display on or off while the
+ *          timer is paused. A completed battery burst is filtered; a low
+ *          battery beeps and turns the display warning on, a critical one
+ *          shuts the timer down. The idle time and the press that wakes
+ *          the display from deep idle are handled first.
+ *
+ * @param[in] event  Event to handle.
+ *
+ * @return  None
+ *
+ * @retval  None
+ *
+ * @see session_Dispatch()
+ *****************************************************************************/
+static void dispatchEvent(AppEvent_e event)
+{
+#if APP_IDLE_TIMEOUT
+	if(idleFilter(event))
+	{
+		return;
+	}
+#endif
+	switch(event)
+	{
+		case AppEvent_ControlShortPress:
+			session_Dispatch(SessionEvent_StartPause);
+			break;
+		case AppEvent_ControlLongPress:
+			session_Dispatch(SessionEvent_Restart);
+			break;
+		case AppEvent_FunctionShortPress:
+			session_Dispatch(SessionEvent_Skip);
+			break;
+#if APP_PROFILE_STORE
+		case AppEvent_FunctionLongPress:
+			profileNext();
+			break;
+#endif
+		case AppEvent_DisplayBlink:
+			if(session_IsPaused())
+			{
+				glbBlinkOff = !glbBlinkOff;
+				displayRedraw();
+			}
+			break;
+#if APP_BATTERY_MONITOR
+		case AppEvent_BatterySample:
+			battery_Process();
+			break;
+		case AppEvent_BatteryOk:
+			glbBatteryLow = false;
+			break;
+		case AppEvent_BatteryLow:
+			glbBatteryLow = true;
+			(void)Buzzer_Play(&glbBatteryLowBeeps);
+			break;
+		case AppEvent_BatteryCritical:
+			batteryShutdown();
+			break;
+#endif
+		case AppEvent_SecondTick:
+			FaultCapture_SecondTick();
+#if APP_BATTERY_MONITOR
+			battery_SecondTick();
+#endif
+#if APP_SCHEDULER_STATS
+			glbSchedulerStats.seconds++;
+#endif
+#if APP_PROFILER
+			glbProfilerSeconds++;
+#endif
+			break;
+		default:
+			break;
+	}
+}
+
+/*****************************************************************************
+ * @brief Chooses the low power state for the next idle period.
+ *
+ * @details STOP mode halts the PLL clocks, so it is only allowed when TIM3 is
+ *          not counting, no TIM4 software timer (button debounce, long
+ *          press, buzzer pattern, or the pause blink of the TIM3 timebase)
+ *          is pending, the display bus DMA is idle, no battery burst is
+ *          converting and the debug UART has sent everything. Otherwise
+ *          the core only sleeps in WFI. With the RTC timebase a running
+ *          timer does not need TIM3 and a paused one blinks on the RTC
+ *          alarm, so STOP is allowed.
+ *
+ * @param   None
+ *
+ * @return  PowerIdle_e
+ *
+ * @retval  PowerIdle_Sleep  TIM3 counting, TIM4 timer pending, display, ADC or UART busy.
+ * @retval  PowerIdle_Stop   Nothing to do until the next button edge or RTC wake-up or alarm.
+ *
+ * @see Power_Idle()
+ *****************************************************************************/
+static PowerIdle_e selectIdleMode(void)
+{
+#if (APP_TIMEBASE == APP_TIMEBASE_TIM3)
+	bool tim3running = session_IsRunning();
+#else
+	bool tim3running = (APP_TIMEBASE_DRIFT_MEASURE != 0); /** Free running drift reference **/
+#endif
+
+#if APP_BATTERY_MONITOR
+	if(BatteryAdc_IsBusy())
+	{
+		return PowerIdle_Sleep;
+	}
+#endif
+#if (APP_DEBUG_OUTPUT == APP_DEBUG_OUTPUT_UART)
+	if(DebugOut_IsBusy())
+	{
+		return PowerIdle_Sleep; /** USART2 and DMA1 stop in STOP mode **/
+	}
+#endif
+	if(tim3running || HwTimer_IsActive() || TM1637_Bus_IsBusy())
+	{
+		return PowerIdle_Sleep;
+	}
+	return PowerIdle_Stop;
+}
+
+#if APP_TIMEBASE_DRIFT_MEASURE
+/*****************************************************************************
+ * @brief Reports the TIM3 drift against the RTC.
+ *
+ * @details Prints the error of the TIM3 second counter in ppm once every
+ *          APP_TIMEBASE_DRIFT_PERIOD RTC seconds, whether or not the
+ *          session timer is running.
+ *
+ * @param   None
+ *
+ * @return  None
+ *
+ * @retval  None
+ *
+ * @see RtcClock_GetDrift()
+ *****************************************************************************/
+static void timebaseDriftReport(void)
+{
+	RtcClockDrift_t drift;
+
+	if(RtcClock_GetDrift(&drift))
+	{
+		uint32_t magnitude = (uint32_t)((drift.ppmx10 < 0) ? -drift.ppmx10 : drift.ppmx10);
+		DEBUG_LOG("drift: tim3 %c%lu.%lu ppm over %lu s (rtc %s)\r\n",
+				(drift.ppmx10 < 0) ? '-' : '+',
+				(unsigned long)(magnitude / 10U), (unsigned long)(magnitude % 10U),
+				(unsigned long)drift.seconds,
+				DEBUG_LOG_STRING((RtcClock_GetSource() == RtcClockSource_Lse) ? "lse" : "lsi"));
+	}
 }
+#endif
+
+#if APP_SCHEDULER_STATS
+/*****************************************************************************
+ * @brief Reports and restarts the scheduler residency statistics.
+ *
+ * @details Prints the share of time the core was awake over the last period
+ *          in 1/100 %, derived from the awake cycles and the elapsed seconds,
+ *          and the TM1637 bus bytes per display update since boot.
+ *          Build once with APP_IDLE_WFI = 0 to get the busy-poll baseline.
+ *
+ * @param   None
+ *
+ * @return  None
+ *
+ * @retval  None
+ *
+ * @note The awake cycles are measured with DWT->CYCCNT which does not count
+ *       while the core sleeps, so the period length comes from the second
+ *       tick and a report is only produced while the timer is running.
+ *****************************************************************************/
+static void schedulerStatsReport(void)
+{
+	if(glbSchedulerStats.seconds >= APP_SCHEDULER_STATS_PERIOD)
+	{
+		uint64_t periodcycles = (uint64_t)glbSchedulerStats.seconds * SystemCoreClock;
+		uint32_t active = (uint32_t)((glbSchedulerStats.activeCycles * 10000U) / periodcycles);
+
+		DEBUG_LOG("sched: active %lu.%02lu%% sleep %lu.%02lu%% wakeups %lu events %lu dropped %lu\r\n",
+				(unsigned long)(active / 100U), (unsigned long)(active % 100U),
+				(unsigned long)((10000U - active) / 100U), (unsigned long)((10000U - active) % 100U),
+				(unsigned long)glbSchedulerStats.wakeups, (unsigned long)glbSchedulerStats.events,
+				(unsigned long)eventQueue_GetOverflowCount());
+		uint32_t updates = TM1637_GetUpdateCount();
+		uint32_t bytes = TM1637_GetBusByteCount();
+		uint32_t perupdate = (updates != 0U) ? ((bytes * 100U) / updates) : 0U;
+		DEBUG_LOG("display: %lu updates %lu bytes, %lu.%02lu per update of %u\r\n", (unsigned long)updates,
+				(unsigned long)bytes, (unsigned long)(perupdate / 100U), (unsigned long)(perupdate % 100U),
+				(unsigned)TM1637_FULL_FRAME_BYTES);
+#if (APP_DEBUG_OUTPUT == APP_DEBUG_OUTPUT_UART)
+		DebugOutStats_t uartstats;
+		DebugOut_GetStats(&uartstats);
+		DEBUG_LOG("uart: sent %lu dropped %lu peak %lu/%u bytes\r\n", (unsigned long)uartstats.sent,
+				(unsigned long)uartstats.dropped, (unsigned long)uartstats.peak, (unsigned)APP_DEBUG_UART_BUFFER);
+#endif
+
+		memset(&glbSchedulerStats, 0, sizeof(glbSchedulerStats));
+	}
+}
+#endif
 
 /*****************************************************************************/
 /* User Main Function                                                        */
 /*****************************************************************************/
 /*****************************************************************************
- * @brief Main user function to handle Pomodoro control logic.
+ * @brief Puts the first frame on the display.
  *
- * @details This is the main loop function which initializes the display state
- *          and continuously checks the control and function button inputs.
- *          It updates the timer display accordingly.
+ * @details Resets the mode and counters, loads the saved session profile,
+ *          puts the initial value on the display and, after a deep idle
+ *          STANDBY or a brownout, the saved session. Only the display and
+ *          the flash are used, the timers and the buttons are not set up
+ *          yet.
  *
  * @param   None
  *
@@ -348,37 +1105,226 @@ void updateDisplay(void)
  *
  * @retval  None
  *
- * @note Should be called after system and peripheral initialization.
- *
- * @warning This function runs in an infinite loop. Make sure all critical
- *          initialization is done before calling it.
+ * @note Called by main() as soon as the display is up, before userMain().
  *
- * @see buttonControlDebounce(), buttonFunctionDebounce(), updateDisplay()
+ * @see userInit()
  *****************************************************************************/
-void userMain(void)
+void userBootDisplay(void)
 {
 	/* Start counting seconds*/
-	glbSecondCounter = 0;
+	timeBase_ResetSeconds();
 
-	/*Reset Mode counter*/
-	glbModeSelection = PomodoroFunctions_PomodoroMode;
+	/* First Pomodoro, timer stopped */
+	session_Init(&glbSessionHooks);
+	glbLastSecondsCount = 0;
+	glbColonShown = false;
+	glbBlinkOff = false;
 
-    /* Reset Time selection*/
-    glbCurrentModeTime = POMODOROMODE_TIME;
+	/* Initialize data on display */
+    TM1637_Update_Data_Dots(displayData,false); /** Set initial colon/dot state on display **/
 
-    /*Reset Pomodoro Cycles*/
-    glbPomodoroCycles = 0;
+#if APP_PROFILE_STORE
+    /* Mode lengths of the saved profile, compiled defaults without one */
+    profileStore_Init();
+    (void)session_SetProfile(&profileStore_Get(profileStore_GetSelected())->profile);
+#endif
 
-	glbTimerState = false;
+#if (APP_IDLE_STANDBY || APP_BROWNOUT_RESUME)
+    /* Woken from deep idle or back from a brownout: the saved session, profile and display */
+    sessionRestore();
+#endif
+}
+/*****************************************************************************
+ * @brief Initializes the rest of the Pomodoro application state.
+ *
+ * @details Resets the button state machines, empties the event queue,
+ *          finds the end of the session log, continues a session put on
+ *          the display by userBootDisplay() and takes the first battery
+ *          measurement.
+ *
+ * @param   None
+ *
+ * @return  None
+ *
+ * @retval  None
+ *
+ * @note Should be called after system and peripheral initialization and
+ *       userBootDisplay().
+ *
+ * @see userBootDisplay(), userProcess(), userMain()
+ *****************************************************************************/
+void userInit(void)
+{
+	eventQueue_Init();
 
-	/* Initialize data on display */
-    TM1637_Update_Data_Dots(displayData,false); /** Set initial colon/dot state on display **/
+	/* Match the debounced button states to the pins */
+	button_Init();
+
+#if APP_PROFILER
+    /* TM1637_Benchmark() in main() left 88:88 on the display */
+    TM1637_Update_Data_Dots(displayData,glbColonShown);
+#endif
+
+#if APP_SESSION_LOG
+    /* Find the write position of the session history */
+    sessionLog_Init();
+#endif
+
+#if (APP_IDLE_STANDBY || APP_BROWNOUT_RESUME)
+    /* Start the restored session's timer or pause blink */
+    sessionResume();
+#endif
+
+#if APP_BATTERY_MONITOR
+    /* Measure the battery once at power up */
+    glbBatteryLow = false;
+    battery_Init();
+#endif
+
+#if APP_SCHEDULER_STATS
+    APP_CYCLE_COUNTER_INIT();
+    glbWakeCycles = APP_CYCLE_COUNTER();
+#endif
+}
+/*****************************************************************************
+ * @brief Runs one pass of the event scheduler.
+ *
+ * @details Drains the event queue posted by the second timebase and the
+ *          button state machines, refreshes the display, writes finished
+ *          sessions to the history log and a new profile selection to
+ *          flash, and sleeps until the next interrupt.
+ *
+ * @param   None
+ *
+ * @return  None
+ *
+ * @retval  None
+ *
+ * @note The queue-empty check and WFI run with PRIMASK set, so an event
+ *       posted in between still wakes the core immediately. With
+ *       APP_TICKLESS_IDLE the SysTick is stopped while asleep and STOP
+ *       mode is used when no running timer needs the PLL clocks.
+ *
+ * @see dispatchEvent(), updateDisplay(), eventQueue_Get(), Power_Idle()
+ *****************************************************************************/
+void userProcess(void)
+{
+	AppEvent_e event;
+	while((event = eventQueue_Get()) != AppEvent_None)
+	{
+		PROFILE_BEGIN(ProfileProbe_Dispatch);
+		FaultCapture_Event((uint8_t)event); /** Event history of a fault record **/
+		dispatchEvent(event);
+		PROFILE_END(ProfileProbe_Dispatch);
+#if APP_SCHEDULER_STATS
+		glbSchedulerStats.events++;
+#endif
+	}
+#if APP_WATCHDOG
+	Watchdog_CheckIn(WatchdogTask_Input); /** Queue drained **/
+#endif
+
+	FaultCapture_SetMode((uint8_t)((session_GetRun() << 4) | session_GetMode())); /** Run state and mode of a fault record **/
+
+	PROFILE_BEGIN(ProfileProbe_UpdateDisplay);
+	updateDisplay(); /** Refresh display based on timer count **/
+	PROFILE_END(ProfileProbe_UpdateDisplay);
+#if APP_WATCHDOG
+	Watchdog_CheckIn(WatchdogTask_Session);
+#endif
+
+#if APP_SESSION_LOG
+	if(Buzzer_IsBusy() == false)
+	{
+		sessionLog_Service(session_IsRunning() == false); /** Flash stalls the core, not while a beep is timed **/
+	}
+#endif
+#if APP_PROFILE_STORE
+	if((Buzzer_IsBusy() == false) && (session_IsRunning() == false))
+	{
+		profileStore_Service(); /** A new selection, written after its cue **/
+	}
+#endif
+#if APP_IDLE_TIMEOUT
+	idleService();
+#endif
+#if APP_SCHEDULER_STATS
+	schedulerStatsReport();
+#endif
+#if APP_PROFILER
+	if(glbProfilerSeconds >= APP_PROFILER_PERIOD)
+	{
+		Profiler_Report(glbProfilerSeconds);
+		glbProfilerSeconds = 0;
+	}
+#endif
+#if APP_TIMEBASE_DRIFT_MEASURE
+	timebaseDriftReport();
+#endif
+#if APP_WATCHDOG
+	if(TM1637_Bus_IsBusy() == false)
+	{
+		Watchdog_CheckIn(WatchdogTask_Display); /** A frame that never completes stops these **/
+	}
+	if(Buzzer_IsBusy() == false)
+	{
+		Watchdog_CheckIn(WatchdogTask_Buzzer);
+	}
+	(void)Watchdog_Service(); /** Fed only with every task on time **/
+#endif
+
+	uint32_t irqstate = APP_IRQ_SAVE();
+	APP_IRQ_DISABLE();
+	if(eventQueue_IsEmpty())
+	{
+#if APP_SCHEDULER_STATS
+		uint32_t nowcycles = APP_CYCLE_COUNTER();
+		glbSchedulerStats.activeCycles += (uint32_t)(nowcycles - glbWakeCycles);
+		glbWakeCycles = nowcycles;
+		glbSchedulerStats.wakeups++;
+#endif
+#if APP_IDLE_WFI
+		Power_Idle(selectIdleMode()); /** Sleep, any pending interrupt wakes the core even with PRIMASK set **/
+#if APP_SCHEDULER_STATS
+		glbWakeCycles = APP_CYCLE_COUNTER(); /** Sleep time is not counted as active **/
+#endif
+#else
+		APP_IRQ_RESTORE(irqstate); /** Busy-poll baseline: spin until an event arrives, counted as active **/
+		while(eventQueue_IsEmpty())
+		{
+		}
+		APP_IRQ_DISABLE();
+#endif
+	}
+	APP_IRQ_RESTORE(irqstate); /** Let the waking interrupt run **/
+}
+/*****************************************************************************
+ * @brief Main user function to handle Pomodoro control logic.
+ *
+ * @details Initializes the application and then runs the event scheduler
+ *          forever.
+ *
+ * @param   None
+ *
+ * @return  None
+ *
+ * @retval  None
+ *
+ * @note Should be called after system and peripheral initialization and
+ *       userBootDisplay().
+ *
+ * @warning This function runs in an infinite loop. Make sure all critical
+ *          initialization is done before calling it.
+ *
+ * @see userInit(), userProcess()
+ *****************************************************************************/
+void userMain(void)
+{
+	userInit();
 
 	while(1)
 	{
-		buttonControlDebounce(); /** Handle control button with debounce **/
-		buttonFunctionDebounce(); /** Handle mode change button with debounce **/
-		updateDisplay(); /** Refresh display based on timer count **/
+		userProcess();
 	}
 }
 /*************************************END*************************************/
@@ -42,55 +42,27 @@ extern "C"
 /*****************************************************************************/
 #include "main.h"
 #include "TM1637.h"
+#include "session.h"
 
 /*****************************************************************************/
 /* Private Defines                                                           */
 /*****************************************************************************/
 
 /**
- * @brief Pomodoro session duration in seconds.
+ * @brief Display blink half period while the timer is paused, in milliseconds.
  *
- * @details Represents 25 minutes (25 * 60 = 1500 seconds).
+ * @details TIM3 timebase only, the RTC timebase blinks on its half second
+ *          alarm.
  */
-#define POMODOROMODE_TIME            (1500) /*25 minutes in seconds*/
+#define PAUSE_BLINK_TIME              (500) /*1 Hz blink*/
 
 /**
- * @brief Short break duration in seconds.
+ * @brief Low battery warning period in seconds.
  *
- * @details Represents 5 minutes (5 * 60 = 300 seconds).
+ * @details With a low battery, one second out of this many shows "----"
+ *          instead of the time while the timer runs.
  */
-#define SHORTBREAK_TIME              (300)  /*5 minutes in seconds*/
-
-/**
- * @brief Long break duration in seconds.
- *
- * @details Represents 15 minutes (15 * 60 = 900 seconds).
- */
-#define LONGBREAK_TIME               (900)  /*15 minutes in seconds*/
-
-/**
- * @brief No of cycles to shift to Long Break.
- *
- * @details If we required to take 6 cycles i.e. 3 pomodoros & 2 Short Breaks,
- *          then Total no of cycles - 1 put 5 over here.
- */
-#define NO_OF_CYCLES                  (5) /*3 Pomodoros & 2 Short Breaks*/
-
-/*****************************************************************************/
-/* Private Enums                                                             */
-/*****************************************************************************/
-
-/**
- * @brief Enum for Pomodoro timer modes.
- *
- * @details Used to switch between different Pomodoro states during operation.
- */
-typedef enum
-{
-	PomodoroFunctions_PomodoroMode,   /**< Pomodoro work session */
-	PomodoroFunctions_ShortBreak,     /**< Short break session */
-	PomodoroFunctions_LongBreak,      /**< Long break session */
-}PomodoroFunctions_e;
+#define BATTERY_WARNING_PERIOD        (10)
 
 /*****************************************************************************/
 /* Private Variables                                                         */
@@ -111,6 +83,27 @@ typedef enum
  */
 void userMain(void);
 
+/**
+ * @brief Puts the first frame on the display, before the rest of the boot.
+ *
+ * @note Called by main() right after TM1637_Init(), userInit() follows.
+ */
+void userBootDisplay(void);
+
+/**
+ * @brief Initializes the rest of the Pomodoro application state.
+ *
+ * @note Called by userMain(); separate so a host build can drive the loop.
+ */
+void userInit(void);
+
+/**
+ * @brief Runs one pass of the event scheduler, sleeps if nothing is pending.
+ *
+ * @note Called by userMain(); separate so a host build can drive the loop.
+ */
+void userProcess(void);
+
 
 #ifdef __cplusplus
 }
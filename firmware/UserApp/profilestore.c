@@ -0,0 +1,411 @@
+/**
+ * \file           profilestore.c
+ * \brief          Session profile store in flash source file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+/*
+ * Layout of the profile sector (FlashRegion_Profiles), 76 byte slots, each
+ * holding a complete image:
+ *
+ *   word 0      MAGIC
+ *   word 1      version | count << 8 | selected << 16
+ *   word 2...   four words per profile: name[0..3], name[4..7],
+ *               Pomodoro | short break << 16, long break | cycles << 16
+ *               (seconds, names NUL padded, unused profiles zero)
+ *   word 18     CRC-32 of words 0 ... 17
+ *
+ * A save appends a whole image in the next erased slot, CRC word last, so a
+ * power cut leaves the previous image as the latest valid one. At boot the
+ * first erased slot is found by a binary search, as in sessionlog.c, and
+ * the image before it is copied to RAM and checked once; only a torn write
+ * makes the load step back further. The per-second path never reads the
+ * flash, the session engine works on its own copy of the selected profile.
+ *
+ * Only a new selection is written, 862 of them fit before the sector is
+ * erased and the current image starts it again. A power cut inside that
+ * erase loses the stored profiles: the compiled defaults are used until the
+ * next save. Tools/profile_image.py builds an image to flash at the start
+ * of the sector.
+ */
+
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "profilestore.h"
+#if APP_PROFILE_STORE
+#include <string.h>
+#include "flashregion.h"
+/*****************************************************************************/
+/* Private Defines                                                           */
+/*****************************************************************************/
+#define PROFILESTORE_ERASED          0xFFFFFFFFU                      /** Erased flash word **/
+#define PROFILESTORE_CRC_WORD        (PROFILESTORE_IMAGE_WORDS - 1U)  /** Word holding the CRC of the words before it **/
+#define PROFILESTORE_ENTRY_WORD      2U                               /** First word of the profiles **/
+
+/*****************************************************************************/
+/* Private Types                                                             */
+/*****************************************************************************/
+/**
+ * @brief Profiles in RAM and write position.
+ */
+typedef struct
+{
+	uint32_t slots;                   /**< Image slots in the sector */
+	uint32_t next;                    /**< First erased slot, slots when full */
+	uint32_t eraseCount;              /**< Sector erases since the reset */
+	uint8_t count;                    /**< Profiles in entries */
+	uint8_t selected;                 /**< Selected profile */
+	bool loaded;                      /**< entries came from flash */
+	bool dirty;                       /**< Selection not yet in flash */
+	ProfileStoreEntry_t entries[PROFILESTORE_MAX]; /**< The profiles */
+}ProfileStore_t;
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+/**
+ * @brief Compiled default profiles, used when the sector holds no valid image.
+ *
+ * @details The classic 25/5/15 of session.h, 50/10/30 and 90/20/30.
+ */
+static const ProfileStoreEntry_t profilestoredefaults[] =
+{
+	{ "25/5",  { { POMODOROMODE_TIME, SHORTBREAK_TIME, LONGBREAK_TIME }, NO_OF_CYCLES } },
+	{ "50/10", { { 3000U, 600U, 1800U }, NO_OF_CYCLES } },
+	{ "90/20", { { 5400U, 1200U, 1800U }, 3U } },
+};
+
+_Static_assert((sizeof(profilestoredefaults) / sizeof(profilestoredefaults[0])) <= PROFILESTORE_MAX, "too many default profiles");
+
+static ProfileStore_t profilestore; /** Store state **/
+
+/*****************************************************************************/
+/* Private Functions                                                         */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Copies one slot out of flash.
+ *
+ * @param[in]  slot   Slot number.
+ * @param[out] words  PROFILESTORE_IMAGE_WORDS words.
+ *
+ * @return None
+ *****************************************************************************/
+static void profileStoreLoad(uint32_t slot, uint32_t *words)
+{
+	const volatile uint32_t *base = FlashRegion_GetBase(FlashRegion_Profiles) + (slot * PROFILESTORE_IMAGE_WORDS);
+
+	for(uint32_t i = 0; i < PROFILESTORE_IMAGE_WORDS; i++)
+	{
+		words[i] = base[i];
+	}
+}
+/*****************************************************************************
+ * @brief CRC of the words of an image before its CRC word.
+ *
+ * @param[in] words  Image words.
+ *
+ * @return uint32_t Standard CRC-32.
+ *****************************************************************************/
+static uint32_t profileStoreCrc(const uint32_t *words)
+{
+	return ~stdUtil_crc32(STDUTIL_CRC32_INIT, words, PROFILESTORE_CRC_WORD * 4U);
+}
+/*****************************************************************************
+ * @brief Checks if a slot is still erased.
+ *
+ * @param[in] slot  Slot number.
+ *
+ * @return bool true if all words read 0xFFFFFFFF.
+ *****************************************************************************/
+static bool profileStoreIsErased(uint32_t slot)
+{
+	const volatile uint32_t *base = FlashRegion_GetBase(FlashRegion_Profiles) + (slot * PROFILESTORE_IMAGE_WORDS);
+
+	for(uint32_t i = 0; i < PROFILESTORE_IMAGE_WORDS; i++)
+	{
+		if(base[i] != PROFILESTORE_ERASED)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+/*****************************************************************************
+ * @brief Takes the profiles of an image if it is valid.
+ *
+ * @details The image is decoded into a local copy first, a broken image
+ *          leaves the store unchanged.
+ *
+ * @param[in] words  Image words.
+ *
+ * @return bool true if the image was valid and taken.
+ *****************************************************************************/
+static bool profileStoreDecode(const uint32_t *words)
+{
+	ProfileStoreEntry_t entries[PROFILESTORE_MAX];
+	uint32_t count = (words[1] >> 8U) & 0xFFU;
+	uint32_t selected = (words[1] >> 16U) & 0xFFU;
+
+	if((words[0] != PROFILESTORE_MAGIC) || (words[PROFILESTORE_CRC_WORD] != profileStoreCrc(words)) ||
+			((words[1] & 0xFFU) != PROFILESTORE_VERSION) ||
+			(count == 0U) || (count > PROFILESTORE_MAX) || (selected >= count))
+	{
+		return false;
+	}
+
+	memset(entries, 0, sizeof(entries));
+	for(uint32_t i = 0; i < count; i++)
+	{
+		const uint32_t *entry = &words[PROFILESTORE_ENTRY_WORD + (i * 4U)];
+
+		for(uint32_t c = 0; c < PROFILESTORE_NAME_LENGTH; c++)
+		{
+			entries[i].name[c] = (char)(entry[c / 4U] >> ((c % 4U) * 8U));
+		}
+		entries[i].profile.duration[PomodoroFunctions_PomodoroMode] = (uint16_t)entry[2];
+		entries[i].profile.duration[PomodoroFunctions_ShortBreak] = (uint16_t)(entry[2] >> 16U);
+		entries[i].profile.duration[PomodoroFunctions_LongBreak] = (uint16_t)entry[3];
+		entries[i].profile.cycles = (uint8_t)(entry[3] >> 16U);
+		if(session_IsProfileValid(&entries[i].profile) == false)
+		{
+			return false;
+		}
+	}
+
+	memcpy(profilestore.entries, entries, sizeof(entries));
+	profilestore.count = (uint8_t)count;
+	profilestore.selected = (uint8_t)selected;
+	return true;
+}
+/*****************************************************************************
+ * @brief Builds the image of the profiles in RAM, CRC word included.
+ *
+ * @param[out] words  PROFILESTORE_IMAGE_WORDS words.
+ *
+ * @return None
+ *****************************************************************************/
+static void profileStoreEncode(uint32_t *words)
+{
+	memset(words, 0, PROFILESTORE_IMAGE_SIZE);
+	words[0] = PROFILESTORE_MAGIC;
+	words[1] = PROFILESTORE_VERSION | ((uint32_t)profilestore.count << 8U) | ((uint32_t)profilestore.selected << 16U);
+	for(uint32_t i = 0; i < profilestore.count; i++)
+	{
+		const ProfileStoreEntry_t *source = &profilestore.entries[i];
+		uint32_t *entry = &words[PROFILESTORE_ENTRY_WORD + (i * 4U)];
+
+		for(uint32_t c = 0; (c < PROFILESTORE_NAME_LENGTH) && (source->name[c] != '\0'); c++)
+		{
+			entry[c / 4U] |= (uint32_t)(uint8_t)source->name[c] << ((c % 4U) * 8U);
+		}
+		entry[2] = (uint32_t)source->profile.duration[PomodoroFunctions_PomodoroMode] |
+				((uint32_t)source->profile.duration[PomodoroFunctions_ShortBreak] << 16U);
+		entry[3] = (uint32_t)source->profile.duration[PomodoroFunctions_LongBreak] |
+				((uint32_t)source->profile.cycles << 16U);
+	}
+	words[PROFILESTORE_CRC_WORD] = profileStoreCrc(words);
+}
+
+/*****************************************************************************/
+/* Profile Store Functions                                                   */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Loads the latest valid image from flash, or the compiled defaults.
+ *
+ * @details The first erased slot is found by a binary search; the images
+ *          before it are tried newest first, normally only one.
+ *
+ * @param None
+ *
+ * @return None
+ *****************************************************************************/
+void profileStore_Init(void)
+{
+	uint32_t words[PROFILESTORE_IMAGE_WORDS];
+	uint32_t low = 0;
+	uint32_t high;
+
+	memset(&profilestore, 0, sizeof(profilestore));
+	profilestore.slots = FlashRegion_GetSize(FlashRegion_Profiles) / PROFILESTORE_IMAGE_SIZE;
+	memcpy(profilestore.entries, profilestoredefaults, sizeof(profilestoredefaults));
+	profilestore.count = (uint8_t)(sizeof(profilestoredefaults) / sizeof(profilestoredefaults[0]));
+
+	/* slots below low are used, slots from high on are erased */
+	high = profilestore.slots;
+	while(low < high)
+	{
+		uint32_t middle = low + ((high - low) / 2U);
+
+		if(profileStoreIsErased(middle))
+		{
+			high = middle;
+		}
+		else
+		{
+			low = middle + 1U;
+		}
+	}
+	profilestore.next = low;
+
+	for(uint32_t slot = low; (slot > 0U) && (profilestore.loaded == false); slot--)
+	{
+		profileStoreLoad(slot - 1U, words);
+		profilestore.loaded = profileStoreDecode(words);
+	}
+}
+/*****************************************************************************
+ * @brief Returns the number of profiles.
+ *
+ * @param None
+ *
+ * @return uint8_t 1 ... PROFILESTORE_MAX.
+ *****************************************************************************/
+uint8_t profileStore_GetCount(void)
+{
+	return profilestore.count;
+}
+/*****************************************************************************
+ * @brief Returns one profile.
+ *
+ * @param[in] index  Profile index.
+ *
+ * @return const ProfileStoreEntry_t *
+ *
+ * @retval NULL  Out of range.
+ *****************************************************************************/
+const ProfileStoreEntry_t *profileStore_Get(uint8_t index)
+{
+	return (index < profilestore.count) ? &profilestore.entries[index] : NULL;
+}
+/*****************************************************************************
+ * @brief Returns the index of the selected profile.
+ *
+ * @param None
+ *
+ * @return uint8_t
+ *****************************************************************************/
+uint8_t profileStore_GetSelected(void)
+{
+	return profilestore.selected;
+}
+/*****************************************************************************
+ * @brief Selects a profile.
+ *
+ * @details Only RAM changes here, profileStore_Service() writes the new
+ *          selection at a quiet moment.
+ *
+ * @param[in] index  Profile index.
+ *
+ * @return bool
+ *
+ * @retval true   Selected.
+ * @retval false  Out of range.
+ *****************************************************************************/
+bool profileStore_Select(uint8_t index)
+{
+	if(index >= profilestore.count)
+	{
+		return false;
+	}
+	if(index != profilestore.selected)
+	{
+		profilestore.selected = index;
+		profilestore.dirty = true;
+	}
+	return true;
+}
+/*****************************************************************************
+ * @brief Writes a changed selection to flash.
+ *
+ * @details The image takes 19 word programs, about 300 us. Slots left
+ *          programmed by an interrupted erase are stepped over. A full
+ *          sector is erased first, which stalls the core for about 1 s; a
+ *          failed erase or program leaves the selection to be written on
+ *          the next call, a slot spoilt by the program is stepped over.
+ *
+ * @param None
+ *
+ * @return None
+ *****************************************************************************/
+void profileStore_Service(void)
+{
+	uint32_t words[PROFILESTORE_IMAGE_WORDS];
+
+	if(profilestore.dirty == false)
+	{
+		return;
+	}
+
+	while((profilestore.next < profilestore.slots) && (profileStoreIsErased(profilestore.next) == false))
+	{
+		profilestore.next++;
+	}
+	if(profilestore.next >= profilestore.slots)
+	{
+		if(FlashRegion_Erase(FlashRegion_Profiles) == false)
+		{
+			return;
+		}
+		profilestore.eraseCount++;
+		profilestore.next = 0;
+	}
+
+	profileStoreEncode(words);
+	if(FlashRegion_Program(FlashRegion_Profiles, profilestore.next * PROFILESTORE_IMAGE_SIZE, words, PROFILESTORE_IMAGE_WORDS))
+	{
+		profilestore.loaded = true;
+		profilestore.dirty = false;
+	}
+	profilestore.next++;
+}
+/*****************************************************************************
+ * @brief Whether the profiles came from flash.
+ *
+ * @param None
+ *
+ * @return bool false while the compiled defaults are used.
+ *****************************************************************************/
+bool profileStore_IsLoaded(void)
+{
+	return profilestore.loaded;
+}
+/*****************************************************************************
+ * @brief Returns the number of sector erases since the reset.
+ *
+ * @param None
+ *
+ * @return uint32_t
+ *****************************************************************************/
+uint32_t profileStore_GetEraseCount(void)
+{
+	return profilestore.eraseCount;
+}
+#endif
+/*************************************END*************************************/
@@ -0,0 +1,151 @@
+/**
+ * \file           profilestore.h
+ * \brief          Session profile store header file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+#ifndef PROFILESTORE_H_
+#define PROFILESTORE_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "session.h"
+#include "AppConfig.h"
+
+/*****************************************************************************/
+/* Profile Store Macros                                                      */
+/*****************************************************************************/
+
+/**
+ * @brief Most profiles in the store.
+ */
+#define PROFILESTORE_MAX                     4U
+
+/**
+ * @brief Longest profile name, in characters.
+ */
+#define PROFILESTORE_NAME_LENGTH             8U
+
+/**
+ * @brief Words per stored image (slot).
+ */
+#define PROFILESTORE_IMAGE_WORDS             (3U + (4U * PROFILESTORE_MAX))
+
+/**
+ * @brief Bytes per stored image (slot).
+ */
+#define PROFILESTORE_IMAGE_SIZE              (PROFILESTORE_IMAGE_WORDS * 4U)
+
+/**
+ * @brief First word of every image ("PROF").
+ */
+#define PROFILESTORE_MAGIC                   0x464F5250U
+
+/**
+ * @brief Image layout version; images of another version are not loaded.
+ */
+#define PROFILESTORE_VERSION                 1U
+
+/*****************************************************************************/
+/* Profile Store Structures                                                  */
+/*****************************************************************************/
+
+/**
+ * @brief One named profile.
+ */
+typedef struct
+{
+	char name[PROFILESTORE_NAME_LENGTH + 1U]; /**< Name, NUL terminated */
+	SessionProfile_t profile;         /**< Mode lengths and cycles */
+}ProfileStoreEntry_t;
+
+/*****************************************************************************/
+/* Profile Store Function Declarations                                       */
+/*****************************************************************************/
+
+/**
+ * @brief Loads the latest valid image from flash, or the compiled defaults.
+ */
+void profileStore_Init(void);
+
+/**
+ * @brief Number of profiles, 1 ... PROFILESTORE_MAX.
+ */
+uint8_t profileStore_GetCount(void);
+
+/**
+ * @brief One profile.
+ *
+ * @param[in] index  0 ... profileStore_GetCount() - 1.
+ *
+ * @return The profile, NULL if out of range.
+ */
+const ProfileStoreEntry_t *profileStore_Get(uint8_t index);
+
+/**
+ * @brief Index of the selected profile.
+ */
+uint8_t profileStore_GetSelected(void);
+
+/**
+ * @brief Selects a profile, written to flash by profileStore_Service().
+ *
+ * @param[in] index  0 ... profileStore_GetCount() - 1.
+ *
+ * @return false if out of range.
+ */
+bool profileStore_Select(uint8_t index);
+
+/**
+ * @brief Writes a changed selection to flash.
+ *
+ * @note May erase the sector (about 1 s) once it is full.
+ */
+void profileStore_Service(void);
+
+/**
+ * @brief Whether the profiles came from flash rather than the compiled defaults.
+ */
+bool profileStore_IsLoaded(void);
+
+/**
+ * @brief Number of times the sector was erased since the reset.
+ */
+uint32_t profileStore_GetEraseCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PROFILESTORE_H_ */
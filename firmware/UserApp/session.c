@@ -0,0 +1,533 @@
+/**
+ * \file           session.c
+ * \brief          Table-driven Pomodoro session engine source file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include <stddef.h>
+#include "session.h"
+
+/*****************************************************************************/
+/* Private Structures                                                        */
+/*****************************************************************************/
+
+/**
+ * @brief One row of the mode table: what follows the mode.
+ */
+typedef struct
+{
+	uint8_t cycleStep;                /**< Added to the cycle count when the mode ends */
+	bool cycleLimit;                  /**< Compare the cycle count with the profile cycles when the mode ends */
+	PomodoroFunctions_e next;         /**< Mode that follows */
+	PomodoroFunctions_e nextAtLimit;  /**< Mode that follows once the cycle count reached the profile cycles */
+}SessionMode_t;
+
+/**
+ * @brief State owned by the engine.
+ */
+typedef struct
+{
+	const SessionHooks_t *hooks;      /**< Hardware hooks */
+	SessionProfile_t profile;         /**< Mode lengths and cycles in use, a RAM copy */
+	PomodoroFunctions_e mode;         /**< Current mode */
+	uint32_t elapsed;                 /**< Elapsed seconds of the current mode, as last shown */
+	uint8_t cycles;                   /**< Completed Pomodoros and short breaks */
+	uint8_t pauses;                   /**< Pauses in the current mode */
+	SessionRun_e run;                 /**< Run state */
+}Session_t;
+
+typedef void (*SessionHandler_t)(void); /** Handler of one SessionEvent_e **/
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+
+/**
+ * @brief Mode table, indexed by PomodoroFunctions_e.
+ *
+ * @details Pomodoro -> short break, counting one cycle.
+ *          Short break -> Pomodoro, counting one cycle, or -> long break
+ *          once the profile cycles are done (the count restarts).
+ *          Long break -> Pomodoro.
+ *          The lengths come from the profile.
+ */
+static const SessionMode_t sessionmodes[PomodoroFunctions_Count] =
+{
+	[PomodoroFunctions_PomodoroMode] = { 1U, false, PomodoroFunctions_ShortBreak,   PomodoroFunctions_ShortBreak },
+	[PomodoroFunctions_ShortBreak]   = { 1U, true,  PomodoroFunctions_PomodoroMode, PomodoroFunctions_LongBreak },
+	[PomodoroFunctions_LongBreak]    = { 0U, false, PomodoroFunctions_PomodoroMode, PomodoroFunctions_PomodoroMode },
+};
+
+/**
+ * @brief Compiled default profile, used from session_Init().
+ */
+static const SessionProfile_t sessiondefaultprofile =
+{
+	.duration = { POMODOROMODE_TIME, SHORTBREAK_TIME, LONGBREAK_TIME },
+	.cycles = NO_OF_CYCLES,
+};
+
+static Session_t session; /** The one session engine **/
+
+/*****************************************************************************/
+/* Private Functions                                                         */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Shows a new elapsed value through the display hook.
+ *
+ * @param[in] elapsed  Elapsed seconds of the current mode.
+ *
+ * @return None
+ *****************************************************************************/
+static void sessionShow(uint32_t elapsed)
+{
+	if(session.elapsed != elapsed)
+	{
+		session.elapsed = elapsed;
+		session.hooks->display(elapsed);
+	}
+}
+/*****************************************************************************
+ * @brief Reports the end of a started session through the ended hook.
+ *
+ * @details Stopped timers have no session, nothing is reported. The pause
+ *          count starts again for the next session.
+ *
+ * @param[in] reason   Why the session ended.
+ * @param[in] elapsed  Seconds it counted.
+ *
+ * @return None
+ *****************************************************************************/
+static void sessionEnded(SessionEnd_e reason, uint32_t elapsed)
+{
+	SessionSummary_t summary;
+
+	if(session_GetSummary(reason, &summary))
+	{
+		summary.actual = (uint16_t)((elapsed > UINT16_MAX) ? UINT16_MAX : elapsed);
+		session.hooks->ended(&summary);
+	}
+	session.pauses = 0;
+}
+/*****************************************************************************
+ * @brief Moves to the mode that follows the current one.
+ *
+ * @details One table lookup, the same for the end of time and a skip.
+ *
+ * @param[in] cause  SessionEvent_TimeUp or SessionEvent_Skip, for the hook.
+ *
+ * @return None
+ *****************************************************************************/
+static void sessionAdvance(SessionEvent_e cause)
+{
+	PomodoroFunctions_e finished = session.mode;
+	const SessionMode_t *row = &sessionmodes[finished];
+
+	sessionEnded((cause == SessionEvent_TimeUp) ? SessionEnd_TimeUp : SessionEnd_Skip,
+			(cause == SessionEvent_TimeUp) ? session.profile.duration[finished] : session.elapsed);
+	session.cycles += row->cycleStep;
+	if(row->cycleLimit && (session.cycles >= session.profile.cycles))
+	{
+		session.cycles = 0;
+		session.mode = row->nextAtLimit;
+	}
+	else
+	{
+		session.mode = row->next;
+	}
+	session.hooks->modeEnd(finished, cause);
+}
+/*****************************************************************************
+ * @brief Stops the timer and goes back to the first Pomodoro at zero.
+ *****************************************************************************/
+static void sessionStop(void)
+{
+	sessionEnded(SessionEnd_Stop, session.elapsed);
+	session.run = SessionRun_Stopped;
+	session.mode = PomodoroFunctions_PomodoroMode;
+	session.cycles = 0;
+	session.hooks->timer(SessionTimer_Stop);
+	sessionShow(0);
+}
+/*****************************************************************************
+ * @brief SessionEvent_StartPause: starts, pauses or resumes the timer.
+ *
+ * @details A start begins the first Pomodoro of the cycle at zero. A pause
+ *          keeps the mode, the elapsed seconds and the phase of the running
+ *          second, so the resume continues exactly where the pause left.
+ *****************************************************************************/
+static void sessionStartPause(void)
+{
+	switch(session.run)
+	{
+		case SessionRun_Stopped:
+			session.run = SessionRun_Running;
+			session.mode = PomodoroFunctions_PomodoroMode;
+			session.cycles = 0;
+			session.hooks->timer(SessionTimer_Start);
+			sessionShow(0);
+			break;
+		case SessionRun_Running:
+			session.run = SessionRun_Paused;
+			if(session.pauses < UINT8_MAX)
+			{
+				session.pauses++;
+			}
+			session.hooks->timer(SessionTimer_Pause);
+			break;
+		default:
+			session.run = SessionRun_Running;
+			session.hooks->timer(SessionTimer_Resume);
+			break;
+	}
+}
+/*****************************************************************************
+ * @brief SessionEvent_Restart: the current mode starts again from zero.
+ *
+ * @details A paused timer is stopped instead, which is the only way back to
+ *          the stopped state.
+ *****************************************************************************/
+static void sessionRestart(void)
+{
+	if(session.run == SessionRun_Paused)
+	{
+		sessionStop();
+	}
+	else
+	{
+		sessionEnded(SessionEnd_Restart, session.elapsed);
+		session.hooks->timer((session.run == SessionRun_Running) ? SessionTimer_Restart : SessionTimer_Zero);
+		sessionShow(0);
+	}
+}
+/*****************************************************************************
+ * @brief SessionEvent_Skip: the next mode starts now.
+ *
+ * @details A paused timer stays paused at zero in the new mode.
+ *****************************************************************************/
+static void sessionSkip(void)
+{
+	session.hooks->timer((session.run == SessionRun_Running) ? SessionTimer_Restart : SessionTimer_Zero);
+	sessionAdvance(SessionEvent_Skip);
+	sessionShow(0);
+}
+/*****************************************************************************
+ * @brief SessionEvent_TimeUp: the next mode starts where this one ended.
+ *
+ * @note The elapsed seconds are carried over by session_Update().
+ *****************************************************************************/
+static void sessionTimeUp(void)
+{
+	sessionAdvance(SessionEvent_TimeUp);
+}
+
+/**
+ * @brief Event handlers, indexed by SessionEvent_e.
+ */
+static const SessionHandler_t sessionhandlers[SessionEvent_Count] =
+{
+	[SessionEvent_StartPause] = sessionStartPause,
+	[SessionEvent_Restart]    = sessionRestart,
+	[SessionEvent_Skip]       = sessionSkip,
+	[SessionEvent_TimeUp]     = sessionTimeUp,
+};
+
+/*****************************************************************************/
+/* Session Functions                                                         */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Stops the engine in the first Pomodoro with no elapsed time.
+ *
+ * @details The compiled default profile is in use afterwards.
+ *
+ * @param[in] hooks  Hardware hooks, all four set. Kept by reference.
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Does not call any hook, the caller puts the hardware in the
+ *       matching state.
+ *****************************************************************************/
+void session_Init(const SessionHooks_t *hooks)
+{
+	session.hooks = hooks;
+	session.profile = sessiondefaultprofile;
+	session.mode = PomodoroFunctions_PomodoroMode;
+	session.elapsed = 0;
+	session.cycles = 0;
+	session.pauses = 0;
+	session.run = SessionRun_Stopped;
+}
+/*****************************************************************************
+ * @brief Feeds one event to the engine.
+ *
+ * @details O(1): one lookup in the handler table, and for a mode change one
+ *          lookup in the mode table. Every transition goes through here,
+ *          whether a button or the time caused it.
+ *
+ * @param[in] event  Event to handle.
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @see session_Update()
+ *****************************************************************************/
+void session_Dispatch(SessionEvent_e event)
+{
+	if((unsigned)event < (unsigned)SessionEvent_Count)
+	{
+		sessionhandlers[event]();
+	}
+}
+/*****************************************************************************
+ * @brief Feeds the elapsed seconds of the current mode to the engine.
+ *
+ * @details When the mode length is reached SessionEvent_TimeUp is dispatched
+ *          and the seconds past the end carry into the next mode, which the
+ *          caller applies by consuming the returned length from its source.
+ *          The display hook is called when the elapsed value changes.
+ *
+ * @param[in] seconds  Elapsed seconds since the source was last zeroed.
+ *
+ * @return uint32_t
+ *
+ * @retval 0      The mode is still running.
+ * @retval other  Length of the mode that just ended.
+ *
+ * @see timeBase_ConsumeSeconds()
+ *****************************************************************************/
+uint32_t session_Update(uint32_t seconds)
+{
+	uint32_t consumed = 0;
+	uint32_t duration = session.profile.duration[session.mode];
+
+	if(seconds >= duration)
+	{
+		consumed = duration;
+		seconds -= duration;
+		session_Dispatch(SessionEvent_TimeUp);
+	}
+	sessionShow(seconds);
+	return consumed;
+}
+/*****************************************************************************
+ * @brief Current mode.
+ *
+ * @return PomodoroFunctions_e
+ *****************************************************************************/
+PomodoroFunctions_e session_GetMode(void)
+{
+	return session.mode;
+}
+/*****************************************************************************
+ * @brief Length of the current mode in seconds.
+ *
+ * @return uint32_t
+ *****************************************************************************/
+uint32_t session_GetDuration(void)
+{
+	return session.profile.duration[session.mode];
+}
+/*****************************************************************************
+ * @brief Elapsed seconds of the current mode, as last shown.
+ *
+ * @return uint32_t
+ *****************************************************************************/
+uint32_t session_GetElapsed(void)
+{
+	return session.elapsed;
+}
+/*****************************************************************************
+ * @brief Completed Pomodoros and short breaks towards the long break.
+ *
+ * @return uint8_t
+ *****************************************************************************/
+uint8_t session_GetCycles(void)
+{
+	return session.cycles;
+}
+/*****************************************************************************
+ * @brief Changes the mode lengths and cycles used from now on.
+ *
+ * @details The profile is copied, session_Update() keeps reading its RAM
+ *          copy, one array index per second. Only a stopped timer takes a
+ *          new profile, so a session never changes length while counted.
+ *
+ * @param[in] profile  Profile.
+ *
+ * @return bool
+ *
+ * @retval true   Profile in use.
+ * @retval false  Timer running or paused, or profile not valid; unchanged.
+ *
+ * @see session_IsProfileValid()
+ *****************************************************************************/
+bool session_SetProfile(const SessionProfile_t *profile)
+{
+	if((session.run != SessionRun_Stopped) || (session_IsProfileValid(profile) == false))
+	{
+		return false;
+	}
+	session.profile = *profile;
+	return true;
+}
+/*****************************************************************************
+ * @brief Whether a profile can be used.
+ *
+ * @details A zero length would end the mode at once on every update, zero
+ *          cycles would send every short break to the long break.
+ *
+ * @param[in] profile  Profile.
+ *
+ * @return bool true if all lengths and the cycles are non-zero.
+ *****************************************************************************/
+bool session_IsProfileValid(const SessionProfile_t *profile)
+{
+	bool valid = (profile != NULL) && (profile->cycles != 0U);
+
+	for(uint32_t i = 0; valid && (i < (uint32_t)PomodoroFunctions_Count); i++)
+	{
+		valid = (profile->duration[i] != 0U);
+	}
+	return valid;
+}
+/*****************************************************************************
+ * @brief Summary of the current session as if it ended now.
+ *
+ * @details Used when the session cannot end through an event, e.g. a
+ *          shutdown; the engine state is not changed.
+ *
+ * @param[in]  reason   End reason to put in the summary.
+ * @param[out] summary  Summary of the current session.
+ *
+ * @return bool
+ *
+ * @retval true   The timer is running or paused, summary filled.
+ * @retval false  The timer is stopped.
+ *****************************************************************************/
+bool session_GetSummary(SessionEnd_e reason, SessionSummary_t *summary)
+{
+	if(session.run == SessionRun_Stopped)
+	{
+		return false;
+	}
+	summary->mode = session.mode;
+	summary->planned = session.profile.duration[session.mode];
+	summary->actual = (uint16_t)((session.elapsed > UINT16_MAX) ? UINT16_MAX : session.elapsed);
+	summary->pauses = session.pauses;
+	summary->reason = reason;
+	return true;
+}
+/*****************************************************************************
+ * @brief Copies the engine state.
+ *
+ * @param[out] state  Engine state.
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @see session_SetState()
+ *****************************************************************************/
+void session_GetState(SessionState_t *state)
+{
+	state->mode = session.mode;
+	state->run = session.run;
+	state->elapsed = (uint16_t)((session.elapsed > UINT16_MAX) ? UINT16_MAX : session.elapsed);
+	state->cycles = session.cycles;
+	state->pauses = session.pauses;
+}
+/*****************************************************************************
+ * @brief Puts the engine back into a saved state.
+ *
+ * @details The state must be one the engine can reach with the profile in
+ *          use: a known mode and run state, the elapsed seconds inside the
+ *          mode length, no more cycles than the profile, and a stopped
+ *          timer at zero. Select the profile first.
+ *
+ * @param[in] state  Engine state.
+ *
+ * @return bool
+ *
+ * @retval true   State in use.
+ * @retval false  State not reachable; unchanged.
+ *
+ * @note Does not call any hook, like session_Init() the caller puts the
+ *       elapsed seconds source, the display and the timer in the matching
+ *       state.
+ *****************************************************************************/
+bool session_SetState(const SessionState_t *state)
+{
+	if(((unsigned)state->mode >= (unsigned)PomodoroFunctions_Count) ||
+	   ((unsigned)state->run > (unsigned)SessionRun_Paused) ||
+	   (state->elapsed >= session.profile.duration[state->mode]) ||
+	   (state->cycles > session.profile.cycles) ||
+	   ((state->run == SessionRun_Stopped) && ((state->elapsed != 0U) || (state->pauses != 0U))))
+	{
+		return false;
+	}
+	session.mode = state->mode;
+	session.run = state->run;
+	session.elapsed = state->elapsed;
+	session.cycles = state->cycles;
+	session.pauses = state->pauses;
+	return true;
+}
+/*****************************************************************************
+ * @brief Run state of the timer.
+ *
+ * @return SessionRun_e
+ *****************************************************************************/
+SessionRun_e session_GetRun(void)
+{
+	return session.run;
+}
+/*****************************************************************************
+ * @brief Whether the timer is running (counting).
+ *
+ * @return bool
+ *****************************************************************************/
+bool session_IsRunning(void)
+{
+	return (session.run == SessionRun_Running);
+}
+/*****************************************************************************
+ * @brief Whether the timer is paused.
+ *
+ * @return bool
+ *****************************************************************************/
+bool session_IsPaused(void)
+{
+	return (session.run == SessionRun_Paused);
+}
+/*************************************END*************************************/
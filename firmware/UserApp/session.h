@@ -0,0 +1,310 @@
+/**
+ * \file           session.h
+ * \brief          Table-driven Pomodoro session engine header file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+#ifndef SESSION_H_
+#define SESSION_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/*****************************************************************************/
+/* Session Macros                                                            */
+/*****************************************************************************/
+
+/**
+ * @brief Pomodoro session duration in seconds.
+ *
+ * @details Represents 25 minutes (25 * 60 = 1500 seconds). This and the
+ *          three macros below make the compiled default profile, used
+ *          until session_SetProfile() selects another one.
+ */
+#define POMODOROMODE_TIME            (1500) /*25 minutes in seconds*/
+
+/**
+ * @brief Short break duration in seconds.
+ *
+ * @details Represents 5 minutes (5 * 60 = 300 seconds).
+ */
+#define SHORTBREAK_TIME              (300)  /*5 minutes in seconds*/
+
+/**
+ * @brief Long break duration in seconds.
+ *
+ * @details Represents 15 minutes (15 * 60 = 900 seconds).
+ */
+#define LONGBREAK_TIME               (900)  /*15 minutes in seconds*/
+
+/**
+ * @brief No of cycles to shift to Long Break.
+ *
+ * @details If we required to take 6 cycles i.e. 3 pomodoros & 2 Short Breaks,
+ *          then Total no of cycles - 1 put 5 over here.
+ */
+#define NO_OF_CYCLES                  (5) /*3 Pomodoros & 2 Short Breaks*/
+
+/*****************************************************************************/
+/* Session Enums                                                             */
+/*****************************************************************************/
+
+/**
+ * @brief Enum for Pomodoro timer modes.
+ *
+ * @details Used to switch between different Pomodoro states during operation.
+ */
+typedef enum
+{
+	PomodoroFunctions_PomodoroMode,   /**< Pomodoro work session */
+	PomodoroFunctions_ShortBreak,     /**< Short break session */
+	PomodoroFunctions_LongBreak,      /**< Long break session */
+	PomodoroFunctions_Count,          /**< Number of modes */
+}PomodoroFunctions_e;
+
+/**
+ * @brief Events fed to the session engine.
+ *
+ * @details User and time events go through the same session_Dispatch().
+ */
+typedef enum
+{
+	SessionEvent_StartPause,          /**< Start a stopped timer, pause a running one, resume a paused one */
+	SessionEvent_Restart,             /**< Restart the current session from zero, or stop a paused timer */
+	SessionEvent_Skip,                /**< End the current session now, by the user */
+	SessionEvent_TimeUp,              /**< The current session ran its full length */
+	SessionEvent_Count,               /**< Number of session events */
+}SessionEvent_e;
+
+/**
+ * @brief Run state of the timer.
+ */
+typedef enum
+{
+	SessionRun_Stopped,               /**< Not started, first Pomodoro at zero */
+	SessionRun_Running,               /**< Counting */
+	SessionRun_Paused,                /**< Not counting, elapsed time and second phase kept */
+}SessionRun_e;
+
+/**
+ * @brief What the session engine asks from the elapsed seconds source.
+ */
+typedef enum
+{
+	SessionTimer_Start,               /**< Restart from zero and start counting, with a full first second */
+	SessionTimer_Stop,                /**< Stop counting and restart from zero */
+	SessionTimer_Pause,               /**< Stop counting, keep the elapsed seconds and the second phase */
+	SessionTimer_Resume,              /**< Continue counting from the kept second phase */
+	SessionTimer_Restart,             /**< Restart from zero while counting, with a full first second */
+	SessionTimer_Zero,                /**< Restart from zero while not counting */
+}SessionTimer_e;
+
+/**
+ * @brief Why a started session ended.
+ */
+typedef enum
+{
+	SessionEnd_TimeUp,                /**< Ran its full length */
+	SessionEnd_Skip,                  /**< Skipped to the next mode */
+	SessionEnd_Restart,               /**< Restarted from zero */
+	SessionEnd_Stop,                  /**< Timer stopped while paused */
+	SessionEnd_Shutdown,              /**< Power down (critical battery) */
+	SessionEnd_Count,                 /**< Number of end reasons */
+}SessionEnd_e;
+
+/*****************************************************************************/
+/* Session Structures                                                        */
+/*****************************************************************************/
+
+/**
+ * @brief Lengths of the modes and cycles to the long break.
+ */
+typedef struct
+{
+	uint16_t duration[PomodoroFunctions_Count]; /**< Length of each mode in seconds, indexed by PomodoroFunctions_e */
+	uint8_t cycles;                   /**< Pomodoros and short breaks before the long break, like NO_OF_CYCLES */
+}SessionProfile_t;
+
+/**
+ * @brief Summary of a session that ended, for the history log.
+ */
+typedef struct
+{
+	PomodoroFunctions_e mode;         /**< Mode of the session */
+	uint16_t planned;                 /**< Mode length in seconds */
+	uint16_t actual;                  /**< Seconds counted before it ended */
+	uint8_t pauses;                   /**< Number of pauses, saturates at 255 */
+	SessionEnd_e reason;              /**< Why it ended */
+}SessionSummary_t;
+
+/**
+ * @brief State of the engine, saved over a STANDBY.
+ */
+typedef struct
+{
+	PomodoroFunctions_e mode;         /**< Current mode */
+	SessionRun_e run;                 /**< Run state */
+	uint16_t elapsed;                 /**< Elapsed seconds of the current mode */
+	uint8_t cycles;                   /**< Completed Pomodoros and short breaks */
+	uint8_t pauses;                   /**< Pauses in the current mode */
+}SessionState_t;
+
+/**
+ * @brief Hooks through which the engine drives the hardware.
+ *
+ * @details All four must be set. They run synchronously inside
+ *          session_Dispatch() and session_Update().
+ */
+typedef struct
+{
+	void (*timer)(SessionTimer_e action);                              /**< Start/stop/zero the elapsed seconds */
+	void (*modeEnd)(PomodoroFunctions_e finished, SessionEvent_e cause); /**< A mode ended, the new one is session_GetMode() */
+	void (*display)(uint32_t elapsed);                                  /**< Elapsed seconds of the current mode changed */
+	void (*ended)(const SessionSummary_t *summary);                     /**< A started session ended, before the next one begins */
+}SessionHooks_t;
+
+/*****************************************************************************/
+/* Session Function Declarations                                             */
+/*****************************************************************************/
+
+/**
+ * @brief Stops the engine in the first Pomodoro with no elapsed time.
+ *
+ * @param[in] hooks Hardware hooks, kept by reference.
+ */
+void session_Init(const SessionHooks_t *hooks);
+
+/**
+ * @brief Feeds one event to the engine.
+ *
+ * @param[in] event Event to handle, out of range events are ignored.
+ */
+void session_Dispatch(SessionEvent_e event);
+
+/**
+ * @brief Feeds the elapsed seconds of the current mode to the engine.
+ *
+ * @details Dispatches SessionEvent_TimeUp when the mode length is reached and
+ *          calls the display hook when the shown value changes.
+ *
+ * @param[in] seconds Elapsed seconds since the elapsed source was last zeroed.
+ *
+ * @return Seconds the finished mode took off, to be consumed from the source.
+ */
+uint32_t session_Update(uint32_t seconds);
+
+/**
+ * @brief Current mode.
+ */
+PomodoroFunctions_e session_GetMode(void);
+
+/**
+ * @brief Length of the current mode in seconds.
+ */
+uint32_t session_GetDuration(void);
+
+/**
+ * @brief Elapsed seconds of the current mode, as last shown.
+ */
+uint32_t session_GetElapsed(void);
+
+/**
+ * @brief Completed Pomodoros and short breaks towards the long break.
+ */
+uint8_t session_GetCycles(void);
+
+/**
+ * @brief Changes the mode lengths and cycles used from now on.
+ *
+ * @param[in] profile  Profile, copied.
+ *
+ * @return false if the timer is not stopped or the profile is not valid.
+ */
+bool session_SetProfile(const SessionProfile_t *profile);
+
+/**
+ * @brief Whether a profile can be used: all lengths and cycles non-zero.
+ *
+ * @param[in] profile  Profile.
+ */
+bool session_IsProfileValid(const SessionProfile_t *profile);
+
+/**
+ * @brief Summary of the current session as if it ended now.
+ *
+ * @param[in]  reason   End reason to put in the summary.
+ * @param[out] summary  Filled when a session is started.
+ *
+ * @return false while the timer is stopped (no session to summarize).
+ */
+bool session_GetSummary(SessionEnd_e reason, SessionSummary_t *summary);
+
+/**
+ * @brief Copies the engine state.
+ *
+ * @param[out] state  Mode, run state, elapsed seconds, cycles and pauses.
+ */
+void session_GetState(SessionState_t *state);
+
+/**
+ * @brief Puts the engine back into a saved state, with the current profile.
+ *
+ * @param[in] state  State from session_GetState().
+ *
+ * @return false if the state does not fit the profile; unchanged.
+ */
+bool session_SetState(const SessionState_t *state);
+
+/**
+ * @brief Run state of the timer.
+ */
+SessionRun_e session_GetRun(void);
+
+/**
+ * @brief Whether the timer is running (counting).
+ */
+bool session_IsRunning(void);
+
+/**
+ * @brief Whether the timer is paused.
+ */
+bool session_IsPaused(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SESSION_H_ */
@@ -0,0 +1,438 @@
+/**
+ * \file           sessionlog.c
+ * \brief          Session history log source file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+/*
+ * Layout of the log sector (FlashRegion_SessionLog), 16 byte slots:
+ *
+ *   slot 0      header  MAGIC, erase count, sequence of slot 1, CRC
+ *   slot 1...   records sequence, mode/reason/pauses/version,
+ *                       planned/actual, CRC
+ *
+ * Records are appended in slot order and the CRC word is programmed last,
+ * so a power cut leaves at most one torn slot, which is skipped. The write
+ * position is the first erased slot; used slots are never followed by
+ * erased ones, so it is found by a binary search at boot (13 slot reads
+ * for 8191 slots) instead of a scan.
+ *
+ * When the sector is full it is erased as a whole and the log starts again
+ * with the next sequence number: the history before the erase is lost. One
+ * erase per 8191 sessions is one erase every few years of daily use, far
+ * below the 10000 cycles the sector is specified for, which is why no
+ * second sector is used.
+ */
+
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "sessionlog.h"
+#if APP_SESSION_LOG
+#include <string.h>
+#include "flashregion.h"
+/*****************************************************************************/
+/* Private Defines                                                           */
+/*****************************************************************************/
+#define SESSIONLOG_ERASED            0xFFFFFFFFU   /** Erased flash word **/
+#define SESSIONLOG_CRC_WORD          3U            /** Word holding the CRC of the words before it **/
+
+#if (APP_SESSION_LOG_STAGING < 1) || (APP_SESSION_LOG_STAGING > 255)
+#error "APP_SESSION_LOG_STAGING must be 1 ... 255"
+#endif
+
+/*****************************************************************************/
+/* Private Types                                                             */
+/*****************************************************************************/
+/**
+ * @brief Write position and staged records.
+ */
+typedef struct
+{
+	uint32_t slots;                   /**< Slots in the sector, header included */
+	uint32_t next;                    /**< First erased slot, slots when full */
+	uint32_t eraseCount;              /**< Erase count of the header */
+	uint32_t firstSequence;           /**< Sequence of slot 1 */
+	uint32_t dropped;                 /**< Records dropped, staging full */
+	uint8_t staged;                   /**< Records in staging */
+	SessionSummary_t staging[APP_SESSION_LOG_STAGING]; /**< Records not yet in flash, oldest first */
+}SessionLog_t;
+
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static SessionLog_t sessionlog; /** Log state **/
+
+/*****************************************************************************/
+/* Private Functions                                                         */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Copies one slot out of flash.
+ *
+ * @param[in]  slot   Slot number.
+ * @param[out] words  SESSIONLOG_RECORD_WORDS words.
+ *
+ * @return None
+ *****************************************************************************/
+static void sessionLogLoad(uint32_t slot, uint32_t *words)
+{
+	const volatile uint32_t *base = FlashRegion_GetBase(FlashRegion_SessionLog) + (slot * SESSIONLOG_RECORD_WORDS);
+
+	for(uint32_t i = 0; i < SESSIONLOG_RECORD_WORDS; i++)
+	{
+		words[i] = base[i];
+	}
+}
+/*****************************************************************************
+ * @brief CRC of the words of a slot before its CRC word.
+ *
+ * @param[in] words  Slot words.
+ *
+ * @return uint32_t Standard CRC-32.
+ *****************************************************************************/
+static uint32_t sessionLogCrc(const uint32_t *words)
+{
+	return ~stdUtil_crc32(STDUTIL_CRC32_INIT, words, SESSIONLOG_CRC_WORD * 4U);
+}
+/*****************************************************************************
+ * @brief Checks if a slot is still erased.
+ *
+ * @param[in] slot  Slot number.
+ *
+ * @return bool true if all words read 0xFFFFFFFF.
+ *****************************************************************************/
+static bool sessionLogIsErased(uint32_t slot)
+{
+	uint32_t words[SESSIONLOG_RECORD_WORDS];
+
+	sessionLogLoad(slot, words);
+	for(uint32_t i = 0; i < SESSIONLOG_RECORD_WORDS; i++)
+	{
+		if(words[i] != SESSIONLOG_ERASED)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+/*****************************************************************************
+ * @brief Programs one slot, CRC word included.
+ *
+ * @param[in]     slot   Slot number.
+ * @param[in,out] words  Slot words, the CRC word is filled in.
+ *
+ * @return bool true if programmed. The slot is used either way.
+ *****************************************************************************/
+static bool sessionLogProgram(uint32_t slot, uint32_t *words)
+{
+	words[SESSIONLOG_CRC_WORD] = sessionLogCrc(words);
+	return FlashRegion_Program(FlashRegion_SessionLog, slot * SESSIONLOG_RECORD_SIZE, words, SESSIONLOG_RECORD_WORDS);
+}
+/*****************************************************************************
+ * @brief Starts a new log in the sector.
+ *
+ * @details Erases the sector if asked to and writes the header. The old
+ *          header is zeroed before the erase: an erase cut by a power
+ *          failure can leave any mix of erased and programmed words, the
+ *          header must not survive it as valid. If formatting fails the log
+ *          is left full, the next flush that may erase tries again.
+ *
+ * @param[in] erase          Erase the sector first.
+ * @param[in] eraseCount     Erase count for the header.
+ * @param[in] firstSequence  Sequence of the first record.
+ *
+ * @return None
+ *****************************************************************************/
+static void sessionLogFormat(bool erase, uint32_t eraseCount, uint32_t firstSequence)
+{
+	static const uint32_t retired[SESSIONLOG_RECORD_WORDS] = { 0 };
+	uint32_t header[SESSIONLOG_RECORD_WORDS] = { SESSIONLOG_MAGIC, eraseCount, firstSequence, 0 };
+
+	sessionlog.eraseCount = eraseCount;
+	sessionlog.firstSequence = firstSequence;
+	sessionlog.next = sessionlog.slots;
+	if(erase)
+	{
+		(void)FlashRegion_Program(FlashRegion_SessionLog, 0, retired, SESSIONLOG_RECORD_WORDS);
+		if(FlashRegion_Erase(FlashRegion_SessionLog) == false)
+		{
+			return;
+		}
+	}
+	if(sessionLogProgram(0, header))
+	{
+		sessionlog.next = 1;
+	}
+}
+/*****************************************************************************
+ * @brief Checks that the whole sector is erased.
+ *
+ * @details Needed when the header is erased: an erase interrupted by a
+ *          power cut can leave any part of the sector programmed.
+ *
+ * @return bool true if every word reads 0xFFFFFFFF.
+ *****************************************************************************/
+static bool sessionLogIsBlank(void)
+{
+	const volatile uint32_t *base = FlashRegion_GetBase(FlashRegion_SessionLog);
+	uint32_t words = FlashRegion_GetSize(FlashRegion_SessionLog) / 4U;
+
+	for(uint32_t i = 0; i < words; i++)
+	{
+		if(base[i] != SESSIONLOG_ERASED)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/*****************************************************************************/
+/* Session Log Functions                                                     */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Finds the write position after a reset.
+ *
+ * @details With a valid header the first erased slot is found by a binary
+ *          search. An erased sector gets a header; a broken header (power
+ *          cut while formatting or erasing) costs one erase, the erase
+ *          count restarts.
+ *
+ * @param None
+ *
+ * @return None
+ *****************************************************************************/
+void sessionLog_Init(void)
+{
+	uint32_t header[SESSIONLOG_RECORD_WORDS];
+
+	memset(&sessionlog, 0, sizeof(sessionlog));
+	sessionlog.slots = FlashRegion_GetSize(FlashRegion_SessionLog) / SESSIONLOG_RECORD_SIZE;
+
+	sessionLogLoad(0, header);
+	if((header[0] == SESSIONLOG_MAGIC) && (header[SESSIONLOG_CRC_WORD] == sessionLogCrc(header)))
+	{
+		uint32_t low = 1;
+		uint32_t high = sessionlog.slots;
+
+		/* slots below low are used, slots from high on are erased */
+		while(low < high)
+		{
+			uint32_t middle = low + ((high - low) / 2U);
+
+			if(sessionLogIsErased(middle))
+			{
+				high = middle;
+			}
+			else
+			{
+				low = middle + 1U;
+			}
+		}
+		sessionlog.eraseCount = header[1];
+		sessionlog.firstSequence = header[2];
+		sessionlog.next = low;
+	}
+	else if(sessionLogIsErased(0) && sessionLogIsBlank())
+	{
+		sessionLogFormat(false, 0, 0);
+	}
+	else
+	{
+		sessionLogFormat(true, 1, 0);
+	}
+}
+/*****************************************************************************
+ * @brief Stages one record in RAM.
+ *
+ * @param[in] summary  Session that ended.
+ *
+ * @return bool
+ *
+ * @retval true   Staged.
+ * @retval false  Staging full, the record is dropped and counted.
+ *****************************************************************************/
+bool sessionLog_Append(const SessionSummary_t *summary)
+{
+	if(sessionlog.staged >= APP_SESSION_LOG_STAGING)
+	{
+		sessionlog.dropped++;
+		return false;
+	}
+	sessionlog.staging[sessionlog.staged++] = *summary;
+	return true;
+}
+/*****************************************************************************
+ * @brief Writes the staged records to flash.
+ *
+ * @details A record takes four word programs, about 70 us. A slot that
+ *          fails to program stays used and reads back as invalid. A full
+ *          sector is only erased when allowed, the erase stalls the core
+ *          for 1 to 2 s; otherwise the records stay staged.
+ *
+ * @param[in] allowErase  The sector may be erased when it is full.
+ *
+ * @return None
+ *****************************************************************************/
+void sessionLog_Flush(bool allowErase)
+{
+	uint8_t written = 0;
+
+	while(written < sessionlog.staged)
+	{
+		const SessionSummary_t *summary = &sessionlog.staging[written];
+		uint32_t words[SESSIONLOG_RECORD_WORDS];
+
+		if(sessionlog.next >= sessionlog.slots)
+		{
+			if(allowErase == false)
+			{
+				break;
+			}
+			sessionLogFormat(true, sessionlog.eraseCount + 1U, sessionlog.firstSequence + sessionlog.slots - 1U);
+			if(sessionlog.next >= sessionlog.slots)
+			{
+				break;
+			}
+		}
+
+		words[0] = sessionlog.firstSequence + sessionlog.next - 1U;
+		words[1] = (uint32_t)summary->mode | ((uint32_t)summary->reason << 8U) |
+				((uint32_t)summary->pauses << 16U) | (SESSIONLOG_VERSION << 24U);
+		words[2] = (uint32_t)summary->planned | ((uint32_t)summary->actual << 16U);
+		(void)sessionLogProgram(sessionlog.next, words);
+		sessionlog.next++;
+		written++;
+	}
+
+	sessionlog.staged -= written;
+	memmove(&sessionlog.staging[0], &sessionlog.staging[written], sessionlog.staged * sizeof(SessionSummary_t));
+}
+/*****************************************************************************
+ * @brief Writes the staged records at a quiet moment.
+ *
+ * @details While the timer runs the records are only written once the
+ *          staging buffer is full and never with an erase, so a running
+ *          second is not stalled.
+ *
+ * @param[in] idle  Timer paused or stopped.
+ *
+ * @return None
+ *****************************************************************************/
+void sessionLog_Service(bool idle)
+{
+	if((sessionlog.staged > 0U) && (idle || (sessionlog.staged >= APP_SESSION_LOG_STAGING)))
+	{
+		sessionLog_Flush(idle);
+	}
+}
+/*****************************************************************************
+ * @brief Returns the number of used record slots.
+ *
+ * @param None
+ *
+ * @return uint32_t Records in flash, torn ones included.
+ *****************************************************************************/
+uint32_t sessionLog_GetCount(void)
+{
+	return (sessionlog.next > 0U) ? (sessionlog.next - 1U) : 0U;
+}
+/*****************************************************************************
+ * @brief Reads one record.
+ *
+ * @param[in]  index   Record index, oldest first.
+ * @param[out] record  Record.
+ *
+ * @return bool
+ *
+ * @retval true   Valid record.
+ * @retval false  Out of range, torn or from another format version.
+ *****************************************************************************/
+bool sessionLog_Read(uint32_t index, SessionLogRecord_t *record)
+{
+	uint32_t words[SESSIONLOG_RECORD_WORDS];
+	uint32_t slot = index + 1U;
+
+	if(slot >= sessionlog.next)
+	{
+		return false;
+	}
+	sessionLogLoad(slot, words);
+	if((words[SESSIONLOG_CRC_WORD] != sessionLogCrc(words)) ||
+			(words[0] != (sessionlog.firstSequence + index)) ||
+			((words[1] >> 24U) != SESSIONLOG_VERSION) ||
+			((words[1] & 0xFFU) >= (uint32_t)PomodoroFunctions_Count) ||
+			(((words[1] >> 8U) & 0xFFU) >= (uint32_t)SessionEnd_Count))
+	{
+		return false;
+	}
+
+	record->sequence = words[0];
+	record->summary.mode = (PomodoroFunctions_e)(words[1] & 0xFFU);
+	record->summary.reason = (SessionEnd_e)((words[1] >> 8U) & 0xFFU);
+	record->summary.pauses = (uint8_t)(words[1] >> 16U);
+	record->summary.planned = (uint16_t)words[2];
+	record->summary.actual = (uint16_t)(words[2] >> 16U);
+	return true;
+}
+/*****************************************************************************
+ * @brief Returns the erase count of the sector.
+ *
+ * @param None
+ *
+ * @return uint32_t Erases since the log was first formatted.
+ *****************************************************************************/
+uint32_t sessionLog_GetEraseCount(void)
+{
+	return sessionlog.eraseCount;
+}
+/*****************************************************************************
+ * @brief Returns the number of staged records.
+ *
+ * @param None
+ *
+ * @return uint32_t Records not yet in flash.
+ *****************************************************************************/
+uint32_t sessionLog_GetStaged(void)
+{
+	return sessionlog.staged;
+}
+/*****************************************************************************
+ * @brief Returns the number of dropped records.
+ *
+ * @param None
+ *
+ * @return uint32_t Records lost to a full staging buffer.
+ *****************************************************************************/
+uint32_t sessionLog_GetDropped(void)
+{
+	return sessionlog.dropped;
+}
+#endif
+/*************************************END*************************************/
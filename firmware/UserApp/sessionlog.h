@@ -0,0 +1,151 @@
+/**
+ * \file           sessionlog.h
+ * \brief          Session history log header file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+#ifndef SESSIONLOG_H_
+#define SESSIONLOG_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "session.h"
+#include "AppConfig.h"
+
+/*****************************************************************************/
+/* Session Log Macros                                                        */
+/*****************************************************************************/
+
+/**
+ * @brief Words per flash record (slot).
+ */
+#define SESSIONLOG_RECORD_WORDS              4U
+
+/**
+ * @brief Bytes per flash record (slot).
+ */
+#define SESSIONLOG_RECORD_SIZE               (SESSIONLOG_RECORD_WORDS * 4U)
+
+/**
+ * @brief Marks slot 0 of the sector as the log header ("SLOG").
+ */
+#define SESSIONLOG_MAGIC                     0x474F4C53U
+
+/**
+ * @brief Record format version, stored in every record.
+ */
+#define SESSIONLOG_VERSION                   1U
+
+/*****************************************************************************/
+/* Session Log Structures                                                    */
+/*****************************************************************************/
+
+/**
+ * @brief One record read back from the log.
+ */
+typedef struct
+{
+	uint32_t sequence;                /**< Running record number, kept over sector erases */
+	SessionSummary_t summary;         /**< The session */
+}SessionLogRecord_t;
+
+/*****************************************************************************/
+/* Session Log Function Declarations                                         */
+/*****************************************************************************/
+
+/**
+ * @brief Finds the write position after a reset, repairs the sector if needed.
+ *
+ * @note May erase the sector (1 to 2 s) when its header is missing or broken.
+ */
+void sessionLog_Init(void);
+
+/**
+ * @brief Stages one record in RAM.
+ *
+ * @param[in] summary  Session that ended.
+ *
+ * @return false if the staging buffer was full and the record dropped.
+ */
+bool sessionLog_Append(const SessionSummary_t *summary);
+
+/**
+ * @brief Writes the staged records to flash.
+ *
+ * @param[in] allowErase  The sector may be erased when it is full.
+ */
+void sessionLog_Flush(bool allowErase);
+
+/**
+ * @brief Writes the staged records when the timer is idle or the buffer full.
+ *
+ * @param[in] idle  Timer paused or stopped, erasing is allowed.
+ */
+void sessionLog_Service(bool idle);
+
+/**
+ * @brief Number of used record slots in the sector, torn records included.
+ */
+uint32_t sessionLog_GetCount(void);
+
+/**
+ * @brief Reads one record.
+ *
+ * @param[in]  index   0 ... sessionLog_GetCount() - 1, oldest first.
+ * @param[out] record  Record.
+ *
+ * @return false if the slot holds no valid record (torn by a power cut).
+ */
+bool sessionLog_Read(uint32_t index, SessionLogRecord_t *record);
+
+/**
+ * @brief Number of times the sector was erased, from its header.
+ */
+uint32_t sessionLog_GetEraseCount(void);
+
+/**
+ * @brief Number of records waiting in the staging buffer.
+ */
+uint32_t sessionLog_GetStaged(void);
+
+/**
+ * @brief Records dropped because the staging buffer was full.
+ */
+uint32_t sessionLog_GetDropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SESSIONLOG_H_ */
@@ -0,0 +1,203 @@
+/**
+ * \file           snapshot.c
+ * \brief          Session snapshot in the RTC backup registers source file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+/*
+ * Layout in the RTC backup registers, from SNAPSHOT_FIRST_REGISTER:
+ *
+ *   word 0  SNAPSHOT_MAGIC
+ *   word 1  elapsed (bits 0-15), cycles (16-23), pauses (24-31)
+ *   word 2  mode (0-7), run (8-15), profile (16-23), reason (24-31)
+ *   word 3  CRC-32 of words 0 ... 2
+ *   word 4  core cycles of the last brownout snapshot, outside the CRC
+ *
+ * The backup registers keep their value over STANDBY and every reset, but
+ * not over a power cycle without VBAT; a write cut short leaves a CRC that
+ * does not match, which reads as no snapshot.
+ */
+
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "snapshot.h"
+#include "Platform_Translate.h"
+
+/*****************************************************************************/
+/* Private Defines                                                           */
+/*****************************************************************************/
+#define SNAPSHOT_CRC_WORD            3U            /** Word holding the CRC of the words before it **/
+
+/*****************************************************************************/
+/* Private Functions                                                         */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief CRC of the words before the CRC word.
+ *
+ * @param[in] words  Snapshot words.
+ *
+ * @return uint32_t Standard CRC-32.
+ *****************************************************************************/
+static uint32_t snapshotCrc(const uint32_t *words)
+{
+	return ~stdUtil_crc32(STDUTIL_CRC32_INIT, words, SNAPSHOT_CRC_WORD * 4U);
+}
+
+/*****************************************************************************/
+/* Snapshot Functions                                                        */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Writes the snapshot into the backup registers.
+ *
+ * @details The magic and the CRC word are written last.
+ *
+ * @param[in] snapshot  Snapshot.
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+void snapshot_Save(const Snapshot_t *snapshot)
+{
+	uint32_t words[SNAPSHOT_REGISTERS];
+
+	words[0] = SNAPSHOT_MAGIC;
+	words[1] = (uint32_t)snapshot->state.elapsed |
+			((uint32_t)snapshot->state.cycles << 16) |
+			((uint32_t)snapshot->state.pauses << 24);
+	words[2] = ((uint32_t)snapshot->state.mode & 0xFFU) |
+			(((uint32_t)snapshot->state.run & 0xFFU) << 8) |
+			((uint32_t)snapshot->profile << 16) |
+			(((uint32_t)snapshot->reason & 0xFFU) << 24);
+	words[SNAPSHOT_CRC_WORD] = snapshotCrc(words);
+
+	APP_BACKUP_WRITE(SNAPSHOT_FIRST_REGISTER + 1U, words[1]);
+	APP_BACKUP_WRITE(SNAPSHOT_FIRST_REGISTER + 2U, words[2]);
+	APP_BACKUP_WRITE(SNAPSHOT_FIRST_REGISTER, words[0]);
+	APP_BACKUP_WRITE(SNAPSHOT_FIRST_REGISTER + SNAPSHOT_CRC_WORD, words[SNAPSHOT_CRC_WORD]);
+}
+/*****************************************************************************
+ * @brief Reads the snapshot back.
+ *
+ * @details The engine state is only checked for its encoding here,
+ *          session_SetState() checks it against the profile.
+ *
+ * @param[out] snapshot  Snapshot.
+ *
+ * @return bool
+ *
+ * @retval true   Snapshot filled.
+ * @retval false  No snapshot, or a broken one.
+ *****************************************************************************/
+bool snapshot_Load(Snapshot_t *snapshot)
+{
+	uint32_t words[SNAPSHOT_REGISTERS];
+
+	for(uint32_t i = 0; i < SNAPSHOT_REGISTERS; i++)
+	{
+		words[i] = APP_BACKUP_READ(SNAPSHOT_FIRST_REGISTER + i);
+	}
+	if((words[0] != SNAPSHOT_MAGIC) || (words[SNAPSHOT_CRC_WORD] != snapshotCrc(words)) ||
+	   (((words[2] >> 24) & 0xFFU) >= (uint32_t)SnapshotReason_Count))
+	{
+		return false;
+	}
+
+	snapshot->state.elapsed = (uint16_t)words[1];
+	snapshot->state.cycles = (uint8_t)(words[1] >> 16);
+	snapshot->state.pauses = (uint8_t)(words[1] >> 24);
+	snapshot->state.mode = (PomodoroFunctions_e)(words[2] & 0xFFU);
+	snapshot->state.run = (SessionRun_e)((words[2] >> 8) & 0xFFU);
+	snapshot->profile = (uint8_t)(words[2] >> 16);
+	snapshot->reason = (SnapshotReason_e)((words[2] >> 24) & 0xFFU);
+	return true;
+}
+/*****************************************************************************
+ * @brief Whether a valid snapshot is saved.
+ *
+ * @param None
+ *
+ * @return bool true if snapshot_Load() would return one.
+ *****************************************************************************/
+bool snapshot_IsSaved(void)
+{
+	Snapshot_t snapshot;
+
+	return snapshot_Load(&snapshot);
+}
+/*****************************************************************************
+ * @brief Removes the snapshot.
+ *
+ * @details Clearing the magic is enough, the CRC covers it.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+void snapshot_Clear(void)
+{
+	APP_BACKUP_WRITE(SNAPSHOT_FIRST_REGISTER, 0U);
+}
+/*****************************************************************************
+ * @brief Keeps the core cycles a snapshot took.
+ *
+ * @details Written after the snapshot itself, a cut here only loses the
+ *          measurement.
+ *
+ * @param[in] cycles  Core cycles.
+ *
+ * @return None
+ *
+ * @retval None
+ *****************************************************************************/
+void snapshot_SetCycles(uint32_t cycles)
+{
+	APP_BACKUP_WRITE(SNAPSHOT_CYCLES_REGISTER, cycles);
+}
+/*****************************************************************************
+ * @brief Returns and clears the kept core cycles.
+ *
+ * @param None
+ *
+ * @return uint32_t Core cycles, 0 if none were kept since the last call.
+ *****************************************************************************/
+uint32_t snapshot_TakeCycles(void)
+{
+	uint32_t cycles = APP_BACKUP_READ(SNAPSHOT_CYCLES_REGISTER);
+
+	if(cycles != 0U)
+	{
+		APP_BACKUP_WRITE(SNAPSHOT_CYCLES_REGISTER, 0U);
+	}
+	return cycles;
+}
+/*************************************END*************************************/
@@ -0,0 +1,143 @@
+/**
+ * \file           snapshot.h
+ * \brief          Session snapshot in the RTC backup registers header file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "session.h"
+#include "AppConfig.h"
+
+/*****************************************************************************/
+/* Snapshot Macros                                                           */
+/*****************************************************************************/
+
+/**
+ * @brief First RTC backup register of the snapshot (BKP0R).
+ */
+#define SNAPSHOT_FIRST_REGISTER              0U
+
+/**
+ * @brief Backup registers of one snapshot: magic, two data words, CRC.
+ */
+#define SNAPSHOT_REGISTERS                   4U
+
+/**
+ * @brief Backup register after the snapshot with the core cycles the last
+ *        brownout snapshot took (BKP4R).
+ */
+#define SNAPSHOT_CYCLES_REGISTER             (SNAPSHOT_FIRST_REGISTER + SNAPSHOT_REGISTERS)
+
+/**
+ * @brief Marks a saved snapshot ("SNAP").
+ */
+#define SNAPSHOT_MAGIC                       0x50414E53U
+
+/*****************************************************************************/
+/* Snapshot Enums                                                            */
+/*****************************************************************************/
+
+/**
+ * @brief Why the snapshot was taken.
+ */
+typedef enum
+{
+	SnapshotReason_Idle,              /**< Deep idle in STANDBY, see APP_IDLE_STANDBY */
+	SnapshotReason_PowerFail,         /**< Supply below the PVD level, see APP_BROWNOUT_RESUME */
+	SnapshotReason_Count,             /**< Number of reasons */
+}SnapshotReason_e;
+
+/*****************************************************************************/
+/* Snapshot Structures                                                       */
+/*****************************************************************************/
+
+/**
+ * @brief What is kept over a STANDBY.
+ */
+typedef struct
+{
+	SessionState_t state;             /**< Session engine state */
+	uint8_t profile;                  /**< Selected profile, index into the profile store */
+	SnapshotReason_e reason;          /**< Why it was taken */
+}Snapshot_t;
+
+/*****************************************************************************/
+/* Snapshot Function Declarations                                            */
+/*****************************************************************************/
+
+/**
+ * @brief Writes the snapshot into the backup registers.
+ *
+ * @param[in] snapshot  Snapshot.
+ */
+void snapshot_Save(const Snapshot_t *snapshot);
+
+/**
+ * @brief Reads the snapshot back.
+ *
+ * @param[out] snapshot  Filled when valid.
+ *
+ * @return false if there is none, or its magic or CRC does not match.
+ */
+bool snapshot_Load(Snapshot_t *snapshot);
+
+/**
+ * @brief Whether a valid snapshot is saved.
+ */
+bool snapshot_IsSaved(void);
+
+/**
+ * @brief Removes the snapshot, so it is restored only once.
+ */
+void snapshot_Clear(void);
+
+/**
+ * @brief Keeps the core cycles a snapshot took, for the next boot.
+ */
+void snapshot_SetCycles(uint32_t cycles);
+
+/**
+ * @brief Core cycles kept by snapshot_SetCycles(), 0 if none; clears them.
+ */
+uint32_t snapshot_TakeCycles(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SNAPSHOT_H_ */
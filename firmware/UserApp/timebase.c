@@ -0,0 +1,158 @@
+/**
+ * \file           timebase.c
+ * \brief          Lock-free session time base source file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "timebase.h"
+/*****************************************************************************/
+/* Private Variables                                                         */
+/*****************************************************************************/
+static volatile uint32_t timebaseseconds = 0; /** Raw second count, written only by the second interrupt **/
+
+static volatile uint32_t timebasesecondsbase = 0; /** timebaseseconds at the last reset, written only by the main loop **/
+
+/*****************************************************************************/
+/* Time Base Functions                                                       */
+/*****************************************************************************/
+/*****************************************************************************
+ * @brief Clears the second counter.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Must be called before the TIM3/RTC interrupt that counts into
+ *       this module is enabled.
+ *****************************************************************************/
+void timeBase_Init(void)
+{
+	timebaseseconds = 0;
+	timebasesecondsbase = 0;
+}
+/*****************************************************************************
+ * @brief Counts one session second.
+ *
+ * @details The raw count is a native 32-bit word with a single writer, so
+ *          the increment needs no lock and every reader sees either the old
+ *          or the new value, never half of each.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @note Runs in the TIM3 update or RTC wake-up interrupt.
+ *
+ * @see timeBase_GetSeconds()
+ *****************************************************************************/
+void timeBase_SecondTickFromISR(void)
+{
+	timebaseseconds = timebaseseconds + 1U;
+}
+/*****************************************************************************
+ * @brief Returns the seconds since the last timeBase_ResetSeconds().
+ *
+ * @details Raw count minus the reset base, modulo 2^32. The base is only
+ *          written by the main loop itself, so the pair is consistent
+ *          without masking the second interrupt.
+ *
+ * @param None
+ *
+ * @return uint32_t Elapsed seconds.
+ *
+ * @see timeBase_ResetSeconds()
+ *****************************************************************************/
+uint32_t timeBase_GetSeconds(void)
+{
+	return (uint32_t)(timebaseseconds - timebasesecondsbase);
+}
+/*****************************************************************************
+ * @brief Restarts the elapsed seconds from zero.
+ *
+ * @details Copies the raw count into the base instead of clearing a counter
+ *          the interrupt increments, so an increment can never be lost or
+ *          undone. A tick arriving right after the copy counts as the
+ *          first second of the new session.
+ *
+ * @param None
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @see timeBase_GetSeconds()
+ *****************************************************************************/
+void timeBase_ResetSeconds(void)
+{
+	timebasesecondsbase = timebaseseconds;
+}
+/*****************************************************************************
+ * @brief Sets the elapsed seconds.
+ *
+ * @details Moves the reset base like timeBase_ResetSeconds(), used to
+ *          continue a session saved over a STANDBY.
+ *
+ * @param[in] seconds  Elapsed seconds from now on.
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @see timeBase_GetSeconds()
+ *****************************************************************************/
+void timeBase_SetSeconds(uint32_t seconds)
+{
+	timebasesecondsbase = timebaseseconds - seconds;
+}
+/*****************************************************************************
+ * @brief Moves the start of the elapsed seconds forward.
+ *
+ * @details Used when a session ends: the next one starts exactly where the
+ *          finished one ended, even if a second ticked after the caller
+ *          took its snapshot.
+ *
+ * @param[in] seconds  Seconds to take off the elapsed count.
+ *
+ * @return None
+ *
+ * @retval None
+ *
+ * @see timeBase_ResetSeconds()
+ *****************************************************************************/
+void timeBase_ConsumeSeconds(uint32_t seconds)
+{
+	timebasesecondsbase = timebasesecondsbase + seconds;
+}
+/*************************************END*************************************/
@@ -0,0 +1,89 @@
+/**
+ * \file           timebase.h
+ * \brief          Lock-free session time base header file
+ */
+
+/*
+ * Copyright (c) 2024 Sourabh Potdar
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sub-license, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * Author:          Sourabh Potdar
+ * Version:         V1.0.0
+ */
+
+#ifndef TIMEBASE_H_
+#define TIMEBASE_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/*****************************************************************************/
+/* Include Files                                                             */
+/*****************************************************************************/
+#include "Platform_Translate.h"
+
+/*****************************************************************************/
+/* Time Base Function Declarations                                           */
+/*****************************************************************************/
+
+/**
+ * @brief Clears the second counter. Call before the timebase interrupt is enabled.
+ */
+void timeBase_Init(void);
+
+/**
+ * @brief Counts one session second. Called by the second timebase interrupt only (TIM3 or RTC).
+ */
+void timeBase_SecondTickFromISR(void);
+
+/**
+ * @brief Seconds since the last timeBase_ResetSeconds(). Main loop only.
+ *
+ * @return Elapsed seconds, a consistent 32-bit snapshot.
+ */
+uint32_t timeBase_GetSeconds(void);
+
+/**
+ * @brief Restarts the elapsed seconds from zero. Main loop only.
+ */
+void timeBase_ResetSeconds(void);
+
+/**
+ * @brief Sets the elapsed seconds. Main loop only.
+ *
+ * @param[in] seconds Elapsed seconds from now on.
+ */
+void timeBase_SetSeconds(uint32_t seconds);
+
+/**
+ * @brief Moves the start of the elapsed seconds forward. Main loop only.
+ *
+ * @param[in] seconds Seconds to take off the elapsed count.
+ */
+void timeBase_ConsumeSeconds(uint32_t seconds);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIMEBASE_H_ */